@@ -0,0 +1,44 @@
+/* Entry point of the CPU benchmarks (mandelbrot-bench), none of them needs a Vulkan device */
+#include "benchmark/Benchmarks.h"
+#include <stdlib.h>
+
+struct BenchmarkEntry
+{
+	const char* Name;
+	const char* Description;
+	int (*Run)(const int argc, char** argv);
+};
+
+INTERNALSCOPE const BenchmarkEntry Benchmarks[] = {
+	{ "png", "Parallel PNG encoder against lodepng", RunPngBenchmark },
+	{ "convert", "Float RGBA to RGBA8 readback conversion, scalar against SIMD", RunConversionBenchmark },
+	{ "kernels", "CPU escape time kernels, scalar against SIMD, in iterations per second", RunKernelBenchmark },
+	{ "variants", "Template escape time kernel family, every compiled variant on its own", RunEscapeTimeBenchmark },
+	{ "deepzoom", "BigFixed Karatsuba products and perturbation against their references", RunDeepZoomBenchmark },
+};
+
+INTERNALSCOPE void PrintUsage(const char* executableName)
+{
+	printf("Usage: %s <benchmark> [options]\n", executableName);
+	for (const BenchmarkEntry& entry : Benchmarks)
+		printf("  %-12s %s\n", entry.Name, entry.Description);
+
+	printf("Run '%s <benchmark> --help' for the options of one benchmark\n", executableName);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		PrintUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	const std::string_view name = argv[1];
+	for (const BenchmarkEntry& entry : Benchmarks)
+		if (name == entry.Name)
+			return entry.Run(argc - 1, argv + 1);
+
+	PrintUsage(argv[0]);
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "include/Core.h"
+#include <chrono>
+
+/* Each benchmark parses its own options (argv[0] is the benchmark name) and returns the process exit code */
+int RunPngBenchmark(const int argc, char** argv);
+int RunConversionBenchmark(const int argc, char** argv);
+int RunKernelBenchmark(const int argc, char** argv);
+int RunEscapeTimeBenchmark(const int argc, char** argv);
+int RunDeepZoomBenchmark(const int argc, char** argv);
+
+namespace Benchmark {
+	/* Best of several runs, the first one also warms caches and the allocator */
+	inline double MeasureSeconds(const uint32_t runCount, const std::function<void()>& function)
+	{
+		double best = 0.0;
+		for (uint32_t run = 0; run < runCount; ++run)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			function();
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (run == 0 || seconds < best)
+				best = seconds;
+		}
+
+		return best;
+	}
+}
@@ -0,0 +1,144 @@
+/*
+* Readback conversion (linear float RGBA to RGBA8): times the scalar reference and every SIMD
+* level the CPU supports on one thread, then the best level on all threads, and checks each
+* kernel's output against the reference.
+*/
+#include "benchmark/Benchmarks.h"
+#include "include/PostProcess.h"
+#include "include/ThreadPool.h"
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+
+namespace Utilities {
+	struct ConversionBenchmarkSettings
+	{
+		uint32_t Width = 3840;
+		uint32_t Height = 2160;
+		uint32_t RunCount = 5;
+		uint32_t ThreadCount = 0;
+		ConversionSettings Conversion;
+	};
+
+	INTERNALSCOPE bool ParseConversionBenchmarkArguments(const int argc, char** argv, ConversionBenchmarkSettings& settings)
+	{
+		settings.Conversion.Gamma = 2.2f;
+		settings.Conversion.Dither = true;
+
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view argument = argv[i];
+			const int remaining = argc - i - 1;
+
+			if (argument == "--width" && remaining >= 1)
+				settings.Width = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--height" && remaining >= 1)
+				settings.Height = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--runs" && remaining >= 1)
+				settings.RunCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--threads" && remaining >= 1)
+				settings.ThreadCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--gamma" && remaining >= 1)
+				settings.Conversion.Gamma = strtof(argv[++i], nullptr);
+			else if (argument == "--no-dither")
+				settings.Conversion.Dither = false;
+			else
+			{
+				printf(
+					"Usage: convert [options]\n"
+					"  --width <pixels>   Image width (default 3840)\n"
+					"  --height <pixels>  Image height (default 2160)\n"
+					"  --runs <count>     Runs per kernel, the best one is reported (default 5)\n"
+					"  --threads <count>  Threads of the parallel run (default: all hardware threads)\n"
+					"  --gamma <gamma>    Gamma of the conversion, 1 skips it (default 2.2)\n"
+					"  --no-dither        Round instead of ordered dithering\n");
+				return false;
+			}
+		}
+
+		return settings.Width > 0 && settings.Height > 0 && settings.RunCount > 0 && settings.Conversion.Gamma > 0.0f;
+	}
+
+	/* Smooth gradients with some out of range values, NaN and infinity mixed in */
+	INTERNALSCOPE void CreateTestImage(const uint32_t width, const uint32_t height, std::vector<float>& image)
+	{
+		image.resize(static_cast<std::size_t>(width) * height * 4);
+		uint32_t state = 12345;
+		for (std::size_t i = 0; i < image.size(); ++i)
+		{
+			state = state * 1664525u + 1013904223u;
+			const std::size_t pixel = i / 4;
+			const float u = static_cast<float>(pixel % width) / width;
+			const float v = static_cast<float>(pixel / width) / height;
+			image[i] = (i & 3) == 3 ? 1.0f : u * (1.0f - v) + 0.1f * static_cast<float>(i & 3) * v;
+
+			switch (state >> 24)
+			{
+				case 0: image[i] = -0.25f; break;
+				case 1: image[i] = 1.5f; break;
+				case 2: image[i] = NAN; break;
+				case 3: image[i] = INFINITY; break;
+				default: break;
+			}
+		}
+	}
+}
+
+int RunConversionBenchmark(const int argc, char** argv)
+{
+	Utilities::ConversionBenchmarkSettings settings;
+	if (!Utilities::ParseConversionBenchmarkArguments(argc, argv, settings))
+		return EXIT_FAILURE;
+
+	ThreadPool parallelPool(settings.ThreadCount);
+	ThreadPool serialPool(1);
+
+	std::vector<float> source;
+	Utilities::CreateTestImage(settings.Width, settings.Height, source);
+	const std::size_t sourcePitch = static_cast<std::size_t>(settings.Width) * 4 * sizeof(float);
+	const std::size_t destinationPitch = static_cast<std::size_t>(settings.Width) * 4;
+
+	std::vector<uint8_t> reference(destinationPitch * settings.Height);
+	for (uint32_t y = 0; y < settings.Height; ++y)
+		PostProcess::ConvertFloatRowReference(source.data() + y * settings.Width * 4, reference.data() + y * destinationPitch, settings.Width, 0, y, settings.Conversion);
+
+	const double megapixels = static_cast<double>(settings.Width) * settings.Height / 1e6;
+	printf("%ux%u (%.1f MP), gamma %.2f, %s, best of %u runs\n",
+		settings.Width, settings.Height, megapixels, settings.Conversion.Gamma, settings.Conversion.Dither ? "dithered" : "rounded", settings.RunCount);
+	printf("%-10s %8s %10s %10s %9s %9s %10s\n", "kernel", "threads", "ms", "MP/s", "GB/s in", "speedup", "max error");
+
+	std::vector<uint8_t> destination(reference.size());
+	bool valid = true;
+	double scalarTime = 0.0;
+	const auto run = [&](const ESimdLevel level, ThreadPool& threadPool) {
+		std::fill(destination.begin(), destination.end(), static_cast<uint8_t>(0));
+		const double seconds = Benchmark::MeasureSeconds(settings.RunCount, [&]() {
+			PostProcess::ConvertFloatToRGBA8(
+				source.data(), sourcePitch, destination.data(), destinationPitch,
+				settings.Width, settings.Height, 0, 0, settings.Conversion, threadPool, level);
+		});
+
+		/* The polynomial pow() may land on the other side of a quantization step, nothing more */
+		int32_t maxError = 0;
+		for (std::size_t i = 0; i < destination.size(); ++i)
+			maxError = std::max(maxError, abs(static_cast<int32_t>(destination[i]) - static_cast<int32_t>(reference[i])));
+
+		valid = valid && maxError <= (level == ESimdLevel::Scalar ? 0 : 1);
+		if (level == ESimdLevel::Scalar && threadPool.GetThreadCount() == 1)
+			scalarTime = seconds;
+
+		printf("%-10s %8u %10.2f %10.1f %9.2f %8.2fx %10d\n",
+			Simd::GetLevelName(level), threadPool.GetThreadCount(), seconds * 1e3, megapixels / seconds,
+			static_cast<double>(source.size() * sizeof(float)) / seconds / 1e9, scalarTime / seconds, maxError);
+	};
+
+	const ESimdLevel supportedLevel = Simd::GetSupportedLevel();
+	for (const ESimdLevel level : { ESimdLevel::Scalar, ESimdLevel::SSE2, ESimdLevel::AVX2 })
+		if (level <= supportedLevel)
+			run(level, serialPool);
+
+	run(std::min(supportedLevel, ESimdLevel::AVX2), parallelPool);
+
+	printf(valid ? "All kernels match the scalar reference\n" : "A kernel does NOT match the scalar reference\n");
+	return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
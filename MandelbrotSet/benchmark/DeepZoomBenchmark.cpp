@@ -0,0 +1,289 @@
+/*
+* Deep zoom arithmetic: times BigFixed products (Karatsuba multiplication and squaring against
+* the schoolbook product they have to reproduce limb for limb) and perturbation against direct
+* double iteration at a zoom double still resolves, on a sweep of thread counts. The perturbed
+* escape iterations are checked against the direct ones, so a broken fast path cannot report
+* a speedup.
+*/
+#include "benchmark/Benchmarks.h"
+#include "include/BigFixed.h"
+#include "include/Perturbation.h"
+#include "include/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <stdlib.h>
+#include <thread>
+
+namespace Utilities {
+	struct DeepZoomBenchmarkSettings
+	{
+		/* Operand precisions of the product benchmark, below and far above BigFixed::KaratsubaThreshold limbs */
+		std::vector<uint32_t> ProductBits = { 512, 4096, 16384, 40000 };
+		uint32_t Width = 512;
+		uint32_t Height = 384;
+		uint32_t MaxIterations = 1000;
+		/* Shallow enough for double to iterate every pixel directly, deep enough that the orbits are long */
+		std::string CenterX = "-0.743643887037151";
+		std::string CenterY = "0.131825904205330";
+		double Scale = 1.0e-6;
+		uint32_t RunCount = 3;
+		/* Largest thread count of the sweep, 0 for all hardware threads */
+		uint32_t ThreadCount = 0;
+	};
+
+	INTERNALSCOPE bool ParseDeepZoomBenchmarkArguments(const int argc, char** argv, DeepZoomBenchmarkSettings& settings)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view argument = argv[i];
+			const int remaining = argc - i - 1;
+
+			if (argument == "--bits" && remaining >= 1)
+				settings.ProductBits = { static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)) };
+			else if (argument == "--width" && remaining >= 1)
+				settings.Width = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--height" && remaining >= 1)
+				settings.Height = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--iterations" && remaining >= 1)
+				settings.MaxIterations = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--center" && remaining >= 2)
+			{
+				settings.CenterX = argv[++i];
+				settings.CenterY = argv[++i];
+			}
+			else if (argument == "--scale" && remaining >= 1)
+				settings.Scale = strtod(argv[++i], nullptr);
+			else if (argument == "--runs" && remaining >= 1)
+				settings.RunCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--threads" && remaining >= 1)
+				settings.ThreadCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else
+			{
+				printf(
+					"Usage: deepzoom [options]\n"
+					"  --bits <count>        Operand precision of the product benchmark (default 512, 4096, 16384 and 40000)\n"
+					"  --width <pixels>      Image width of the perturbation benchmark (default 512)\n"
+					"  --height <pixels>     Image height (default 384)\n"
+					"  --iterations <count>  Iteration limit (default 1000)\n"
+					"  --center <x> <y>      Viewport center as decimal text (default -0.743643887037151 0.131825904205330)\n"
+					"  --scale <extent>      Horizontal extent of the viewport, double has to resolve its pixels (default 1e-6)\n"
+					"  --runs <count>        Runs per measurement, the best one is reported (default 3)\n"
+					"  --threads <count>     Largest thread count of the sweep (default: all hardware threads)\n");
+				return false;
+			}
+		}
+
+		return !settings.ProductBits.empty() && settings.ProductBits[0] > 0 && settings.Width > 0 && settings.Height > 0 &&
+			settings.MaxIterations > 0 && settings.Scale > 0.0 && settings.RunCount > 0;
+	}
+
+	/* Every fraction limb filled, so no product takes the zero limb shortcut of the schoolbook loop */
+	INTERNALSCOPE BigFixed GenerateOperand(const uint32_t fractionBits, uint32_t& seed)
+	{
+		std::string text = "0.";
+		const uint32_t digitCount = fractionBits * 30103 / 100000 + 1;
+		for (uint32_t i = 0; i < digitCount; ++i)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			text += static_cast<char>('0' + (seed >> 16) % 10);
+		}
+
+		BigFixed value;
+		BigFixed::Parse(text, fractionBits, value);
+		return value;
+	}
+
+	/* 1, 2, 4, ... below maxThreadCount and maxThreadCount itself, each count once */
+	INTERNALSCOPE std::vector<uint32_t> GetThreadCounts(const uint32_t maxThreadCount)
+	{
+		std::vector<uint32_t> threadCounts;
+		for (uint32_t threadCount = 1; threadCount < maxThreadCount; threadCount *= 2)
+			threadCounts.push_back(threadCount);
+
+		threadCounts.push_back(maxThreadCount);
+		return threadCounts;
+	}
+
+	/* z = z^2 + c from z = 0 in double, the iteration convention of Perturbation::IteratePixel */
+	INTERNALSCOPE uint32_t IterateDirect(const double cx, const double cy, const uint32_t maxIterations, const double escapeRadiusSquared, uint64_t& iterationCount)
+	{
+		double x = 0.0;
+		double y = 0.0;
+		uint32_t i = 0;
+		for (; i < maxIterations; ++i)
+		{
+			const double nextX = x * x - y * y + cx;
+			y = 2.0 * x * y + cy;
+			x = nextX;
+			if (x * x + y * y > escapeRadiusSquared)
+			{
+				iterationCount += i + 1;
+				return i;
+			}
+		}
+
+		iterationCount += i;
+		return i;
+	}
+}
+
+int RunDeepZoomBenchmark(const int argc, char** argv)
+{
+	Utilities::DeepZoomBenchmarkSettings settings;
+	if (!Utilities::ParseDeepZoomBenchmarkArguments(argc, argv, settings))
+		return EXIT_FAILURE;
+
+	bool valid = true;
+
+	/* Products of the reference orbit, Multiply and Square take the Karatsuba path from KaratsubaThreshold limbs on */
+	printf("BigFixed products, Karatsuba from %u limbs, best of %u runs\n", BigFixed::KaratsubaThreshold, settings.RunCount);
+	printf("%8s %6s %8s %14s %14s %14s %9s %9s %8s\n", "bits", "limbs", "products", "schoolbook ms", "karatsuba ms", "square ms", "multiply", "square", "match");
+	uint32_t seed = 1;
+	for (const uint32_t bits : settings.ProductBits)
+	{
+		const BigFixed a = Utilities::GenerateOperand(bits, seed);
+		const BigFixed b = -Utilities::GenerateOperand(bits, seed);
+		/* Enough products per run that the small precisions take measurable time */
+		const uint32_t productCount = std::max(1u, 4000000u / (a.GetLimbCount() * a.GetLimbCount()));
+
+		BigFixed schoolbook;
+		BigFixed karatsuba;
+		BigFixed square;
+		BigFixed squareReference;
+		const double schoolbookSeconds = Benchmark::MeasureSeconds(settings.RunCount, [&]() {
+			for (uint32_t i = 0; i < productCount; ++i)
+				BigFixed::MultiplySchoolbook(a, b, schoolbook);
+		});
+		const double karatsubaSeconds = Benchmark::MeasureSeconds(settings.RunCount, [&]() {
+			for (uint32_t i = 0; i < productCount; ++i)
+				BigFixed::Multiply(a, b, karatsuba);
+		});
+		const double squareSeconds = Benchmark::MeasureSeconds(settings.RunCount, [&]() {
+			for (uint32_t i = 0; i < productCount; ++i)
+				BigFixed::Square(a, square);
+		});
+
+		/* Integer arithmetic truncated at the same limb, anything but an exact match is a bug */
+		BigFixed::MultiplySchoolbook(a, a, squareReference);
+		const bool matches = karatsuba == schoolbook && square == squareReference;
+		valid = valid && matches;
+
+		printf("%8u %6u %8u %14.3f %14.3f %14.3f %8.2fx %8.2fx %8s\n",
+			bits, a.GetLimbCount(), productCount, schoolbookSeconds * 1e3, karatsubaSeconds * 1e3, squareSeconds * 1e3,
+			schoolbookSeconds / karatsubaSeconds, schoolbookSeconds / squareSeconds, matches ? "yes" : "NO");
+	}
+
+	PerturbationView view;
+	view.Scale = settings.Scale;
+	view.Width = settings.Width;
+	view.Height = settings.Height;
+	view.MaxIterations = settings.MaxIterations;
+	const uint32_t fractionBits = Perturbation::GetFractionBits(view.Scale, view.Width);
+	if (!BigFixed::Parse(settings.CenterX, fractionBits, view.CenterX) || !BigFixed::Parse(settings.CenterY, fractionBits, view.CenterY))
+	{
+		printf("Failed to parse the center %s %s\n", settings.CenterX.c_str(), settings.CenterY.c_str());
+		return EXIT_FAILURE;
+	}
+
+	const double centerX = view.CenterX.ToDouble();
+	const double centerY = view.CenterY.ToDouble();
+	if (Perturbation::IsBeyondDoublePrecision(centerX, centerY, view.Scale, view.Width))
+	{
+		printf("Double cannot resolve the pixels of scale %g, the direct path has nothing to check against\n", view.Scale);
+		return EXIT_FAILURE;
+	}
+
+	ReferenceOrbit reference;
+	const double referenceSeconds = Benchmark::MeasureSeconds(settings.RunCount, [&]() { reference = Perturbation::ComputeMainReference(view); });
+	SeriesApproximation series;
+	const double seriesSeconds = Benchmark::MeasureSeconds(settings.RunCount, [&]() { series = Perturbation::ComputeSeriesApproximation(view, reference); });
+
+	printf("\nPerturbation at %ux%u, %u iterations, scale %g, %u fraction bits, best of %u runs\n",
+		view.Width, view.Height, view.MaxIterations, view.Scale, fractionBits, settings.RunCount);
+	printf("Main reference: %u iterations in %.2f ms, series: %u skipped iterations in %.2f ms\n",
+		reference.GetLength(), referenceSeconds * 1e3, series.SkipIterations, seriesSeconds * 1e3);
+
+	const std::size_t pixelCount = static_cast<std::size_t>(view.Width) * view.Height;
+	const double escapeRadiusSquared = 4.0;
+	std::vector<uint32_t> directIterations(pixelCount);
+	std::vector<uint32_t> perturbedIterations(pixelCount);
+	std::vector<uint8_t> glitched(pixelCount);
+	std::atomic<uint64_t> directIterationCount(0);
+	std::atomic<uint64_t> perturbedIterationCount(0);
+
+	printf("%-12s %8s %10s %10s %12s %9s\n", "path", "threads", "ms", "MP/s", "GIter/s", "speedup");
+	double directTime = 0.0;
+	const uint32_t maxThreadCount = settings.ThreadCount != 0 ? settings.ThreadCount : std::max(1u, std::thread::hardware_concurrency());
+	for (const uint32_t threadCount : Utilities::GetThreadCounts(maxThreadCount))
+	{
+		ThreadPool threadPool(threadCount);
+		const double directSeconds = Benchmark::MeasureSeconds(settings.RunCount, [&]() {
+			directIterationCount = 0;
+			threadPool.ParallelFor(view.Height, [&](const uint32_t y) {
+				uint64_t iterationCount = 0;
+				for (uint32_t x = 0; x < view.Width; ++x)
+				{
+					double offsetX;
+					double offsetY;
+					Perturbation::GetPixelOffset(view, x, y, offsetX, offsetY);
+					directIterations[static_cast<std::size_t>(y) * view.Width + x] = Utilities::IterateDirect(
+						centerX + offsetX, centerY + offsetY, view.MaxIterations, escapeRadiusSquared, iterationCount);
+				}
+
+				directIterationCount += iterationCount;
+			});
+		});
+
+		const double perturbedSeconds = Benchmark::MeasureSeconds(settings.RunCount, [&]() {
+			perturbedIterationCount = 0;
+			threadPool.ParallelFor(view.Height, [&](const uint32_t y) {
+				uint64_t iterationCount = 0;
+				for (uint32_t x = 0; x < view.Width; ++x)
+				{
+					const std::size_t pixel = static_cast<std::size_t>(y) * view.Width + x;
+					double offsetX;
+					double offsetY;
+					Perturbation::GetPixelOffset(view, x, y, offsetX, offsetY);
+					float magnitude;
+					glitched[pixel] = Perturbation::IteratePixel(
+						reference, &series, offsetX - reference.OffsetX, offsetY - reference.OffsetY, view.MaxIterations, escapeRadiusSquared,
+						perturbedIterations[pixel], magnitude, iterationCount) ? 0 : 1;
+				}
+
+				perturbedIterationCount += iterationCount;
+			});
+		});
+
+		if (threadCount == 1)
+			directTime = directSeconds;
+
+		printf("%-12s %8u %10.2f %10.1f %12.3f %8.2fx\n", "direct", threadCount, directSeconds * 1e3,
+			static_cast<double>(pixelCount) / directSeconds / 1e6, static_cast<double>(directIterationCount) / directSeconds / 1e9, directTime / directSeconds);
+		printf("%-12s %8u %10.2f %10.1f %12.3f %8.2fx\n", "perturbation", threadCount, perturbedSeconds * 1e3,
+			static_cast<double>(pixelCount) / perturbedSeconds / 1e6, static_cast<double>(perturbedIterationCount) / perturbedSeconds / 1e9, directTime / perturbedSeconds);
+	}
+
+	/*
+	* Both paths round differently, and orbits that stay near the boundary for hundreds of iterations
+	* amplify that until they escape at unrelated iterations. Glitched pixels are iterated again
+	* against other references by the renderers and are left out. A broken path differs almost
+	* everywhere, more than a hundredth of the rest differing fails the benchmark.
+	*/
+	std::size_t glitchedCount = 0;
+	std::size_t mismatchCount = 0;
+	for (std::size_t i = 0; i < pixelCount; ++i)
+	{
+		if (glitched[i])
+			++glitchedCount;
+		else if (perturbedIterations[i] != directIterations[i])
+			++mismatchCount;
+	}
+
+	const std::size_t comparedCount = pixelCount - glitchedCount;
+	const bool perturbationMatches = comparedCount != 0 && mismatchCount * 100 <= comparedCount;
+	valid = valid && perturbationMatches;
+	printf("Perturbation against direct: %zu of %zu pixels differ, %zu glitched\n", mismatchCount, comparedCount, glitchedCount);
+
+	printf(valid ? "Karatsuba matches schoolbook and perturbation matches direct iteration\n" : "A fast path does NOT match its reference\n");
+	return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,124 @@
+/*
+* Escape time kernel family: times every compiled variant the CPU supports on one thread and
+* checks that each SIMD variant matches the scalar variant of the same precision, power,
+* coloring and interior checks bit for bit.
+*/
+#include "benchmark/Benchmarks.h"
+#include "include/CpuKernels.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace Utilities {
+	struct EscapeTimeBenchmarkSettings
+	{
+		EscapeTimeParameters Parameters;
+		/* Only variants whose name contains it, such as "f64" or "p2 smooth" */
+		std::string Filter;
+		uint32_t RunCount = 3;
+	};
+
+	INTERNALSCOPE bool ParseEscapeTimeBenchmarkArguments(const int argc, char** argv, EscapeTimeBenchmarkSettings& settings)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view argument = argv[i];
+			const int remaining = argc - i - 1;
+
+			if (argument == "--width" && remaining >= 1)
+				settings.Parameters.Width = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--height" && remaining >= 1)
+				settings.Parameters.Height = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--iterations" && remaining >= 1)
+				settings.Parameters.MaxIterations = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--center" && remaining >= 2)
+			{
+				settings.Parameters.CenterX = strtod(argv[++i], nullptr);
+				settings.Parameters.CenterY = strtod(argv[++i], nullptr);
+			}
+			else if (argument == "--scale" && remaining >= 1)
+				settings.Parameters.Scale = strtod(argv[++i], nullptr);
+			else if (argument == "--periodicity-tolerance" && remaining >= 1)
+				settings.Parameters.PeriodicityTolerance = strtof(argv[++i], nullptr);
+			else if (argument == "--filter" && remaining >= 1)
+				settings.Filter = argv[++i];
+			else if (argument == "--runs" && remaining >= 1)
+				settings.RunCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else
+			{
+				printf(
+					"Usage: variants [options]\n"
+					"  --width <pixels>      Image width (default 1024)\n"
+					"  --height <pixels>     Image height (default 768)\n"
+					"  --iterations <count>  Iteration limit (default 1000)\n"
+					"  --center <x> <y>      Viewport center (default -0.445 0.0)\n"
+					"  --scale <extent>      Horizontal extent of the viewport (default 2.68)\n"
+					"  --periodicity-tolerance <distance> Distance that counts as a repeated orbit (default 1e-6)\n"
+					"  --filter <text>       Only variants whose name contains <text>, such as \"f64\" or \"p2 smooth\"\n"
+					"  --runs <count>        Runs per variant, the best one is reported (default 3)\n");
+				return false;
+			}
+		}
+
+		return settings.Parameters.Width > 0 && settings.Parameters.Height > 0 && settings.Parameters.MaxIterations > 0 && settings.RunCount > 0;
+	}
+}
+
+int RunEscapeTimeBenchmark(const int argc, char** argv)
+{
+	Utilities::EscapeTimeBenchmarkSettings settings;
+	if (!Utilities::ParseEscapeTimeBenchmarkArguments(argc, argv, settings))
+		return EXIT_FAILURE;
+
+	const EscapeTimeParameters& parameters = settings.Parameters;
+	const std::size_t pixelCount = static_cast<std::size_t>(parameters.Width) * parameters.Height;
+	printf("%ux%u, %u iterations, center %g %g, scale %g, best of %u runs, one thread\n",
+		parameters.Width, parameters.Height, parameters.MaxIterations, parameters.CenterX, parameters.CenterY, parameters.Scale, settings.RunCount);
+	printf("%-28s %6s %10s %10s %12s %9s %10s\n", "variant", "lanes", "ms", "MP/s", "GIter/s", "speedup", "mismatches");
+
+	/* Variants are ordered with the level varying fastest, so the scalar one of each group comes first */
+	std::vector<float> reference(pixelCount);
+	std::vector<float> escapeTimes(pixelCount);
+	double scalarTime = 0.0;
+	uint32_t variantCount = 0;
+	bool valid = true;
+	for (const EscapeTimeKernelKey& key : CpuKernels::GetVariants())
+	{
+		const EscapeTimeKernel kernel = CpuKernels::Find(key);
+		const std::string name = CpuKernels::GetVariantName(key);
+		if (!kernel || (!settings.Filter.empty() && name.find(settings.Filter) == std::string::npos && key.Level != ESimdLevel::Scalar))
+			continue;
+
+		uint64_t iterationCount = 0;
+		const double seconds = Benchmark::MeasureSeconds(settings.RunCount, [&]() {
+			iterationCount = 0;
+			InteriorCheckCounts counts;
+			for (uint32_t y = 0; y < parameters.Height; ++y)
+				iterationCount += kernel(parameters, 0, y, parameters.Width, escapeTimes.data() + static_cast<std::size_t>(y) * parameters.Width, counts);
+		});
+
+		/* The scalar variant is the reference of its group and also runs when the filter excludes it */
+		std::size_t mismatchCount = 0;
+		if (key.Level == ESimdLevel::Scalar)
+		{
+			reference.swap(escapeTimes);
+			scalarTime = seconds;
+			if (!settings.Filter.empty() && name.find(settings.Filter) == std::string::npos)
+				continue;
+		}
+		else
+		{
+			for (std::size_t i = 0; i < pixelCount; ++i)
+				if (memcmp(&escapeTimes[i], &reference[i], sizeof(float)) != 0)
+					++mismatchCount;
+		}
+
+		valid = valid && mismatchCount == 0;
+		++variantCount;
+		printf("%-28s %6u %10.2f %10.1f %12.3f %8.2fx %10zu\n",
+			name.c_str(), CpuKernels::GetLaneCount(key), seconds * 1e3, static_cast<double>(pixelCount) / seconds / 1e6,
+			static_cast<double>(iterationCount) / seconds / 1e9, scalarTime / seconds, mismatchCount);
+	}
+
+	printf(valid ? "%u variants match their scalar variant\n" : "%u variants, one does NOT match its scalar variant\n", variantCount);
+	return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
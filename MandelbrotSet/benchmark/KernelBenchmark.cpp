@@ -0,0 +1,161 @@
+/*
+* CPU escape time kernels: times the scalar reference and every SIMD level the CPU supports on
+* one thread, then the best level on all threads, and checks that each kernel's escape
+* iterations and |z|^2 match the reference bit for bit. The interior checks can be switched
+* off one by one to compare, their hit rates are printed.
+*/
+#include "benchmark/Benchmarks.h"
+#include "include/CpuKernels.h"
+#include "include/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <stdlib.h>
+
+namespace Utilities {
+	struct KernelBenchmarkSettings
+	{
+		uint32_t Width = 1024;
+		uint32_t Height = 768;
+		uint32_t MaxIterations = 1000;
+		/* Default view mixes the interior, the boundary and fast escaping points */
+		float CenterX = -0.445f;
+		float CenterY = 0.0f;
+		float Scale = 2.68f;
+		float EscapeRadiusSquared = 2.0f;
+		InteriorChecks Checks;
+		uint32_t RunCount = 3;
+		uint32_t ThreadCount = 0;
+	};
+
+	INTERNALSCOPE bool ParseKernelBenchmarkArguments(const int argc, char** argv, KernelBenchmarkSettings& settings)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view argument = argv[i];
+			const int remaining = argc - i - 1;
+
+			if (argument == "--width" && remaining >= 1)
+				settings.Width = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--height" && remaining >= 1)
+				settings.Height = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--iterations" && remaining >= 1)
+				settings.MaxIterations = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--center" && remaining >= 2)
+			{
+				settings.CenterX = strtof(argv[++i], nullptr);
+				settings.CenterY = strtof(argv[++i], nullptr);
+			}
+			else if (argument == "--scale" && remaining >= 1)
+				settings.Scale = strtof(argv[++i], nullptr);
+			else if (argument == "--smooth")
+				settings.EscapeRadiusSquared = 65536.0f;
+			else if (argument == "--no-cardioid")
+				settings.Checks.Cardioid = false;
+			else if (argument == "--no-bulb")
+				settings.Checks.Bulb = false;
+			else if (argument == "--no-periodicity")
+				settings.Checks.Periodicity = false;
+			else if (argument == "--periodicity-tolerance" && remaining >= 1)
+				settings.Checks.PeriodicityTolerance = strtof(argv[++i], nullptr);
+			else if (argument == "--runs" && remaining >= 1)
+				settings.RunCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--threads" && remaining >= 1)
+				settings.ThreadCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else
+			{
+				printf(
+					"Usage: kernels [options]\n"
+					"  --width <pixels>      Image width (default 1024)\n"
+					"  --height <pixels>     Image height (default 768)\n"
+					"  --iterations <count>  Iteration limit (default 1000)\n"
+					"  --center <x> <y>      Viewport center (default -0.445 0.0)\n"
+					"  --scale <extent>      Horizontal extent of the viewport (default 2.68)\n"
+					"  --smooth              Escape radius of the smooth output format (256 instead of sqrt 2)\n"
+					"  --no-cardioid         Disable the main cardioid test\n"
+					"  --no-bulb             Disable the period-2 bulb test\n"
+					"  --no-periodicity      Disable periodicity detection\n"
+					"  --periodicity-tolerance <distance> Distance that counts as a repeated orbit (default 1e-6)\n"
+					"  --runs <count>        Runs per kernel, the best one is reported (default 3)\n"
+					"  --threads <count>     Threads of the parallel run (default: all hardware threads)\n");
+				return false;
+			}
+		}
+
+		return settings.Width > 0 && settings.Height > 0 && settings.MaxIterations > 0 && settings.RunCount > 0;
+	}
+}
+
+int RunKernelBenchmark(const int argc, char** argv)
+{
+	Utilities::KernelBenchmarkSettings settings;
+	if (!Utilities::ParseKernelBenchmarkArguments(argc, argv, settings))
+		return EXIT_FAILURE;
+
+	ThreadPool parallelPool(settings.ThreadCount);
+	ThreadPool serialPool(1);
+
+	KernelViewport viewport;
+	viewport.CenterX = settings.CenterX;
+	viewport.CenterY = settings.CenterY;
+	viewport.Scale = settings.Scale;
+	viewport.Width = settings.Width;
+	viewport.Height = settings.Height;
+
+	const std::size_t pixelCount = static_cast<std::size_t>(settings.Width) * settings.Height;
+	std::vector<uint32_t> referenceIterations(pixelCount);
+	std::vector<float> referenceMagnitudes(pixelCount);
+	uint64_t iterationCount = 0;
+	InteriorCheckCounts checkCounts;
+	for (uint32_t y = 0; y < settings.Height; ++y)
+		iterationCount += CpuKernels::IterateRowReference(
+			viewport, 0, y, settings.Width, settings.MaxIterations, settings.EscapeRadiusSquared, settings.Checks,
+			referenceIterations.data() + static_cast<std::size_t>(y) * settings.Width, referenceMagnitudes.data() + static_cast<std::size_t>(y) * settings.Width, checkCounts);
+
+	printf("%ux%u, %u iterations, center %g %g, scale %g, %.1f iterations per pixel, best of %u runs\n",
+		settings.Width, settings.Height, settings.MaxIterations, settings.CenterX, settings.CenterY, settings.Scale,
+		static_cast<double>(iterationCount) / static_cast<double>(pixelCount), settings.RunCount);
+	InteriorCheck::PrintHitRates(settings.Checks, checkCounts, static_cast<double>(pixelCount));
+	printf("%-10s %6s %8s %10s %10s %12s %9s %10s\n", "kernel", "lanes", "threads", "ms", "MP/s", "GIter/s", "speedup", "mismatches");
+
+	std::vector<uint32_t> iterations(pixelCount);
+	std::vector<float> magnitudes(pixelCount);
+	bool valid = true;
+	double scalarTime = 0.0;
+	const auto run = [&](const ESimdLevel level, ThreadPool& threadPool) {
+		std::fill(iterations.begin(), iterations.end(), 0u);
+		std::fill(magnitudes.begin(), magnitudes.end(), 0.0f);
+		const double seconds = Benchmark::MeasureSeconds(settings.RunCount, [&]() {
+			threadPool.ParallelFor(settings.Height, [&](const uint32_t y) {
+				const std::size_t rowOffset = static_cast<std::size_t>(y) * settings.Width;
+				InteriorCheckCounts rowCheckCounts;
+				CpuKernels::IterateRow(
+					viewport, 0, y, settings.Width, settings.MaxIterations, settings.EscapeRadiusSquared, settings.Checks,
+					iterations.data() + rowOffset, magnitudes.data() + rowOffset, rowCheckCounts, level);
+			});
+		});
+
+		/* Same float operations in the same order, anything but an exact match is a bug */
+		std::size_t mismatchCount = 0;
+		for (std::size_t i = 0; i < pixelCount; ++i)
+			if (iterations[i] != referenceIterations[i] || (iterations[i] < settings.MaxIterations && magnitudes[i] != referenceMagnitudes[i]))
+				++mismatchCount;
+
+		valid = valid && mismatchCount == 0;
+		if (level == ESimdLevel::Scalar && threadPool.GetThreadCount() == 1)
+			scalarTime = seconds;
+
+		printf("%-10s %6u %8u %10.2f %10.1f %12.3f %8.2fx %10zu\n",
+			Simd::GetLevelName(level), CpuKernels::GetLaneCount(level), threadPool.GetThreadCount(), seconds * 1e3,
+			static_cast<double>(pixelCount) / seconds / 1e6, static_cast<double>(iterationCount) / seconds / 1e9, scalarTime / seconds, mismatchCount);
+	};
+
+	const ESimdLevel supportedLevel = Simd::GetSupportedLevel();
+	for (const ESimdLevel level : { ESimdLevel::Scalar, ESimdLevel::SSE2, ESimdLevel::AVX2, ESimdLevel::AVX512 })
+		if (level <= supportedLevel)
+			run(level, serialPool);
+
+	run(supportedLevel, parallelPool);
+
+	printf(valid ? "All kernels match the scalar reference\n" : "A kernel does NOT match the scalar reference\n");
+	return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,154 @@
+/*
+* Encodes the same rendered image with lodepng and with Png::EncodeRGBA on one and on all
+* threads, decodes every result again and compares it with the source pixels.
+*/
+#include "benchmark/Benchmarks.h"
+#include "include/Coloring.h"
+#include "include/PngEncoder.h"
+#include "include/ThreadPool.h"
+#include "vendor/lodepng/lodepng.h"
+#include <stdlib.h>
+
+namespace Utilities {
+	struct PngBenchmarkSettings
+	{
+		uint32_t Width = 3200;
+		uint32_t Height = 2400;
+		uint32_t MaxIterations = 256;
+		uint32_t RunCount = 3;
+		uint32_t ThreadCount = 0;
+	};
+
+	INTERNALSCOPE bool ParsePngBenchmarkArguments(const int argc, char** argv, PngBenchmarkSettings& settings)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view argument = argv[i];
+			const int remaining = argc - i - 1;
+
+			if (argument == "--width" && remaining >= 1)
+				settings.Width = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--height" && remaining >= 1)
+				settings.Height = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--iterations" && remaining >= 1)
+				settings.MaxIterations = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--runs" && remaining >= 1)
+				settings.RunCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else if (argument == "--threads" && remaining >= 1)
+				settings.ThreadCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			else
+			{
+				printf(
+					"Usage: png [options]\n"
+					"  --width <pixels>      Image width (default 3200)\n"
+					"  --height <pixels>     Image height (default 2400)\n"
+					"  --iterations <count>  Iteration limit of the test image (default 256)\n"
+					"  --runs <count>        Runs per encoder, the best one is reported (default 3)\n"
+					"  --threads <count>     Threads of the parallel run (default: all hardware threads)\n");
+				return false;
+			}
+		}
+
+		return settings.Width > 0 && settings.Height > 0 && settings.MaxIterations > 0 && settings.RunCount > 0;
+	}
+
+	/* Default viewport of the renderer, the mix of flat areas and fine detail is what real output compresses like */
+	INTERNALSCOPE void RenderTestImage(const PngBenchmarkSettings& settings, ThreadPool& threadPool, std::vector<uint8_t>& image)
+	{
+		image.resize(static_cast<std::size_t>(settings.Width) * settings.Height * 4);
+		const double scale = 2.34;
+		const double aspectRatio = static_cast<double>(settings.Height) / settings.Width;
+
+		threadPool.ParallelFor(settings.Height, [&](const uint32_t y) {
+			uint8_t* row = image.data() + static_cast<std::size_t>(y) * settings.Width * 4;
+			const double ci = (static_cast<double>(y) / settings.Height - 0.5) * scale * aspectRatio;
+			for (uint32_t x = 0; x < settings.Width; ++x)
+			{
+				const double cr = -0.445 + (static_cast<double>(x) / settings.Width - 0.5) * scale;
+				double zr = 0.0;
+				double zi = 0.0;
+				uint32_t n = 0;
+				for (; n < settings.MaxIterations; ++n)
+				{
+					const double temp = zr * zr - zi * zi + cr;
+					zi = 2.0 * zr * zi + ci;
+					zr = temp;
+					if (zr * zr + zi * zi > 4.0)
+						break;
+				}
+
+				Coloring::CosinePalette(static_cast<float>(n) / settings.MaxIterations, row + x * 4);
+			}
+		});
+	}
+
+	INTERNALSCOPE bool DecodesTo(const std::vector<uint8_t>& png, const std::vector<uint8_t>& image, const uint32_t width, const uint32_t height)
+	{
+		std::vector<uint8_t> decoded;
+		unsigned decodedWidth = 0;
+		unsigned decodedHeight = 0;
+		const unsigned error = lodepng::decode(decoded, decodedWidth, decodedHeight, png);
+		if (error)
+		{
+			printf("decoder error %u: %s\n", error, lodepng_error_text(error));
+			return false;
+		}
+
+		return decodedWidth == width && decodedHeight == height && decoded == image;
+	}
+}
+
+int RunPngBenchmark(const int argc, char** argv)
+{
+	Utilities::PngBenchmarkSettings settings;
+	if (!Utilities::ParsePngBenchmarkArguments(argc, argv, settings))
+		return EXIT_FAILURE;
+
+	ThreadPool parallelPool(settings.ThreadCount);
+	ThreadPool serialPool(1);
+
+	std::vector<uint8_t> image;
+	Utilities::RenderTestImage(settings, parallelPool, image);
+	const double megapixels = static_cast<double>(settings.Width) * settings.Height / 1e6;
+	printf("%ux%u (%.1f MP), best of %u runs\n", settings.Width, settings.Height, megapixels, settings.RunCount);
+
+	/* lodepng would otherwise switch to a palette for the few colors of the test image, keep both on 8 bit RGBA */
+	lodepng::State lodepngState;
+	lodepngState.encoder.auto_convert = 0;
+	lodepngState.info_png.color.colortype = LodePNGColorType::LCT_RGBA;
+	lodepngState.info_png.color.bitdepth = 8;
+
+	std::vector<uint8_t> lodepngOutput;
+	const double lodepngTime = Benchmark::MeasureSeconds(settings.RunCount, [&]() {
+		lodepngOutput.clear();
+		lodepng::encode(lodepngOutput, image, settings.Width, settings.Height, lodepngState);
+	});
+
+	std::vector<uint8_t> serialOutput;
+	const double serialTime = Benchmark::MeasureSeconds(settings.RunCount, [&]() {
+		Png::EncodeRGBA(image.data(), settings.Width, settings.Height, serialPool, serialOutput);
+	});
+
+	std::vector<uint8_t> parallelOutput;
+	const double parallelTime = Benchmark::MeasureSeconds(settings.RunCount, [&]() {
+		Png::EncodeRGBA(image.data(), settings.Width, settings.Height, parallelPool, parallelOutput);
+	});
+
+	printf("%-22s %10s %10s %10s %9s\n", "encoder", "seconds", "MP/s", "bytes", "speedup");
+	const auto report = [&](const char* name, const double seconds, const std::size_t size) {
+		printf("%-22s %10.3f %10.1f %10zu %8.2fx\n", name, seconds, megapixels / seconds, size, lodepngTime / seconds);
+	};
+
+	report("lodepng", lodepngTime, lodepngOutput.size());
+	report("parallel, 1 thread", serialTime, serialOutput.size());
+	char parallelName[32];
+	snprintf(parallelName, sizeof(parallelName), "parallel, %u threads", parallelPool.GetThreadCount());
+	report(parallelName, parallelTime, parallelOutput.size());
+
+	const bool valid =
+		Utilities::DecodesTo(serialOutput, image, settings.Width, settings.Height) &&
+		Utilities::DecodesTo(parallelOutput, image, settings.Width, settings.Height);
+
+	printf(valid ? "Decoded output matches the source image\n" : "Decoded output does NOT match the source image\n");
+	return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "include/Core.h"
+
+/*
+* Supersampling of an idle window: while nothing changes, every frame reruns the escape time pass
+* with the plane shifted by a subpixel offset and blends the colored sample into a float image
+* holding the running mean, which the window shows. Once SampleCount samples are in, nothing is
+* submitted until the view, the colors or the window change.
+*/
+namespace Accumulation {
+	constexpr uint32_t SampleCount = 64;
+
+	/* Radical inverse of index in base, the Halton sequence */
+	inline double GetRadicalInverse(uint32_t index, const uint32_t base)
+	{
+		const double inverseBase = 1.0 / static_cast<double>(base);
+		double factor = inverseBase;
+		double value = 0.0;
+		while (index > 0)
+		{
+			value += static_cast<double>(index % base) * factor;
+			index /= base;
+			factor *= inverseBase;
+		}
+
+		return value;
+	}
+
+	/* Offset of a sample from the pixel center in pixels, in [-0.5, 0.5). Sample 0 is the center, the pass shown before accumulating */
+	inline std::pair<double, double> GetSampleOffset(const uint32_t sampleIndex)
+	{
+		if (sampleIndex == 0)
+			return { 0.0, 0.0 };
+
+		return { GetRadicalInverse(sampleIndex, 2) - 0.5, GetRadicalInverse(sampleIndex, 3) - 0.5 };
+	}
+}
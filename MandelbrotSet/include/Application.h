@@ -3,6 +3,10 @@
 #include "include/Window.h"
 #include "include/VulkanTypes.h"
 #include "include/Image2D.h"
+#include "include/OfflineRenderer.h"
+#include "include/AutoIteration.h"
+#include "include/Reprojection.h"
+#include "include/Accumulation.h"
 
 class VulkanApp
 {
@@ -10,7 +14,10 @@ public:
 	enum class ERenderMethod
 	{
 		Graphics,
+		/* Headless, offline rendering */
 		Compute,
+		/* Window, the escape time pass is a compute shader on the async compute queue and the graphics queue only colors and presents */
+		AsyncCompute,
 		Default = Graphics,
 	};
 public:
@@ -34,14 +41,26 @@ private:
 	bool LoadAssets();
 
 	bool CreateGraphicsBasedPipeline();
-	bool CreateComputeBasedPipeline();
+	/* Escape time pass of the async compute mode, built from the same source as the fragment shader */
+	bool CreateEscapeTimeComputePipeline();
+	/* Escape time and accumulation images and their framebuffers, sized like the swapchain */
+	bool CreateEscapeTimeTarget();
+	bool CreateTargetImage(const VkFormat format, const VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& memory, VkImageView& imageView);
+	void DestroyEscapeTimeTarget();
 	bool AllocateGraphicsCommandBuffers();
-	bool AllocateComputeCommandBuffers();
-	bool RecordGraphicsCommandBuffers();
-	bool RecordComputeCommandBuffers();
+	/*
+	* Recorded every frame, with the frame's UBO slot at uniformOffset and the camera pushed. accumulate reruns
+	* the escape time pass with the sample offset and shows the running mean instead of coloring directly
+	*/
+	void RecordGraphicsCommandBuffer(VkCommandBuffer commandBuffer, const uint32_t imageIndex, const uint32_t uniformOffset, const bool computeEscapeTime, const bool accumulate);
+	/* Escape time pass of the async compute mode into escape time image target, reprojecting the other one. Samples skip the timestamps */
+	void RecordComputeCommandBuffer(VkCommandBuffer commandBuffer, const uint32_t frameIndex, const uint32_t uniformOffset, const uint32_t target, const bool sample);
 
 	void UpdateFrameData(const double deltaTime);
-	void DrawFrame();
+	/* False if nothing changed and the accumulation is complete or waits for the counters, no frame was submitted */
+	bool DrawFrame();
+	/* Reads the counters of the last escape time pass once it finished and picks the next automatic iteration limit, prints at most once per second */
+	void ReadEscapeTimeCounters();
 	/* Swapchain */
 	void RecreateSwapchain(const uint32_t width, const uint32_t height);
 	void CleanupSwapchain();
@@ -71,15 +90,45 @@ private:
 		VkPipelineStageFlags srcStageMask,
 		VkPipelineStageFlags dstStageMask);
 private:
+	/* std140, shared by the escape time pass (view) and the coloring pass (palette), one slot of m_UBORing per frame in flight */
 	struct UBO
+	{
+		int32_t IterationCount;
+		/* 0 is the palette texture, i > 0 the cosine palette EPalette(i - 1) */
+		int32_t PaletteIndex;
+		float ColorScale;
+		float ColorOffset;
+		/* CosinePaletteCoefficients of the palette */
+		float PaletteCoefficients[4][4];
+		/* InteriorChecks::GetFlags() and InteriorChecks::PeriodicityTolerance of the escape time pass */
+		uint32_t InteriorChecks;
+		float PeriodicityTolerance;
+		/* Reprojection::Mapping and refinement lattice of the escape time pass, the grid is the snapped center modulo 8 (see Reprojection.h) */
+		uint32_t ReprojectionMode;
+		uint32_t RefineStep;
+		uint32_t RefineGridX;
+		uint32_t RefineGridY;
+		float ReprojectionScaleX;
+		float ReprojectionScaleY;
+		float ReprojectionOffsetX;
+		float ReprojectionOffsetY;
+	};
+
+	/* Pushed to the fragment stage with every frame, the float32 pipelines end their block before PreciseCenterX (offset 32) */
+	struct CameraPushConstants
 	{
 		float AspectRatio;
 		float CenterX;
 		float CenterY;
 		float ZoomScale;
-		int32_t IterationCount;
-		float PADDING[3];
-	};	
+		/* Subpixel offset of an accumulated sample in texture coordinates and its index (see Accumulation.h), 0 outside accumulation */
+		float SampleOffsetX;
+		float SampleOffsetY;
+		uint32_t SampleIndex;
+		double PreciseCenterX;
+		double PreciseCenterY;
+		double PreciseZoomScale;
+	};
 
 	struct QueueFamilyIndices
 	{
@@ -126,6 +175,8 @@ private:
 	struct {
 		std::vector<VkSemaphore> PresentComplete;
 		std::vector<VkSemaphore> RenderComplete;
+		/* Async compute mode, signaled by the frame's escape time pass and waited on by its coloring */
+		std::vector<VkSemaphore> ComputeComplete;
 	} m_Semaphores;
 
 	uint32_t m_MaxFramesInFlight;
@@ -143,33 +194,118 @@ private:
 	/* Graphics Pipeline */
 	VulkanBuffer m_VertexBuffer;
 	VulkanBuffer m_IndexBuffer;
-	VulkanBuffer m_UBOBuffer;
+	/* Persistently mapped, slot i (m_UBORingStride bytes apart) belongs to frame in flight i and is bound with a dynamic offset */
+	VulkanBuffer m_UBORing;
+	uint8_t* m_UBORingData;
+	VkDeviceSize m_UBORingStride;
+	/* Frame data UpdateFrameData() built, copied into the ring once the frame's slot is free */
+	UBO m_FrameUBO;
+	CameraPushConstants m_FrameCamera;
+	/* The frame's escape time pass runs in float64, UpdateFrameData() decides by zoom depth */
+	bool m_FrameDoublePrecision;
 
 	VkShaderModule m_VertexShaderModule;
 	VkShaderModule m_FragmentShaderModule;
+	VkShaderModule m_ColoringShaderModule;
 	
-	VkPipeline m_GraphicsPipeline;
+	/* Escape time pass, iterates into m_EscapeTimeImage. Only runs when the view changes */
+	VkPipeline m_EscapeTimePipeline;
+	/* Same pass in float64, null without shaderFloat64 */
+	VkPipeline m_DoublePrecisionEscapeTimePipeline;
+	/* Coloring pass, one palette lookup per pixel of m_EscapeTimeImage into the swapchain image */
+	VkPipeline m_ColoringPipeline;
+	/* Coloring pass blended into m_AccumulationImage and the pass showing it in the swapchain image */
+	VkPipeline m_AccumulationPipeline;
+	VkPipeline m_ResolvePipeline;
 	VkPipelineLayout m_GraphicsPipelineLayout;
 	
 	VkDescriptorSetLayout m_GraphicsPipelineUBOBufferDescriptorSetLayout;
 	VkDescriptorSetLayout m_GraphicsPipelineColorPaletteDescriptorSetLayout;
+	VkDescriptorSetLayout m_GraphicsPipelineEscapeTimeDescriptorSetLayout;
 	VkDescriptorPool m_GraphicsPipelineDescriptorPool;
 	VkDescriptorSet m_GraphicsPipelineUBOBufferDescriptorSet;
 	VkDescriptorSet m_GraphicsPipelineColorPaletteDescriptorSet;
+	VkDescriptorSet m_GraphicsPipelineEscapeTimeDescriptorSet;
+	/* Same layout, the previous escape time image for the escape time pass */
+	VkDescriptorSet m_PreviousEscapeTimeDescriptorSet;
+	/* Per frame in flight, recorded with the passes the frame needs */
 	std::vector<VkCommandBuffer> m_GraphicsPipelineCommandBuffers;
-	
-	/* Compute Pipeline */
-	VulkanBuffer m_ComputePipelineStorageBuffer;
 
-	VkShaderModule m_ComputeShaderModule;
-	VkDescriptorSetLayout m_ComputePipelineDescriptorSetLayout;
-	VkDescriptorPool m_ComputePipelineDescriptorPool;
-	VkDescriptorSet m_ComputePipelineStorageBufferDescriptorSet;
+	/*
+	* Async compute mode: the escape time and previous escape time images take turns as the target of
+	* the compute pass, which reprojects the other one. Both stay in the general layout
+	*/
+	VkPipeline m_EscapeTimeComputePipeline;
+	VkPipeline m_DoublePrecisionEscapeTimeComputePipeline;
+	VkPipelineLayout m_EscapeTimeComputePipelineLayout;
+	VkDescriptorSetLayout m_EscapeTimeStorageDescriptorSetLayout;
+	/* Storage image of each escape time image, set 1 of the compute pass */
+	std::array<VkDescriptorSet, 2> m_EscapeTimeStorageDescriptorSets;
+	/* Per frame in flight, from the compute command pool */
+	std::vector<VkCommandBuffer> m_ComputeCommandBuffers;
+	/* Image of the last refining pass, reprojected by the next one, and image of the last pass, colored by the graphics queue */
+	uint32_t m_EscapeTimeFront;
+	uint32_t m_ShownEscapeTime;
+	/* Fence of the last frame coloring each image, a pass waits for it before overwriting the image */
+	std::array<VkFence, 2> m_EscapeTimeReadFences;
 
-	VkPipeline m_ComputePipeline;
-	VkPipelineLayout m_ComputePipelineLayout;
-
-	VkCommandBuffer m_ComputePipelineCommandBuffer;
+	/* Escape time target (R32G32_SFLOAT continuous iteration count and pixel code, see fragmentShader.frag) */
+	VkRenderPass m_EscapeTimeRenderPass;
+	VkImage m_EscapeTimeImage;
+	VkDeviceMemory m_EscapeTimeImageMemory;
+	VkImageView m_EscapeTimeImageView;
+	VkSampler m_EscapeTimeSampler;
+	VkFramebuffer m_EscapeTimeFramebuffer;
+	/* Copy of the escape time image made after every escape time pass, read back by the next one */
+	VkImage m_PreviousEscapeTimeImage;
+	VkDeviceMemory m_PreviousEscapeTimeImageMemory;
+	VkImageView m_PreviousEscapeTimeImageView;
+	/* Camera of the last escape time pass, false until a pass filled the current target */
+	Reprojection::Camera m_PreviousEscapeTimeCamera;
+	bool m_PreviousEscapeTimeValid;
+	/* Lattice step the last escape time pass completed, 1 once every pixel is exact and 0 after a camera change */
+	uint32_t m_CompletedRefineStep;
+	/* GPU time the lattice of a pass is chosen for, halved with F5 and doubled with F6 */
+	double m_RefineBudget;
+	/* Two timestamps per frame in flight around the escape time pass, the swapchain's image count may change with every recreation. VK_NULL_HANDLE without timestamp support */
+	VkQueryPool m_EscapeTimeQueryPool;
+	/* Measured cost of an iterated pixel, 0 until a pass iterated enough of them */
+	double m_SecondsPerIteratedPixel;
+	/* Set when the view, the iteration count or the target size changed since the last escape time pass */
+	bool m_EscapeTimeOutdated;
+	/* Set when the colors changed or the window needs a new frame */
+	bool m_ColoringOutdated;
+	/* Running mean of the samples of the current view (see Accumulation.h), R32G32B32A32_SFLOAT where it blends */
+	VkFormat m_AccumulationFormat;
+	VkRenderPass m_AccumulationRenderPass;
+	VkImage m_AccumulationImage;
+	VkDeviceMemory m_AccumulationImageMemory;
+	VkImageView m_AccumulationImageView;
+	VkFramebuffer m_AccumulationFramebuffer;
+	/* Escape time layout, the accumulation image for the resolve pass */
+	VkDescriptorSet m_AccumulationDescriptorSet;
+	uint32_t m_AccumulatedSampleCount;
+	/* Toggled with F1 (cardioid), F2 (bulb) and F3 (periodicity) */
+	InteriorChecks m_InteriorChecks;
+	/* Points settled by each interior check and escape histogram of the last escape time pass, matches Counters in fragmentShader.frag. Stays mapped */
+	VulkanBuffer m_CounterBuffer;
+	uint32_t* m_Counters;
+	/* Fence of the last escape time pass whose counts were not read yet, the iteration limit it ran with and its timestamp slot */
+	VkFence m_CounterFence;
+	int32_t m_CounterIterationCount;
+	uint32_t m_CounterQuerySlot;
+	double m_LastHitRateTime;
+	/* Set by UP and DOWN or, in the automatic mode toggled with I, from the escape histogram (see AutoIteration.h) */
+	int32_t m_IterationCount;
+	bool m_AutoIterations;
+	/* Iteration limit of the next escape time pass */
+	int32_t m_EscapeTimeIterationCount;
+	/* Copy of the last escape histogram read back and its limit, H prints it */
+	std::array<uint32_t, AutoIteration::HistogramBinCount> m_EscapeHistogram;
+	int32_t m_EscapeHistogramIterationCount;
+	
+	/* Compute (offline rendering is headless and owns its own device) */
+	OfflineRenderer* m_OfflineRenderer;
 	/* Swapchain synchronization */
 	uint32_t m_ImageIndex;
 	uint32_t m_FrameIndex;
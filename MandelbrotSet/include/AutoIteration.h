@@ -0,0 +1,103 @@
+#pragma once
+#include "include/Core.h"
+#include <algorithm>
+#include <stdlib.h>
+
+/*
+* Iteration limit of the window picked from the escape histogram of the last escape time pass:
+* escaped pixels counted by escape iteration in HistogramBinCount bins spread evenly over the limit
+* the pass ran with. Deep zooms need far more iterations than shallow views, a fixed limit either
+* wastes iterations on pixels that escape early or flattens the detail of the ones that do not.
+*/
+namespace AutoIteration {
+	/* Must match HISTOGRAM_BIN_COUNT in fragmentShader.frag */
+	constexpr uint32_t HistogramBinCount = 256;
+	constexpr int32_t MinIterations = 64;
+	constexpr int32_t MaxIterations = 1 << 20;
+	/* The limit covers this share of the escaped pixels ... */
+	constexpr double Percentile = 0.999;
+	/* ... times the headroom, which keeps the percentile out of the top bins below */
+	constexpr double Headroom = 1.5;
+	/* Escaped pixels in the top eighth of the bins beyond this share mean the limit cuts the distribution off, it doubles */
+	constexpr uint32_t TopBinCount = HistogramBinCount / 8;
+	constexpr double CutOffShare = 0.002;
+	/* Every new limit reruns the escape time pass, changes below this share of the limit are ignored */
+	constexpr double Hysteresis = 0.125;
+
+	/* Next limit from the histogram of a pass with currentLimit, currentLimit if nothing escaped */
+	inline int32_t ChooseIterationLimit(const uint32_t* bins, const int32_t currentLimit)
+	{
+		uint64_t escaped = 0;
+		uint64_t top = 0;
+		for (uint32_t bin = 0; bin < HistogramBinCount; ++bin)
+		{
+			escaped += bins[bin];
+			if (bin >= HistogramBinCount - TopBinCount)
+				top += bins[bin];
+		}
+
+		if (escaped == 0)
+			return currentLimit;
+
+		double target;
+		if (static_cast<double>(top) > CutOffShare * static_cast<double>(escaped))
+		{
+			target = 2.0 * static_cast<double>(currentLimit);
+		}
+		else
+		{
+			const double percentileCount = Percentile * static_cast<double>(escaped);
+			uint64_t count = 0;
+			uint32_t bin = 0;
+			while (bin < HistogramBinCount - 1 && static_cast<double>(count += bins[bin]) < percentileCount)
+				++bin;
+
+			/* Upper edge of the bin */
+			target = Headroom * static_cast<double>(bin + 1) * static_cast<double>(currentLimit) / static_cast<double>(HistogramBinCount);
+		}
+
+		const int32_t limit = static_cast<int32_t>(std::min(std::max(target, static_cast<double>(MinIterations)), static_cast<double>(MaxIterations)));
+		return std::abs(limit - currentLimit) <= static_cast<int32_t>(Hysteresis * static_cast<double>(currentLimit)) ? currentLimit : limit;
+	}
+
+	/* One line with the escaped share and the iterations below which half and Percentile of the escaped pixels escaped */
+	inline void PrintSummary(const uint32_t* bins, const int32_t limit, const bool automatic, const double pixelCount)
+	{
+		uint64_t escaped = 0;
+		for (uint32_t bin = 0; bin < HistogramBinCount; ++bin)
+			escaped += bins[bin];
+
+		const auto findIteration = [bins, limit](const double share, const uint64_t total) {
+			uint64_t count = 0;
+			uint32_t bin = 0;
+			while (bin < HistogramBinCount - 1 && static_cast<double>(count += bins[bin]) < share * static_cast<double>(total))
+				++bin;
+
+			return static_cast<int64_t>(bin + 1) * limit / HistogramBinCount;
+		};
+
+		printf("Escape histogram: escaped %.2f%%, median %lld, %.1f%% %lld, limit %d (%s)\n",
+			pixelCount > 0.0 ? 100.0 * static_cast<double>(escaped) / pixelCount : 0.0,
+			static_cast<long long>(findIteration(0.5, escaped)),
+			100.0 * Percentile,
+			static_cast<long long>(findIteration(Percentile, escaped)),
+			limit,
+			automatic ? "auto" : "manual");
+	}
+
+	/* Every non-empty bin with its iteration range */
+	inline void PrintHistogram(const uint32_t* bins, const int32_t limit)
+	{
+		printf("Escape histogram of %u bins, limit %d:\n", HistogramBinCount, limit);
+		for (uint32_t bin = 0; bin < HistogramBinCount; ++bin)
+		{
+			if (bins[bin] == 0)
+				continue;
+
+			printf("  %8lld - %8lld: %u\n",
+				static_cast<long long>(static_cast<int64_t>(bin) * limit / HistogramBinCount),
+				static_cast<long long>(static_cast<int64_t>(bin + 1) * limit / HistogramBinCount),
+				bins[bin]);
+		}
+	}
+}
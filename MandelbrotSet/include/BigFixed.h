@@ -0,0 +1,67 @@
+#pragma once
+#include "include/Core.h"
+
+/*
+* Signed fixed-point number of arbitrary precision, the arithmetic of deep zoom reference
+* orbits (see Perturbation.h). The magnitude is stored in 32 bit limbs, least significant
+* first: the last limb is the integer part (|x| < 2^32), the ones before it the fraction.
+* Operands of one operation have the same limb count, results are truncated toward zero.
+* Products switch from schoolbook to Karatsuba multiplication at KaratsubaThreshold limbs.
+*/
+class BigFixed
+{
+public:
+	BigFixed() = default;
+	/* Zero with at least fractionBits of fraction, rounded up to whole limbs */
+	explicit BigFixed(const uint32_t fractionBits);
+
+	/* Exact as far as the fraction reaches, |value| has to be below 2^32 */
+	static BigFixed FromDouble(const double value, const uint32_t fractionBits);
+	/* Decimal text such as "-0.7453" or "1.25e-3". False if it is malformed or its integer part does not fit */
+	static bool Parse(const std::string_view text, const uint32_t fractionBits, BigFixed& value);
+
+	/* Rounded toward zero from the 96 most significant bits */
+	double ToDouble() const;
+	uint32_t GetFractionBits() const { return m_Limbs.empty() ? 0 : static_cast<uint32_t>(m_Limbs.size() - 1) * 32; }
+	bool IsNegative() const { return m_Negative; }
+
+	BigFixed operator+(const BigFixed& other) const;
+	BigFixed operator-(const BigFixed& other) const;
+	BigFixed operator-() const;
+	BigFixed operator*(const BigFixed& other) const;
+	BigFixed Square() const;
+
+	/* result = a * b, allocation free once result has the operands' limb count (the reference orbit's inner loop) */
+	static void Multiply(const BigFixed& a, const BigFixed& b, BigFixed& result);
+	/* result = a^2, cheaper than Multiply: every cross product is computed once */
+	static void Square(const BigFixed& a, BigFixed& result);
+	/* Multiply() without Karatsuba, the reference its products are checked against */
+	static void MultiplySchoolbook(const BigFixed& a, const BigFixed& b, BigFixed& result);
+
+	bool operator==(const BigFixed& other) const { return m_Negative == other.m_Negative && m_Limbs == other.m_Limbs; }
+
+	uint32_t GetLimbCount() const { return static_cast<uint32_t>(m_Limbs.size()); }
+
+	/* Limbs per operand from which Karatsuba beats schoolbook multiplication, below it the recursion stops */
+	static constexpr uint32_t KaratsubaThreshold = 32;
+private:
+	static uint32_t GetLimbCount(const uint32_t fractionBits) { return (fractionBits + 31) / 32 + 1; }
+	/* Keeps the integer limb and the upper fraction limbs of the full product of two limbCount operands */
+	static void TruncateProduct(const uint32_t* product, const std::size_t limbCount, const bool negative, BigFixed& result);
+
+	/* -1, 0 or 1 as |a| compares to |b| */
+	static int CompareMagnitudes(const BigFixed& a, const BigFixed& b);
+	/* |result| = |a| + |b| */
+	static void AddMagnitudes(const BigFixed& a, const BigFixed& b, BigFixed& result);
+	/* |result| = |larger| - |smaller|, |larger| >= |smaller| */
+	static void SubtractMagnitudes(const BigFixed& larger, const BigFixed& smaller, BigFixed& result);
+	/* a + b with b's sign flipped if negateOther */
+	static BigFixed AddSigned(const BigFixed& a, const BigFixed& b, const bool negateOther);
+
+	/* Divides the magnitude by a small divisor, the parser's digit accumulation */
+	void DivideMagnitude(const uint32_t divisor);
+	bool IsZero() const;
+private:
+	std::vector<uint32_t> m_Limbs;
+	bool m_Negative = false;
+};
@@ -0,0 +1,111 @@
+#pragma once
+#include "include/Core.h"
+#include <math.h>
+
+/* Cosine palettes, http://iquilezles.org/www/articles/palettes/palettes.htm */
+enum class EPalette : uint32_t
+{
+	Twilight = 0,	/* The palette computeShader.comp bakes into its RGBA8 and float output */
+	Rainbow,
+	Fire,
+	Ocean,
+	Grayscale,
+	Count
+};
+
+/* color(t) = D + E * cos(2pi * (F * t + G)) per channel, the w components are padding for std140 */
+struct CosinePaletteCoefficients
+{
+	float D[4];
+	float E[4];
+	float F[4];
+	float G[4];
+};
+
+/*
+* Maps an escape time (continuous iteration count) to the palette. Applied after the escape
+* time is computed, so changing it never reruns the iteration.
+*/
+struct ColoringSettings
+{
+	EPalette Palette = EPalette::Twilight;
+	/* Palette periods per MaxIterations, larger values repeat the gradient more often */
+	float Scale = 1.0f;
+	/* Shifts the palette, palette cycling animates this */
+	float Offset = 0.0f;
+};
+
+namespace Coloring {
+	inline const CosinePaletteCoefficients& GetCoefficients(const EPalette palette)
+	{
+		static const CosinePaletteCoefficients coefficients[static_cast<uint32_t>(EPalette::Count)] = {
+			{ { 0.3f, 0.3f, 0.5f, 0.0f }, { -0.2f, -0.3f, -0.5f, 0.0f }, { 2.1f, 2.0f, 3.0f, 0.0f }, { 0.0f, 0.1f, 0.0f, 0.0f } },
+			{ { 0.5f, 0.5f, 0.5f, 0.0f }, { 0.5f, 0.5f, 0.5f, 0.0f }, { 1.0f, 1.0f, 1.0f, 0.0f }, { 0.0f, 0.33f, 0.67f, 0.0f } },
+			{ { 0.5f, 0.5f, 0.5f, 0.0f }, { 0.5f, 0.5f, 0.5f, 0.0f }, { 1.0f, 1.0f, 0.5f, 0.0f }, { 0.8f, 0.9f, 0.3f, 0.0f } },
+			{ { 0.5f, 0.5f, 0.5f, 0.0f }, { 0.5f, 0.5f, 0.5f, 0.0f }, { 1.0f, 0.7f, 0.4f, 0.0f }, { 0.0f, 0.15f, 0.2f, 0.0f } },
+			{ { 0.5f, 0.5f, 0.5f, 0.0f }, { -0.5f, -0.5f, -0.5f, 0.0f }, { 1.0f, 1.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 0.0f } }
+		};
+
+		return coefficients[static_cast<uint32_t>(palette) < static_cast<uint32_t>(EPalette::Count) ? static_cast<uint32_t>(palette) : 0];
+	}
+
+	inline const char* GetPaletteName(const EPalette palette)
+	{
+		switch (palette)
+		{
+			case EPalette::Twilight: return "twilight";
+			case EPalette::Rainbow: return "rainbow";
+			case EPalette::Fire: return "fire";
+			case EPalette::Ocean: return "ocean";
+			case EPalette::Grayscale: return "grayscale";
+			default: return "unknown";
+		}
+	}
+
+	inline bool ParsePalette(const std::string_view name, EPalette& palette)
+	{
+		for (uint32_t i = 0; i < static_cast<uint32_t>(EPalette::Count); ++i)
+			if (name == GetPaletteName(static_cast<EPalette>(i)))
+			{
+				palette = static_cast<EPalette>(i);
+				return true;
+			}
+
+		return false;
+	}
+
+	/* Palette position of an escape time, points inside the set (value >= maxIterations) ignore scale and offset */
+	inline float MapEscapeTime(const float value, const float maxIterations, const ColoringSettings& settings)
+	{
+		return value < maxIterations ? value / maxIterations * settings.Scale + settings.Offset : 1.0f;
+	}
+
+	/* Unclamped linear color with alpha 1, what computeShader.comp stores for EOutputFormat::LinearFloat */
+	inline void PaletteLinear(const CosinePaletteCoefficients& coefficients, const float t, float* rgba)
+	{
+		for (uint32_t channel = 0; channel < 3; ++channel)
+			rgba[channel] = coefficients.D[channel] + coefficients.E[channel] * cosf(6.28318f * (coefficients.F[channel] * t + coefficients.G[channel]));
+
+		rgba[3] = 1.0f;
+	}
+
+	/* Clamped and rounded like packUnorm4x8 */
+	inline void Palette(const CosinePaletteCoefficients& coefficients, const float t, uint8_t* rgba)
+	{
+		float linear[4];
+		PaletteLinear(coefficients, t, linear);
+		for (uint32_t channel = 0; channel < 3; ++channel)
+		{
+			const float value = linear[channel] < 0.0f ? 0.0f : linear[channel] > 1.0f ? 1.0f : linear[channel];
+			rgba[channel] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+		}
+
+		rgba[3] = 255;
+	}
+
+	/* Same palette as computeShader.comp */
+	inline void CosinePalette(const float t, uint8_t* rgba)
+	{
+		Palette(GetCoefficients(EPalette::Twilight), t, rgba);
+	}
+}
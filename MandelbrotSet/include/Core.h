@@ -2,9 +2,13 @@
 #define INTERNALSCOPE static
 #define APP_CLAMP(value, min, max) (value < min) ? min : (value > max) ? max : value;
 /* Win32 */
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 /* STD */
 #include <assert.h>
+#include <stdio.h>
+#include <string.h>
 #include <string>
 #include <stdint.h>
 #include <functional>
@@ -0,0 +1,120 @@
+#pragma once
+#include "include/Core.h"
+#include "include/Simd.h"
+#include "include/InteriorChecks.h"
+
+/*
+* Compile-time switches of the kernel family. Every combination of the enabled parameters
+* is instantiated (four SIMD levels on x64 times two colorings times the rest), so they are
+* the way to trade variants for build time and binary size. The float32 power 2 kernels of
+* the CPU renderer are always compiled.
+*/
+#ifndef APP_ESCAPE_TIME_DOUBLE
+	/* Also instantiates the double precision kernels */
+	#define APP_ESCAPE_TIME_DOUBLE 1
+#endif
+
+#ifndef APP_ESCAPE_TIME_MAX_POWER
+	/* Exponents 2 to APP_ESCAPE_TIME_MAX_POWER of z^p + c */
+	#define APP_ESCAPE_TIME_MAX_POWER 4
+#endif
+
+#ifndef APP_ESCAPE_TIME_CHECK_VARIANTS
+	/* 1 instantiates every subset of the interior checks, 0 only none and all of them */
+	#define APP_ESCAPE_TIME_CHECK_VARIANTS 1
+#endif
+
+/* Viewport of one render in the shader's float32 precision, see PixelToComplex in computeShader.comp */
+struct KernelViewport
+{
+	float CenterX;
+	float CenterY;
+	/* Horizontal extent, the vertical one follows Height / Width */
+	float Scale;
+	uint32_t Width;
+	uint32_t Height;
+};
+
+/* Selects one variant of the family, everything in it is a template parameter of the kernel */
+struct EscapeTimeKernelKey
+{
+	bool DoublePrecision = false;
+	/* Exponent of z^p + c */
+	uint32_t Power = 2;
+	/* Continuous iteration count (escape radius 256) instead of the escape iteration (radius 2) */
+	bool Smooth = true;
+	/* InteriorChecks::GetFlags(). The cardioid and bulb tests only exist for power 2 and are ignored otherwise */
+	uint32_t InteriorCheckFlags = 7;
+	ESimdLevel Level = ESimdLevel::Scalar;
+};
+
+/* Everything that changes per call without selecting another variant */
+struct EscapeTimeParameters
+{
+	double CenterX = -0.445;
+	double CenterY = 0.0;
+	/* Horizontal extent, the vertical one follows Height / Width */
+	double Scale = 2.68;
+	uint32_t Width = 1024;
+	uint32_t Height = 768;
+	uint32_t MaxIterations = 1000;
+	float PeriodicityTolerance = 1.0e-6f;
+};
+
+/*
+* Escape time of count pixels of row y starting at column x: escapeTimes receives the continuous
+* iteration count (smooth) or the escape iteration, MaxIterations inside the set. Returns the
+* number of iterations executed.
+*/
+using EscapeTimeKernel = uint64_t(*)(
+	const EscapeTimeParameters& parameters, const uint32_t x, const uint32_t y, const uint32_t count,
+	float* escapeTimes, InteriorCheckCounts& counts);
+
+/*
+* Escape time kernels for the CPU renderer. They do the float32 math of Iterate() in
+* computeShader.comp in the same order and without fused multiply-add, interior checks
+* included, so every SIMD level matches the scalar reference bit for bit.
+*
+* All of them share one loop body templated on precision, power, interior checks and SIMD
+* width, so none of them branches on those per pixel. The renderer's float32 power 2 kernels
+* and the family of EscapeTimeKernelKey (which adds float64, higher powers and smooth coloring)
+* are indexed in dispatch tables generated from the template parameters at compile time.
+*/
+namespace CpuKernels {
+	/* Point of the pixel column or row, rounded like the shader */
+	float PixelToReal(const KernelViewport& viewport, const uint32_t x);
+	float PixelToImaginary(const KernelViewport& viewport, const uint32_t y);
+
+	/*
+	* Iterates count points c = reals[i] + imaginaries[i] i. iterations receives the escape iteration
+	* (maxIterations inside the set) and magnitudes |z|^2 of the first point outside the escape radius
+	* (0 inside the set). Points settled by the interior checks are added to counts. Returns the
+	* number of iterations executed.
+	*/
+	uint64_t IteratePoints(
+		const float* reals, const float* imaginaries, const uint32_t count,
+		const uint32_t maxIterations, const float escapeRadiusSquared, const InteriorChecks& checks,
+		uint32_t* iterations, float* magnitudes, InteriorCheckCounts& counts, const ESimdLevel level);
+	/* IteratePoints() over count pixels of row y starting at column x */
+	uint64_t IterateRow(
+		const KernelViewport& viewport, const uint32_t x, const uint32_t y, const uint32_t count,
+		const uint32_t maxIterations, const float escapeRadiusSquared, const InteriorChecks& checks,
+		uint32_t* iterations, float* magnitudes, InteriorCheckCounts& counts, const ESimdLevel level);
+	/* Scalar reference, one pixel at a time */
+	uint64_t IterateRowReference(
+		const KernelViewport& viewport, const uint32_t x, const uint32_t y, const uint32_t count,
+		const uint32_t maxIterations, const float escapeRadiusSquared, const InteriorChecks& checks,
+		uint32_t* iterations, float* magnitudes, InteriorCheckCounts& counts);
+
+	/* Pixels iterated together by the kernel of the level */
+	uint32_t GetLaneCount(const ESimdLevel level);
+
+	/* nullptr if the variant is not compiled in (see the switches above) or the CPU lacks its level */
+	EscapeTimeKernel Find(const EscapeTimeKernelKey& key);
+	/* Distinct compiled variants, for benchmarks: keys of the same kernel (power 3 with and without the cardioid test) are listed once */
+	std::vector<EscapeTimeKernelKey> GetVariants();
+	/* Such as "f32 p2 smooth cbp avx2", lowercase check letters are the enabled checks */
+	std::string GetVariantName(const EscapeTimeKernelKey& key);
+	/* Pixels iterated together by the variant */
+	uint32_t GetLaneCount(const EscapeTimeKernelKey& key);
+}
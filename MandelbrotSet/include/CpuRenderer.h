@@ -0,0 +1,100 @@
+#pragma once
+#include "include/Core.h"
+#include "include/Simd.h"
+#include "include/InteriorChecks.h"
+#include <atomic>
+
+class ThreadPool;
+struct OfflineRenderSettings;
+struct TileRegion;
+struct PerturbationView;
+struct ReferenceOrbit;
+struct SeriesApproximation;
+
+/*
+* Mariani-Silver subdivision: a rectangle whose border has a single escape iteration is filled
+* with it instead of iterated, otherwise it is split in two along its longer side. This holds
+* because the set and its escape time bands are connected, what it can miss are filaments
+* narrower than a pixel that slip between border samples. Margin rings guard against those.
+*/
+struct SubdivisionSettings
+{
+	bool Enabled = false;
+	/* Rectangles whose longer inner side is at most this many pixels are iterated pixel by pixel */
+	uint32_t MinEdge = 8;
+	/* Splits below the tile, deeper rectangles are iterated pixel by pixel */
+	uint32_t MaxDepth = 16;
+	/* Rings inside the border that have to match it as well before a rectangle is filled */
+	uint32_t Margin = 0;
+};
+
+/*
+* Renders on the CPU with the kernels in CpuKernels.h. A tile comes out exactly as
+* computeShader.comp stores it (same output formats, same layout), so the OfflineRenderer
+* post-processes it the same way. It renders when no vulkan device is available and serves
+* as the golden reference the device output is checked against.
+*
+* Regions are split into square tiles that the thread pool balances by work stealing. The
+* tile edge adapts to the cost measured per tile: dense tiles (inside the set) make the next
+* tiles smaller so no single tile holds up the others, cheap ones make them larger.
+* With SubdivisionSettings::Enabled each tile is subdivided, filled pixels count as skipped.
+* RenderPerturbationTile iterates deep zoom tiles against a reference orbit (see Perturbation.h)
+* and CorrectGlitches renders the pixels that glitched again against references closer to them.
+*/
+class CpuRenderer
+{
+public:
+	explicit CpuRenderer(ThreadPool& threadPool);
+
+	/* Capped at Simd::GetSupportedLevel() */
+	void SetSimdLevel(const ESimdLevel level);
+	ESimdLevel GetSimdLevel() const { return m_SimdLevel; }
+
+	/* Renders region of the image described by settings into tile, whose rows are tileWidth pixels apart */
+	void RenderTile(const OfflineRenderSettings& settings, const TileRegion& region, void* tile, const uint32_t tileWidth);
+
+	/*
+	* Deep zoom (see Perturbation.h): iterates every pixel of region against reference in double precision,
+	* as perturbationShader.comp does, starting after series if it is not null. Glitched pixels are appended
+	* to glitchedPixels as tile pixel indices.
+	*/
+	void RenderPerturbationTile(
+		const OfflineRenderSettings& settings, const PerturbationView& view, const ReferenceOrbit& reference, const SeriesApproximation* series,
+		const TileRegion& region, void* tile, const uint32_t tileWidth, std::vector<uint32_t>& glitchedPixels);
+	/*
+	* Iterates glitchedPixels of a tile again, against each of references and then against new references
+	* placed on the glitched pixels, which are appended. Pixels that glitch against every one of them stay
+	* in glitchedPixels with the result of the last attempt.
+	*/
+	void CorrectGlitches(
+		const OfflineRenderSettings& settings, const PerturbationView& view, const TileRegion& region, void* tile, const uint32_t tileWidth,
+		std::vector<uint32_t>& glitchedPixels, std::vector<ReferenceOrbit>& references);
+
+	/* Iterations executed since the last reset, the throughput measure */
+	uint64_t GetIterationCount() const { return m_IterationCount.load(); }
+	/* Pixels filled by subdivision without iterating since the last reset */
+	uint64_t GetSkippedPixelCount() const { return m_SkippedPixelCount.load(); }
+	/* Points settled by each interior check since the last reset */
+	InteriorCheckCounts GetCheckCounts() const;
+	void ResetCounters();
+
+	/* Edge of the tiles the next RenderTile() uses without subdivision */
+	uint32_t GetTileEdge() const { return m_TileEdge; }
+private:
+	/* Picks the next tile edge from the densest tile of the last region */
+	void AdaptTileEdge(const std::vector<double>& tileSeconds, const std::vector<uint32_t>& tilePixelCounts, const uint64_t regionPixelCount);
+	/* Largest tile that still leaves enough tiles per thread to balance */
+	double GetBalancedTilePixelCount(const uint64_t regionPixelCount) const;
+	/* Square edge of a tile of tilePixelCount pixels, within the edge limits and granularity */
+	static uint32_t RoundTileEdge(const double tilePixelCount);
+	void AddCheckCounts(const InteriorCheckCounts& counts);
+private:
+	ThreadPool& m_ThreadPool;
+	ESimdLevel m_SimdLevel;
+	std::atomic<uint64_t> m_IterationCount;
+	std::atomic<uint64_t> m_SkippedPixelCount;
+	std::atomic<uint64_t> m_CardioidCount;
+	std::atomic<uint64_t> m_BulbCount;
+	std::atomic<uint64_t> m_PeriodicityCount;
+	uint32_t m_TileEdge;
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include "include/Core.h"
+
+/*
+* Raw escape time buffer of a render: a fixed-size header followed by float16 continuous
+* iteration counts in row order, exactly what EOutputFormat::SmoothIterations reads back.
+* Recoloring a saved buffer (palette, scale, offset) needs no GPU and no iteration.
+*/
+namespace EscapeTime {
+	struct FileHeader
+	{
+		char Magic[8];
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t MaxIterations;
+		uint32_t Reserved;
+	};
+
+	constexpr char FileMagic[8] = { 'M', 'B', 'E', 'S', 'C', 'A', 'P', '1' };
+}
+
+/* Tiles are written in place with a seek, like PamImageWriter, so memory does not depend on the image size */
+class EscapeTimeWriter
+{
+public:
+	bool Open(const std::string& filepath, const uint32_t width, const uint32_t height, const uint32_t maxIterations);
+	/* rowPitch is the distance in bytes between two rows of the tile */
+	bool WriteTile(const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, const uint16_t* values, const std::size_t rowPitch);
+	bool Close();
+
+	bool IsOpen() const { return m_File.is_open(); }
+private:
+	std::ofstream m_File;
+	uint32_t m_Width = 0;
+};
+
+class EscapeTimeReader
+{
+public:
+	bool Open(const std::string& filepath);
+	/* Reads rowCount full-width rows starting at row y */
+	bool ReadRows(const uint32_t y, const uint32_t rowCount, uint16_t* values);
+
+	uint32_t GetWidth() const { return m_Header.Width; }
+	uint32_t GetHeight() const { return m_Header.Height; }
+	uint32_t GetMaxIterations() const { return m_Header.MaxIterations; }
+private:
+	std::ifstream m_File;
+	EscapeTime::FileHeader m_Header = {};
+};
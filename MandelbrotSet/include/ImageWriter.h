@@ -0,0 +1,101 @@
+#pragma once
+#include "include/Core.h"
+#include "include/PngEncoder.h"
+#include "include/ThreadPool.h"
+#include <map>
+#include <memory>
+
+/*
+* Destination of an offline render. Tiles arrive as RGBA8 rectangles in any order,
+* so writers that do not have to keep the whole image can stay bounded in memory.
+*/
+class ImageWriter
+{
+public:
+	virtual ~ImageWriter() = default;
+
+	virtual bool Open(const std::string& filepath, const uint32_t width, const uint32_t height) = 0;
+	/* rowPitch is the distance in bytes between two rows of the tile */
+	virtual bool WriteTile(const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, const uint8_t* pixels, const std::size_t rowPitch) = 0;
+	virtual bool Close() = 0;
+
+	/* Largest tile height that keeps the writer's memory bounded, 0 if any height is fine. Valid after Open() */
+	virtual uint32_t GetMaxTileHeight() const { return 0; }
+
+	/* Picks the writer from the file extension (.pam, otherwise .png). PNG encoding runs on threadPool */
+	static std::unique_ptr<ImageWriter> Create(const std::string& filepath, ThreadPool& threadPool);
+};
+
+/*
+* Streams the image into the file band by band: a band of full-width rows is encoded and written
+* as soon as tiles covered all of it (see Png::StreamEncoder). Tiles of a later band may arrive
+* first, but memory stays bounded only when tiles come roughly in row order and are at most
+* GetMaxTileHeight() rows tall, which is what the offline renderer does.
+*/
+class PngImageWriter : public ImageWriter
+{
+public:
+	/* Stripes are compressed on threadPool, which has to outlive the writer */
+	explicit PngImageWriter(ThreadPool& threadPool);
+
+	bool Open(const std::string& filepath, const uint32_t width, const uint32_t height) override;
+	bool WriteTile(const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, const uint8_t* pixels, const std::size_t rowPitch) override;
+	bool Close() override;
+
+	uint32_t GetMaxTileHeight() const override;
+private:
+	struct Band
+	{
+		std::vector<uint8_t> Pixels;
+		uint64_t WrittenPixelCount = 0;
+	};
+
+	/* Encodes and writes every complete band at the front of the image */
+	bool FlushBands();
+private:
+	std::ofstream m_File;
+	uint32_t m_Width = 0;
+	uint32_t m_Height = 0;
+	uint32_t m_BandHeight = 0;
+	uint32_t m_NextBand = 0;
+	std::map<uint32_t, Band> m_Bands;
+
+	Png::StreamEncoder m_Encoder;
+	std::vector<uint8_t> m_EncodedData;
+};
+
+/*
+* Netpbm PAM (RGB_ALPHA), uncompressed with a fixed-size header, so every tile row
+* is written in place with a seek. Memory use does not depend on the image size.
+*/
+class PamImageWriter : public ImageWriter
+{
+public:
+	bool Open(const std::string& filepath, const uint32_t width, const uint32_t height) override;
+	bool WriteTile(const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, const uint8_t* pixels, const std::size_t rowPitch) override;
+	bool Close() override;
+private:
+	std::ofstream m_File;
+	uint32_t m_Width = 0;
+	uint32_t m_Height = 0;
+	uint64_t m_HeaderSize = 0;
+};
+
+/* Keeps the whole image in host memory for callers that process it further (zoom sequence keyframes) */
+class MemoryImageWriter : public ImageWriter
+{
+public:
+	/* The path only labels the image */
+	bool Open(const std::string& filepath, const uint32_t width, const uint32_t height) override;
+	bool WriteTile(const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, const uint8_t* pixels, const std::size_t rowPitch) override;
+	bool Close() override { return true; }
+
+	uint32_t GetWidth() const { return m_Width; }
+	uint32_t GetHeight() const { return m_Height; }
+	/* Tightly packed RGBA8 rows */
+	std::vector<uint8_t>& GetPixels() { return m_Pixels; }
+private:
+	uint32_t m_Width = 0;
+	uint32_t m_Height = 0;
+	std::vector<uint8_t> m_Pixels;
+};
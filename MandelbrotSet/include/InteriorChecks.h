@@ -0,0 +1,48 @@
+#pragma once
+#include "include/Core.h"
+
+/*
+* Interior shortcuts, each settles points inside the set without iterating them to the limit.
+* The CPU kernels, computeShader.comp and fragmentShader.frag run the same tests in the same
+* float order, so they can be switched off one by one to compare.
+*/
+struct InteriorChecks
+{
+	/* Analytic test for the main cardioid, q (q + x - 1/4) <= y^2 / 4 with q = (x - 1/4)^2 + y^2 */
+	bool Cardioid = true;
+	/* Analytic test for the period-2 bulb, (x + 1)^2 + y^2 <= 1/16 */
+	bool Bulb = true;
+	/* Brent's cycle detection: z is saved at iterations 1, 2, 4, 8, ..., an orbit that comes back within the tolerance is periodic */
+	bool Periodicity = true;
+	/* Distance to the saved point that counts as a repeat, too large a tolerance turns slowly escaping points into interior */
+	float PeriodicityTolerance = 1.0e-6f;
+
+	/* Bit 0 cardioid, bit 1 bulb, bit 2 periodicity, as the shaders test them */
+	uint32_t GetFlags() const { return (Cardioid ? 1u : 0u) | (Bulb ? 2u : 0u) | (Periodicity ? 4u : 0u); }
+};
+
+/* Points settled by each check */
+struct InteriorCheckCounts
+{
+	uint64_t Cardioid = 0;
+	uint64_t Bulb = 0;
+	uint64_t Periodicity = 0;
+};
+
+namespace InteriorCheck {
+	/* One line with the share of pixels each enabled check settled */
+	inline void PrintHitRates(const InteriorChecks& checks, const InteriorCheckCounts& counts, const double pixelCount)
+	{
+		const auto print = [pixelCount](const char* name, const bool enabled, const uint64_t count, const char* separator) {
+			if (enabled)
+				printf("%s %.2f%%%s", name, pixelCount > 0.0 ? 100.0 * static_cast<double>(count) / pixelCount : 0.0, separator);
+			else
+				printf("%s off%s", name, separator);
+		};
+
+		printf("Interior checks (share of pixels): ");
+		print("cardioid", checks.Cardioid, counts.Cardioid, ", ");
+		print("bulb", checks.Bulb, counts.Bulb, ", ");
+		print("periodicity", checks.Periodicity, counts.Periodicity, "\n");
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "include/Core.h"
+
+/*
+* A whole file mapped into memory, a Win32 file mapping or mmap. Reading goes straight to the page
+* cache without an intermediate copy, writing leaves the flushing to the operating system.
+*/
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/* Maps an existing, non-empty file read-only */
+	bool OpenForReading(const std::string& filepath);
+	/* Creates or truncates the file to size bytes and maps it writable */
+	bool Create(const std::string& filepath, const uint64_t size);
+	/* Unmaps the file and schedules written pages for writeback, false if that failed */
+	bool Close();
+
+	bool IsOpen() const { return m_Data != nullptr; }
+	const uint8_t* GetData() const { return m_Data; }
+	/* Only valid for files opened with Create */
+	uint8_t* GetWritableData() { return m_Writable ? m_Data : nullptr; }
+	uint64_t GetSize() const { return m_Size; }
+private:
+	bool Map(const uint64_t size, const bool writable);
+private:
+	uint8_t* m_Data = nullptr;
+	uint64_t m_Size = 0;
+	bool m_Writable = false;
+#ifdef _WIN32
+	HANDLE m_File = INVALID_HANDLE_VALUE;
+	HANDLE m_Mapping = nullptr;
+#else
+	int m_File = -1;
+#endif
+};
@@ -0,0 +1,384 @@
+#pragma once
+#include "include/Core.h"
+#include "include/VulkanTypes.h"
+#include "include/PostProcess.h"
+#include "include/ThreadPool.h"
+#include "include/EscapeTimeFile.h"
+#include "include/CpuRenderer.h"
+#include "include/Perturbation.h"
+#include <map>
+#include <tuple>
+
+class ImageWriter;
+
+/* What the compute shader stores per pixel, must match OUTPUT_FORMAT in computeShader.comp */
+enum class EOutputFormat : uint32_t
+{
+	RGBA8 = 0,				/* Colored on the GPU with packUnorm4x8, written out without conversion */
+	Iterations = 1,			/* uint32 escape iteration, colored on the CPU */
+	SmoothIterations = 2,	/* float16 continuous iteration count, colored on the CPU */
+	LinearFloat = 3			/* float32 linear RGBA colored on the GPU, quantized on the CPU (gamma, dithering) */
+};
+
+/*
+* Arithmetic of the compute shader, computeShader.spv or computeShaderDoublePrecision.spv. Perturbation
+* renders pick the precision of their deltas by depth instead, unless Double is requested.
+*/
+enum class EShaderPrecision : uint32_t
+{
+	Auto = 0,		/* Double when the device has shaderFloat64 and float32 cannot resolve the pixel spacing */
+	Single = 1,
+	Double = 2		/* Falls back to single without shaderFloat64 */
+};
+
+/* Deep zoom rendering against a high-precision reference orbit, see Perturbation.h */
+enum class EPerturbation : uint32_t
+{
+	Auto = 0,		/* Once double precision cannot resolve the pixel spacing */
+	Off = 1,
+	On = 2
+};
+
+/* Describes a single offline (compute) render. Defaults reproduce the original hardcoded compute shader view. */
+struct OfflineRenderSettings
+{
+	uint32_t Width = 3200 * 2;
+	uint32_t Height = 2400 * 2;
+	uint32_t MaxIterations = 10000;
+	/* Viewport in the complex plane. Scale is the horizontal extent, the vertical one follows the aspect ratio */
+	double CenterX = -0.445;
+	double CenterY = 0.0;
+	double Scale = 2.0 + 1.7 * 0.2;
+	/* Decimal text of the center for perturbation renders, which need more digits than CenterX/CenterY hold. Empty uses those */
+	std::string PreciseCenterX;
+	std::string PreciseCenterY;
+	std::string OutputPath = "mandelbrot.png";
+	std::string ShaderDirectory = "assets/shaders/";
+	/* Optional on-disk VkPipelineCache, lets separate runs skip shader compilation. Empty disables it */
+	std::string PipelineCachePath;
+	/* Optional directory of main reference orbits (see OrbitCache.h), renders of a known location skip computing it. Empty disables it */
+	std::string OrbitCacheDirectory;
+	/* Edge length of the square tiles the image is rendered in. 0 derives it from the device memory budget */
+	uint32_t TileSize = 0;
+	EOutputFormat OutputFormat = EOutputFormat::RGBA8;
+	/* Only used by EOutputFormat::LinearFloat */
+	ConversionSettings Conversion;
+	/* Palette of the formats colored on the CPU (Iterations, SmoothIterations) and of recoloring */
+	ColoringSettings Coloring;
+	/* Also stores the escape time buffer here (requires EOutputFormat::SmoothIterations). Empty disables it */
+	std::string EscapeTimePath;
+	/* Colors a saved escape time buffer into OutputPath instead of rendering, needs no device. Size and iterations come from the file */
+	std::string RecolorPath;
+	/* Zoom video (see ZoomSequence.h): frame count, 0 renders a single image. OutputPath is then a printf pattern such as frame_%05d.png */
+	uint32_t ZoomFrameCount = 0;
+	/* Horizontal extent of the last frame, the first frame uses Scale */
+	double ZoomFinalScale = 0.0;
+	/* Renders with the CPU kernels instead of the device, which is also what happens when no suitable device exists */
+	bool RenderOnCpu = false;
+	/* Renders every device tile on the CPU as well and reports the pixels that differ from this reference */
+	bool VerifyWithCpu = false;
+	/* Highest instruction set of the CPU kernels and post-processing, capped at what the CPU supports */
+	ESimdLevel SimdLevel = ESimdLevel::AVX512;
+	/* Mariani-Silver subdivision of CPU renders, never used for the --verify-cpu reference */
+	SubdivisionSettings Subdivision;
+	/* Interior shortcuts of the compute shader and the CPU kernels */
+	InteriorChecks Interior;
+	/* Device renders only, the CPU kernels are float32 */
+	EShaderPrecision Precision = EShaderPrecision::Auto;
+	/* Interior checks do not apply to perturbation renders, the CPU renders them in double precision */
+	EPerturbation Perturbation = EPerturbation::Auto;
+	/* Perturbation renders start every pixel after the series approximation of the main reference */
+	bool Series = true;
+};
+
+/* Everything baked into a compute pipeline variant through specialization constants */
+struct ComputePipelineKey
+{
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t MaxIterations;
+	uint32_t TileWidth;
+	uint32_t TileHeight;
+	EOutputFormat OutputFormat;
+	/* InteriorChecks::GetFlags() */
+	uint32_t InteriorCheckFlags;
+	float PeriodicityTolerance;
+	/* Both pick the shader module rather than a specialization constant */
+	bool DoublePrecision;
+	bool Perturbation;
+
+	bool operator<(const ComputePipelineKey& other) const
+	{
+		return std::tie(Width, Height, MaxIterations, TileWidth, TileHeight, OutputFormat, InteriorCheckFlags, PeriodicityTolerance, DoublePrecision, Perturbation) <
+			std::tie(other.Width, other.Height, other.MaxIterations, other.TileWidth, other.TileHeight, other.OutputFormat, other.InteriorCheckFlags, other.PeriodicityTolerance, other.DoublePrecision, other.Perturbation);
+	}
+};
+
+/* Rectangle of the output image covered by one dispatch */
+struct TileRegion
+{
+	uint32_t X = 0;
+	uint32_t Y = 0;
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+};
+
+/*
+* Headless compute renderer. Creates only the instance, device and compute pipeline,
+* so it runs without a window or surface (e.g. on lavapipe on a headless node).
+* The image is rendered in tiles through a fixed set of reusable buffers, so device
+* memory does not grow with the image size.
+*
+* Tiles move through three stages that overlap: the compute queue renders tile N+1
+* into device-local memory while the transfer queue copies tile N into a host-cached
+* readback ring and the CPU writes out tile N-1. Stages are ordered with two timeline
+* semaphores whose values are the global tile number + 1.
+*
+* Without a device (or with RenderOnCpu) the same tiles are rendered by the CpuRenderer.
+*
+* Deep zooms render with perturbationShader.comp against a reference orbit the CPU iterates in
+* BigFixed. The shader flags glitched pixels in a bitmask behind the tile, and the CPU iterates
+* them again against new references before the tile is written out.
+*/
+class OfflineRenderer
+{
+public:
+	explicit OfflineRenderer(const OfflineRenderSettings& settings);
+	~OfflineRenderer();
+
+	bool Initialize();
+	bool Render();
+	/* Switches to another job on the same device, pipeline variants are reused across jobs */
+	bool Render(const OfflineRenderSettings& settings);
+	/* Same, into a caller-provided writer instead of OutputPath (which only labels the output). Ignores RecolorPath */
+	bool Render(const OfflineRenderSettings& settings, ImageWriter& writer);
+	bool Shutdown();
+
+	const OfflineRenderSettings& GetSettings() const { return m_Settings; }
+	/* The device has shaderFloat64 and computeShaderDoublePrecision.spv loaded */
+	bool SupportsDoublePrecision() const { return m_DoublePrecisionComputeShaderModule != VK_NULL_HANDLE; }
+private:
+	bool CreateInstance();
+	bool CreateLogicalDevice();
+	bool CreateComputePipelineLayout();
+	bool AllocateCommandBuffers();
+	bool CreateSynchronizationObjects();
+	bool CreateTileBuffers(const VkDeviceSize size);
+	/* Interior check hit counters, shared by every compute slot */
+	bool CreateCheckCountBuffer();
+	void DestroyTileBuffers();
+	bool CreateBuffer(const VkDeviceSize size, const VkBufferUsageFlags usage, const VkMemoryPropertyFlags memoryPropertyFlags, const bool sharedWithTransferQueue, VulkanBuffer& buffer) const;
+	void DestroyBuffer(VulkanBuffer& buffer) const;
+
+	bool SubmitCompute(const uint64_t tileNumber, const TileRegion& region, VkPipeline pipeline);
+	bool SubmitReadback(const uint64_t tileNumber, const TileRegion& region);
+	bool WaitForTimeline(VkSemaphore timeline, const uint64_t value);
+
+	/* Largest square tile (multiple of the workgroup size) that fits the device limits and memory budget */
+	uint32_t ChooseTileSize(const std::size_t pixelSize) const;
+	/* ownUsage is subtracted from the reported usage, those buffers are about to be replaced */
+	VkDeviceSize QueryAvailableMemory(const uint32_t memoryTypeIndex, const VkDeviceSize ownUsage) const;
+
+	/* Resolves EShaderPrecision for the current settings and device, for perturbation renders the precision of the deltas */
+	bool UseDoublePrecision() const;
+	/* Resolves EPerturbation for the current settings */
+	bool UsePerturbation() const;
+	VkShaderModule GetShaderModule(const bool perturbation, const bool doublePrecision) const;
+	/* Returns the cached variant for the key, compiling it on first use */
+	VkPipeline GetComputePipeline(const ComputePipelineKey& key);
+	void LoadPipelineCache();
+	void SavePipelineCache() const;
+
+	bool RenderImage(ImageWriter& writer);
+	/* Renders full-width bands with the CpuRenderer, needs no device */
+	bool RenderImageOnCpu(ImageWriter& writer);
+	/* Closes the writer and the escape time file, if open, after a render failed */
+	void CloseWriters(ImageWriter& writer);
+	/* Deferred coloring of RecolorPath, runs on the CPU only */
+	bool Recolor();
+
+	/* Parses the center and computes the main reference, unless the last render left one that still fits */
+	bool PreparePerturbation();
+	/* Fits m_Series to the current scale, which zoom sequences change while the reference stays */
+	void PrepareSeries();
+	/* Copies the main reference into the orbit buffer in the precision of the shader, growing the buffer if needed */
+	bool UploadReferenceOrbit(const bool doublePrecision);
+	/* Iterates m_GlitchedPixels of the tile again against other references, see CpuRenderer::CorrectGlitches */
+	void CorrectGlitches(void* tile, const TileRegion& region);
+	void PrintPerturbationStatistics(const double pixelCount) const;
+
+	/* Waits for the readback of the tile and hands it to the writer */
+	bool ConsumeTile(const uint64_t tileNumber, ImageWriter& writer);
+
+	/* Readback memory prefers HOST_CACHED (fast CPU reads), falls back to HOST_COHERENT */
+	VkMemoryPropertyFlags GetReadbackMemoryPropertyFlags() const;
+	bool HasMemoryType(const uint32_t memoryTypeBits, const VkMemoryPropertyFlags memoryPropertyFlags) const;
+
+	VkShaderModule CreateShaderModule(const std::string_view filepath) const;
+	uint32_t RetrieveMemoryTypeIndex(const uint32_t memoryTypeBits, const VkMemoryPropertyFlags memoryPropertyFlags) const;
+private:
+	/* Matches the push constant block in computeShader.comp and perturbationShader.comp */
+	struct PushConstants
+	{
+		float CenterX;
+		float CenterY;
+		uint32_t TileOffsetX;
+		uint32_t TileOffsetY;
+		float Scale;
+		/* Only read by perturbationShader.comp: the index of the last reference point and the series approximation */
+		uint32_t ReferenceLength;
+		uint32_t SkipIterations;
+		float InverseSeriesRadius;
+	};
+
+	/* Matches the push constant block of the DoublePrecision shaders (std430, 48 bytes) */
+	struct DoublePrecisionPushConstants
+	{
+		double CenterX;
+		double CenterY;
+		uint32_t TileOffsetX;
+		uint32_t TileOffsetY;
+		double Scale;
+		uint32_t ReferenceLength;
+		uint32_t SkipIterations;
+		double InverseSeriesRadius;
+	};
+
+	/* Matches the specialization constants (constant_id 0..9) in computeShader.comp */
+	struct SpecializationConstants
+	{
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t MaxIterations;
+		uint32_t TileWidth;
+		uint32_t TileHeight;
+		uint32_t OutputFormat;
+		VkBool32 CardioidCheck;
+		VkBool32 BulbCheck;
+		VkBool32 PeriodicityCheck;
+		float PeriodicityTolerance;
+	};
+
+	/* Device-local render target of one tile, reused once the transfer queue copied it out */
+	struct ComputeSlot
+	{
+		VulkanBuffer StorageBuffer;
+		VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+		VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+	};
+
+	/* Host-visible copy of one tile, reused once the CPU wrote it out */
+	struct ReadbackSlot
+	{
+		VulkanBuffer Buffer;
+		void* MappedMemory = nullptr;
+		VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+		TileRegion Region;
+	};
+
+	/* Accumulated per Render(), GPU times come from timestamp queries when the queue family supports them */
+	struct StageTimings
+	{
+		double ComputeTime = 0.0;
+		double CopyTime = 0.0;
+		double HostTime = 0.0;
+		double HostWaitTime = 0.0;
+	};
+
+	static constexpr uint32_t ComputeSlotCount = 2;
+	static constexpr uint32_t ReadbackSlotCount = 3;
+private:
+	/* Colors or converts the tile if the output format needs it and hands it to the writer. Rows are m_TileWidth pixels apart */
+	bool WriteTile(const void* tile, const TileRegion& region, ImageWriter& writer);
+	/* Compares a device tile against the CpuRenderer, see VerifyWithCpu */
+	void VerifyTile(const void* tile, const TileRegion& region);
+private:
+	OfflineRenderSettings m_Settings;
+
+	/* Vulkan API */
+	VkInstance m_Instance;
+	VkPhysicalDevice m_PhysicalDevice;
+	VkPhysicalDeviceProperties m_PhysicalDeviceProperties;
+	VkPhysicalDeviceMemoryProperties m_PhysicalDeviceMemoryProperties;
+
+	VkDevice m_LogicalDevice;
+	int32_t m_ComputeQueueIndex;
+	VkQueue m_ComputeQueue;
+	VkCommandPool m_ComputeCommandPool;
+	/* Dedicated transfer family if the device has one, the compute queue otherwise */
+	int32_t m_TransferQueueIndex;
+	VkQueue m_TransferQueue;
+	VkCommandPool m_TransferCommandPool;
+	bool m_MemoryBudgetSupported;
+	/* Transfer-only queues cannot reset queries, so timestamps need vkResetQueryPool on the host */
+	bool m_HostQueryResetSupported;
+	bool m_ShaderFloat64Supported;
+
+	/* Synchronization, values only grow across renders */
+	VkSemaphore m_ComputeTimeline;
+	VkSemaphore m_TransferTimeline;
+	uint64_t m_SubmittedTileCount;
+
+	VkQueryPool m_ComputeQueryPool;
+	VkQueryPool m_TransferQueryPool;
+	StageTimings m_Timings;
+
+	/* Compute Pipeline */
+	std::array<ComputeSlot, ComputeSlotCount> m_ComputeSlots;
+	std::array<ReadbackSlot, ReadbackSlotCount> m_ReadbackSlots;
+	VkDeviceSize m_TileBufferSize;
+	uint32_t m_TileWidth;
+	/* Precision of the current render, its push constants and whether the float32 CPU reference applies */
+	bool m_DoublePrecision;
+	/* The current render iterates against m_MainReference */
+	bool m_Perturbation;
+	/* Preallocated RGBA8 tile for formats that are converted on the CPU */
+	std::vector<uint8_t> m_TileImage;
+	/* Readback post-processing, see PostProcess.h */
+	ThreadPool m_ThreadPool;
+	ESimdLevel m_SimdLevel;
+	CpuRenderer m_CpuRenderer;
+	/* Output of the CpuRenderer, in the compute shader's layout */
+	std::vector<uint8_t> m_CpuTile;
+	uint64_t m_VerifiedPixelCount;
+	uint64_t m_MismatchedPixelCount;
+	/* Open while a render saves its escape time buffer */
+	EscapeTimeWriter m_EscapeTimeWriter;
+
+	/* Matches the Counters block in computeShader.comp, stays mapped */
+	VulkanBuffer m_CheckCountBuffer;
+	uint32_t* m_CheckCounts;
+
+	/* Perturbation: the main reference outlives the render while center and iteration limit stay (zoom sequences) */
+	PerturbationView m_PerturbationView;
+	ReferenceOrbit m_MainReference;
+	/* Empty (SkipIterations 0) unless OfflineRenderSettings::Series */
+	SeriesApproximation m_Series;
+	/* Identifies the center m_MainReference belongs to, empty before the first perturbation render */
+	std::string m_ReferenceCenter;
+	/* Added by glitch correction, only valid for the current scale */
+	std::vector<ReferenceOrbit> m_GlitchReferences;
+	std::vector<uint32_t> m_GlitchedPixels;
+	uint64_t m_GlitchedPixelCount;
+	uint64_t m_UncorrectedPixelCount;
+	/* Glitch bitmask behind the tile data in the tile buffers, one bit per tile pixel */
+	VkDeviceSize m_GlitchMaskOffset;
+	VkDeviceSize m_GlitchMaskSize;
+	/* Matches the ReferenceOrbit block in perturbationShader.comp, host-visible and stays mapped */
+	VulkanBuffer m_ReferenceOrbitBuffer;
+	VkDeviceSize m_ReferenceOrbitBufferSize;
+	void* m_MappedReferenceOrbit;
+
+	VkDescriptorSetLayout m_DescriptorSetLayout;
+	VkDescriptorPool m_DescriptorPool;
+
+	VkShaderModule m_ComputeShaderModule;
+	/* Only loaded on devices with shaderFloat64 */
+	VkShaderModule m_DoublePrecisionComputeShaderModule;
+	/* Optional, perturbation renders fall back to the CPU without them */
+	VkShaderModule m_PerturbationShaderModule;
+	VkShaderModule m_DoublePrecisionPerturbationShaderModule;
+	VkPipelineLayout m_ComputePipelineLayout;
+	VkPipelineCache m_PipelineCache;
+	std::map<ComputePipelineKey, VkPipeline> m_ComputePipelines;
+};
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include "include/Core.h"
+
+struct ReferenceOrbit;
+
+/*
+* On-disk cache of main reference orbits (see Perturbation.h), so rendering a location again with
+* another palette, resolution or tile size skips the BigFixed iteration. One file per center text,
+* precision and iteration limit: a fixed-size header, the center text and the orbit points as
+* doubles, read and written through MappedFile.
+*/
+namespace OrbitCache {
+	struct FileHeader
+	{
+		char Magic[8];
+		uint32_t FractionBits;
+		uint32_t MaxIterations;
+		/* Index of the last point, ReferenceOrbit::GetLength */
+		uint32_t Length;
+		/* Bytes of center text right behind the header, the points follow at the next multiple of 8 */
+		uint32_t CenterSize;
+		double OffsetX;
+		double OffsetY;
+	};
+
+	constexpr char FileMagic[8] = { 'M', 'B', 'O', 'R', 'B', 'I', 'T', '1' };
+
+	/* File of a key in directory, named after a hash of the center text */
+	std::string GetFilePath(const std::string& directory, const std::string& center, const uint32_t fractionBits, const uint32_t maxIterations);
+	/* False if the file is missing, malformed or belongs to another key (a hash collision) */
+	bool Load(const std::string& filepath, const std::string& center, const uint32_t fractionBits, const uint32_t maxIterations, ReferenceOrbit& reference);
+	/* Creates the directory if needed and replaces the file */
+	bool Store(const std::string& filepath, const std::string& center, const uint32_t fractionBits, const uint32_t maxIterations, const ReferenceOrbit& reference);
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include "include/Core.h"
+#include "include/BigFixed.h"
+
+/*
+* Perturbation theory, for zooms past what double precision resolves. One reference point C is
+* iterated in BigFixed, Z_{n+1} = Z_n^2 + C from Z_0 = 0 like computeShader.comp, and its orbit
+* is stored rounded to double. A pixel c = C + dc then only iterates its difference to that
+* orbit, d_n = z_n - Z_n, which stays small enough for float or double:
+*     d_{n+1} = (2 Z_n + d_n) d_n + dc
+* Where |Z_n + d_n| gets much smaller than |Z_n| the rounding of Z_n swamps the pixel's own
+* digits. Such glitched pixels are detected with Pauldelbrot's criterion and iterated again
+* against a reference closer to them.
+*/
+namespace Perturbation {
+	/* |z|^2 < GlitchToleranceSquared |Z|^2 is a glitch, |z| a thousandth of |Z| leaves about 13 digits in double */
+	constexpr double GlitchToleranceSquared = 1.0e-6;
+	/* Covers both escape radii of the shaders, pixels stay within the orbit until they escape */
+	constexpr double ReferenceEscapeRadiusSquared = 65536.0;
+	/* Candidates per axis when the view center makes a short main reference */
+	constexpr uint32_t MainReferenceGridSize = 4;
+	/* Limbs from which the two squares of a reference iteration run on helper threads next to the product */
+	constexpr uint32_t ParallelLimbThreshold = 64;
+	/* Terms of the series approximation, must match SERIES_TERM_COUNT in perturbationShader.comp */
+	constexpr uint32_t SeriesTermCount = 16;
+	/* The smaller escape radius of the shaders, no pixel of any format may escape within the series */
+	constexpr double SeriesEscapeRadiusSquared = 2.0;
+	/* The series may move a pixel by this fraction of the pixel spacing at most, far below what changes its escape iteration */
+	constexpr double SeriesTolerance = 1.0e-3;
+}
+
+/* View of a perturbation render, the center in full precision and the pixel grid relative to it */
+struct PerturbationView
+{
+	BigFixed CenterX;
+	BigFixed CenterY;
+	/* Horizontal extent, the vertical one follows Height / Width */
+	double Scale = 0.0;
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t MaxIterations = 0;
+};
+
+/* Orbit of one reference point, stored rounded to double */
+struct ReferenceOrbit
+{
+	/* C minus the view center, a pixel iterates with dc = its offset minus this one */
+	double OffsetX = 0.0;
+	double OffsetY = 0.0;
+	/* Z_0 .. Z_n as (real, imaginary) pairs, n is the iteration limit or the iteration the reference escaped at */
+	std::vector<double> Points;
+
+	/* Index of the last point, pixels that are still inside past it glitched */
+	uint32_t GetLength() const { return Points.empty() ? 0 : static_cast<uint32_t>(Points.size() / 2 - 1); }
+};
+
+/*
+* Series approximation: for the first iterations all the pixels' deltas are one polynomial in dc,
+*     d_n = A_1,n dc + A_2,n dc^2 + ... + A_K,n dc^K
+* with coefficients that follow from the delta recurrence:
+*     A_1,n+1 = 2 Z_n A_1,n + 1,  A_k,n+1 = 2 Z_n A_k,n + sum_j A_j,n A_k-j,n
+* A pixel evaluates it once and starts iterating at SkipIterations. The terms past K that are
+* dropped every iteration are bounded over the whole disk |dc| <= Radius, the series stops
+* where that bound could move any pixel by SeriesTolerance of the pixel spacing.
+*/
+struct SeriesApproximation
+{
+	uint32_t SkipIterations = 0;
+	/* Largest |dc| of the view, every pixel lies in the disk the bound holds for */
+	double Radius = 0.0;
+	/* A_k Radius^k as (real, imaginary) pairs for k = 1 .. K, normalized so they neither overflow nor underflow */
+	std::vector<double> Coefficients;
+};
+
+namespace Perturbation {
+	/* Fraction bits of a view: the pixel spacing plus 64 guard bits against the rounding that iterating amplifies */
+	uint32_t GetFractionBits(const double scale, const uint32_t width);
+	/* Double cannot resolve the pixel spacing with 8 bits to spare, the float64 shader is not enough */
+	bool IsBeyondDoublePrecision(const double centerX, const double centerY, const double scale, const uint32_t width);
+	/* Pixel differences below about 1e-30 leave no exponent range to float deltas, d^2 and the glitch test flush to zero */
+	bool NeedsDoubleDeltas(const double scale, const uint32_t width);
+
+	/* Iterates the reference at the view center plus offset in BigFixed, in the precision of the view */
+	ReferenceOrbit ComputeReferenceOrbit(const PerturbationView& view, const double offsetX, const double offsetY);
+	/*
+	* The view center, or if its orbit escapes before the iteration limit the longest one of a grid of
+	* points over the view. Pixels that outlive their reference glitch, a short one would glitch most of the image.
+	*/
+	ReferenceOrbit ComputeMainReference(const PerturbationView& view);
+
+	/*
+	* Fits the series over the view against reference. No pixel may escape before SkipIterations,
+	* which stays below the reference length and the iteration limit.
+	*/
+	SeriesApproximation ComputeSeriesApproximation(const PerturbationView& view, const ReferenceOrbit& reference);
+	/* d_SkipIterations of the pixel at dc from the reference, Horner's scheme in dc / Radius */
+	void EvaluateSeries(const SeriesApproximation& series, const double dcX, const double dcY, double& dx, double& dy);
+
+	/* Offset of a pixel from the view center, the arithmetic of PixelToDelta in perturbationShader.comp */
+	void GetPixelOffset(const PerturbationView& view, const uint32_t x, const uint32_t y, double& offsetX, double& offsetY);
+
+	/*
+	* Iterates the difference dc to the reference like perturbationShader.comp does, from the end of series
+	* if it is given (it has to belong to reference). iterations receives the escape iteration (maxIterations
+	* inside the set), magnitude |z|^2 of the first point outside. Returns false if the pixel glitched or
+	* outlived the reference, both outputs then hold where it stopped. Skipped iterations are not counted.
+	*/
+	bool IteratePixel(
+		const ReferenceOrbit& reference, const SeriesApproximation* series, const double dcX, const double dcY,
+		const uint32_t maxIterations, const double escapeRadiusSquared, uint32_t& iterations, float& magnitude, uint64_t& iterationCount);
+}
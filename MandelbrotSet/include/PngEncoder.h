@@ -0,0 +1,63 @@
+#pragma once
+#include "include/Core.h"
+
+class ThreadPool;
+
+/*
+* PNG and zlib building blocks with no global state, safe to use from many threads.
+* The stream encoder below builds on them.
+*/
+namespace Png {
+	uint32_t Crc32(uint32_t crc, const uint8_t* data, const std::size_t size);
+	uint32_t Adler32(uint32_t adler, const uint8_t* data, const std::size_t size);
+	/* Adler-32 of A followed by B, given adler(A), adler(B) and the length of B */
+	uint32_t Adler32Combine(const uint32_t adlerA, const uint32_t adlerB, const std::size_t sizeB);
+
+	/* Writes the filter type byte followed by the filtered row (rowSize + 1 bytes), using the filter with the smallest sum of absolute values */
+	void FilterRow(const uint8_t* row, const uint8_t* previousRow, const std::size_t rowSize, const uint32_t bytesPerPixel, uint8_t* output);
+
+	/*
+	* Raw deflate of data[dictionarySize, size), matches may reach back into data[0, dictionarySize).
+	* A non-final stream ends with an empty stored block (sync flush), so it is byte aligned
+	* and independently compressed streams can be concatenated, like pigz does.
+	*/
+	void Deflate(const uint8_t* data, const std::size_t dictionarySize, const std::size_t size, const bool final, std::vector<uint8_t>& output);
+
+	/* Appends a complete chunk: length, type, data and CRC */
+	void AppendChunk(const char type[4], const uint8_t* data, const std::size_t size, std::vector<uint8_t>& output);
+	/* Signature and IHDR of an 8 bit RGBA image */
+	void AppendHeader(const uint32_t width, const uint32_t height, std::vector<uint8_t>& output);
+
+	/*
+	* Incremental encoder for an 8 bit RGBA image. Rows are handed over in order, in batches of any size;
+	* each batch is split into stripes that are filtered, deflated and wrapped into their own IDAT chunk
+	* in parallel. Only the last row and the deflate window are kept between batches, so memory use
+	* depends on the batch size, not on the image size.
+	*/
+	class StreamEncoder
+	{
+	public:
+		explicit StreamEncoder(ThreadPool& threadPool);
+
+		/* Appends signature and IHDR */
+		bool Begin(const uint32_t width, const uint32_t height, std::vector<uint8_t>& output);
+		/* rows holds rowCount tightly packed rows. Appends the finished chunks, including IEND after the last row of the image */
+		bool AppendRows(const uint8_t* rows, const uint32_t rowCount, std::vector<uint8_t>& output);
+
+		bool IsComplete() const { return m_Width != 0 && m_RowCount == m_Height; }
+	private:
+		ThreadPool& m_ThreadPool;
+		uint32_t m_Width;
+		uint32_t m_Height;
+		uint32_t m_RowCount;
+		/* Unfiltered, for the up/average/paeth predictors of the next batch */
+		std::vector<uint8_t> m_PreviousRow;
+		/* Filtered bytes of the current batch, preceded by m_DictionarySize bytes of the previous one */
+		std::vector<uint8_t> m_Filtered;
+		std::size_t m_DictionarySize;
+		uint32_t m_Adler;
+	};
+
+	/* Encodes a whole 8 bit RGBA image with a StreamEncoder */
+	bool EncodeRGBA(const uint8_t* pixels, const uint32_t width, const uint32_t height, ThreadPool& threadPool, std::vector<uint8_t>& png);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "include/Core.h"
+#include "include/Simd.h"
+#include "include/Coloring.h"
+
+class ThreadPool;
+
+/* How linear float colors are quantized to RGBA8 */
+struct ConversionSettings
+{
+	/* Output is linear^(1 / Gamma) on the color channels, 1 leaves them linear. Alpha is never gamma corrected */
+	float Gamma = 1.0f;
+	/* Ordered (8x8 Bayer) dithering instead of rounding, hides banding in smooth gradients */
+	bool Dither = false;
+};
+
+/*
+* Readback post-processing: turns what the compute shader stored into RGBA8 rows for the
+* image writers. Every function writes into a caller-owned buffer and splits the rows over
+* the thread pool.
+*/
+namespace PostProcess {
+	/*
+	* Converts count linear float RGBA pixels into RGBA8. (x, y) is the image position of the
+	* first pixel, it anchors the dither pattern so tile seams do not show.
+	* The SIMD levels approximate pow() with polynomials and may differ from the reference by one step.
+	*/
+	void ConvertFloatRow(const float* source, uint8_t* destination, const uint32_t count, const uint32_t x, const uint32_t y, const ConversionSettings& settings, const ESimdLevel level);
+	/* Scalar reference with exact powf, the SIMD kernels are checked against it */
+	void ConvertFloatRowReference(const float* source, uint8_t* destination, const uint32_t count, const uint32_t x, const uint32_t y, const ConversionSettings& settings);
+
+	/* Pitches are in bytes */
+	void ConvertFloatToRGBA8(
+		const float* source, const std::size_t sourcePitch,
+		uint8_t* destination, const std::size_t destinationPitch,
+		const uint32_t width, const uint32_t height, const uint32_t x, const uint32_t y,
+		const ConversionSettings& settings, ThreadPool& threadPool, const ESimdLevel level);
+
+	/* Palette coloring of the iteration formats (the deferred coloring pass), pitches are in bytes */
+	void ColorIterations(
+		const uint32_t* source, const std::size_t sourcePitch,
+		uint8_t* destination, const std::size_t destinationPitch,
+		const uint32_t width, const uint32_t height, const uint32_t maxIterations,
+		const ColoringSettings& coloring, ThreadPool& threadPool);
+	/* Values at or above the limit (including float16 infinity) are inside the set */
+	void ColorSmoothIterations(
+		const uint16_t* source, const std::size_t sourcePitch,
+		uint8_t* destination, const std::size_t destinationPitch,
+		const uint32_t width, const uint32_t height, const uint32_t maxIterations,
+		const ColoringSettings& coloring, ThreadPool& threadPool);
+}
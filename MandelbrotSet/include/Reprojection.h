@@ -0,0 +1,126 @@
+#pragma once
+#include "include/Core.h"
+#include <math.h>
+
+/*
+* Reuse of the previous escape time image by the window's escape time pass (fragmentShader.frag).
+* The render camera is snapped to the pixel grid, so a pan moves the previous image by whole pixels
+* and its texels are copied as they are, only the strips the pan exposes are iterated. A zoom
+* resamples the previous image as placeholders.
+*
+* Pixels are refined progressively on nested lattices of the snapped grid: every 8th pixel in both
+* directions, then every 4th, 2nd and all of them. A pass iterates the pixels of its lattice that
+* are not exact yet, so no pixel is iterated twice, and the lattice of each pass is the finest one
+* the GPU time budget allows.
+*
+* The quad maps c.x to the window's y axis and c.y to its x axis (see vertexShader.vert), both
+* with a pixel spacing of ZoomScale / height.
+*/
+namespace Reprojection {
+	enum class EMode : uint32_t
+	{
+		/* Every pixel is iterated */
+		None = 0,
+		/* Same zoom, the previous image moved by whole pixels */
+		Shift,
+		/* Another zoom, the previous image is a placeholder */
+		Resample
+	};
+
+	/* Lattice step of a moving view without a cost estimate, must match GetPixelStep in fragmentShader.frag */
+	constexpr uint32_t CoarsestRefineStep = 8;
+	/* Seconds of GPU time a refining escape time pass may take */
+	constexpr double DefaultRefineBudget = 0.008;
+	/* Zooms by more than this factor between two passes iterate everything, the placeholders would be too coarse */
+	constexpr double MaxResampleScale = 4.0;
+
+	/* Camera of an escape time pass, the center a whole number of pixels */
+	struct Camera
+	{
+		double CenterX = 0.0;
+		double CenterY = 0.0;
+		double ZoomScale = 1.0;
+		/* Center in pixels */
+		int64_t GridX = 0;
+		int64_t GridY = 0;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+	};
+
+	/* Previous pixel = pixel * Scale + Offset, in window pixels */
+	struct Mapping
+	{
+		EMode Mode = EMode::None;
+		float ScaleX = 1.0f;
+		float ScaleY = 1.0f;
+		float OffsetX = 0.0f;
+		float OffsetY = 0.0f;
+	};
+
+	inline Camera SnapToPixels(const double centerX, const double centerY, const double zoomScale, const uint32_t width, const uint32_t height)
+	{
+		const double pixelSpacing = zoomScale / static_cast<double>(height);
+		Camera camera;
+		camera.GridX = llround(centerX / pixelSpacing);
+		camera.GridY = llround(centerY / pixelSpacing);
+		camera.CenterX = static_cast<double>(camera.GridX) * pixelSpacing;
+		camera.CenterY = static_cast<double>(camera.GridY) * pixelSpacing;
+		camera.ZoomScale = zoomScale;
+		camera.Width = width;
+		camera.Height = height;
+		return camera;
+	}
+
+	/* Where each pixel of current was in the image rendered with previous, both of the same size */
+	inline Mapping GetMapping(const Camera& previous, const Camera& current)
+	{
+		Mapping mapping;
+		if (previous.Width != current.Width || previous.Height != current.Height)
+			return mapping;
+
+		/* Window y follows c.x and window x follows c.y */
+		if (current.ZoomScale == previous.ZoomScale)
+		{
+			mapping.Mode = EMode::Shift;
+			mapping.OffsetX = static_cast<float>(current.GridY - previous.GridY);
+			mapping.OffsetY = static_cast<float>(current.GridX - previous.GridX);
+			return mapping;
+		}
+
+		const double scale = current.ZoomScale / previous.ZoomScale;
+		if (scale > MaxResampleScale || scale < 1.0 / MaxResampleScale)
+			return mapping;
+
+		const double height = static_cast<double>(current.Height);
+		mapping.Mode = EMode::Resample;
+		mapping.ScaleX = static_cast<float>(scale);
+		mapping.ScaleY = static_cast<float>(scale);
+		mapping.OffsetX = static_cast<float>(0.5 * static_cast<double>(current.Width) * (1.0 - scale) + (current.CenterY - previous.CenterY) * height / previous.ZoomScale);
+		mapping.OffsetY = static_cast<float>(0.5 * height * (1.0 - scale) + (current.CenterX - previous.CenterX) * height / previous.ZoomScale);
+		return mapping;
+	}
+
+	/*
+	* Finest lattice step whose pixels still to iterate fit budgetSeconds, one step finer than
+	* completedStep at least (0 if no lattice is complete, as after any camera change). The
+	* estimate assumes the whole lattice needs iterating, which pans only partly do.
+	*/
+	inline uint32_t ChooseRefineStep(const uint32_t completedStep, const double secondsPerPixel, const double pixelCount, const double budgetSeconds)
+	{
+		const double completedShare = completedStep == 0 ? 0.0 : 1.0 / static_cast<double>(completedStep * completedStep);
+		uint32_t step = completedStep == 0 ? CoarsestRefineStep : completedStep / 2;
+		if (secondsPerPixel <= 0.0)
+			return step;
+
+		while (step > 1)
+		{
+			const double finerStep = static_cast<double>(step / 2);
+			if (secondsPerPixel * pixelCount * (1.0 / (finerStep * finerStep) - completedShare) > budgetSeconds)
+				break;
+
+			step /= 2;
+		}
+
+		return step;
+	}
+}
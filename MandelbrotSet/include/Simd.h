@@ -0,0 +1,37 @@
+#pragma once
+#include "include/Core.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+	#define APP_SIMD_X64 1
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		/* MSVC compiles intrinsics of any instruction set without extra flags */
+		#define APP_TARGET_AVX2
+		#define APP_TARGET_AVX512
+	#else
+		#include <cpuid.h>
+		/* Lets single functions use instructions beyond the baseline the file is compiled for */
+		#define APP_TARGET_AVX2 __attribute__((target("avx2,fma")))
+		#define APP_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+	#endif
+#else
+	#define APP_SIMD_X64 0
+#endif
+
+/* Instruction sets the CPU kernels are written for, ordered from slowest to fastest */
+enum class ESimdLevel : uint32_t
+{
+	Scalar = 0,
+	SSE2,
+	AVX2,
+	AVX512
+};
+
+namespace Simd {
+	/* Highest level both the CPU and the operating system (saved register state) support, detected once with CPUID */
+	ESimdLevel GetSupportedLevel();
+	const char* GetLevelName(const ESimdLevel level);
+	/* Accepts the names GetLevelName() returns, case insensitive */
+	bool ParseLevel(const std::string_view name, ESimdLevel& level);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "include/Core.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/*
+* Fixed set of worker threads for data parallel loops, the calling thread helps out.
+* ParallelFor balances by work stealing: every thread owns a deque of index ranges and
+* starts with an equal share. The owner takes single indices from the back of its deque,
+* a thread that runs dry takes half of the oldest range of another one. So costly indices
+* (a tile inside the set) do not leave threads idle, and no lock is shared by all threads.
+*/
+class ThreadPool
+{
+public:
+	/* 0 uses every hardware thread, the calling thread counts as one of them */
+	explicit ThreadPool(const uint32_t threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/* Calls function(index) for every index in [0, count) and returns once all of them finished */
+	void ParallelFor(const uint32_t count, const std::function<void(const uint32_t index)>& function);
+
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Workers.size()) + 1; }
+	/* Ranges taken from another thread's deque since construction */
+	uint64_t GetStealCount() const { return m_StealCount.load(); }
+private:
+	/* Indices [Begin, End) */
+	struct IndexRange
+	{
+		uint32_t Begin;
+		uint32_t End;
+	};
+
+	/* Own cache line each, threads mostly touch only their own */
+	struct alignas(64) WorkQueue
+	{
+		std::mutex Mutex;
+		std::deque<IndexRange> Ranges;
+		/* Picks the first victim to steal from, only used by the owner */
+		uint32_t VictimSeed = 0;
+	};
+
+	void WorkerLoop(const uint32_t queueIndex);
+	/* Runs indices of the current loop until none are left to take */
+	void RunIndices(const uint32_t queueIndex);
+	bool PopIndex(const uint32_t queueIndex, uint32_t& index);
+	/* Moves half of the oldest range of another queue into this one */
+	bool Steal(const uint32_t queueIndex);
+private:
+	std::vector<std::thread> m_Workers;
+	/* Index 0 belongs to the thread calling ParallelFor, index i to worker i - 1 */
+	std::vector<std::unique_ptr<WorkQueue>> m_Queues;
+
+	std::mutex m_SubmitMutex;
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkAvailable;
+	std::condition_variable m_WorkDone;
+
+	/* Current loop, set and cleared under m_Mutex while no worker runs indices */
+	const std::function<void(const uint32_t)>* m_Function;
+	uint32_t m_ActiveWorkerCount;
+	uint64_t m_Generation;
+	bool m_Stop;
+
+	/* Indices still sitting in a deque, nothing is left to steal at 0 */
+	std::atomic<uint32_t> m_PendingCount;
+	std::atomic<uint64_t> m_StealCount;
+};
@@ -1,6 +1,8 @@
 #pragma once
 #include "vendor/vulkan/include/vulkan.h"
+#ifdef _WIN32
 #include "vendor/vulkan/include/vulkan_win32.h"
+#endif
 
 #ifdef APP_DEBUG
 #define VK_CHECK(x) if(x != VK_SUCCESS) \
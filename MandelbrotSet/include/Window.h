@@ -76,6 +76,8 @@ public:
 	~Window();
 	
 	void PollEvents();
+	/* Blocks until a message arrives, then handles all of them */
+	void WaitEvents();
 	bool KeyPressed(const KeyCode keyCode);
 	const std::pair<uint32_t, uint32_t> GetSize() const;
 
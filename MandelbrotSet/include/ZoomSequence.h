@@ -0,0 +1,51 @@
+#pragma once
+#include "include/Core.h"
+#include "include/OfflineRenderer.h"
+#include "include/ThreadPool.h"
+
+/*
+* Zoom video from keyframes. Instead of rendering every frame, one keyframe is rendered per
+* zoom factor of 2 around the fixed center, KeyframeScale times the frame size per axis. A frame
+* between two keyframes is resampled from them: the outer keyframe covers the whole frame with
+* at least one keyframe pixel per frame pixel, the inner one replaces its center with twice the
+* detail, so nothing is ever upscaled and frames do not pop when the next keyframe takes over.
+*
+* Keyframe k + 2 renders on the GPU while a worker thread resamples and encodes the frames between
+* keyframes k and k + 1, so the GPU never waits for frame output.
+*/
+class ZoomSequence
+{
+public:
+	explicit ZoomSequence(OfflineRenderer& renderer);
+
+	/* Uses ZoomFrameCount, Scale, ZoomFinalScale and OutputPath as the frame pattern */
+	bool Render(const OfflineRenderSettings& settings);
+private:
+	struct Keyframe
+	{
+		std::vector<uint8_t> Pixels;
+		double Scale = 0.0;
+	};
+
+	bool RenderKeyframe(const uint32_t index, Keyframe& keyframe);
+	/* Resamples and writes frames [firstFrame, endFrame), inner is null past the last keyframe */
+	bool WriteFrames(const uint32_t firstFrame, const uint32_t endFrame, const Keyframe& outer, const Keyframe* inner);
+	void ResampleFrame(const double scale, const Keyframe& outer, const Keyframe* inner);
+
+	double GetFrameScale(const uint32_t frame) const;
+	std::string GetFramePath(const uint32_t frame) const;
+private:
+	/* Keyframes are this many times larger than a frame per axis, which covers one zoom octave */
+	static constexpr uint32_t KeyframeScale = 2;
+	/* Keyframes alive at once: two being resampled and one being rendered */
+	static constexpr uint32_t KeyframeSlotCount = 3;
+private:
+	OfflineRenderer& m_Renderer;
+	OfflineRenderSettings m_Settings;
+	uint32_t m_KeyframeWidth;
+	uint32_t m_KeyframeHeight;
+
+	/* Frame output runs on its own thread, these are only touched there */
+	ThreadPool m_ThreadPool;
+	std::vector<uint8_t> m_Frame;
+};
@@ -2,7 +2,9 @@
 #include "include\Application.h"
 #include "include\Platform.h"
 #include "include\Input.h"
+#include "include\Coloring.h"
 #include "glm/glm.hpp"
+#include <float.h>
 
 namespace Utilities {
 	#if APP_DEBUG
@@ -35,11 +37,23 @@ namespace Utilities {
 	};
 
 	constexpr uint64_t MaxSwapchainTimeout = UINT64_MAX;
-	/* These can be tweaked. In order to change the dimensions, adjust the compute shader code and recompile them. */
-	constexpr uint32_t ComputeRenderWidth = 3200 * 2;
-	constexpr uint32_t ComputeRenderHeight = 2400 * 2;
-	constexpr std::size_t ComputeBufferSize = ComputeRenderWidth * ComputeRenderHeight * sizeof(float) * 4;
-	constexpr std::size_t RenderedImageSize = ComputeRenderWidth * ComputeRenderHeight * sizeof(uint8_t) * 4;
+	/* Longest block on a pending counter readback in nanoseconds, input is polled again after about a frame */
+	constexpr uint64_t CounterWaitTimeout = 16000000;
+	/* Counters in fragmentShader.frag: three interior check counts and the iterated pixels, then the escape histogram */
+	constexpr uint32_t CounterHistogramOffset = 4;
+	/* Continuous iteration count and pixel code of the escape time pass */
+	constexpr VkFormat EscapeTimeFormat = VK_FORMAT_R32G32_SFLOAT;
+	/* Workgroup of the escape time compute shader, must match TILE_WIDTH and TILE_HEIGHT in fragmentShader.frag */
+	constexpr uint32_t EscapeTimeTileWidth = 16;
+	constexpr uint32_t EscapeTimeTileHeight = 8;
+
+	/* float32 has to resolve the pixel spacing with 8 bits to spare, the rule of the offline renderer's automatic precision */
+	INTERNALSCOPE bool NeedsDoublePrecision(const Reprojection::Camera& camera)
+	{
+		const double magnitude = std::max(fabs(camera.CenterX), fabs(camera.CenterY)) + camera.ZoomScale;
+		const double pixelSpacing = camera.ZoomScale / static_cast<double>(camera.Height);
+		return pixelSpacing < magnitude * static_cast<double>(FLT_EPSILON) * 256.0;
+	}
 }
 
 VulkanApp* VulkanApp::s_ApplicationInstance = nullptr;
@@ -47,7 +61,7 @@ VulkanApp::VulkanApp(const ERenderMethod renderMethod, HINSTANCE hInstance, cons
 	:
 	m_RenderMethod(renderMethod),
 	m_Running(true),
-	m_Window(renderMethod == ERenderMethod::Graphics ? new Window(hInstance, { 1280, 720, showConsole, std::bind(&VulkanApp::OnEvent, this, std::placeholders::_1) }) : nullptr),
+	m_Window(renderMethod != ERenderMethod::Compute ? new Window(hInstance, { 1280, 720, showConsole, std::bind(&VulkanApp::OnEvent, this, std::placeholders::_1) }) : nullptr),
 	/* Vulkan API */
 	m_Instance(VK_NULL_HANDLE),
 	m_Surface(VK_NULL_HANDLE),
@@ -77,25 +91,77 @@ VulkanApp::VulkanApp(const ERenderMethod renderMethod, HINSTANCE hInstance, cons
 	m_SwapchainRenderPass(VK_NULL_HANDLE),
 	m_VertexBuffer(),
 	m_IndexBuffer(),
-	m_UBOBuffer(),
+	m_UBORing(),
+	m_UBORingData(nullptr),
+	m_UBORingStride(0),
+	m_FrameUBO(),
+	m_FrameCamera(),
+	m_FrameDoublePrecision(false),
 	m_VertexShaderModule(VK_NULL_HANDLE),
 	m_FragmentShaderModule(VK_NULL_HANDLE),
+	m_ColoringShaderModule(VK_NULL_HANDLE),
 	m_GraphicsPipelineUBOBufferDescriptorSetLayout(VK_NULL_HANDLE),
 	m_GraphicsPipelineColorPaletteDescriptorSetLayout(VK_NULL_HANDLE),
-	m_GraphicsPipeline(VK_NULL_HANDLE),
+	m_GraphicsPipelineEscapeTimeDescriptorSetLayout(VK_NULL_HANDLE),
+	m_EscapeTimePipeline(VK_NULL_HANDLE),
+	m_DoublePrecisionEscapeTimePipeline(VK_NULL_HANDLE),
+	m_ColoringPipeline(VK_NULL_HANDLE),
+	m_AccumulationPipeline(VK_NULL_HANDLE),
+	m_ResolvePipeline(VK_NULL_HANDLE),
 	m_GraphicsPipelineLayout(VK_NULL_HANDLE),
 	m_GraphicsPipelineDescriptorPool(VK_NULL_HANDLE),
 	m_GraphicsPipelineUBOBufferDescriptorSet(VK_NULL_HANDLE),
 	m_GraphicsPipelineColorPaletteDescriptorSet(VK_NULL_HANDLE),
+	m_GraphicsPipelineEscapeTimeDescriptorSet(VK_NULL_HANDLE),
+	m_PreviousEscapeTimeDescriptorSet(VK_NULL_HANDLE),
 	m_GraphicsPipelineCommandBuffers(),
-	m_ComputePipelineStorageBuffer(),
-	m_ComputeShaderModule(VK_NULL_HANDLE),
-	m_ComputePipelineDescriptorSetLayout(VK_NULL_HANDLE),
-	m_ComputePipelineDescriptorPool(VK_NULL_HANDLE),
-	m_ComputePipelineStorageBufferDescriptorSet(VK_NULL_HANDLE),
-	m_ComputePipeline(VK_NULL_HANDLE),
-	m_ComputePipelineLayout(VK_NULL_HANDLE),
-	m_ComputePipelineCommandBuffer(VK_NULL_HANDLE),
+	m_EscapeTimeComputePipeline(VK_NULL_HANDLE),
+	m_DoublePrecisionEscapeTimeComputePipeline(VK_NULL_HANDLE),
+	m_EscapeTimeComputePipelineLayout(VK_NULL_HANDLE),
+	m_EscapeTimeStorageDescriptorSetLayout(VK_NULL_HANDLE),
+	m_EscapeTimeStorageDescriptorSets(),
+	m_ComputeCommandBuffers(),
+	m_EscapeTimeFront(1),
+	m_ShownEscapeTime(0),
+	m_EscapeTimeReadFences(),
+	m_EscapeTimeRenderPass(VK_NULL_HANDLE),
+	m_EscapeTimeImage(VK_NULL_HANDLE),
+	m_EscapeTimeImageMemory(VK_NULL_HANDLE),
+	m_EscapeTimeImageView(VK_NULL_HANDLE),
+	m_EscapeTimeSampler(VK_NULL_HANDLE),
+	m_EscapeTimeFramebuffer(VK_NULL_HANDLE),
+	m_PreviousEscapeTimeImage(VK_NULL_HANDLE),
+	m_PreviousEscapeTimeImageMemory(VK_NULL_HANDLE),
+	m_PreviousEscapeTimeImageView(VK_NULL_HANDLE),
+	m_PreviousEscapeTimeCamera(),
+	m_PreviousEscapeTimeValid(false),
+	m_CompletedRefineStep(0),
+	m_RefineBudget(Reprojection::DefaultRefineBudget),
+	m_EscapeTimeQueryPool(VK_NULL_HANDLE),
+	m_SecondsPerIteratedPixel(0.0),
+	m_EscapeTimeOutdated(true),
+	m_ColoringOutdated(true),
+	m_AccumulationFormat(VK_FORMAT_R32G32B32A32_SFLOAT),
+	m_AccumulationRenderPass(VK_NULL_HANDLE),
+	m_AccumulationImage(VK_NULL_HANDLE),
+	m_AccumulationImageMemory(VK_NULL_HANDLE),
+	m_AccumulationImageView(VK_NULL_HANDLE),
+	m_AccumulationFramebuffer(VK_NULL_HANDLE),
+	m_AccumulationDescriptorSet(VK_NULL_HANDLE),
+	m_AccumulatedSampleCount(0),
+	m_InteriorChecks(),
+	m_CounterBuffer(),
+	m_Counters(nullptr),
+	m_CounterFence(VK_NULL_HANDLE),
+	m_CounterIterationCount(0),
+	m_CounterQuerySlot(0),
+	m_LastHitRateTime(0.0),
+	m_IterationCount(800),
+	m_AutoIterations(true),
+	m_EscapeTimeIterationCount(0),
+	m_EscapeHistogram(),
+	m_EscapeHistogramIterationCount(0),
+	m_OfflineRenderer(nullptr),
 	m_ImageIndex(0),
 	m_FrameIndex(0),
 	m_InFlightFences(),
@@ -120,6 +186,19 @@ VulkanApp::~VulkanApp()
 
 bool VulkanApp::Initialize()
 {
+	/* The compute path does not need a window, surface or swapchain */
+	if (m_RenderMethod == ERenderMethod::Compute)
+	{
+		m_OfflineRenderer = new OfflineRenderer(OfflineRenderSettings());
+		if (!m_OfflineRenderer->Initialize())
+		{
+			printf("Failed to initialize offline renderer\n");
+			return false;
+		}
+
+		return true;
+	}
+
 	if (!CreateInstance())
 	{
 		printf("Failed to create vulkan instance\n");
@@ -132,63 +211,46 @@ bool VulkanApp::Initialize()
 		return false;
 	}
 
-	if (m_RenderMethod == ERenderMethod::Graphics)
+	if (!LoadAssets())
 	{
-		if (!LoadAssets())
-		{
-			printf("Failed to load assets\n");
-			return false;
-		}
+		printf("Failed to load assets\n");
+		return false;
+	}
 
-		if (!CreateSurface())
-		{
-			printf("Failed to create vulkan surface\n");
-			return false;
-		}
+	if (!CreateSurface())
+	{
+		printf("Failed to create vulkan surface\n");
+		return false;
+	}
 
-		if (!CreateSwapchain())
-		{
-			printf("Failed to create vulkan swapchain\n");
-			return false;
-		}
+	if (!CreateSwapchain())
+	{
+		printf("Failed to create vulkan swapchain\n");
+		return false;
+	}
 
-		if (!CreateGraphicsBasedPipeline())
-		{
-			printf("Failed to create graphics based pipeline\n");
-			return false;
-		}
+	if (!CreateGraphicsBasedPipeline())
+	{
+		printf("Failed to create graphics based pipeline\n");
+		return false;
+	}
 
-		if (!AllocateGraphicsCommandBuffers())
-		{
-			printf("Failed to allocate graphics command buffers\n");
-			return false;
-		}
+	if (m_RenderMethod == ERenderMethod::AsyncCompute && !CreateEscapeTimeComputePipeline())
+	{
+		printf("Failed to create escape time compute pipeline\n");
+		return false;
+	}
 
-		if (!RecordGraphicsCommandBuffers())
-		{
-			printf("Failed to create graphics command buffers\n");
-			return false;
-		}
+	if (!CreateEscapeTimeTarget())
+	{
+		printf("Failed to create escape time target\n");
+		return false;
 	}
-	else
+
+	if (!AllocateGraphicsCommandBuffers())
 	{
-		if (!CreateComputeBasedPipeline())
-		{
-			printf("Failed to create compute based pipeline\n");
-			return false;
-		}
-		
-		if (!AllocateComputeCommandBuffers())
-		{
-			printf("Failed to allocate compute commands buffers\n");
-			return false;
-		}
-		
-		if (!RecordComputeCommandBuffers())
-		{
-			printf("Failed to create compute command buffers\n");
-			return false;
-		}
+		printf("Failed to allocate graphics command buffers\n");
+		return false;
 	}
 
 	return true;
@@ -198,10 +260,7 @@ bool VulkanApp::Run()
 {
 	double timer = 0.0;
 	if (m_RenderMethod == ERenderMethod::Compute)
-	{
-		DrawFrame();
-		return true;
-	}
+		return m_OfflineRenderer->Render();
 
 	while (m_Running) 
 	{
@@ -212,7 +271,16 @@ bool VulkanApp::Run()
 		timer = Platform::GetAbsoluteTime();
 
 		UpdateFrameData(deltaTime);
-		DrawFrame();
+		if (!DrawFrame())
+		{
+			/* Nothing left to draw until input arrives or the pending counters land, the frame timer restarts so the wait is not taken as movement */
+			if (m_CounterFence)
+				vkWaitForFences(m_LogicalDevice, 1, &m_CounterFence, VK_TRUE, Utilities::CounterWaitTimeout);
+			else
+				m_Window->WaitEvents();
+
+			timer = Platform::GetAbsoluteTime();
+		}
 	}
 
 	return true;
@@ -220,6 +288,14 @@ bool VulkanApp::Run()
 
 bool VulkanApp::Shutdown()
 {
+	if (m_OfflineRenderer)
+	{
+		const bool result = m_OfflineRenderer->Shutdown();
+		delete m_OfflineRenderer;
+		m_OfflineRenderer = nullptr;
+		return result;
+	}
+
 	VK_CHECK(vkDeviceWaitIdle(m_LogicalDevice));
 	delete m_ColorPaletteImage;
 	/* Device level */
@@ -227,19 +303,38 @@ bool VulkanApp::Shutdown()
 
 	/* Graphics */
 	/* Destroy buffers */
-	if (m_UBOBuffer.Handle)
+	if (m_UBORing.Handle)
+	{
+		vkFreeMemory(
+			m_LogicalDevice,
+			m_UBORing.DeviceMemory,
+			nullptr);
+
+		vkDestroyBuffer(
+			m_LogicalDevice,
+			m_UBORing.Handle,
+			nullptr);
+	}
+
+	if (m_CounterBuffer.Handle)
 	{
 		vkFreeMemory(
 			m_LogicalDevice,
-			m_UBOBuffer.DeviceMemory,
+			m_CounterBuffer.DeviceMemory,
 			nullptr);
 
 		vkDestroyBuffer(
 			m_LogicalDevice,
-			m_UBOBuffer.Handle,
+			m_CounterBuffer.Handle,
 			nullptr);
 	}
 
+	if (m_EscapeTimeQueryPool)
+		vkDestroyQueryPool(
+			m_LogicalDevice,
+			m_EscapeTimeQueryPool,
+			nullptr);
+
 	if (m_VertexBuffer.Handle)
 	{
 		vkFreeMemory(
@@ -266,11 +361,67 @@ bool VulkanApp::Shutdown()
 			nullptr);
 	}
 	
+	DestroyEscapeTimeTarget();
+
 	/* Destroy Pipelines */
-	if(m_GraphicsPipeline)
+	if(m_EscapeTimePipeline)
+		vkDestroyPipeline(
+			m_LogicalDevice,
+			m_EscapeTimePipeline,
+			nullptr);
+
+	if (m_DoublePrecisionEscapeTimePipeline)
+		vkDestroyPipeline(
+			m_LogicalDevice,
+			m_DoublePrecisionEscapeTimePipeline,
+			nullptr);
+
+	if(m_ColoringPipeline)
+		vkDestroyPipeline(
+			m_LogicalDevice,
+			m_ColoringPipeline,
+			nullptr);
+
+	if (m_AccumulationPipeline)
+		vkDestroyPipeline(
+			m_LogicalDevice,
+			m_AccumulationPipeline,
+			nullptr);
+
+	if (m_ResolvePipeline)
 		vkDestroyPipeline(
 			m_LogicalDevice,
-			m_GraphicsPipeline,
+			m_ResolvePipeline,
+			nullptr);
+
+	if (m_EscapeTimeComputePipeline)
+		vkDestroyPipeline(
+			m_LogicalDevice,
+			m_EscapeTimeComputePipeline,
+			nullptr);
+
+	if (m_DoublePrecisionEscapeTimeComputePipeline)
+		vkDestroyPipeline(
+			m_LogicalDevice,
+			m_DoublePrecisionEscapeTimeComputePipeline,
+			nullptr);
+
+	if (m_EscapeTimeRenderPass)
+		vkDestroyRenderPass(
+			m_LogicalDevice,
+			m_EscapeTimeRenderPass,
+			nullptr);
+
+	if (m_AccumulationRenderPass)
+		vkDestroyRenderPass(
+			m_LogicalDevice,
+			m_AccumulationRenderPass,
+			nullptr);
+
+	if (m_EscapeTimeSampler)
+		vkDestroySampler(
+			m_LogicalDevice,
+			m_EscapeTimeSampler,
 			nullptr);
 
 	if (m_GraphicsPipelineLayout)
@@ -279,6 +430,12 @@ bool VulkanApp::Shutdown()
 			m_GraphicsPipelineLayout,
 			nullptr);
 
+	if (m_EscapeTimeComputePipelineLayout)
+		vkDestroyPipelineLayout(
+			m_LogicalDevice,
+			m_EscapeTimeComputePipelineLayout,
+			nullptr);
+
 	if (m_GraphicsPipelineUBOBufferDescriptorSetLayout)
 		vkDestroyDescriptorSetLayout(
 			m_LogicalDevice,
@@ -291,12 +448,45 @@ bool VulkanApp::Shutdown()
 			m_GraphicsPipelineColorPaletteDescriptorSetLayout,
 			nullptr);
 
+	if (m_GraphicsPipelineEscapeTimeDescriptorSetLayout)
+		vkDestroyDescriptorSetLayout(
+			m_LogicalDevice,
+			m_GraphicsPipelineEscapeTimeDescriptorSetLayout,
+			nullptr);
+
+	if (m_EscapeTimeStorageDescriptorSetLayout)
+		vkDestroyDescriptorSetLayout(
+			m_LogicalDevice,
+			m_EscapeTimeStorageDescriptorSetLayout,
+			nullptr);
+
 	if (m_GraphicsPipelineColorPaletteDescriptorSet)
 		vkFreeDescriptorSets(
 			m_LogicalDevice,
 			m_GraphicsPipelineDescriptorPool,
 			1,
 			&m_GraphicsPipelineColorPaletteDescriptorSet);
+
+	if (m_GraphicsPipelineEscapeTimeDescriptorSet)
+		vkFreeDescriptorSets(
+			m_LogicalDevice,
+			m_GraphicsPipelineDescriptorPool,
+			1,
+			&m_GraphicsPipelineEscapeTimeDescriptorSet);
+
+	if (m_PreviousEscapeTimeDescriptorSet)
+		vkFreeDescriptorSets(
+			m_LogicalDevice,
+			m_GraphicsPipelineDescriptorPool,
+			1,
+			&m_PreviousEscapeTimeDescriptorSet);
+
+	if (m_EscapeTimeStorageDescriptorSets[0])
+		vkFreeDescriptorSets(
+			m_LogicalDevice,
+			m_GraphicsPipelineDescriptorPool,
+			static_cast<uint32_t>(m_EscapeTimeStorageDescriptorSets.size()),
+			m_EscapeTimeStorageDescriptorSets.data());
 			
 	if (m_GraphicsPipelineDescriptorPool)
 		vkDestroyDescriptorPool(
@@ -310,42 +500,6 @@ bool VulkanApp::Shutdown()
 			m_GraphicsCommandPool,
 			nullptr);
 	/* Compute */
-	if (m_ComputePipelineStorageBuffer.Handle)
-		vkDestroyBuffer(
-			m_LogicalDevice,
-			m_ComputePipelineStorageBuffer.Handle,
-			nullptr);
-
-	if (m_ComputePipelineStorageBuffer.DeviceMemory)
-		vkFreeMemory(
-			m_LogicalDevice,
-			m_ComputePipelineStorageBuffer.DeviceMemory,
-			nullptr);
-
-	if (m_ComputePipeline)
-		vkDestroyPipeline(
-			m_LogicalDevice,
-			m_ComputePipeline,
-			nullptr);
-
-	if (m_ComputePipelineLayout)
-		vkDestroyPipelineLayout(
-			m_LogicalDevice,
-			m_ComputePipelineLayout,
-			nullptr);
-
-	if (m_ComputePipelineDescriptorSetLayout)
-		vkDestroyDescriptorSetLayout(
-			m_LogicalDevice,
-			m_ComputePipelineDescriptorSetLayout,
-			nullptr);
-
-	if(m_ComputePipelineDescriptorPool)
-		vkDestroyDescriptorPool(
-			m_LogicalDevice,
-			m_ComputePipelineDescriptorPool,
-			nullptr);
-
 	if (m_ComputeCommandPool)
 		vkDestroyCommandPool(
 			m_LogicalDevice,
@@ -395,6 +549,8 @@ void VulkanApp::OnEvent(Event& event)
 			const auto [windowWidth, windowHeight] = e->GetSize();
 			m_SwapchainExtent.width = windowWidth;
 			m_SwapchainExtent.height = windowHeight;
+			/* An idle window draws nothing, this frame finds the swapchain out of date */
+			m_ColoringOutdated = true;
 
 			printf("Window resized: [width, height]: %d, %d\n", windowWidth, windowHeight);
 			break;
@@ -604,12 +760,34 @@ bool VulkanApp::CreateLogicalDevice()
 		}
 	}
 
-	if (m_RenderMethod == ERenderMethod::Graphics)
+	if (m_RenderMethod != ERenderMethod::Compute)
 		m_PresentQueue = m_GraphicsQueue;
 
+	/* The compute escape time pass stores to an rg32f image, an extended storage format */
+	VkFormatProperties escapeTimeFormatProperties;
+	vkGetPhysicalDeviceFormatProperties(
+		m_PhysicalDevice,
+		Utilities::EscapeTimeFormat,
+		&escapeTimeFormatProperties);
+
+	if (m_RenderMethod == ERenderMethod::AsyncCompute &&
+		(!m_PhysicalDeviceFeatures.shaderStorageImageExtendedFormats || (escapeTimeFormatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) == 0))
+	{
+		printf("The device cannot store the escape time from compute shaders, falling back to the graphics escape time pass\n");
+		m_RenderMethod = ERenderMethod::Graphics;
+	}
+
 	constexpr float defaultQueuePrority[1] = { 1.0f };
 	VkPhysicalDeviceFeatures enabledFeatures = {};
 	enabledFeatures.shaderFloat64 = m_PhysicalDeviceFeatures.shaderFloat64;
+	enabledFeatures.shaderStorageImageExtendedFormats = m_RenderMethod == ERenderMethod::AsyncCompute ? VK_TRUE : VK_FALSE;
+	/* The escape time pass counts interior check hits with atomics, compute shaders always may */
+	enabledFeatures.fragmentStoresAndAtomics = m_PhysicalDeviceFeatures.fragmentStoresAndAtomics;
+	if (m_RenderMethod == ERenderMethod::Graphics && !m_PhysicalDeviceFeatures.fragmentStoresAndAtomics)
+	{
+		printf("The device does not support fragment stores and atomics\n");
+		return false;
+	}
 	
 	VkDeviceCreateInfo deviceCreateInfo;
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -899,6 +1077,7 @@ bool VulkanApp::CreateSwapchain()
 
 	m_Semaphores.PresentComplete.resize(m_MaxFramesInFlight);
 	m_Semaphores.RenderComplete.resize(m_MaxFramesInFlight);
+	m_Semaphores.ComputeComplete.resize(m_MaxFramesInFlight);
 	m_InFlightFences.resize(m_MaxFramesInFlight);
 	for (uint32_t i = 0; i < m_MaxFramesInFlight; ++i)
 	{
@@ -914,6 +1093,12 @@ bool VulkanApp::CreateSwapchain()
 			nullptr,
 			&m_Semaphores.RenderComplete[i]));
 
+		VK_CHECK(vkCreateSemaphore(
+			m_LogicalDevice,
+			&semaphoreCreateInfo,
+			nullptr,
+			&m_Semaphores.ComputeComplete[i]));
+
 		VK_CHECK(vkCreateFence(
 			m_LogicalDevice,
 			&fenceCreateInfo,
@@ -1184,22 +1369,57 @@ bool VulkanApp::CreateGraphicsBasedPipeline()
 			nullptr);
 	}
 	
-	/* TODO: Add support for doubles */
-	const bool deviceSupportsDoublePrecisionFloats = false; //m_PhysicalDeviceFeatures.shaderFloat64;
-	m_VertexShaderModule = CreateShaderModule(deviceSupportsDoublePrecisionFloats ? "assets/shaders/vertexShaderDoublePrecision.spv" : "assets/shaders/vertexShader.spv");
+	/* The float32 pass turns blocky below a zoom of about 1e-5, float64 reaches about 1e-14. UpdateFrameData() picks one per frame */
+	const bool deviceSupportsDoublePrecisionFloats = m_PhysicalDeviceFeatures.shaderFloat64 == VK_TRUE;
+	printf("Escape time pass in %s precision\n", deviceSupportsDoublePrecisionFloats ? "single and double" : "single");
+	/* The camera is pushed to the fragment stage, both precisions share the vertex shader */
+	m_VertexShaderModule = CreateShaderModule("assets/shaders/vertexShader.spv");
 	if (!m_VertexShaderModule)
 	{
 		printf("Failed to create vertex shader module\n");
 		return false;
 	}
 
-	m_FragmentShaderModule = CreateShaderModule(deviceSupportsDoublePrecisionFloats ? "assets/shaders/fragmentShaderDoublePrecision.spv" : "assets/shaders/fragmentShader.spv");
-	if (!m_FragmentShaderModule)
+	/* Subgroup ballots add each escape histogram bin once per subgroup instead of once per pixel */
+	VkPhysicalDeviceSubgroupProperties subgroupProperties{};
+	subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+	if (m_PhysicalDeviceProperties.apiVersion >= VK_API_VERSION_1_1)
+	{
+		VkPhysicalDeviceProperties2 properties{};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &subgroupProperties;
+		vkGetPhysicalDeviceProperties2(m_PhysicalDevice, &properties);
+	}
+
+	const bool deviceSupportsFragmentBallots = (subgroupProperties.supportedStages & VK_SHADER_STAGE_FRAGMENT_BIT) != 0 &&
+		(subgroupProperties.supportedOperations & VK_SUBGROUP_FEATURE_BALLOT_BIT) != 0;
+	printf("Escape histogram through %s\n", deviceSupportsFragmentBallots ? "subgroup ballots" : "atomics");
+	m_FragmentShaderModule = CreateShaderModule(deviceSupportsFragmentBallots ? "assets/shaders/fragmentShaderSubgroup.spv" : "assets/shaders/fragmentShader.spv");
+	VkShaderModule doublePrecisionFragmentShaderModule = VK_NULL_HANDLE;
+	if (deviceSupportsDoublePrecisionFloats)
+		doublePrecisionFragmentShaderModule = CreateShaderModule(deviceSupportsFragmentBallots ? "assets/shaders/fragmentShaderDoublePrecisionSubgroup.spv" : "assets/shaders/fragmentShaderDoublePrecision.spv");
+
+	if (!m_FragmentShaderModule || (deviceSupportsDoublePrecisionFloats && !doublePrecisionFragmentShaderModule))
 	{
 		printf("Failed to create fragment shader module\n");
 		return false;
 	}
 
+	m_ColoringShaderModule = CreateShaderModule("assets/shaders/coloringShader.spv");
+	if (!m_ColoringShaderModule)
+	{
+		printf("Failed to create coloring shader module\n");
+		return false;
+	}
+
+	const VkShaderModule accumulationShaderModule = CreateShaderModule("assets/shaders/coloringShaderAccumulate.spv");
+	const VkShaderModule resolveShaderModule = CreateShaderModule("assets/shaders/resolveShader.spv");
+	if (!accumulationShaderModule || !resolveShaderModule)
+	{
+		printf("Failed to create accumulation shader modules\n");
+		return false;
+	}
+
 	VkPipelineShaderStageCreateInfo vertShaderStageInfo;
 	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -1310,11 +1530,18 @@ bool VulkanApp::CreateGraphicsBasedPipeline()
 		VkDescriptorSetLayoutBinding uboBinding;
 		uboBinding.binding = 0;
 		uboBinding.descriptorCount = 1;
-		uboBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		uboBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		uboBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		uboBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 		uboBinding.pImmutableSamplers = nullptr;
 
-		const std::array<VkDescriptorSetLayoutBinding, 1> bindings{ uboBinding };
+		VkDescriptorSetLayoutBinding checkCountBinding;
+		checkCountBinding.binding = 1;
+		checkCountBinding.descriptorCount = 1;
+		checkCountBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		checkCountBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+		checkCountBinding.pImmutableSamplers = nullptr;
+
+		const std::array<VkDescriptorSetLayoutBinding, 2> bindings{ uboBinding, checkCountBinding };
 		VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo;
 		descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 		descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
@@ -1352,13 +1579,43 @@ bool VulkanApp::CreateGraphicsBasedPipeline()
 			&m_GraphicsPipelineColorPaletteDescriptorSetLayout));
 	}
 
-	const std::array<VkDescriptorSetLayout, 2> descriptorSetLayouts{ m_GraphicsPipelineUBOBufferDescriptorSetLayout, m_GraphicsPipelineColorPaletteDescriptorSetLayout };
+	{
+		VkDescriptorSetLayoutBinding escapeTimeBinding;
+		escapeTimeBinding.binding = 0;
+		escapeTimeBinding.descriptorCount = 1;
+		escapeTimeBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		escapeTimeBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+		escapeTimeBinding.pImmutableSamplers = nullptr;
+
+		const std::array<VkDescriptorSetLayoutBinding, 1> bindings{ escapeTimeBinding };
+		VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo;
+		descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		descriptorSetLayoutCreateInfo.pBindings = bindings.data();
+		descriptorSetLayoutCreateInfo.flags = 0;
+		descriptorSetLayoutCreateInfo.pNext = nullptr;
+
+		VK_CHECK(vkCreateDescriptorSetLayout(
+			m_LogicalDevice,
+			&descriptorSetLayoutCreateInfo,
+			nullptr,
+			&m_GraphicsPipelineEscapeTimeDescriptorSetLayout));
+	}
+
+	/* The camera changes with nearly every frame, it is pushed rather than written to the ring */
+	VkPushConstantRange cameraPushConstantRange;
+	cameraPushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	cameraPushConstantRange.offset = 0;
+	cameraPushConstantRange.size = sizeof(CameraPushConstants);
+
+	/* Both passes share the layout, the escape time pass only binds set 0 */
+	const std::array<VkDescriptorSetLayout, 3> descriptorSetLayouts{ m_GraphicsPipelineUBOBufferDescriptorSetLayout, m_GraphicsPipelineColorPaletteDescriptorSetLayout, m_GraphicsPipelineEscapeTimeDescriptorSetLayout };
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo;
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
 	pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data(); 
-	pipelineLayoutInfo.pushConstantRangeCount = 0;
-	pipelineLayoutInfo.pPushConstantRanges = nullptr;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &cameraPushConstantRange;
 	pipelineLayoutInfo.flags = 0;
 	pipelineLayoutInfo.pNext = nullptr;
 	
@@ -1369,13 +1626,24 @@ bool VulkanApp::CreateGraphicsBasedPipeline()
 
 	VkDescriptorPoolSize uboBufferdescriptorPoolSize;
 	uboBufferdescriptorPoolSize.descriptorCount = 1;
-	uboBufferdescriptorPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uboBufferdescriptorPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 
+	/* Color palette, escape time, previous escape time and accumulation */
 	VkDescriptorPoolSize colorPalleteImagedescriptorPoolSize;
-	colorPalleteImagedescriptorPoolSize.descriptorCount = 1;
+	colorPalleteImagedescriptorPoolSize.descriptorCount = 4;
 	colorPalleteImagedescriptorPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 
-	const std::array<VkDescriptorPoolSize, 2> descriptorPoolSizes{ uboBufferdescriptorPoolSize, colorPalleteImagedescriptorPoolSize };
+	/* Interior check counters */
+	VkDescriptorPoolSize checkCountDescriptorPoolSize;
+	checkCountDescriptorPoolSize.descriptorCount = 1;
+	checkCountDescriptorPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
+	/* Escape time images of the async compute mode */
+	VkDescriptorPoolSize storageImageDescriptorPoolSize;
+	storageImageDescriptorPoolSize.descriptorCount = 2;
+	storageImageDescriptorPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+
+	const std::array<VkDescriptorPoolSize, 4> descriptorPoolSizes{ uboBufferdescriptorPoolSize, colorPalleteImagedescriptorPoolSize, checkCountDescriptorPoolSize, storageImageDescriptorPoolSize };
 	VkDescriptorPoolCreateInfo descriptorPoolCreateInfo;
 	descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 	descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());
@@ -1414,13 +1682,49 @@ bool VulkanApp::CreateGraphicsBasedPipeline()
 		&colorPalleteImageDescriptorSetAllocateInfo,
 		&m_GraphicsPipelineColorPaletteDescriptorSet));
 
+	/* Written by CreateEscapeTimeTarget(), the image changes with the swapchain size */
+	VkDescriptorSetAllocateInfo escapeTimeDescriptorSetAllocateInfo;
+	escapeTimeDescriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	escapeTimeDescriptorSetAllocateInfo.descriptorPool = m_GraphicsPipelineDescriptorPool;
+	escapeTimeDescriptorSetAllocateInfo.descriptorSetCount = 1;
+	escapeTimeDescriptorSetAllocateInfo.pSetLayouts = &m_GraphicsPipelineEscapeTimeDescriptorSetLayout;
+	escapeTimeDescriptorSetAllocateInfo.pNext = nullptr;
+
+	VK_CHECK(vkAllocateDescriptorSets(
+		m_LogicalDevice,
+		&escapeTimeDescriptorSetAllocateInfo,
+		&m_GraphicsPipelineEscapeTimeDescriptorSet));
+
+	VK_CHECK(vkAllocateDescriptorSets(
+		m_LogicalDevice,
+		&escapeTimeDescriptorSetAllocateInfo,
+		&m_PreviousEscapeTimeDescriptorSet));
+
+	VK_CHECK(vkAllocateDescriptorSets(
+		m_LogicalDevice,
+		&escapeTimeDescriptorSetAllocateInfo,
+		&m_AccumulationDescriptorSet));
+
+	/* One slot per frame in flight, each aligned for a dynamic offset */
+	const VkDeviceSize uboAlignment = std::max<VkDeviceSize>(m_PhysicalDeviceProperties.limits.minUniformBufferOffsetAlignment, 1);
+	m_UBORingStride = (sizeof(UBO) + uboAlignment - 1) / uboAlignment * uboAlignment;
+
 	VkBufferCreateInfo uboBufferCreateInfo;
 	uboBufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	uboBufferCreateInfo.size = sizeof(UBO);
+	uboBufferCreateInfo.size = m_UBORingStride * m_MaxFramesInFlight;
 	uboBufferCreateInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
 	uboBufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 	uboBufferCreateInfo.queueFamilyIndexCount = VK_QUEUE_FAMILY_IGNORED;
 	uboBufferCreateInfo.pQueueFamilyIndices = nullptr;
+
+	/* The async compute mode reads each slot on both queues */
+	const std::array<uint32_t, 2> queueFamilies{ static_cast<uint32_t>(m_QueueIndices.Graphics), static_cast<uint32_t>(m_QueueIndices.Compute) };
+	if (m_RenderMethod == ERenderMethod::AsyncCompute && m_QueueIndices.Compute != m_QueueIndices.Graphics)
+	{
+		uboBufferCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		uboBufferCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+		uboBufferCreateInfo.pQueueFamilyIndices = queueFamilies.data();
+	}
 	uboBufferCreateInfo.flags = 0;
 	uboBufferCreateInfo.pNext = nullptr;
 
@@ -1428,12 +1732,12 @@ bool VulkanApp::CreateGraphicsBasedPipeline()
 		m_LogicalDevice,
 		&uboBufferCreateInfo,
 		nullptr,
-		&m_UBOBuffer.Handle));
+		&m_UBORing.Handle));
 
 	VkMemoryRequirements uboBufferMemoryRequirements;
 	vkGetBufferMemoryRequirements(
 		m_LogicalDevice,
-		m_UBOBuffer.Handle,
+		m_UBORing.Handle,
 		&uboBufferMemoryRequirements);
 
 	VkMemoryAllocateInfo uboBufferMemoryAllocationInfo;
@@ -1446,12 +1750,12 @@ bool VulkanApp::CreateGraphicsBasedPipeline()
 		m_LogicalDevice,
 		&uboBufferMemoryAllocationInfo,
 		nullptr,
-		&m_UBOBuffer.DeviceMemory));
+		&m_UBORing.DeviceMemory));
 
 	vkBindBufferMemory(
 		m_LogicalDevice,
-		m_UBOBuffer.Handle,
-		m_UBOBuffer.DeviceMemory,
+		m_UBORing.Handle,
+		m_UBORing.DeviceMemory,
 		0);
 
 	VkWriteDescriptorSet colorPalleteDescriptorSetWrite{};
@@ -1473,21 +1777,21 @@ bool VulkanApp::CreateGraphicsBasedPipeline()
 		0,
 		nullptr);
 
-	glm::mat4 __temp = glm::mat4(1.0f);
-
-	void* data;
-	vkMapMemory(m_LogicalDevice, m_UBOBuffer.DeviceMemory, 0, sizeof(UBO), 0, &data);
-	memcpy(data, &__temp, sizeof(UBO));
-	vkUnmapMemory(m_LogicalDevice, m_UBOBuffer.DeviceMemory);
+	/* Host coherent and never unmapped, a frame's slot is written once its fence signaled */
+	void* uboRingData;
+	VK_CHECK(vkMapMemory(m_LogicalDevice, m_UBORing.DeviceMemory, 0, uboBufferCreateInfo.size, 0, &uboRingData));
+	m_UBORingData = static_cast<uint8_t*>(uboRingData);
+	memset(m_UBORingData, 0, static_cast<size_t>(uboBufferCreateInfo.size));
 
+	/* The dynamic offset picks the slot */
 	VkDescriptorBufferInfo bufferInfo;
-	bufferInfo.buffer = m_UBOBuffer.Handle;
+	bufferInfo.buffer = m_UBORing.Handle;
 	bufferInfo.range = sizeof(UBO);
 	bufferInfo.offset = 0;
 
 	VkWriteDescriptorSet uboBufferDescriptorSetWrite{};
 	uboBufferDescriptorSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	uboBufferDescriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	uboBufferDescriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	uboBufferDescriptorSetWrite.dstBinding = 0;
 	uboBufferDescriptorSetWrite.dstArrayElement = 0;
 	uboBufferDescriptorSetWrite.descriptorCount = 1;
@@ -1504,6 +1808,75 @@ bool VulkanApp::CreateGraphicsBasedPipeline()
 		0,
 		nullptr);
 
+	/* Cleared by every escape time pass and read on the host, a few atomics per frame do not need device-local memory */
+	VkBufferCreateInfo counterBufferCreateInfo;
+	counterBufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	counterBufferCreateInfo.size = (Utilities::CounterHistogramOffset + AutoIteration::HistogramBinCount) * sizeof(uint32_t);
+	counterBufferCreateInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	counterBufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	counterBufferCreateInfo.queueFamilyIndexCount = 0;
+	counterBufferCreateInfo.pQueueFamilyIndices = nullptr;
+	counterBufferCreateInfo.flags = 0;
+	counterBufferCreateInfo.pNext = nullptr;
+
+	VK_CHECK(vkCreateBuffer(
+		m_LogicalDevice,
+		&counterBufferCreateInfo,
+		nullptr,
+		&m_CounterBuffer.Handle));
+
+	VkMemoryRequirements counterBufferMemoryRequirements;
+	vkGetBufferMemoryRequirements(
+		m_LogicalDevice,
+		m_CounterBuffer.Handle,
+		&counterBufferMemoryRequirements);
+
+	VkMemoryAllocateInfo counterBufferMemoryAllocationInfo;
+	counterBufferMemoryAllocationInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	counterBufferMemoryAllocationInfo.allocationSize = counterBufferMemoryRequirements.size;
+	counterBufferMemoryAllocationInfo.memoryTypeIndex = RetrieveMemoryTypeIndex(counterBufferMemoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+	counterBufferMemoryAllocationInfo.pNext = nullptr;
+
+	VK_CHECK(vkAllocateMemory(
+		m_LogicalDevice,
+		&counterBufferMemoryAllocationInfo,
+		nullptr,
+		&m_CounterBuffer.DeviceMemory));
+
+	vkBindBufferMemory(
+		m_LogicalDevice,
+		m_CounterBuffer.Handle,
+		m_CounterBuffer.DeviceMemory,
+		0);
+
+	void* counters;
+	VK_CHECK(vkMapMemory(m_LogicalDevice, m_CounterBuffer.DeviceMemory, 0, counterBufferCreateInfo.size, 0, &counters));
+	m_Counters = static_cast<uint32_t*>(counters);
+
+	VkDescriptorBufferInfo counterBufferInfo;
+	counterBufferInfo.buffer = m_CounterBuffer.Handle;
+	counterBufferInfo.range = counterBufferCreateInfo.size;
+	counterBufferInfo.offset = 0;
+
+	VkWriteDescriptorSet counterDescriptorSetWrite{};
+	counterDescriptorSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	counterDescriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	counterDescriptorSetWrite.dstBinding = 1;
+	counterDescriptorSetWrite.dstArrayElement = 0;
+	counterDescriptorSetWrite.descriptorCount = 1;
+	counterDescriptorSetWrite.dstSet = m_GraphicsPipelineUBOBufferDescriptorSet;
+	counterDescriptorSetWrite.pBufferInfo = &counterBufferInfo;
+	counterDescriptorSetWrite.pImageInfo = nullptr;
+	counterDescriptorSetWrite.pTexelBufferView = nullptr;
+	counterDescriptorSetWrite.pNext = nullptr;
+
+	vkUpdateDescriptorSets(
+		m_LogicalDevice,
+		1,
+		&counterDescriptorSetWrite,
+		0,
+		nullptr);
+
 	if (vkCreatePipelineLayout(
 		m_LogicalDevice, 
 		&pipelineLayoutInfo, 
@@ -1514,18 +1887,139 @@ bool VulkanApp::CreateGraphicsBasedPipeline()
 		return false;
 	}
 
-	VkGraphicsPipelineCreateInfo pipelineInfo{};
-	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
-	pipelineInfo.pStages = shaderStages.data();
-	pipelineInfo.pVertexInputState = &vertexInputInfo;
-	pipelineInfo.pInputAssemblyState = &inputAssembly;
-	pipelineInfo.pViewportState = &viewportState;
-	pipelineInfo.pRasterizationState = &rasterizerStateInfo;
-	pipelineInfo.pMultisampleState = &multisampling;
-	pipelineInfo.pColorBlendState = &colorBlending;
-	pipelineInfo.layout = m_GraphicsPipelineLayout;
-	pipelineInfo.renderPass = m_SwapchainRenderPass;
+	/* Escape time render pass, the result is sampled by the coloring pass of the same and later frames */
+	VkAttachmentDescription escapeTimeAttachment;
+	escapeTimeAttachment.format = Utilities::EscapeTimeFormat;
+	escapeTimeAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	escapeTimeAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	escapeTimeAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	escapeTimeAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	escapeTimeAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	escapeTimeAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	escapeTimeAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	escapeTimeAttachment.flags = 0;
+
+	VkAttachmentReference escapeTimeAttachmentReference;
+	escapeTimeAttachmentReference.attachment = 0;
+	escapeTimeAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription escapeTimeSubpassDescription;
+	escapeTimeSubpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	escapeTimeSubpassDescription.colorAttachmentCount = 1;
+	escapeTimeSubpassDescription.pColorAttachments = &escapeTimeAttachmentReference;
+	escapeTimeSubpassDescription.inputAttachmentCount = 0;
+	escapeTimeSubpassDescription.pInputAttachments = nullptr;
+	escapeTimeSubpassDescription.preserveAttachmentCount = 0;
+	escapeTimeSubpassDescription.pPreserveAttachments = nullptr;
+	escapeTimeSubpassDescription.pResolveAttachments = nullptr;
+	escapeTimeSubpassDescription.pDepthStencilAttachment = nullptr;
+	escapeTimeSubpassDescription.flags = 0;
+
+	/* Previous coloring passes and copies finish reading before the image is overwritten, this coloring pass waits for the write */
+	std::array<VkSubpassDependency, 2> escapeTimeSubpassDependencies;
+	escapeTimeSubpassDependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	escapeTimeSubpassDependencies[0].dstSubpass = 0;
+	escapeTimeSubpassDependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+	escapeTimeSubpassDependencies[0].srcAccessMask = 0;
+	escapeTimeSubpassDependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	escapeTimeSubpassDependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	escapeTimeSubpassDependencies[0].dependencyFlags = 0;
+
+	escapeTimeSubpassDependencies[1].srcSubpass = 0;
+	escapeTimeSubpassDependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	escapeTimeSubpassDependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	escapeTimeSubpassDependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	escapeTimeSubpassDependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	escapeTimeSubpassDependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	escapeTimeSubpassDependencies[1].dependencyFlags = 0;
+
+	VkRenderPassCreateInfo escapeTimeRenderPassCreateInfo;
+	escapeTimeRenderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	escapeTimeRenderPassCreateInfo.attachmentCount = 1;
+	escapeTimeRenderPassCreateInfo.pAttachments = &escapeTimeAttachment;
+	escapeTimeRenderPassCreateInfo.dependencyCount = static_cast<uint32_t>(escapeTimeSubpassDependencies.size());
+	escapeTimeRenderPassCreateInfo.pDependencies = escapeTimeSubpassDependencies.data();
+	escapeTimeRenderPassCreateInfo.subpassCount = 1;
+	escapeTimeRenderPassCreateInfo.pSubpasses = &escapeTimeSubpassDescription;
+	escapeTimeRenderPassCreateInfo.flags = 0;
+	escapeTimeRenderPassCreateInfo.pNext = nullptr;
+
+	VK_CHECK(vkCreateRenderPass(
+		m_LogicalDevice,
+		&escapeTimeRenderPassCreateInfo,
+		nullptr,
+		&m_EscapeTimeRenderPass));
+
+	/* Float32 keeps the running mean of Accumulation::SampleCount samples exact, blending float16 targets is the fallback every device supports */
+	VkFormatProperties accumulationFormatProperties;
+	vkGetPhysicalDeviceFormatProperties(
+		m_PhysicalDevice,
+		VK_FORMAT_R32G32B32A32_SFLOAT,
+		&accumulationFormatProperties);
+
+	m_AccumulationFormat = (accumulationFormatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BLEND_BIT) != 0 ? VK_FORMAT_R32G32B32A32_SFLOAT : VK_FORMAT_R16G16B16A16_SFLOAT;
+
+	/* Accumulation render pass, every sample blends over the mean kept from the samples before */
+	VkAttachmentDescription accumulationAttachment = escapeTimeAttachment;
+	accumulationAttachment.format = m_AccumulationFormat;
+	accumulationAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	accumulationAttachment.initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	/* The previous sample's blend and resolve finish before this sample blends, the resolve pass waits for it */
+	std::array<VkSubpassDependency, 2> accumulationSubpassDependencies = escapeTimeSubpassDependencies;
+	accumulationSubpassDependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	accumulationSubpassDependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	accumulationSubpassDependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	VkRenderPassCreateInfo accumulationRenderPassCreateInfo = escapeTimeRenderPassCreateInfo;
+	accumulationRenderPassCreateInfo.pAttachments = &accumulationAttachment;
+	accumulationRenderPassCreateInfo.pDependencies = accumulationSubpassDependencies.data();
+
+	VK_CHECK(vkCreateRenderPass(
+		m_LogicalDevice,
+		&accumulationRenderPassCreateInfo,
+		nullptr,
+		&m_AccumulationRenderPass));
+
+	/* The coloring pass reads exact texels with texelFetch, the sampler never filters */
+	VkSamplerCreateInfo escapeTimeSamplerCreateInfo;
+	escapeTimeSamplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	escapeTimeSamplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+	escapeTimeSamplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+	escapeTimeSamplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	escapeTimeSamplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	escapeTimeSamplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	escapeTimeSamplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	escapeTimeSamplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+	escapeTimeSamplerCreateInfo.maxAnisotropy = 1.0f;
+	escapeTimeSamplerCreateInfo.mipLodBias = 0.0f;
+	escapeTimeSamplerCreateInfo.minLod = 0.0f;
+	escapeTimeSamplerCreateInfo.maxLod = 0.0f;
+	escapeTimeSamplerCreateInfo.compareEnable = VK_FALSE;
+	escapeTimeSamplerCreateInfo.compareOp = VK_COMPARE_OP_NEVER;
+	escapeTimeSamplerCreateInfo.anisotropyEnable = VK_FALSE;
+	escapeTimeSamplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
+	escapeTimeSamplerCreateInfo.flags = 0;
+	escapeTimeSamplerCreateInfo.pNext = nullptr;
+
+	VK_CHECK(vkCreateSampler(
+		m_LogicalDevice,
+		&escapeTimeSamplerCreateInfo,
+		nullptr,
+		&m_EscapeTimeSampler));
+
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+	pipelineInfo.pStages = shaderStages.data();
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizerStateInfo;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.layout = m_GraphicsPipelineLayout;
+	pipelineInfo.renderPass = m_EscapeTimeRenderPass;
 	pipelineInfo.pDynamicState = &dynamicStateInfo;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.subpass = 0;
@@ -1535,9 +2029,98 @@ bool VulkanApp::CreateGraphicsBasedPipeline()
 		1, 
 		&pipelineInfo, 
 		nullptr, 
-		&m_GraphicsPipeline) != VK_SUCCESS) 
+		&m_EscapeTimePipeline) != VK_SUCCESS) 
+	{
+		printf("Failed to create escape time pipeline\n");
+		return false;
+	}
+
+	/* Same state, float64 escape time fragment shader */
+	VkPipelineShaderStageCreateInfo doublePrecisionShaderStageInfo = fragShaderStageInfo;
+	doublePrecisionShaderStageInfo.module = doublePrecisionFragmentShaderModule;
+
+	const std::array<VkPipelineShaderStageCreateInfo, 2> doublePrecisionShaderStages{ vertShaderStageInfo, doublePrecisionShaderStageInfo };
+	pipelineInfo.pStages = doublePrecisionShaderStages.data();
+
+	if (doublePrecisionFragmentShaderModule && vkCreateGraphicsPipelines(
+		m_LogicalDevice, VK_NULL_HANDLE, 
+		1, 
+		&pipelineInfo, 
+		nullptr, 
+		&m_DoublePrecisionEscapeTimePipeline) != VK_SUCCESS) 
+	{
+		printf("Failed to create double precision escape time pipeline\n");
+		return false;
+	}
+
+	/* Same state, coloring fragment shader into the swapchain image */
+	VkPipelineShaderStageCreateInfo coloringShaderStageInfo = fragShaderStageInfo;
+	coloringShaderStageInfo.module = m_ColoringShaderModule;
+
+	const std::array<VkPipelineShaderStageCreateInfo, 2> coloringShaderStages{ vertShaderStageInfo, coloringShaderStageInfo };
+	pipelineInfo.pStages = coloringShaderStages.data();
+	pipelineInfo.renderPass = m_SwapchainRenderPass;
+
+	if (vkCreateGraphicsPipelines(
+		m_LogicalDevice, VK_NULL_HANDLE, 
+		1, 
+		&pipelineInfo, 
+		nullptr, 
+		&m_ColoringPipeline) != VK_SUCCESS) 
+	{
+		printf("Failed to create coloring pipeline\n");
+		return false;
+	}
+
+	/* Coloring of a sample, blended over the running mean with the weight the shader writes to alpha */
+	VkPipelineColorBlendAttachmentState accumulationBlendAttachment = colorBlendAttachment;
+	accumulationBlendAttachment.blendEnable = VK_TRUE;
+	accumulationBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	accumulationBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	accumulationBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+	accumulationBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	accumulationBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+	accumulationBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+	VkPipelineColorBlendStateCreateInfo accumulationBlending = colorBlending;
+	accumulationBlending.pAttachments = &accumulationBlendAttachment;
+
+	VkPipelineShaderStageCreateInfo accumulationShaderStageInfo = fragShaderStageInfo;
+	accumulationShaderStageInfo.module = accumulationShaderModule;
+
+	const std::array<VkPipelineShaderStageCreateInfo, 2> accumulationShaderStages{ vertShaderStageInfo, accumulationShaderStageInfo };
+	pipelineInfo.pStages = accumulationShaderStages.data();
+	pipelineInfo.pColorBlendState = &accumulationBlending;
+	pipelineInfo.renderPass = m_AccumulationRenderPass;
+
+	if (vkCreateGraphicsPipelines(
+		m_LogicalDevice, VK_NULL_HANDLE, 
+		1, 
+		&pipelineInfo, 
+		nullptr, 
+		&m_AccumulationPipeline) != VK_SUCCESS) 
+	{
+		printf("Failed to create accumulation pipeline\n");
+		return false;
+	}
+
+	/* The running mean into the swapchain image */
+	VkPipelineShaderStageCreateInfo resolveShaderStageInfo = fragShaderStageInfo;
+	resolveShaderStageInfo.module = resolveShaderModule;
+
+	const std::array<VkPipelineShaderStageCreateInfo, 2> resolveShaderStages{ vertShaderStageInfo, resolveShaderStageInfo };
+	pipelineInfo.pStages = resolveShaderStages.data();
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.renderPass = m_SwapchainRenderPass;
+
+	if (vkCreateGraphicsPipelines(
+		m_LogicalDevice, VK_NULL_HANDLE, 
+		1, 
+		&pipelineInfo, 
+		nullptr, 
+		&m_ResolvePipeline) != VK_SUCCESS) 
 	{
-		printf("Failed to create graphics pipeline\n");
+		printf("Failed to create resolve pipeline\n");
 		return false;
 	}
 
@@ -1546,6 +2129,27 @@ bool VulkanApp::CreateGraphicsBasedPipeline()
 		m_FragmentShaderModule,
 		nullptr);
 
+	if (doublePrecisionFragmentShaderModule)
+		vkDestroyShaderModule(
+			m_LogicalDevice,
+			doublePrecisionFragmentShaderModule,
+			nullptr);
+
+	vkDestroyShaderModule(
+		m_LogicalDevice,
+		accumulationShaderModule,
+		nullptr);
+
+	vkDestroyShaderModule(
+		m_LogicalDevice,
+		resolveShaderModule,
+		nullptr);
+
+	vkDestroyShaderModule(
+		m_LogicalDevice,
+		m_ColoringShaderModule,
+		nullptr);
+
 	vkDestroyShaderModule(
 		m_LogicalDevice,
 		m_VertexShaderModule,
@@ -1554,150 +2158,288 @@ bool VulkanApp::CreateGraphicsBasedPipeline()
 	return true;
 }
 
-bool VulkanApp::CreateComputeBasedPipeline()
+bool VulkanApp::CreateEscapeTimeComputePipeline()
 {
-	constexpr uint32_t WORKGROUP_SIZE = 32U;
-
-	VkBufferCreateInfo bufferCreateInfo;
-	bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	bufferCreateInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-	bufferCreateInfo.size = Utilities::ComputeBufferSize; 
-	bufferCreateInfo.queueFamilyIndexCount = VK_QUEUE_FAMILY_IGNORED;
-	bufferCreateInfo.pQueueFamilyIndices = nullptr;
-	bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-	bufferCreateInfo.flags = 0;
-	bufferCreateInfo.pNext = nullptr;
+	{
+		VkDescriptorSetLayoutBinding escapeTimeOutputBinding;
+		escapeTimeOutputBinding.binding = 0;
+		escapeTimeOutputBinding.descriptorCount = 1;
+		escapeTimeOutputBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		escapeTimeOutputBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		escapeTimeOutputBinding.pImmutableSamplers = nullptr;
 
-	VK_CHECK(vkCreateBuffer(
-		m_LogicalDevice,
-		&bufferCreateInfo,
-		nullptr,
-		&m_ComputePipelineStorageBuffer.Handle));
+		VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo;
+		descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		descriptorSetLayoutCreateInfo.bindingCount = 1;
+		descriptorSetLayoutCreateInfo.pBindings = &escapeTimeOutputBinding;
+		descriptorSetLayoutCreateInfo.flags = 0;
+		descriptorSetLayoutCreateInfo.pNext = nullptr;
 
-	VkMemoryRequirements storageBufferMemoryRequirements;
-	vkGetBufferMemoryRequirements(
+		VK_CHECK(vkCreateDescriptorSetLayout(
+			m_LogicalDevice,
+			&descriptorSetLayoutCreateInfo,
+			nullptr,
+			&m_EscapeTimeStorageDescriptorSetLayout));
+	}
+
+	/* Written by CreateEscapeTimeTarget() */
+	const std::array<VkDescriptorSetLayout, 2> storageDescriptorSetLayouts{ m_EscapeTimeStorageDescriptorSetLayout, m_EscapeTimeStorageDescriptorSetLayout };
+	VkDescriptorSetAllocateInfo storageDescriptorSetAllocateInfo;
+	storageDescriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	storageDescriptorSetAllocateInfo.descriptorPool = m_GraphicsPipelineDescriptorPool;
+	storageDescriptorSetAllocateInfo.descriptorSetCount = static_cast<uint32_t>(storageDescriptorSetLayouts.size());
+	storageDescriptorSetAllocateInfo.pSetLayouts = storageDescriptorSetLayouts.data();
+	storageDescriptorSetAllocateInfo.pNext = nullptr;
+
+	VK_CHECK(vkAllocateDescriptorSets(
 		m_LogicalDevice,
-		m_ComputePipelineStorageBuffer.Handle,
-		&storageBufferMemoryRequirements);
+		&storageDescriptorSetAllocateInfo,
+		m_EscapeTimeStorageDescriptorSets.data()));
 
-	VkMemoryAllocateInfo storageBufferMemoryAllocateInfo;
-	storageBufferMemoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	storageBufferMemoryAllocateInfo.allocationSize = storageBufferMemoryRequirements.size;
-	storageBufferMemoryAllocateInfo.memoryTypeIndex = RetrieveMemoryTypeIndex(storageBufferMemoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-	storageBufferMemoryAllocateInfo.pNext = nullptr;
+	VkPushConstantRange cameraPushConstantRange;
+	cameraPushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	cameraPushConstantRange.offset = 0;
+	cameraPushConstantRange.size = sizeof(CameraPushConstants);
 
-	VK_CHECK(vkAllocateMemory(
+	/* Set 0 and 2 as in the escape time pass of the graphics pipeline, set 1 is the target */
+	const std::array<VkDescriptorSetLayout, 3> descriptorSetLayouts{ m_GraphicsPipelineUBOBufferDescriptorSetLayout, m_EscapeTimeStorageDescriptorSetLayout, m_GraphicsPipelineEscapeTimeDescriptorSetLayout };
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo;
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+	pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &cameraPushConstantRange;
+	pipelineLayoutInfo.flags = 0;
+	pipelineLayoutInfo.pNext = nullptr;
+
+	if (vkCreatePipelineLayout(
 		m_LogicalDevice,
-		&storageBufferMemoryAllocateInfo,
+		&pipelineLayoutInfo,
 		nullptr,
-		&m_ComputePipelineStorageBuffer.DeviceMemory));
+		&m_EscapeTimeComputePipelineLayout) != VK_SUCCESS)
+	{
+		printf("Failed to create escape time compute pipeline layout\n");
+		return false;
+	}
 
-	VK_CHECK(vkBindBufferMemory(
-		m_LogicalDevice,
-		m_ComputePipelineStorageBuffer.Handle,
-		m_ComputePipelineStorageBuffer.DeviceMemory,
-		0));
+	VkPhysicalDeviceSubgroupProperties subgroupProperties{};
+	subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+	if (m_PhysicalDeviceProperties.apiVersion >= VK_API_VERSION_1_1)
+	{
+		VkPhysicalDeviceProperties2 properties{};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &subgroupProperties;
+		vkGetPhysicalDeviceProperties2(m_PhysicalDevice, &properties);
+	}
 
-	m_ComputeShaderModule = CreateShaderModule("assets/shaders/computeShader.spv");
-	if (!m_ComputeShaderModule)
+	const bool deviceSupportsDoublePrecisionFloats = m_PhysicalDeviceFeatures.shaderFloat64 == VK_TRUE;
+	const bool deviceSupportsComputeBallots = (subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) != 0 &&
+		(subgroupProperties.supportedOperations & VK_SUBGROUP_FEATURE_BALLOT_BIT) != 0;
+	printf("Escape time pass on the async compute queue (family %d, graphics family %d)\n", m_QueueIndices.Compute, m_QueueIndices.Graphics);
+	/* Both precisions as in the graphics pipeline, UpdateFrameData() picks one per frame */
+	const VkShaderModule escapeTimeShaderModule = CreateShaderModule(deviceSupportsComputeBallots ? "assets/shaders/escapeTimeShaderSubgroup.spv" : "assets/shaders/escapeTimeShader.spv");
+	VkShaderModule doublePrecisionEscapeTimeShaderModule = VK_NULL_HANDLE;
+	if (deviceSupportsDoublePrecisionFloats)
+		doublePrecisionEscapeTimeShaderModule = CreateShaderModule(deviceSupportsComputeBallots ? "assets/shaders/escapeTimeShaderDoublePrecisionSubgroup.spv" : "assets/shaders/escapeTimeShaderDoublePrecision.spv");
+
+	if (!escapeTimeShaderModule || (deviceSupportsDoublePrecisionFloats && !doublePrecisionEscapeTimeShaderModule))
 	{
-		printf("Failed to create compute shader\n");
+		printf("Failed to create escape time compute shader module\n");
 		return false;
 	}
 
-	VkDescriptorSetLayoutBinding outImageBufferBinding;
-	outImageBufferBinding.binding = 0;
-	outImageBufferBinding.descriptorCount = 1;
-	outImageBufferBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	outImageBufferBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-	outImageBufferBinding.pImmutableSamplers = nullptr;
-
-	const std::array<VkDescriptorSetLayoutBinding, 1> bindings{ outImageBufferBinding };
-	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo;
-	descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-	descriptorSetLayoutCreateInfo.pBindings = bindings.data();
-	descriptorSetLayoutCreateInfo.flags = 0;
-	descriptorSetLayoutCreateInfo.pNext = nullptr;
+	VkPipelineShaderStageCreateInfo computeShaderStageInfo;
+	computeShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	computeShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	computeShaderStageInfo.module = escapeTimeShaderModule;
+	computeShaderStageInfo.pName = "main";
+	computeShaderStageInfo.pSpecializationInfo = nullptr;
+	computeShaderStageInfo.flags = 0;
+	computeShaderStageInfo.pNext = nullptr;
+
+	VkComputePipelineCreateInfo pipelineInfo;
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = computeShaderStageInfo;
+	pipelineInfo.layout = m_EscapeTimeComputePipelineLayout;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineInfo.basePipelineIndex = -1;
+	pipelineInfo.flags = 0;
+	pipelineInfo.pNext = nullptr;
 
-	if (vkCreateDescriptorSetLayout(
+	VkResult result = vkCreateComputePipelines(
 		m_LogicalDevice,
-		&descriptorSetLayoutCreateInfo,
+		VK_NULL_HANDLE,
+		1,
+		&pipelineInfo,
 		nullptr,
-		&m_ComputePipelineDescriptorSetLayout) != VK_SUCCESS)
+		&m_EscapeTimeComputePipeline);
+
+	if (result == VK_SUCCESS && doublePrecisionEscapeTimeShaderModule)
 	{
-		printf("Failed to create compute pipeline descriptor set layout\n");
-		return false;
+		pipelineInfo.stage.module = doublePrecisionEscapeTimeShaderModule;
+		result = vkCreateComputePipelines(
+			m_LogicalDevice,
+			VK_NULL_HANDLE,
+			1,
+			&pipelineInfo,
+			nullptr,
+			&m_DoublePrecisionEscapeTimeComputePipeline);
 	}
 
-	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo;
-	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-	pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
-	pipelineLayoutCreateInfo.setLayoutCount = 1;
-	pipelineLayoutCreateInfo.pSetLayouts = &m_ComputePipelineDescriptorSetLayout;
-	pipelineLayoutCreateInfo.flags = 0;
-	pipelineLayoutCreateInfo.pNext = nullptr;
-		
-	if (vkCreatePipelineLayout(	
+	vkDestroyShaderModule(
 		m_LogicalDevice,
-		&pipelineLayoutCreateInfo,
-		nullptr,
-		&m_ComputePipelineLayout) != VK_SUCCESS)
+		escapeTimeShaderModule,
+		nullptr);
+
+	if (doublePrecisionEscapeTimeShaderModule)
+		vkDestroyShaderModule(
+			m_LogicalDevice,
+			doublePrecisionEscapeTimeShaderModule,
+			nullptr);
+
+	if (result != VK_SUCCESS)
 	{
-		printf("Failed to create compute pipeline layout\n");
+		printf("Failed to create escape time compute pipeline\n");
 		return false;
 	}
 
-	VkDescriptorPoolSize storageBufferPoolSize;
-	storageBufferPoolSize.descriptorCount = 1;
-	storageBufferPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	return true;
+}
 
-	const std::array<VkDescriptorPoolSize, 1> poolSizes{ storageBufferPoolSize };
-	VkDescriptorPoolCreateInfo descriptorPoolCreateInfo;
-	descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	descriptorPoolCreateInfo.maxSets = 1;
-	descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-	descriptorPoolCreateInfo.pPoolSizes = poolSizes.data();
-	descriptorPoolCreateInfo.flags = 0;
-	descriptorPoolCreateInfo.pNext = nullptr;
+bool VulkanApp::CreateEscapeTimeTarget()
+{
+	/* The compute pass of the async compute mode stores to either escape time image */
+	const bool asyncCompute = m_RenderMethod == ERenderMethod::AsyncCompute;
+	const VkImageUsageFlags storageUsage = asyncCompute ? VK_IMAGE_USAGE_STORAGE_BIT : 0;
+	if (!CreateTargetImage(Utilities::EscapeTimeFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | storageUsage, m_EscapeTimeImage, m_EscapeTimeImageMemory, m_EscapeTimeImageView) ||
+		!CreateTargetImage(Utilities::EscapeTimeFormat, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | storageUsage, m_PreviousEscapeTimeImage, m_PreviousEscapeTimeImageMemory, m_PreviousEscapeTimeImageView) ||
+		!CreateTargetImage(m_AccumulationFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, m_AccumulationImage, m_AccumulationImageMemory, m_AccumulationImageView))
+		return false;
 
-	VK_CHECK(vkCreateDescriptorPool(
+	/* The recorded copy expects the previous image ready for sampling, its texels are only read once a pass filled it */
+	VkCommandBuffer commandBuffer = BeginRecordingSingleTimeUseCommands(false);
+	if (asyncCompute)
+	{
+		/* Stored to on the compute queue and sampled on both, neither image changes layout again */
+		SetImageLayout(
+			commandBuffer,
+			m_EscapeTimeImage,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+		SetImageLayout(
+			commandBuffer,
+			m_PreviousEscapeTimeImage,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+	}
+	else
+	{
+		SetImageLayout(
+			commandBuffer,
+			m_PreviousEscapeTimeImage,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	}
+
+	/* The first sample blends with weight 1 over whatever is there, which must not be NaN */
+	SetImageLayout(
+		commandBuffer,
+		m_AccumulationImage,
+		VK_IMAGE_LAYOUT_UNDEFINED,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	VkClearColorValue accumulationClearValue = { {0.0f, 0.0f, 0.0f, 0.0f} };
+	VkImageSubresourceRange accumulationSubresourceRange;
+	accumulationSubresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	accumulationSubresourceRange.baseMipLevel = 0;
+	accumulationSubresourceRange.levelCount = 1;
+	accumulationSubresourceRange.baseArrayLayer = 0;
+	accumulationSubresourceRange.layerCount = 1;
+
+	vkCmdClearColorImage(
+		commandBuffer,
+		m_AccumulationImage,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		&accumulationClearValue,
+		1,
+		&accumulationSubresourceRange);
+
+	SetImageLayout(
+		commandBuffer,
+		m_AccumulationImage,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+	EndRecordingSingleTimeUseCommands(commandBuffer, false);
+
+	VkFramebufferCreateInfo framebufferCreateInfo;
+	framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferCreateInfo.renderPass = m_EscapeTimeRenderPass;
+	framebufferCreateInfo.width = m_SwapchainExtent.width;
+	framebufferCreateInfo.height = m_SwapchainExtent.height;
+	framebufferCreateInfo.attachmentCount = 1;
+	framebufferCreateInfo.pAttachments = &m_EscapeTimeImageView;
+	framebufferCreateInfo.layers = 1;
+	framebufferCreateInfo.flags = 0;
+	framebufferCreateInfo.pNext = nullptr;
+
+	VK_CHECK(vkCreateFramebuffer(
 		m_LogicalDevice,
-		&descriptorPoolCreateInfo,
+		&framebufferCreateInfo,
 		nullptr,
-		&m_ComputePipelineDescriptorPool));
+		&m_EscapeTimeFramebuffer));
 
-	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo;
-	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	descriptorSetAllocateInfo.descriptorSetCount = 1;
-	descriptorSetAllocateInfo.pSetLayouts = &m_ComputePipelineDescriptorSetLayout;
-	descriptorSetAllocateInfo.descriptorPool = m_ComputePipelineDescriptorPool;
-	descriptorSetAllocateInfo.pNext = nullptr;
+	framebufferCreateInfo.renderPass = m_AccumulationRenderPass;
+	framebufferCreateInfo.pAttachments = &m_AccumulationImageView;
 
-	VK_CHECK(vkAllocateDescriptorSets(
+	VK_CHECK(vkCreateFramebuffer(
 		m_LogicalDevice,
-		&descriptorSetAllocateInfo,
-		&m_ComputePipelineStorageBufferDescriptorSet));
-
-	VkDescriptorBufferInfo bufferInfo;
-	bufferInfo.buffer = m_ComputePipelineStorageBuffer.Handle;
-	bufferInfo.range = Utilities::ComputeBufferSize;
-	bufferInfo.offset = 0;
+		&framebufferCreateInfo,
+		nullptr,
+		&m_AccumulationFramebuffer));
 
-	VkWriteDescriptorSet descriptorSetWrite;
-	descriptorSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	descriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	descriptorSetWrite.dstBinding = 0;
-	descriptorSetWrite.dstArrayElement = 0;
-	descriptorSetWrite.descriptorCount = 1;
-	descriptorSetWrite.dstSet = m_ComputePipelineStorageBufferDescriptorSet;
-	descriptorSetWrite.pBufferInfo = &bufferInfo;
-	descriptorSetWrite.pImageInfo = nullptr;
-	descriptorSetWrite.pTexelBufferView = nullptr;
-	descriptorSetWrite.pNext = nullptr;
-
-	const std::array<VkWriteDescriptorSet, 1> descriptorSetWrites{ descriptorSetWrite };
+	VkDescriptorImageInfo imageInfo;
+	imageInfo.imageLayout = asyncCompute ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = m_EscapeTimeImageView;
+	imageInfo.sampler = m_EscapeTimeSampler;
+
+	VkWriteDescriptorSet escapeTimeDescriptorSetWrite{};
+	escapeTimeDescriptorSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	escapeTimeDescriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	escapeTimeDescriptorSetWrite.dstBinding = 0;
+	escapeTimeDescriptorSetWrite.dstArrayElement = 0;
+	escapeTimeDescriptorSetWrite.descriptorCount = 1;
+	escapeTimeDescriptorSetWrite.dstSet = m_GraphicsPipelineEscapeTimeDescriptorSet;
+	escapeTimeDescriptorSetWrite.pBufferInfo = nullptr;
+	escapeTimeDescriptorSetWrite.pImageInfo = &imageInfo;
+	escapeTimeDescriptorSetWrite.pTexelBufferView = nullptr;
+	escapeTimeDescriptorSetWrite.pNext = nullptr;
+
+	VkDescriptorImageInfo previousImageInfo = imageInfo;
+	previousImageInfo.imageView = m_PreviousEscapeTimeImageView;
+	VkWriteDescriptorSet previousEscapeTimeDescriptorSetWrite = escapeTimeDescriptorSetWrite;
+	previousEscapeTimeDescriptorSetWrite.dstSet = m_PreviousEscapeTimeDescriptorSet;
+	previousEscapeTimeDescriptorSetWrite.pImageInfo = &previousImageInfo;
+
+	VkDescriptorImageInfo accumulationImageInfo = imageInfo;
+	accumulationImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	accumulationImageInfo.imageView = m_AccumulationImageView;
+	VkWriteDescriptorSet accumulationDescriptorSetWrite = escapeTimeDescriptorSetWrite;
+	accumulationDescriptorSetWrite.dstSet = m_AccumulationDescriptorSet;
+	accumulationDescriptorSetWrite.pImageInfo = &accumulationImageInfo;
+
+	const std::array<VkWriteDescriptorSet, 3> descriptorSetWrites{ escapeTimeDescriptorSetWrite, previousEscapeTimeDescriptorSetWrite, accumulationDescriptorSetWrite };
 	vkUpdateDescriptorSets(
 		m_LogicalDevice,
 		static_cast<uint32_t>(descriptorSetWrites.size()),
@@ -1705,153 +2447,567 @@ bool VulkanApp::CreateComputeBasedPipeline()
 		0,
 		nullptr);
 
-	VkPipelineShaderStageCreateInfo computeShaderStageInfo{};
-	computeShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	computeShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-	computeShaderStageInfo.module = m_ComputeShaderModule;
-	computeShaderStageInfo.pName = "main";
+	if (asyncCompute)
+	{
+		const std::array<VkImageView, 2> storageImageViews{ m_EscapeTimeImageView, m_PreviousEscapeTimeImageView };
+		for (uint32_t i = 0; i < static_cast<uint32_t>(storageImageViews.size()); ++i)
+		{
+			VkDescriptorImageInfo storageImageInfo;
+			storageImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+			storageImageInfo.imageView = storageImageViews[i];
+			storageImageInfo.sampler = VK_NULL_HANDLE;
 
-	VkComputePipelineCreateInfo pipelineCreateInfo{};
-	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-	pipelineCreateInfo.stage = computeShaderStageInfo;
-	pipelineCreateInfo.layout = m_ComputePipelineLayout;
-	pipelineCreateInfo.basePipelineIndex = 0;
-	pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
-	pipelineCreateInfo.flags = 0;
-	pipelineCreateInfo.pNext = nullptr;
+			VkWriteDescriptorSet storageDescriptorSetWrite = escapeTimeDescriptorSetWrite;
+			storageDescriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			storageDescriptorSetWrite.dstSet = m_EscapeTimeStorageDescriptorSets[i];
+			storageDescriptorSetWrite.pImageInfo = &storageImageInfo;
 
-	if (vkCreateComputePipelines(
-		m_LogicalDevice, 
-		VK_NULL_HANDLE, 
-		1, 
-		&pipelineCreateInfo,
-		nullptr, 
-		&m_ComputePipeline) != VK_SUCCESS) 
+			vkUpdateDescriptorSets(
+				m_LogicalDevice,
+				1,
+				&storageDescriptorSetWrite,
+				0,
+				nullptr);
+		}
+	}
+
+	/* The first compute pass writes image 0 */
+	m_EscapeTimeFront = 1;
+	m_ShownEscapeTime = 0;
+
+	/* The new image holds nothing yet */
+	m_EscapeTimeOutdated = true;
+	m_PreviousEscapeTimeValid = false;
+	m_CompletedRefineStep = 0;
+	m_AccumulatedSampleCount = 0;
+	return true;
+}
+
+bool VulkanApp::CreateTargetImage(const VkFormat format, const VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& memory, VkImageView& imageView)
+{
+	VkImageCreateInfo imageCreateInfo;
+	imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageCreateInfo.extent.width = m_SwapchainExtent.width;
+	imageCreateInfo.extent.height = m_SwapchainExtent.height;
+	imageCreateInfo.extent.depth = 1;
+	imageCreateInfo.format = format;
+	imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageCreateInfo.usage = usage;
+	imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageCreateInfo.arrayLayers = 1;
+	imageCreateInfo.mipLevels = 1;
+	imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageCreateInfo.queueFamilyIndexCount = 0;
+	imageCreateInfo.pQueueFamilyIndices = nullptr;
+	imageCreateInfo.flags = 0;
+	imageCreateInfo.pNext = nullptr;
+
+	/* Storage images are written on the compute queue and sampled on the graphics queue, without ownership transfers */
+	const std::array<uint32_t, 2> queueFamilies{ static_cast<uint32_t>(m_QueueIndices.Graphics), static_cast<uint32_t>(m_QueueIndices.Compute) };
+	if ((usage & VK_IMAGE_USAGE_STORAGE_BIT) != 0 && m_QueueIndices.Compute != m_QueueIndices.Graphics)
 	{
-		printf("Failed to create compute pipeline");
+		imageCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		imageCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+		imageCreateInfo.pQueueFamilyIndices = queueFamilies.data();
+	}
+
+	if (vkCreateImage(
+		m_LogicalDevice,
+		&imageCreateInfo,
+		nullptr,
+		&image) != VK_SUCCESS)
+	{
+		printf("Failed to create target image\n");
 		return false;
 	}
 
-	vkDestroyShaderModule(
+	VkMemoryRequirements memoryRequirements;
+	vkGetImageMemoryRequirements(
 		m_LogicalDevice,
-		m_ComputeShaderModule,
-		nullptr);
+		image,
+		&memoryRequirements);
+
+	VkMemoryAllocateInfo allocateInfo;
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = memoryRequirements.size;
+	allocateInfo.memoryTypeIndex = RetrieveMemoryTypeIndex(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	allocateInfo.pNext = nullptr;
+
+	VK_CHECK(vkAllocateMemory(
+		m_LogicalDevice,
+		&allocateInfo,
+		nullptr,
+		&memory));
+
+	VK_CHECK(vkBindImageMemory(
+		m_LogicalDevice,
+		image,
+		memory,
+		0));
+
+	VkImageViewCreateInfo imageViewCreateInfo;
+	imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	imageViewCreateInfo.image = image;
+	imageViewCreateInfo.format = format;
+	imageViewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_R;
+	imageViewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_G;
+	imageViewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_B;
+	imageViewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_A;
+	imageViewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageViewCreateInfo.subresourceRange.layerCount = 1;
+	imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+	imageViewCreateInfo.subresourceRange.levelCount = 1;
+	imageViewCreateInfo.subresourceRange.baseMipLevel = 0;
+	imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	imageViewCreateInfo.flags = 0;
+	imageViewCreateInfo.pNext = nullptr;
+
+	VK_CHECK(vkCreateImageView(
+		m_LogicalDevice,
+		&imageViewCreateInfo,
+		nullptr,
+		&imageView));
 
 	return true;
 }
 
+void VulkanApp::DestroyEscapeTimeTarget()
+{
+	if (m_EscapeTimeFramebuffer)
+		vkDestroyFramebuffer(
+			m_LogicalDevice,
+			m_EscapeTimeFramebuffer,
+			nullptr);
+
+	if (m_EscapeTimeImageView)
+		vkDestroyImageView(
+			m_LogicalDevice,
+			m_EscapeTimeImageView,
+			nullptr);
+
+	if (m_EscapeTimeImage)
+		vkDestroyImage(
+			m_LogicalDevice,
+			m_EscapeTimeImage,
+			nullptr);
+
+	if (m_EscapeTimeImageMemory)
+		vkFreeMemory(
+			m_LogicalDevice,
+			m_EscapeTimeImageMemory,
+			nullptr);
+
+	if (m_PreviousEscapeTimeImageView)
+		vkDestroyImageView(
+			m_LogicalDevice,
+			m_PreviousEscapeTimeImageView,
+			nullptr);
+
+	if (m_PreviousEscapeTimeImage)
+		vkDestroyImage(
+			m_LogicalDevice,
+			m_PreviousEscapeTimeImage,
+			nullptr);
+
+	if (m_PreviousEscapeTimeImageMemory)
+		vkFreeMemory(
+			m_LogicalDevice,
+			m_PreviousEscapeTimeImageMemory,
+			nullptr);
+
+	if (m_AccumulationFramebuffer)
+		vkDestroyFramebuffer(
+			m_LogicalDevice,
+			m_AccumulationFramebuffer,
+			nullptr);
+
+	if (m_AccumulationImageView)
+		vkDestroyImageView(
+			m_LogicalDevice,
+			m_AccumulationImageView,
+			nullptr);
+
+	if (m_AccumulationImage)
+		vkDestroyImage(
+			m_LogicalDevice,
+			m_AccumulationImage,
+			nullptr);
+
+	if (m_AccumulationImageMemory)
+		vkFreeMemory(
+			m_LogicalDevice,
+			m_AccumulationImageMemory,
+			nullptr);
+
+	m_EscapeTimeFramebuffer = VK_NULL_HANDLE;
+	m_EscapeTimeImageView = VK_NULL_HANDLE;
+	m_EscapeTimeImage = VK_NULL_HANDLE;
+	m_EscapeTimeImageMemory = VK_NULL_HANDLE;
+	m_PreviousEscapeTimeImageView = VK_NULL_HANDLE;
+	m_PreviousEscapeTimeImage = VK_NULL_HANDLE;
+	m_PreviousEscapeTimeImageMemory = VK_NULL_HANDLE;
+	m_AccumulationFramebuffer = VK_NULL_HANDLE;
+	m_AccumulationImageView = VK_NULL_HANDLE;
+	m_AccumulationImage = VK_NULL_HANDLE;
+	m_AccumulationImageMemory = VK_NULL_HANDLE;
+}
+
 bool VulkanApp::AllocateGraphicsCommandBuffers()
 {
 	VkCommandBufferAllocateInfo commandBufferAllocateInfo;
 	commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	commandBufferAllocateInfo.commandPool = m_GraphicsCommandPool;
 	commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	commandBufferAllocateInfo.commandBufferCount = m_ImageCount;
+	commandBufferAllocateInfo.commandBufferCount = m_MaxFramesInFlight;
 	commandBufferAllocateInfo.pNext = nullptr;
 
-	m_GraphicsPipelineCommandBuffers.resize(m_ImageCount);
-	VK_CHECK(vkAllocateCommandBuffers(
-		m_LogicalDevice,
-		&commandBufferAllocateInfo,
-		m_GraphicsPipelineCommandBuffers.data()));
+	/* Rerecorded by DrawFrame() once the frame's fence signaled, the pool resets them individually */
+	m_GraphicsPipelineCommandBuffers.resize(m_MaxFramesInFlight);
+	VK_CHECK(vkAllocateCommandBuffers(
+		m_LogicalDevice,
+		&commandBufferAllocateInfo,
+		m_GraphicsPipelineCommandBuffers.data()));
+
+	const bool asyncCompute = m_RenderMethod == ERenderMethod::AsyncCompute;
+	if (asyncCompute)
+	{
+		/* The escape time pass of each frame in flight, reused under the same fence as the frame's graphics command buffer */
+		commandBufferAllocateInfo.commandPool = m_ComputeCommandPool;
+		m_ComputeCommandBuffers.resize(m_MaxFramesInFlight);
+		VK_CHECK(vkAllocateCommandBuffers(
+			m_LogicalDevice,
+			&commandBufferAllocateInfo,
+			m_ComputeCommandBuffers.data()));
+	}
+
+	/* Begin and end timestamp of the escape time pass per frame in flight, only where the queue family running it supports timestamps */
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, queueFamilyProperties.data());
+	if (queueFamilyProperties[asyncCompute ? m_QueueIndices.Compute : m_QueueIndices.Graphics].timestampValidBits == 0)
+	{
+		printf("No GPU timestamps on the %s queue family, refinement goes one lattice per frame\n", asyncCompute ? "compute" : "graphics");
+		return true;
+	}
+
+	VkQueryPoolCreateInfo queryPoolCreateInfo;
+	queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolCreateInfo.queryCount = m_MaxFramesInFlight * 2;
+	queryPoolCreateInfo.pipelineStatistics = 0;
+	queryPoolCreateInfo.flags = 0;
+	queryPoolCreateInfo.pNext = nullptr;
+
+	VK_CHECK(vkCreateQueryPool(
+		m_LogicalDevice,
+		&queryPoolCreateInfo,
+		nullptr,
+		&m_EscapeTimeQueryPool));
+
+	return true;
+}
+
+void VulkanApp::RecordGraphicsCommandBuffer(VkCommandBuffer commandBuffer, const uint32_t imageIndex, const uint32_t uniformOffset, const bool computeEscapeTime, const bool accumulate)
+{
+	VkCommandBufferBeginInfo commandBufferBeginInfo;
+	commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	commandBufferBeginInfo.pInheritanceInfo = nullptr;
+	commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	commandBufferBeginInfo.pNext = nullptr;
+
+	VkClearValue colorClearValue = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
+	VkClearValue clearValues[1]{ colorClearValue };
+
+	VkRenderPassBeginInfo renderPassBeginInfo;
+	renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassBeginInfo.framebuffer = m_SwapchainFramebuffers[imageIndex];
+	renderPassBeginInfo.renderPass = m_SwapchainRenderPass;
+	renderPassBeginInfo.clearValueCount = 1;
+	renderPassBeginInfo.pClearValues = clearValues;
+	renderPassBeginInfo.renderArea.extent = m_SwapchainExtent;
+	renderPassBeginInfo.renderArea.offset = { 0, 0 };
+	renderPassBeginInfo.pNext = nullptr;
+
+	VkViewport viewport;
+	viewport.width = static_cast<float>(m_SwapchainExtent.width);
+	viewport.height = static_cast<float>(m_SwapchainExtent.height);
+	viewport.x = 0;
+	viewport.y = 0;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor;
+	scissor.extent = m_SwapchainExtent;
+	scissor.offset = { 0, 0 };
+
+	VK_CHECK(vkBeginCommandBuffer(
+		commandBuffer,
+		&commandBufferBeginInfo));
+
+	vkCmdSetViewport(
+		commandBuffer,
+		0,
+		1,
+		&viewport);
+
+	vkCmdSetScissor(
+		commandBuffer,
+		0,
+		1,
+		&scissor);
+
+	constexpr VkDeviceSize offsets[1]{ 0 };
+	vkCmdBindVertexBuffers(
+		commandBuffer,
+		0,
+		1,
+		&m_VertexBuffer.Handle,
+		offsets);
 
-	return true;
-}
+	vkCmdBindIndexBuffer(
+		commandBuffer,
+		m_IndexBuffer.Handle,
+		0,
+		VK_INDEX_TYPE_UINT32);
 
-bool VulkanApp::AllocateComputeCommandBuffers()
-{
-	VkCommandBufferAllocateInfo commandBufferAllocateInfo;
-	commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	commandBufferAllocateInfo.commandPool = m_ComputeCommandPool;
-	commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	commandBufferAllocateInfo.commandBufferCount = 1;
-	commandBufferAllocateInfo.pNext = nullptr;
+	/* Every pipeline shares the layout, one push serves all passes */
+	vkCmdPushConstants(
+		commandBuffer,
+		m_GraphicsPipelineLayout,
+		VK_SHADER_STAGE_FRAGMENT_BIT,
+		0,
+		sizeof(CameraPushConstants),
+		&m_FrameCamera);
 
-	VK_CHECK(vkAllocateCommandBuffers(
-		m_LogicalDevice,
-		&commandBufferAllocateInfo,
-		&m_ComputePipelineCommandBuffer));
-	
-	return true;
-}
+	if (computeEscapeTime)
+	{
+		/* Samples keep the timestamps and the previous escape time image of the last refining pass, their counters are never read */
+		if (m_EscapeTimeQueryPool && !accumulate)
+		{
+			vkCmdResetQueryPool(commandBuffer, m_EscapeTimeQueryPool, m_FrameIndex * 2, 2);
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_EscapeTimeQueryPool, m_FrameIndex * 2);
+		}
 
-bool VulkanApp::RecordGraphicsCommandBuffers()
-{
-	for (uint32_t i = 0; i < m_ImageCount; ++i)
-	{ 
-		VkCommandBuffer& commandBuffer = m_GraphicsPipelineCommandBuffers[i];
-		VkCommandBufferBeginInfo commandBufferBeginInfo;
-		commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		commandBufferBeginInfo.pInheritanceInfo = nullptr;
-		commandBufferBeginInfo.flags = 0;
-		commandBufferBeginInfo.pNext = nullptr;
-
-		VkClearValue colorClearValue = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
-		VkClearValue clearValues[1]{ colorClearValue };
-
-		VkRenderPassBeginInfo renderPassBeginInfo;
-		renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassBeginInfo.framebuffer = m_SwapchainFramebuffers[i];
-		renderPassBeginInfo.renderPass = m_SwapchainRenderPass;
-		renderPassBeginInfo.clearValueCount = 1;
-		renderPassBeginInfo.pClearValues = clearValues;
-		renderPassBeginInfo.renderArea.extent = m_SwapchainExtent;
-		renderPassBeginInfo.renderArea.offset = { 0, 0 };
-		renderPassBeginInfo.pNext = nullptr;
-
-		VkViewport viewport;
-		viewport.width = static_cast<float>(m_SwapchainExtent.width);
-		viewport.height = static_cast<float>(m_SwapchainExtent.height);
-		viewport.x = 0;
-		viewport.y = 0;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-
-		VkRect2D scissor;
-		scissor.extent = m_SwapchainExtent;
-		scissor.offset = { 0, 0 };
-
-		VK_CHECK(vkBeginCommandBuffer(
-			commandBuffer,
-			&commandBufferBeginInfo));
+		/* The previous escape time pass may still add to the counters */
+		VkMemoryBarrier clearCountersBarrier;
+		clearCountersBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		clearCountersBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		clearCountersBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		clearCountersBarrier.pNext = nullptr;
 
-		vkCmdSetViewport(
+		vkCmdPipelineBarrier(
 			commandBuffer,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
 			0,
 			1,
-			&viewport);
+			&clearCountersBarrier,
+			0,
+			nullptr,
+			0,
+			nullptr);
+
+		vkCmdFillBuffer(
+			commandBuffer,
+			m_CounterBuffer.Handle,
+			0,
+			VK_WHOLE_SIZE,
+			0);
+
+		VkMemoryBarrier countersBarrier;
+		countersBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		countersBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		countersBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		countersBarrier.pNext = nullptr;
 
-		vkCmdSetScissor(
+		vkCmdPipelineBarrier(
 			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
 			0,
 			1,
-			&scissor);
+			&countersBarrier,
+			0,
+			nullptr,
+			0,
+			nullptr);
+
+		/* Every pixel is covered by the quad, nothing to clear */
+		VkRenderPassBeginInfo escapeTimeRenderPassBeginInfo;
+		escapeTimeRenderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		escapeTimeRenderPassBeginInfo.framebuffer = m_EscapeTimeFramebuffer;
+		escapeTimeRenderPassBeginInfo.renderPass = m_EscapeTimeRenderPass;
+		escapeTimeRenderPassBeginInfo.clearValueCount = 0;
+		escapeTimeRenderPassBeginInfo.pClearValues = nullptr;
+		escapeTimeRenderPassBeginInfo.renderArea.extent = m_SwapchainExtent;
+		escapeTimeRenderPassBeginInfo.renderArea.offset = { 0, 0 };
+		escapeTimeRenderPassBeginInfo.pNext = nullptr;
 
 		vkCmdBeginRenderPass(
 			commandBuffer,
-			&renderPassBeginInfo,
+			&escapeTimeRenderPassBeginInfo,
 			VK_SUBPASS_CONTENTS_INLINE);
-		
-		constexpr VkDeviceSize offsets[1]{ 0 };
-		vkCmdBindVertexBuffers(
+
+		vkCmdBindPipeline(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			m_FrameDoublePrecision ? m_DoublePrecisionEscapeTimePipeline : m_EscapeTimePipeline);
+
+		vkCmdBindDescriptorSets(
 			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			m_GraphicsPipelineLayout,
 			0,
 			1,
-			&m_VertexBuffer.Handle,
-			offsets);
+			&m_GraphicsPipelineUBOBufferDescriptorSet,
+			1,
+			&uniformOffset);
 
-		vkCmdBindIndexBuffer(
+		vkCmdBindDescriptorSets(
 			commandBuffer,
-			m_IndexBuffer.Handle,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			m_GraphicsPipelineLayout,
+			2,
+			1,
+			&m_PreviousEscapeTimeDescriptorSet,
+			0,
+			nullptr);
+
+		vkCmdDrawIndexed(
+			commandBuffer,
+			6,
+			1,
 			0,
-			VK_INDEX_TYPE_UINT32);
+			0,
+			0);
+
+		vkCmdEndRenderPass(commandBuffer);
+
+		if (m_EscapeTimeQueryPool && !accumulate)
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_EscapeTimeQueryPool, m_FrameIndex * 2 + 1);
+
+		if (!accumulate)
+		{
+			/* The next escape time pass reprojects this one */
+			VkImageSubresourceRange subresourceRange;
+			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			subresourceRange.baseMipLevel = 0;
+			subresourceRange.levelCount = 1;
+			subresourceRange.baseArrayLayer = 0;
+			subresourceRange.layerCount = 1;
+
+			InsertImageMemoryBarrier(
+				commandBuffer,
+				m_EscapeTimeImage,
+				VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				VK_ACCESS_TRANSFER_READ_BIT,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				subresourceRange);
+
+			InsertImageMemoryBarrier(
+				commandBuffer,
+				m_PreviousEscapeTimeImage,
+				0,
+				VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				subresourceRange);
+
+			VkImageCopy imageCopy;
+			imageCopy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			imageCopy.srcSubresource.mipLevel = 0;
+			imageCopy.srcSubresource.baseArrayLayer = 0;
+			imageCopy.srcSubresource.layerCount = 1;
+			imageCopy.srcOffset = { 0, 0, 0 };
+			imageCopy.dstSubresource = imageCopy.srcSubresource;
+			imageCopy.dstOffset = { 0, 0, 0 };
+			imageCopy.extent = { m_SwapchainExtent.width, m_SwapchainExtent.height, 1 };
+
+			vkCmdCopyImage(
+				commandBuffer,
+				m_EscapeTimeImage,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				m_PreviousEscapeTimeImage,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1,
+				&imageCopy);
+
+			InsertImageMemoryBarrier(
+				commandBuffer,
+				m_EscapeTimeImage,
+				0,
+				VK_ACCESS_SHADER_READ_BIT,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				subresourceRange);
+
+			InsertImageMemoryBarrier(
+				commandBuffer,
+				m_PreviousEscapeTimeImage,
+				VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_ACCESS_SHADER_READ_BIT,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				subresourceRange);
+
+			/* Fences do not make shader writes visible to the host */
+			VkMemoryBarrier readCountersBarrier;
+			readCountersBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			readCountersBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			readCountersBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			readCountersBarrier.pNext = nullptr;
+
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				VK_PIPELINE_STAGE_HOST_BIT,
+				0,
+				1,
+				&readCountersBarrier,
+				0,
+				nullptr,
+				0,
+				nullptr);
+		}
+	}
+
+	/* The async compute mode alternates between both escape time images, the graphics escape time pass always shows the first */
+	const VkDescriptorSet escapeTimeDescriptorSet = m_ShownEscapeTime == 0 ? m_GraphicsPipelineEscapeTimeDescriptorSet : m_PreviousEscapeTimeDescriptorSet;
+	const std::array<VkDescriptorSet, 3> descriptorSets{ m_GraphicsPipelineUBOBufferDescriptorSet, m_GraphicsPipelineColorPaletteDescriptorSet, escapeTimeDescriptorSet };
+	if (accumulate)
+	{
+		VkRenderPassBeginInfo accumulationRenderPassBeginInfo;
+		accumulationRenderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		accumulationRenderPassBeginInfo.framebuffer = m_AccumulationFramebuffer;
+		accumulationRenderPassBeginInfo.renderPass = m_AccumulationRenderPass;
+		accumulationRenderPassBeginInfo.clearValueCount = 0;
+		accumulationRenderPassBeginInfo.pClearValues = nullptr;
+		accumulationRenderPassBeginInfo.renderArea.extent = m_SwapchainExtent;
+		accumulationRenderPassBeginInfo.renderArea.offset = { 0, 0 };
+		accumulationRenderPassBeginInfo.pNext = nullptr;
+
+		vkCmdBeginRenderPass(
+			commandBuffer,
+			&accumulationRenderPassBeginInfo,
+			VK_SUBPASS_CONTENTS_INLINE);
 
 		vkCmdBindPipeline(
 			commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			m_GraphicsPipeline);
+			m_AccumulationPipeline);
 
-		const std::array<VkDescriptorSet, 2> descriptorSets{ m_GraphicsPipelineUBOBufferDescriptorSet, m_GraphicsPipelineColorPaletteDescriptorSet };
 		vkCmdBindDescriptorSets(
 			commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -1859,8 +3015,8 @@ bool VulkanApp::RecordGraphicsCommandBuffers()
 			0,
 			static_cast<uint32_t>(descriptorSets.size()),
 			descriptorSets.data(),
-			0,
-			nullptr);
+			1,
+			&uniformOffset);
 
 		vkCmdDrawIndexed(
 			commandBuffer,
@@ -1871,57 +3027,179 @@ bool VulkanApp::RecordGraphicsCommandBuffers()
 			0);
 
 		vkCmdEndRenderPass(commandBuffer);
-
-		VK_CHECK(vkEndCommandBuffer(commandBuffer));
 	}
 
-	return true;
+	vkCmdBeginRenderPass(
+		commandBuffer,
+		&renderPassBeginInfo,
+		VK_SUBPASS_CONTENTS_INLINE);
+
+	/* The swapchain image shows the colored escape time or, while accumulating, the running mean */
+	vkCmdBindPipeline(
+		commandBuffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS,
+		accumulate ? m_ResolvePipeline : m_ColoringPipeline);
+
+	const std::array<VkDescriptorSet, 3> presentDescriptorSets{ m_GraphicsPipelineUBOBufferDescriptorSet, m_GraphicsPipelineColorPaletteDescriptorSet, accumulate ? m_AccumulationDescriptorSet : escapeTimeDescriptorSet };
+	vkCmdBindDescriptorSets(
+		commandBuffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS,
+		m_GraphicsPipelineLayout,
+		0,
+		static_cast<uint32_t>(presentDescriptorSets.size()),
+		presentDescriptorSets.data(),
+		1,
+		&uniformOffset);
+
+	vkCmdDrawIndexed(
+		commandBuffer,
+		6,
+		1,
+		0,
+		0,
+		0);
+
+	vkCmdEndRenderPass(commandBuffer);
+
+	VK_CHECK(vkEndCommandBuffer(commandBuffer));
 }
 
-bool VulkanApp::RecordComputeCommandBuffers()
+void VulkanApp::RecordComputeCommandBuffer(VkCommandBuffer commandBuffer, const uint32_t frameIndex, const uint32_t uniformOffset, const uint32_t target, const bool sample)
 {
 	VkCommandBufferBeginInfo commandBufferBeginInfo;
 	commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 	commandBufferBeginInfo.pInheritanceInfo = nullptr;
-	commandBufferBeginInfo.flags = 0;
+	commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 	commandBufferBeginInfo.pNext = nullptr;
 
-	VkCommandBuffer& commandBuffer = m_ComputePipelineCommandBuffer;
-
 	VK_CHECK(vkBeginCommandBuffer(
 		commandBuffer,
 		&commandBufferBeginInfo));
 
+	/* Samples keep the timestamps of the last refining pass, like the graphics escape time pass */
+	if (m_EscapeTimeQueryPool && !sample)
+	{
+		vkCmdResetQueryPool(commandBuffer, m_EscapeTimeQueryPool, frameIndex * 2, 2);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_EscapeTimeQueryPool, frameIndex * 2);
+	}
+
+	/* The previous pass may still add to the counters or store to the image this one reprojects */
+	VkMemoryBarrier previousPassBarrier;
+	previousPassBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	previousPassBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	previousPassBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+	previousPassBarrier.pNext = nullptr;
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		1,
+		&previousPassBarrier,
+		0,
+		nullptr,
+		0,
+		nullptr);
+
+	vkCmdFillBuffer(
+		commandBuffer,
+		m_CounterBuffer.Handle,
+		0,
+		VK_WHOLE_SIZE,
+		0);
+
+	VkMemoryBarrier countersBarrier;
+	countersBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	countersBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	countersBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	countersBarrier.pNext = nullptr;
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		1,
+		&countersBarrier,
+		0,
+		nullptr,
+		0,
+		nullptr);
+
 	vkCmdBindPipeline(
 		commandBuffer,
 		VK_PIPELINE_BIND_POINT_COMPUTE,
-		m_ComputePipeline);
+		m_FrameDoublePrecision ? m_DoublePrecisionEscapeTimeComputePipeline : m_EscapeTimeComputePipeline);
 
-	const std::array<VkDescriptorSet, 1> descriptorSets{ m_ComputePipelineStorageBufferDescriptorSet };
 	vkCmdBindDescriptorSets(
 		commandBuffer,
 		VK_PIPELINE_BIND_POINT_COMPUTE,
-		m_ComputePipelineLayout,
+		m_EscapeTimeComputePipelineLayout,
 		0,
-		static_cast<uint32_t>(descriptorSets.size()),
-		descriptorSets.data(),
+		1,
+		&m_GraphicsPipelineUBOBufferDescriptorSet,
+		1,
+		&uniformOffset);
+
+	/* Stores to the target and reprojects the other image, which holds the last refining pass */
+	const std::array<VkDescriptorSet, 2> imageDescriptorSets{ m_EscapeTimeStorageDescriptorSets[target], target == 0 ? m_PreviousEscapeTimeDescriptorSet : m_GraphicsPipelineEscapeTimeDescriptorSet };
+	vkCmdBindDescriptorSets(
+		commandBuffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		m_EscapeTimeComputePipelineLayout,
+		1,
+		static_cast<uint32_t>(imageDescriptorSets.size()),
+		imageDescriptorSets.data(),
 		0,
 		nullptr);
 
-	const int WORKGROUP_SIZE = 32; // Workgroup size in compute shader.
+	vkCmdPushConstants(
+		commandBuffer,
+		m_EscapeTimeComputePipelineLayout,
+		VK_SHADER_STAGE_COMPUTE_BIT,
+		0,
+		sizeof(CameraPushConstants),
+		&m_FrameCamera);
 
+	/* One workgroup per tile, the tiles on the right and bottom edges may stick out of the image */
 	vkCmdDispatch(
 		commandBuffer,
-		(uint32_t)ceil(Utilities::ComputeRenderWidth / float(WORKGROUP_SIZE)), (uint32_t)ceil(Utilities::ComputeRenderHeight / float(WORKGROUP_SIZE)), 1);
+		(m_SwapchainExtent.width + Utilities::EscapeTimeTileWidth - 1) / Utilities::EscapeTimeTileWidth,
+		(m_SwapchainExtent.height + Utilities::EscapeTimeTileHeight - 1) / Utilities::EscapeTimeTileHeight,
+		1);
+
+	if (m_EscapeTimeQueryPool && !sample)
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_EscapeTimeQueryPool, frameIndex * 2 + 1);
+
+	/* Fences do not make shader writes visible to the host, the semaphore covers the graphics queue */
+	VkMemoryBarrier readCountersBarrier;
+	readCountersBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	readCountersBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	readCountersBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	readCountersBarrier.pNext = nullptr;
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT,
+		0,
+		1,
+		&readCountersBarrier,
+		0,
+		nullptr,
+		0,
+		nullptr);
 
 	VK_CHECK(vkEndCommandBuffer(commandBuffer));
-	
-	return true;
 }
 
 void VulkanApp::UpdateFrameData(const double deltaTime)
 {
-	INTERNALSCOPE float zoomScale = 1.0f; 
+	/* The camera is double, the float32 shaders get it rounded and the float64 ones as is */
+	INTERNALSCOPE double zoomScale = 1.0;
+	INTERNALSCOPE double centerX = 0.0;
+	INTERNALSCOPE double centerY = -0.5;
 	const auto [windowWidth, windowHeight] = m_Window->GetSize();
 
 	if (windowWidth <= 0 || windowHeight <= 0)
@@ -1929,11 +3207,10 @@ void VulkanApp::UpdateFrameData(const double deltaTime)
 	
 	const float aspectRatio = (float)windowWidth / (float)windowHeight;
 	INTERNALSCOPE UBO ubo = {
-		aspectRatio,
-		0.0f,
-		-0.5f,
-		zoomScale,
-		800
+		800,
+		0,
+		1.0f,
+		0.0f
 	};
 	
 	constexpr float moveSpeedFactor = 0.25f;
@@ -1949,105 +3226,217 @@ void VulkanApp::UpdateFrameData(const double deltaTime)
 		zoomScale -= zoomScale * zoomSpeed * deltaTime;
 
 	if (Input::IsKeyPressed(Key::KEY_W))
-		ubo.CenterX -= moveSpeed * deltaTime * zoomScale;
+		centerX -= moveSpeed * deltaTime * zoomScale;
 
 	if (Input::IsKeyPressed(Key::KEY_S))
-		ubo.CenterX += moveSpeed * deltaTime * zoomScale;
+		centerX += moveSpeed * deltaTime * zoomScale;
 
 	if (Input::IsKeyPressed(Key::KEY_A))
-		ubo.CenterY -= moveSpeed * deltaTime * zoomScale;
+		centerY -= moveSpeed * deltaTime * zoomScale;
 
 	if (Input::IsKeyPressed(Key::KEY_D))
-		ubo.CenterY += moveSpeed * deltaTime * zoomScale;
+		centerY += moveSpeed * deltaTime * zoomScale;
 	
+	/* Iteration limit, UP and DOWN leave the automatic mode */
+	INTERNALSCOPE bool autoIterationKeyWasPressed = false;
+	INTERNALSCOPE bool histogramKeyWasPressed = false;
+	const bool autoIterationKeyPressed = Input::IsKeyPressed(Key::KEY_I);
+	if (autoIterationKeyPressed && !autoIterationKeyWasPressed)
+	{
+		m_AutoIterations = !m_AutoIterations;
+		printf("Iteration limit: %s\n", m_AutoIterations ? "auto" : "manual");
+	}
+
 	if (Input::IsKeyPressed(Key::KEY_UP))
-		ubo.IterationCount += 1;
+	{
+		m_IterationCount += 1;
+		m_AutoIterations = false;
+	}
 
 	if (Input::IsKeyPressed(Key::KEY_DOWN))
-		ubo.IterationCount -= 1;
+	{
+		m_IterationCount = std::max(m_IterationCount - 1, 1);
+		m_AutoIterations = false;
+	}
 
-	/* Cap the zoom scale to avoid black border as we are rendering a quad */
-	zoomScale = zoomScale > 1.0f * aspectRatio ? 1.0f * aspectRatio : fabs(zoomScale);
-	/* Update uniform buffer block */
-	ubo.ZoomScale = zoomScale;
-	ubo.AspectRatio = aspectRatio;
+	const bool histogramKeyPressed = Input::IsKeyPressed(Key::KEY_H);
+	if (histogramKeyPressed && !histogramKeyWasPressed && m_EscapeHistogramIterationCount > 0)
+		AutoIteration::PrintHistogram(m_EscapeHistogram.data(), m_EscapeHistogramIterationCount);
 
-	void* data;
-	vkMapMemory(m_LogicalDevice, m_UBOBuffer.DeviceMemory, 0, sizeof(UBO), 0, &data);
-	memcpy(data, &ubo, sizeof(UBO));
-	vkUnmapMemory(m_LogicalDevice, m_UBOBuffer.DeviceMemory);
+	autoIterationKeyWasPressed = autoIterationKeyPressed;
+	histogramKeyWasPressed = histogramKeyPressed;
+	ubo.IterationCount = m_IterationCount;
 
-	VkDescriptorBufferInfo bufferInfo;
-	bufferInfo.buffer = m_UBOBuffer.Handle;
-	bufferInfo.range = sizeof(UBO);
-	bufferInfo.offset = 0;
+	/* GPU time budget of a refining escape time pass, F5 halves and F6 doubles it */
+	INTERNALSCOPE std::array<bool, 2> budgetKeysWerePressed{};
+	const std::array<bool, 2> budgetKeysPressed{ Input::IsKeyPressed(Key::KEY_F5), Input::IsKeyPressed(Key::KEY_F6) };
+	if ((budgetKeysPressed[0] && !budgetKeysWerePressed[0]) || (budgetKeysPressed[1] && !budgetKeysWerePressed[1]))
+	{
+		m_RefineBudget = std::min(std::max(budgetKeysPressed[0] ? 0.5 * m_RefineBudget : 2.0 * m_RefineBudget, 0.001), 0.256);
+		printf("Refinement budget: %.1f ms per frame\n", 1000.0 * m_RefineBudget);
+	}
 
-	VkWriteDescriptorSet uboBufferDescriptorSetWrite{};
-	uboBufferDescriptorSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	uboBufferDescriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	uboBufferDescriptorSetWrite.dstBinding = 0;
-	uboBufferDescriptorSetWrite.dstArrayElement = 0;
-	uboBufferDescriptorSetWrite.descriptorCount = 1;
-	uboBufferDescriptorSetWrite.dstSet = m_GraphicsPipelineUBOBufferDescriptorSet;
-	uboBufferDescriptorSetWrite.pBufferInfo = &bufferInfo;
-	uboBufferDescriptorSetWrite.pImageInfo = nullptr;
-	uboBufferDescriptorSetWrite.pTexelBufferView = nullptr;
-	uboBufferDescriptorSetWrite.pNext = nullptr;
-}
+	budgetKeysWerePressed = budgetKeysPressed;
 
-#include "vendor/lodepng/lodepng.h"
-#include <iostream>
+	/* Coloring, only reruns the coloring pass */
+	constexpr uint32_t paletteCount = static_cast<uint32_t>(EPalette::Count) + 1;
+	constexpr float paletteCycleSpeed = 0.1f;
+	INTERNALSCOPE bool paletteCycling = false;
+	INTERNALSCOPE bool paletteKeyWasPressed = false;
+	INTERNALSCOPE bool cycleKeyWasPressed = false;
 
-void VulkanApp::DrawFrame()
-{
-	struct Pixel
-	{
-		uint8_t r;
-		uint8_t g;
-		uint8_t b;
-		uint8_t a;
-	};
+	const bool paletteKeyPressed = Input::IsKeyPressed(Key::KEY_P);
+	if (paletteKeyPressed && !paletteKeyWasPressed)
+		ubo.PaletteIndex = (ubo.PaletteIndex + 1) % paletteCount;
 
-	if (m_RenderMethod == ERenderMethod::Compute)
+	const bool cycleKeyPressed = Input::IsKeyPressed(Key::KEY_C);
+	if (cycleKeyPressed && !cycleKeyWasPressed)
+		paletteCycling = !paletteCycling;
+
+	paletteKeyWasPressed = paletteKeyPressed;
+	cycleKeyWasPressed = cycleKeyPressed;
+
+	if (Input::IsKeyPressed(Key::KEY_R))
 	{
-		VkSubmitInfo submitInfo{};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_ComputePipelineCommandBuffer;
+		ubo.ColorScale = 1.0f;
+		ubo.ColorOffset = 0.0f;
+	}
 
-		VK_CHECK(vkQueueSubmit(m_ComputeQueue, 1, &submitInfo, VK_NULL_HANDLE));
-		VK_CHECK(vkQueueWaitIdle(m_ComputeQueue));
+	if (Input::IsKeyPressed(Key::KEY_E))
+		ubo.ColorScale += ubo.ColorScale * deltaTime;
 
-		void* mappedMemory = nullptr;
-		vkMapMemory(m_LogicalDevice, m_ComputePipelineStorageBuffer.DeviceMemory, 0, Utilities::ComputeBufferSize, 0, &mappedMemory);
-		Pixel* pmappedMemory = reinterpret_cast<Pixel*>(mappedMemory);
+	if (Input::IsKeyPressed(Key::KEY_Q))
+		ubo.ColorScale -= ubo.ColorScale * deltaTime;
 
-		std::vector<uint8_t> image;
-		/* To prevent unnecessary vector buffer reallocations */
-		image.reserve(Utilities::RenderedImageSize);
-		for (uint32_t i = 0; i < Utilities::RenderedImageSize; i += 4)
-		{
-			float pixelR = *(float*)&pmappedMemory[i + 0];
-			float pixelG = *(float*)&pmappedMemory[i + 1];
-			float pixelB = *(float*)&pmappedMemory[i + 2];
-			float pixelA = *(float*)&pmappedMemory[i + 3];
-
-			image.push_back(static_cast<uint8_t>(pixelR * 255.0f));
-			image.push_back(static_cast<uint8_t>(pixelG * 255.0f));
-			image.push_back(static_cast<uint8_t>(pixelB * 255.0f));
-			image.push_back(static_cast<uint8_t>(pixelA * 255.0f));
-		}
+	if (paletteCycling)
+		ubo.ColorOffset = fmodf(ubo.ColorOffset + paletteCycleSpeed * static_cast<float>(deltaTime), 1.0f);
 
-		vkUnmapMemory(m_LogicalDevice, m_ComputePipelineStorageBuffer.DeviceMemory);
-		const auto error = lodepng::encode("mandelbrot.png", image, Utilities::ComputeRenderWidth, Utilities::ComputeRenderHeight, LodePNGColorType::LCT_RGBA, 8U);
-		if (error)
-			printf("encoder error %d: %s", error, lodepng_error_text(error));
-		else
-			printf("Sucessfully rendered image\n");
+	/* Interior checks, rerun the escape time pass */
+	INTERNALSCOPE std::array<bool, 3> checkKeysWerePressed{};
+	const std::array<bool, 3> checkKeysPressed{ Input::IsKeyPressed(Key::KEY_F1), Input::IsKeyPressed(Key::KEY_F2), Input::IsKeyPressed(Key::KEY_F3) };
+	if (checkKeysPressed[0] && !checkKeysWerePressed[0])
+		m_InteriorChecks.Cardioid = !m_InteriorChecks.Cardioid;
+
+	if (checkKeysPressed[1] && !checkKeysWerePressed[1])
+		m_InteriorChecks.Bulb = !m_InteriorChecks.Bulb;
+
+	if (checkKeysPressed[2] && !checkKeysWerePressed[2])
+		m_InteriorChecks.Periodicity = !m_InteriorChecks.Periodicity;
 
+	checkKeysWerePressed = checkKeysPressed;
+	ubo.InteriorChecks = m_InteriorChecks.GetFlags();
+	ubo.PeriodicityTolerance = m_InteriorChecks.PeriodicityTolerance;
+
+	if (ubo.PaletteIndex > 0)
+		memcpy(ubo.PaletteCoefficients, &Coloring::GetCoefficients(static_cast<EPalette>(ubo.PaletteIndex - 1)), sizeof(ubo.PaletteCoefficients));
+
+	/* Cap the zoom scale to avoid black border as we are rendering a quad */
+	zoomScale = zoomScale > 1.0 * aspectRatio ? 1.0 * aspectRatio : fabs(zoomScale);
+	/* The rendered center is snapped to whole pixels, pans move the previous escape time image by whole pixels */
+	const Reprojection::Camera camera = Reprojection::SnapToPixels(centerX, centerY, zoomScale, m_SwapchainExtent.width, m_SwapchainExtent.height);
+	/* Pushed with the frame, no sample offset outside accumulation */
+	CameraPushConstants frameCamera = {};
+	frameCamera.AspectRatio = aspectRatio;
+	frameCamera.CenterX = static_cast<float>(camera.CenterX);
+	frameCamera.CenterY = static_cast<float>(camera.CenterY);
+	frameCamera.ZoomScale = static_cast<float>(camera.ZoomScale);
+	frameCamera.PreciseCenterX = camera.CenterX;
+	frameCamera.PreciseCenterY = camera.CenterY;
+	frameCamera.PreciseZoomScale = camera.ZoomScale;
+	m_FrameDoublePrecision = m_DoublePrecisionEscapeTimePipeline && Utilities::NeedsDoublePrecision(camera);
+
+	/* The escape time image stays valid until the view or the iteration count changes and every pixel is exact */
+	INTERNALSCOPE UBO escapeTimeView = {};
+	INTERNALSCOPE CameraPushConstants escapeTimeCamera = {};
+	const bool viewChanged = frameCamera.AspectRatio != escapeTimeCamera.AspectRatio || frameCamera.PreciseCenterX != escapeTimeCamera.PreciseCenterX || frameCamera.PreciseCenterY != escapeTimeCamera.PreciseCenterY ||
+		frameCamera.PreciseZoomScale != escapeTimeCamera.PreciseZoomScale || ubo.IterationCount != escapeTimeView.IterationCount || ubo.InteriorChecks != escapeTimeView.InteriorChecks;
+	if (viewChanged || m_CompletedRefineStep != 1)
+		m_EscapeTimeOutdated = true;
+
+	if (m_EscapeTimeOutdated)
+	{
+		/* Texels of another limit or other interior checks cannot be reused */
+		const bool reusable = m_PreviousEscapeTimeValid && frameCamera.AspectRatio == escapeTimeCamera.AspectRatio &&
+			ubo.IterationCount == escapeTimeView.IterationCount && ubo.InteriorChecks == escapeTimeView.InteriorChecks;
+		const Reprojection::Mapping mapping = reusable ? Reprojection::GetMapping(m_PreviousEscapeTimeCamera, camera) : Reprojection::Mapping();
+		ubo.ReprojectionMode = static_cast<uint32_t>(mapping.Mode);
+		ubo.ReprojectionScaleX = mapping.ScaleX;
+		ubo.ReprojectionScaleY = mapping.ScaleY;
+		ubo.ReprojectionOffsetX = mapping.OffsetX;
+		ubo.ReprojectionOffsetY = mapping.OffsetY;
+		/* Only an unmoved view keeps the lattice the last pass completed, anything else starts over from the coarsest lattice that fits */
+		const uint32_t completedStep = mapping.Mode == Reprojection::EMode::Shift && !viewChanged ? m_CompletedRefineStep : 0;
+		const double pixelCount = static_cast<double>(camera.Width) * static_cast<double>(camera.Height);
+		m_CompletedRefineStep = Reprojection::ChooseRefineStep(completedStep, m_SecondsPerIteratedPixel, pixelCount, m_RefineBudget);
+		/* Window x follows c.y and window y follows c.x, the lattice stays on the same pixels of the plane while panning */
+		ubo.RefineStep = m_CompletedRefineStep;
+		ubo.RefineGridX = static_cast<uint32_t>(camera.GridY & 7);
+		ubo.RefineGridY = static_cast<uint32_t>(camera.GridX & 7);
+
+		m_PreviousEscapeTimeCamera = camera;
+		m_PreviousEscapeTimeValid = true;
+		m_EscapeTimeIterationCount = ubo.IterationCount;
+		escapeTimeView = ubo;
+		escapeTimeCamera = frameCamera;
+	}
+
+	/* Palette changes only recolor the stored escape time, any change of the shown image restarts the accumulation */
+	INTERNALSCOPE UBO coloringView = {};
+	if (ubo.PaletteIndex != coloringView.PaletteIndex || ubo.ColorScale != coloringView.ColorScale || ubo.ColorOffset != coloringView.ColorOffset)
+		m_ColoringOutdated = true;
+
+	coloringView = ubo;
+	if (m_EscapeTimeOutdated || m_ColoringOutdated)
+	{
+		m_AccumulatedSampleCount = 0;
+	}
+	else if (m_AccumulatedSampleCount < Accumulation::SampleCount)
+	{
+		/* Every pixel is iterated again at the sample's offset, texture u runs against window y and v against window x */
+		const auto [sampleOffsetX, sampleOffsetY] = Accumulation::GetSampleOffset(m_AccumulatedSampleCount);
+		ubo.ReprojectionMode = static_cast<uint32_t>(Reprojection::EMode::None);
+		ubo.RefineStep = 1;
+		frameCamera.SampleOffsetX = static_cast<float>(-sampleOffsetY / static_cast<double>(camera.Height));
+		frameCamera.SampleOffsetY = static_cast<float>(-sampleOffsetX / static_cast<double>(camera.Width));
+		frameCamera.SampleIndex = m_AccumulatedSampleCount;
+	}
+	else
+	{
+		/* Idle, the last frame shows the complete accumulation */
 		return;
 	}
 
+	/* DrawFrame() copies the UBO into the frame's slot of the ring once the frame is free */
+	m_FrameUBO = ubo;
+	m_FrameCamera = frameCamera;
+}
+
+bool VulkanApp::DrawFrame()
+{
+	ReadEscapeTimeCounters();
+
+	/* Samples start once the counters of the last refining pass are read, their own passes overwrite them */
+	const bool accumulate = !m_EscapeTimeOutdated && !m_ColoringOutdated && m_AccumulatedSampleCount < Accumulation::SampleCount && !m_CounterFence;
+	if (!m_EscapeTimeOutdated && !m_ColoringOutdated && !accumulate)
+		return false;
+
+	/* The frame's command buffer, UBO slot and semaphores are reused once its last submission finished */
+	VK_CHECK(vkWaitForFences(
+		m_LogicalDevice,
+		1,
+		&m_InFlightFences[m_FrameIndex],
+		VK_TRUE,
+		UINT64_MAX));
+
+	/* The counters of the last escape time pass are read before its fence is reset */
+	if (m_CounterFence == m_InFlightFences[m_FrameIndex])
+		ReadEscapeTimeCounters();
+
+	/* Host coherent, the copy is visible to the submissions below */
+	const VkDeviceSize uniformOffset = m_FrameIndex * m_UBORingStride;
+	memcpy(m_UBORingData + uniformOffset, &m_FrameUBO, sizeof(UBO));
+
+	/* A failed acquire returns before anything is submitted, the frame is drawn again into the new swapchain */
 	VkResult result = vkAcquireNextImageKHR(
 		m_LogicalDevice,
 		m_Swapchain,
@@ -2058,26 +3447,70 @@ void VulkanApp::DrawFrame()
 
 	if (result != VK_SUCCESS)
 	{
-
 		const auto [windowWidth, windowHeight] = m_Window->GetSize();
 		RecreateSwapchain(windowWidth, windowHeight);
-		return;
+		return true;
+	}
+
+	/*
+	* The async compute mode submits the escape time pass before waiting for the acquired image, so it
+	* runs while the frames before are still colored and presented. Its target is the image the last
+	* refining pass did not write, samples keep that pass for the next reprojection
+	*/
+	const bool computeEscapeTime = m_EscapeTimeOutdated || accumulate;
+	const bool asyncEscapeTime = m_RenderMethod == ERenderMethod::AsyncCompute && computeEscapeTime;
+	if (asyncEscapeTime)
+	{
+		const uint32_t target = 1 - m_EscapeTimeFront;
+		if (m_EscapeTimeReadFences[target] != VK_NULL_HANDLE)
+			VK_CHECK(vkWaitForFences(m_LogicalDevice, 1, &m_EscapeTimeReadFences[target], VK_TRUE, UINT64_MAX));
+
+		VkCommandBuffer computeCommandBuffer = m_ComputeCommandBuffers[m_FrameIndex];
+		RecordComputeCommandBuffer(computeCommandBuffer, m_FrameIndex, static_cast<uint32_t>(uniformOffset), target, accumulate);
+
+		VkSubmitInfo computeSubmitInfo{};
+		computeSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		computeSubmitInfo.commandBufferCount = 1;
+		computeSubmitInfo.pCommandBuffers = &computeCommandBuffer;
+		computeSubmitInfo.waitSemaphoreCount = 0;
+		computeSubmitInfo.pWaitSemaphores = nullptr;
+		computeSubmitInfo.pWaitDstStageMask = nullptr;
+		computeSubmitInfo.signalSemaphoreCount = 1;
+		computeSubmitInfo.pSignalSemaphores = &m_Semaphores.ComputeComplete[m_FrameIndex];
+
+		/* The frame's fence signals after its coloring, which waits for this pass */
+		VK_CHECK(vkQueueSubmit(
+			m_ComputeQueue,
+			1,
+			&computeSubmitInfo,
+			VK_NULL_HANDLE));
+
+		m_ShownEscapeTime = target;
+		if (!accumulate)
+			m_EscapeTimeFront = target;
 	}
 
 	if (m_ImagesInFlight[m_ImageIndex] != VK_NULL_HANDLE) 
 		vkWaitForFences(m_LogicalDevice, 1, &m_ImagesInFlight[m_ImageIndex], VK_TRUE, UINT64_MAX);
-		
+
 	m_ImagesInFlight[m_ImageIndex] = m_InFlightFences[m_FrameIndex];
-	const VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+
+	/* Palette changes alone only recolor the stored escape time, an unchanged view takes the next sample */
+	VkCommandBuffer commandBuffer = m_GraphicsPipelineCommandBuffers[m_FrameIndex];
+	RecordGraphicsCommandBuffer(commandBuffer, m_ImageIndex, static_cast<uint32_t>(uniformOffset), computeEscapeTime && !asyncEscapeTime, accumulate);
+
+	/* The coloring of an async escape time pass waits for it, the swapchain image is only needed for the output */
+	const std::array<VkSemaphore, 2> waitSemaphores{ m_Semaphores.PresentComplete[m_FrameIndex], m_Semaphores.ComputeComplete[m_FrameIndex] };
+	const std::array<VkPipelineStageFlags, 2> waitStages{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &m_GraphicsPipelineCommandBuffers[m_ImageIndex];
-	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = &m_Semaphores.PresentComplete[m_FrameIndex];
+	submitInfo.pCommandBuffers = &commandBuffer;
+	submitInfo.waitSemaphoreCount = asyncEscapeTime ? 2 : 1;
+	submitInfo.pWaitSemaphores = waitSemaphores.data();
 	submitInfo.signalSemaphoreCount = 1;
 	submitInfo.pSignalSemaphores = &m_Semaphores.RenderComplete[m_FrameIndex];
-	submitInfo.pWaitDstStageMask = waitStages;
+	submitInfo.pWaitDstStageMask = waitStages.data();
 
 	VK_CHECK(vkResetFences(
 		m_LogicalDevice, 
@@ -2090,6 +3523,22 @@ void VulkanApp::DrawFrame()
 		&submitInfo,
 		m_InFlightFences[m_FrameIndex]));
 
+	if (m_RenderMethod == ERenderMethod::AsyncCompute)
+		m_EscapeTimeReadFences[m_ShownEscapeTime] = m_InFlightFences[m_FrameIndex];
+
+	if (m_EscapeTimeOutdated)
+	{
+		m_CounterFence = m_InFlightFences[m_FrameIndex];
+		m_CounterIterationCount = m_EscapeTimeIterationCount;
+		m_CounterQuerySlot = m_FrameIndex;
+	}
+
+	if (accumulate)
+		++m_AccumulatedSampleCount;
+
+	m_EscapeTimeOutdated = false;
+	m_ColoringOutdated = false;
+
 	VkPresentInfoKHR presentInfo;
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 	presentInfo.swapchainCount = 1;
@@ -2111,6 +3560,41 @@ void VulkanApp::DrawFrame()
 	}
 	
 	m_FrameIndex = (m_FrameIndex + 1) % m_MaxFramesInFlight;
+	return true;
+}
+
+void VulkanApp::ReadEscapeTimeCounters()
+{
+	/* Only the last pass writes the counters, later passes clear them first */
+	if (!m_CounterFence || vkGetFenceStatus(m_LogicalDevice, m_CounterFence) != VK_SUCCESS)
+		return;
+
+	m_CounterFence = VK_NULL_HANDLE;
+	memcpy(m_EscapeHistogram.data(), m_Counters + Utilities::CounterHistogramOffset, sizeof(m_EscapeHistogram));
+	m_EscapeHistogramIterationCount = m_CounterIterationCount;
+	/* Takes effect with the next frame, whose escape time pass brings the next histogram */
+	if (m_AutoIterations && m_CounterIterationCount > 0)
+		m_IterationCount = AutoIteration::ChooseIterationLimit(m_EscapeHistogram.data(), m_CounterIterationCount);
+
+	/* Cost of an iterated pixel for the next lattice choice, passes that iterated next to nothing mostly time the copies */
+	const double pixelCount = static_cast<double>(m_SwapchainExtent.width) * static_cast<double>(m_SwapchainExtent.height);
+	const uint32_t iteratedCount = m_Counters[3];
+	std::array<uint64_t, 2> timestamps;
+	if (m_EscapeTimeQueryPool && static_cast<double>(iteratedCount) >= pixelCount / 256.0 &&
+		vkGetQueryPoolResults(m_LogicalDevice, m_EscapeTimeQueryPool, m_CounterQuerySlot * 2, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+		m_SecondsPerIteratedPixel = static_cast<double>(timestamps[1] - timestamps[0]) * static_cast<double>(m_PhysicalDeviceProperties.limits.timestampPeriod) * 1.0e-9 / static_cast<double>(iteratedCount);
+
+	const double time = Platform::GetAbsoluteTime();
+	if (time - m_LastHitRateTime < 1.0)
+		return;
+
+	m_LastHitRateTime = time;
+	InteriorCheckCounts counts;
+	counts.Cardioid = m_Counters[0];
+	counts.Bulb = m_Counters[1];
+	counts.Periodicity = m_Counters[2];
+	InteriorCheck::PrintHitRates(m_InteriorChecks, counts, pixelCount);
+	AutoIteration::PrintSummary(m_EscapeHistogram.data(), m_CounterIterationCount, m_AutoIterations, pixelCount);
 }
 
 void VulkanApp::RecreateSwapchain(const uint32_t width, const uint32_t height)
@@ -2130,7 +3614,8 @@ void VulkanApp::RecreateSwapchain(const uint32_t width, const uint32_t height)
 	VK_CHECK(vkDeviceWaitIdle(m_LogicalDevice));
 	CleanupSwapchain();
 	CreateSwapchain();	
-	RecordGraphicsCommandBuffers();
+	DestroyEscapeTimeTarget();
+	CreateEscapeTimeTarget();
 }
 
 void VulkanApp::CleanupSwapchain()
@@ -2157,7 +3642,10 @@ void VulkanApp::CleanupSwapchain()
 			m_InFlightFences[i],
 			nullptr);
 	}
-	
+
+	/* Pointed at the fences above, the counts of that pass are dropped with it */
+	m_CounterFence = VK_NULL_HANDLE;
+	m_EscapeTimeReadFences = {};
 	m_ImagesInFlight.clear();
 	for (uint32_t i = 0; i < m_MaxFramesInFlight; ++i)
 	{
@@ -2175,6 +3663,12 @@ void VulkanApp::CleanupSwapchain()
 				m_LogicalDevice,
 				m_Semaphores.RenderComplete[i],
 				nullptr);
+
+		if(m_Semaphores.ComputeComplete[i])
+			vkDestroySemaphore(
+				m_LogicalDevice,
+				m_Semaphores.ComputeComplete[i],
+				nullptr);
 	}
 
 	vkDestroySwapchainKHR(
@@ -2395,6 +3889,13 @@ void VulkanApp::SetImageLayout(VkCommandBuffer cmdbuffer, VkImage image, VkImage
 
 			break;
 		}
+
+		case VK_IMAGE_LAYOUT_GENERAL:
+		{
+			imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+			break;
+		}
 			
 		default:
 		{
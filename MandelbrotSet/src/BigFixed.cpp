@@ -0,0 +1,450 @@
+#include "include/BigFixed.h"
+#include <math.h>
+#include <stdlib.h>
+
+namespace Utilities {
+	/* product[0, 2n) = a * b */
+	INTERNALSCOPE void MultiplySchoolbook(const uint32_t* a, const uint32_t* b, const std::size_t n, uint32_t* product)
+	{
+		memset(product, 0, n * 2 * sizeof(uint32_t));
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			if (a[i] == 0)
+				continue;
+
+			uint64_t carry = 0;
+			for (std::size_t j = 0; j < n; ++j)
+			{
+				const uint64_t sum = static_cast<uint64_t>(a[i]) * b[j] + product[i + j] + carry;
+				product[i + j] = static_cast<uint32_t>(sum);
+				carry = sum >> 32;
+			}
+
+			product[i + n] = static_cast<uint32_t>(carry);
+		}
+	}
+
+	/* product[0, 2n) = a^2, the cross products a_i a_j (i < j) once and doubled, then the diagonal */
+	INTERNALSCOPE void SquareSchoolbook(const uint32_t* a, const std::size_t n, uint32_t* product)
+	{
+		memset(product, 0, n * 2 * sizeof(uint32_t));
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			if (a[i] == 0)
+				continue;
+
+			uint64_t carry = 0;
+			for (std::size_t j = i + 1; j < n; ++j)
+			{
+				const uint64_t sum = static_cast<uint64_t>(a[i]) * a[j] + product[i + j] + carry;
+				product[i + j] = static_cast<uint32_t>(sum);
+				carry = sum >> 32;
+			}
+
+			product[i + n] = static_cast<uint32_t>(carry);
+		}
+
+		uint32_t shiftedOut = 0;
+		for (std::size_t i = 0; i < n * 2; ++i)
+		{
+			const uint32_t limb = product[i];
+			product[i] = (limb << 1) | shiftedOut;
+			shiftedOut = limb >> 31;
+		}
+
+		uint64_t carry = 0;
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			const uint64_t square = static_cast<uint64_t>(a[i]) * a[i];
+			const uint64_t low = static_cast<uint64_t>(product[i * 2]) + static_cast<uint32_t>(square) + carry;
+			product[i * 2] = static_cast<uint32_t>(low);
+			const uint64_t high = static_cast<uint64_t>(product[i * 2 + 1]) + (square >> 32) + (low >> 32);
+			product[i * 2 + 1] = static_cast<uint32_t>(high);
+			carry = high >> 32;
+		}
+	}
+
+	/* sum[0, high + 1) = a[0, low) + b[0, high), low <= high */
+	INTERNALSCOPE void AddHalves(const uint32_t* a, const std::size_t low, const uint32_t* b, const std::size_t high, uint32_t* sum)
+	{
+		uint64_t carry = 0;
+		for (std::size_t i = 0; i < high; ++i)
+		{
+			const uint64_t limbSum = static_cast<uint64_t>(i < low ? a[i] : 0) + b[i] + carry;
+			sum[i] = static_cast<uint32_t>(limbSum);
+			carry = limbSum >> 32;
+		}
+
+		sum[high] = static_cast<uint32_t>(carry);
+	}
+
+	/* target[0, targetCount) -= value[0, valueCount), valueCount <= targetCount and the difference is not negative */
+	INTERNALSCOPE void SubtractInPlace(uint32_t* target, const std::size_t targetCount, const uint32_t* value, const std::size_t valueCount)
+	{
+		uint64_t borrow = 0;
+		for (std::size_t i = 0; i < targetCount && (i < valueCount || borrow != 0); ++i)
+		{
+			const uint64_t difference = static_cast<uint64_t>(target[i]) - (i < valueCount ? value[i] : 0) - borrow;
+			target[i] = static_cast<uint32_t>(difference);
+			borrow = (difference >> 32) & 1;
+		}
+	}
+
+	/* target[0, targetCount) += value[0, valueCount), limbs of value past targetCount are zero and the sum fits */
+	INTERNALSCOPE void AddInPlace(uint32_t* target, const std::size_t targetCount, const uint32_t* value, const std::size_t valueCount)
+	{
+		uint64_t carry = 0;
+		for (std::size_t i = 0; i < targetCount && (i < valueCount || carry != 0); ++i)
+		{
+			const uint64_t sum = static_cast<uint64_t>(target[i]) + (i < valueCount ? value[i] : 0) + carry;
+			target[i] = static_cast<uint32_t>(sum);
+			carry = sum >> 32;
+		}
+	}
+
+	/* Limbs the Karatsuba recursion on n limbs needs besides the product: both half sums and their product per level */
+	INTERNALSCOPE std::size_t GetScratchSize(const std::size_t n)
+	{
+		if (n < BigFixed::KaratsubaThreshold)
+			return 0;
+
+		const std::size_t sumCount = n - n / 2 + 1;
+		return sumCount * 4 + GetScratchSize(sumCount);
+	}
+
+	/*
+	* product[0, 2n) = a * b with a = a1 B^low + a0 (B = 2^32): a0 b0 and a1 b1 go straight into the
+	* lower and upper half of product, the middle term is (a0 + a1)(b0 + b1) - a0 b0 - a1 b1.
+	*/
+	INTERNALSCOPE void MultiplyKaratsuba(const uint32_t* a, const uint32_t* b, const std::size_t n, uint32_t* product, uint32_t* scratch)
+	{
+		if (n < BigFixed::KaratsubaThreshold)
+		{
+			MultiplySchoolbook(a, b, n, product);
+			return;
+		}
+
+		const std::size_t low = n / 2;
+		const std::size_t high = n - low;
+		const std::size_t sumCount = high + 1;
+		uint32_t* sumA = scratch;
+		uint32_t* sumB = scratch + sumCount;
+		uint32_t* middle = scratch + sumCount * 2;
+		uint32_t* nextScratch = scratch + sumCount * 4;
+
+		MultiplyKaratsuba(a, b, low, product, nextScratch);
+		MultiplyKaratsuba(a + low, b + low, high, product + low * 2, nextScratch);
+		AddHalves(a, low, a + low, high, sumA);
+		AddHalves(b, low, b + low, high, sumB);
+		MultiplyKaratsuba(sumA, sumB, sumCount, middle, nextScratch);
+
+		SubtractInPlace(middle, sumCount * 2, product, low * 2);
+		SubtractInPlace(middle, sumCount * 2, product + low * 2, high * 2);
+		AddInPlace(product + low, n * 2 - low, middle, sumCount * 2);
+	}
+
+	/* MultiplyKaratsuba with a = b, the three partial products are squares */
+	INTERNALSCOPE void SquareKaratsuba(const uint32_t* a, const std::size_t n, uint32_t* product, uint32_t* scratch)
+	{
+		if (n < BigFixed::KaratsubaThreshold)
+		{
+			SquareSchoolbook(a, n, product);
+			return;
+		}
+
+		const std::size_t low = n / 2;
+		const std::size_t high = n - low;
+		const std::size_t sumCount = high + 1;
+		uint32_t* sum = scratch;
+		uint32_t* middle = scratch + sumCount * 2;
+		uint32_t* nextScratch = scratch + sumCount * 4;
+
+		SquareKaratsuba(a, low, product, nextScratch);
+		SquareKaratsuba(a + low, high, product + low * 2, nextScratch);
+		AddHalves(a, low, a + low, high, sum);
+		SquareKaratsuba(sum, sumCount, middle, nextScratch);
+
+		SubtractInPlace(middle, sumCount * 2, product, low * 2);
+		SubtractInPlace(middle, sumCount * 2, product + low * 2, high * 2);
+		AddInPlace(product + low, n * 2 - low, middle, sumCount * 2);
+	}
+
+	/* Full product and Karatsuba scratch of the calling thread, grown to the largest operands seen */
+	INTERNALSCOPE std::vector<uint32_t>& GetProductBuffer(const std::size_t n, uint32_t*& scratch)
+	{
+		thread_local std::vector<uint32_t> buffer;
+		const std::size_t size = n * 2 + GetScratchSize(n);
+		if (buffer.size() < size)
+			buffer.resize(size);
+
+		scratch = buffer.data() + n * 2;
+		return buffer;
+	}
+}
+
+BigFixed::BigFixed(const uint32_t fractionBits)
+	:
+	m_Limbs(GetLimbCount(fractionBits), 0),
+	m_Negative(false)
+{}
+
+BigFixed BigFixed::FromDouble(const double value, const uint32_t fractionBits)
+{
+	BigFixed result(fractionBits);
+	double magnitude = fabs(value);
+	assert(magnitude < 4294967296.0);
+
+	/* Scaling by 2^32 is exact, so every limb takes the next 32 bits of the double */
+	const double integerPart = floor(magnitude);
+	result.m_Limbs.back() = static_cast<uint32_t>(integerPart);
+	magnitude -= integerPart;
+	for (std::size_t i = result.m_Limbs.size() - 1; i-- > 0 && magnitude != 0.0;)
+	{
+		magnitude *= 4294967296.0;
+		const double limb = floor(magnitude);
+		result.m_Limbs[i] = static_cast<uint32_t>(limb);
+		magnitude -= limb;
+	}
+
+	result.m_Negative = value < 0.0 && !result.IsZero();
+	return result;
+}
+
+bool BigFixed::Parse(const std::string_view text, const uint32_t fractionBits, BigFixed& value)
+{
+	std::size_t position = 0;
+	bool negative = false;
+	if (position < text.size() && (text[position] == '-' || text[position] == '+'))
+		negative = text[position++] == '-';
+
+	/* Digits without the point, pointPosition of them belong to the integer part */
+	std::string digits;
+	int64_t pointPosition = -1;
+	for (; position < text.size(); ++position)
+	{
+		const char character = text[position];
+		if (character >= '0' && character <= '9')
+			digits.push_back(character);
+		else if (character == '.' && pointPosition < 0)
+			pointPosition = static_cast<int64_t>(digits.size());
+		else
+			break;
+	}
+
+	if (digits.empty())
+		return false;
+
+	if (pointPosition < 0)
+		pointPosition = static_cast<int64_t>(digits.size());
+
+	if (position < text.size() && (text[position] == 'e' || text[position] == 'E'))
+	{
+		char* end = nullptr;
+		const std::string exponentText(text.substr(position + 1));
+		const long exponent = strtol(exponentText.c_str(), &end, 10);
+		if (end == exponentText.c_str() || *end != '\0' || exponent < -1000000 || exponent > 1000000)
+			return false;
+
+		pointPosition += exponent;
+		position = text.size();
+	}
+
+	if (position != text.size())
+		return false;
+
+	/* Moves the point into the digits, padding with zeros on either side */
+	if (pointPosition < 0)
+	{
+		digits.insert(0, static_cast<std::size_t>(-pointPosition), '0');
+		pointPosition = 0;
+	}
+	else if (pointPosition > static_cast<int64_t>(digits.size()))
+		digits.append(static_cast<std::size_t>(pointPosition) - digits.size(), '0');
+
+	uint64_t integerPart = 0;
+	for (int64_t i = 0; i < pointPosition; ++i)
+	{
+		integerPart = integerPart * 10 + static_cast<uint64_t>(digits[i] - '0');
+		if (integerPart > 0xFFFFFFFFull)
+			return false;
+	}
+
+	/* Horner's scheme from the last digit on: fraction = (digit + fraction) / 10 */
+	BigFixed result(fractionBits);
+	for (std::size_t i = digits.size(); i-- > static_cast<std::size_t>(pointPosition);)
+	{
+		result.m_Limbs.back() = static_cast<uint32_t>(digits[i] - '0');
+		result.DivideMagnitude(10);
+	}
+
+	result.m_Limbs.back() = static_cast<uint32_t>(integerPart);
+	result.m_Negative = negative && !result.IsZero();
+	value = std::move(result);
+	return true;
+}
+
+double BigFixed::ToDouble() const
+{
+	/* The most significant non-zero limb and the two below it cover more than the 53 bits of a double */
+	std::size_t top = m_Limbs.size();
+	while (top > 0 && m_Limbs[top - 1] == 0)
+		--top;
+
+	if (top == 0)
+		return 0.0;
+
+	const int fractionLimbCount = static_cast<int>(m_Limbs.size()) - 1;
+	double result = 0.0;
+	for (std::size_t i = top; i-- > 0 && top - i <= 3;)
+		result += ldexp(static_cast<double>(m_Limbs[i]), (static_cast<int>(i) - fractionLimbCount) * 32);
+
+	return m_Negative ? -result : result;
+}
+
+BigFixed BigFixed::operator+(const BigFixed& other) const
+{
+	return AddSigned(*this, other, false);
+}
+
+BigFixed BigFixed::operator-(const BigFixed& other) const
+{
+	return AddSigned(*this, other, true);
+}
+
+BigFixed BigFixed::operator-() const
+{
+	BigFixed result = *this;
+	result.m_Negative = !m_Negative && !IsZero();
+	return result;
+}
+
+BigFixed BigFixed::operator*(const BigFixed& other) const
+{
+	BigFixed result;
+	Multiply(*this, other, result);
+	return result;
+}
+
+BigFixed BigFixed::Square() const
+{
+	BigFixed result;
+	Square(*this, result);
+	return result;
+}
+
+void BigFixed::Multiply(const BigFixed& a, const BigFixed& b, BigFixed& result)
+{
+	assert(a.m_Limbs.size() == b.m_Limbs.size());
+	const std::size_t limbCount = a.m_Limbs.size();
+
+	uint32_t* scratch;
+	std::vector<uint32_t>& product = Utilities::GetProductBuffer(limbCount, scratch);
+	Utilities::MultiplyKaratsuba(a.m_Limbs.data(), b.m_Limbs.data(), limbCount, product.data(), scratch);
+	TruncateProduct(product.data(), limbCount, a.m_Negative != b.m_Negative, result);
+}
+
+void BigFixed::Square(const BigFixed& a, BigFixed& result)
+{
+	const std::size_t limbCount = a.m_Limbs.size();
+
+	uint32_t* scratch;
+	std::vector<uint32_t>& product = Utilities::GetProductBuffer(limbCount, scratch);
+	Utilities::SquareKaratsuba(a.m_Limbs.data(), limbCount, product.data(), scratch);
+	TruncateProduct(product.data(), limbCount, false, result);
+}
+
+void BigFixed::MultiplySchoolbook(const BigFixed& a, const BigFixed& b, BigFixed& result)
+{
+	assert(a.m_Limbs.size() == b.m_Limbs.size());
+	const std::size_t limbCount = a.m_Limbs.size();
+
+	uint32_t* scratch;
+	std::vector<uint32_t>& product = Utilities::GetProductBuffer(limbCount, scratch);
+	Utilities::MultiplySchoolbook(a.m_Limbs.data(), b.m_Limbs.data(), limbCount, product.data());
+	TruncateProduct(product.data(), limbCount, a.m_Negative != b.m_Negative, result);
+}
+
+void BigFixed::TruncateProduct(const uint32_t* product, const std::size_t limbCount, const bool negative, BigFixed& result)
+{
+	/* Both operands carry limbCount - 1 fraction limbs, the product twice as many */
+	result.m_Limbs.assign(product + (limbCount - 1), product + (limbCount * 2 - 1));
+	result.m_Negative = negative && !result.IsZero();
+}
+
+int BigFixed::CompareMagnitudes(const BigFixed& a, const BigFixed& b)
+{
+	for (std::size_t i = a.m_Limbs.size(); i-- > 0;)
+		if (a.m_Limbs[i] != b.m_Limbs[i])
+			return a.m_Limbs[i] < b.m_Limbs[i] ? -1 : 1;
+
+	return 0;
+}
+
+void BigFixed::AddMagnitudes(const BigFixed& a, const BigFixed& b, BigFixed& result)
+{
+	uint64_t carry = 0;
+	for (std::size_t i = 0; i < a.m_Limbs.size(); ++i)
+	{
+		const uint64_t sum = static_cast<uint64_t>(a.m_Limbs[i]) + b.m_Limbs[i] + carry;
+		result.m_Limbs[i] = static_cast<uint32_t>(sum);
+		carry = sum >> 32;
+	}
+}
+
+void BigFixed::SubtractMagnitudes(const BigFixed& larger, const BigFixed& smaller, BigFixed& result)
+{
+	uint64_t borrow = 0;
+	for (std::size_t i = 0; i < larger.m_Limbs.size(); ++i)
+	{
+		const uint64_t difference = static_cast<uint64_t>(larger.m_Limbs[i]) - smaller.m_Limbs[i] - borrow;
+		result.m_Limbs[i] = static_cast<uint32_t>(difference);
+		borrow = (difference >> 32) & 1;
+	}
+}
+
+BigFixed BigFixed::AddSigned(const BigFixed& a, const BigFixed& b, const bool negateOther)
+{
+	assert(a.m_Limbs.size() == b.m_Limbs.size());
+	const bool otherNegative = b.m_Negative != negateOther;
+
+	BigFixed result;
+	result.m_Limbs.resize(a.m_Limbs.size());
+	if (a.m_Negative == otherNegative)
+	{
+		AddMagnitudes(a, b, result);
+		result.m_Negative = a.m_Negative;
+	}
+	else if (CompareMagnitudes(a, b) >= 0)
+	{
+		SubtractMagnitudes(a, b, result);
+		result.m_Negative = a.m_Negative;
+	}
+	else
+	{
+		SubtractMagnitudes(b, a, result);
+		result.m_Negative = otherNegative;
+	}
+
+	result.m_Negative = result.m_Negative && !result.IsZero();
+	return result;
+}
+
+void BigFixed::DivideMagnitude(const uint32_t divisor)
+{
+	uint64_t remainder = 0;
+	for (std::size_t i = m_Limbs.size(); i-- > 0;)
+	{
+		const uint64_t dividend = (remainder << 32) | m_Limbs[i];
+		m_Limbs[i] = static_cast<uint32_t>(dividend / divisor);
+		remainder = dividend % divisor;
+	}
+}
+
+bool BigFixed::IsZero() const
+{
+	for (const uint32_t limb : m_Limbs)
+		if (limb != 0)
+			return false;
+
+	return true;
+}
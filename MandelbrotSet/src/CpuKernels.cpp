@@ -0,0 +1,715 @@
+#include "include/CpuKernels.h"
+#include <algorithm>
+#include <bitset>
+#include <math.h>
+#include <type_traits>
+#include <utility>
+
+/* The kernels have to round like the reference, the compiler must not fuse their multiplies and adds */
+#if defined(__clang__)
+	#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+	#pragma GCC optimize("fp-contract=off")
+#endif
+
+/*
+* IterateLanes() is written once for every level and only inlined into the entry points that
+* carry the level's target attribute, GCC warns about the vector ABI of the generic version that
+* is never emitted.
+*/
+#if defined(__GNUC__)
+	#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+#ifdef _MSC_VER
+	#define APP_FORCEINLINE __forceinline
+#else
+	#define APP_FORCEINLINE inline __attribute__((always_inline))
+#endif
+
+namespace Utilities {
+	/* Same operations as PixelToComplex in computeShader.comp */
+	INTERNALSCOPE float PixelToReal(const KernelViewport& viewport, const uint32_t x)
+	{
+		return viewport.CenterX + (static_cast<float>(x) / static_cast<float>(viewport.Width) - 0.5f) * viewport.Scale;
+	}
+
+	INTERNALSCOPE float PixelToImaginary(const KernelViewport& viewport, const uint32_t y)
+	{
+		const float aspectRatio = static_cast<float>(viewport.Height) / static_cast<float>(viewport.Width);
+		return viewport.CenterY + (static_cast<float>(y) / static_cast<float>(viewport.Height) - 0.5f) * (viewport.Scale * aspectRatio);
+	}
+
+	/* Pixels whose coordinates IterateRow() prepares at once */
+	constexpr uint32_t RowChunkSize = 256;
+
+	/*
+	* Lane traits, one per level and precision: the vector, mask and counter types and the handful
+	* of operations the kernel body needs. Masks of SSE2 and AVX2 are vectors, of AVX-512 opmasks.
+	* Counters hold the escape iteration of every lane as an integer as wide as the lane.
+	*/
+	template<typename Real>
+	struct ScalarLanes
+	{
+		using Vector = Real;
+		using Mask = bool;
+		using Counter = uint32_t;
+		static constexpr uint32_t Count = 1;
+
+		static Vector Broadcast(const Real value) { return value; }
+		static Vector Load(const Real* values) { return *values; }
+		static void Store(Real* values, const Vector vector) { *values = vector; }
+		static Vector Add(const Vector a, const Vector b) { return a + b; }
+		static Vector Sub(const Vector a, const Vector b) { return a - b; }
+		static Vector Mul(const Vector a, const Vector b) { return a * b; }
+		static Mask Greater(const Vector a, const Vector b) { return a > b; }
+		static Mask LessEqual(const Vector a, const Vector b) { return a <= b; }
+		static Mask None() { return false; }
+		static Mask And(const Mask a, const Mask b) { return a && b; }
+		static Mask AndNot(const Mask a, const Mask b) { return a && !b; }
+		static Mask Or(const Mask a, const Mask b) { return a || b; }
+		static Vector Select(const Mask mask, const Vector a, const Vector b) { return mask ? a : b; }
+		static uint32_t Bits(const Mask mask) { return mask ? 1u : 0u; }
+		static Counter ZeroCounter() { return 0; }
+		static Counter Increment(const Counter counter, const Mask mask) { return counter + (mask ? 1u : 0u); }
+		static void StoreCounter(uint32_t* values, const Counter counter) { *values = counter; }
+	};
+
+#if APP_SIMD_X64
+	template<typename Real>
+	struct SSE2Lanes;
+
+	template<>
+	struct SSE2Lanes<float>
+	{
+		using Vector = __m128;
+		using Mask = __m128;
+		using Counter = __m128i;
+		static constexpr uint32_t Count = 4;
+
+		static Vector Broadcast(const float value) { return _mm_set1_ps(value); }
+		static Vector Load(const float* values) { return _mm_load_ps(values); }
+		static void Store(float* values, const Vector vector) { _mm_store_ps(values, vector); }
+		static Vector Add(const Vector a, const Vector b) { return _mm_add_ps(a, b); }
+		static Vector Sub(const Vector a, const Vector b) { return _mm_sub_ps(a, b); }
+		static Vector Mul(const Vector a, const Vector b) { return _mm_mul_ps(a, b); }
+		static Mask Greater(const Vector a, const Vector b) { return _mm_cmpgt_ps(a, b); }
+		static Mask LessEqual(const Vector a, const Vector b) { return _mm_cmple_ps(a, b); }
+		static Mask None() { return _mm_setzero_ps(); }
+		static Mask And(const Mask a, const Mask b) { return _mm_and_ps(a, b); }
+		static Mask AndNot(const Mask a, const Mask b) { return _mm_andnot_ps(b, a); }
+		static Mask Or(const Mask a, const Mask b) { return _mm_or_ps(a, b); }
+		static Vector Select(const Mask mask, const Vector a, const Vector b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+		static uint32_t Bits(const Mask mask) { return static_cast<uint32_t>(_mm_movemask_ps(mask)); }
+		static Counter ZeroCounter() { return _mm_setzero_si128(); }
+		/* Masked lanes are all ones, -1 */
+		static Counter Increment(const Counter counter, const Mask mask) { return _mm_sub_epi32(counter, _mm_castps_si128(mask)); }
+		static void StoreCounter(uint32_t* values, const Counter counter) { _mm_store_si128(reinterpret_cast<__m128i*>(values), counter); }
+	};
+
+	template<>
+	struct SSE2Lanes<double>
+	{
+		using Vector = __m128d;
+		using Mask = __m128d;
+		using Counter = __m128i;
+		static constexpr uint32_t Count = 2;
+
+		static Vector Broadcast(const double value) { return _mm_set1_pd(value); }
+		static Vector Load(const double* values) { return _mm_load_pd(values); }
+		static void Store(double* values, const Vector vector) { _mm_store_pd(values, vector); }
+		static Vector Add(const Vector a, const Vector b) { return _mm_add_pd(a, b); }
+		static Vector Sub(const Vector a, const Vector b) { return _mm_sub_pd(a, b); }
+		static Vector Mul(const Vector a, const Vector b) { return _mm_mul_pd(a, b); }
+		static Mask Greater(const Vector a, const Vector b) { return _mm_cmpgt_pd(a, b); }
+		static Mask LessEqual(const Vector a, const Vector b) { return _mm_cmple_pd(a, b); }
+		static Mask None() { return _mm_setzero_pd(); }
+		static Mask And(const Mask a, const Mask b) { return _mm_and_pd(a, b); }
+		static Mask AndNot(const Mask a, const Mask b) { return _mm_andnot_pd(b, a); }
+		static Mask Or(const Mask a, const Mask b) { return _mm_or_pd(a, b); }
+		static Vector Select(const Mask mask, const Vector a, const Vector b) { return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b)); }
+		static uint32_t Bits(const Mask mask) { return static_cast<uint32_t>(_mm_movemask_pd(mask)); }
+		static Counter ZeroCounter() { return _mm_setzero_si128(); }
+		static Counter Increment(const Counter counter, const Mask mask) { return _mm_sub_epi64(counter, _mm_castpd_si128(mask)); }
+		/* The low halves of the 64 bit lanes */
+		static void StoreCounter(uint32_t* values, const Counter counter) { _mm_storel_epi64(reinterpret_cast<__m128i*>(values), _mm_shuffle_epi32(counter, _MM_SHUFFLE(3, 1, 2, 0))); }
+	};
+
+	template<typename Real>
+	struct AVX2Lanes;
+
+	template<>
+	struct AVX2Lanes<float>
+	{
+		using Vector = __m256;
+		using Mask = __m256;
+		using Counter = __m256i;
+		static constexpr uint32_t Count = 8;
+
+		APP_TARGET_AVX2 static Vector Broadcast(const float value) { return _mm256_set1_ps(value); }
+		APP_TARGET_AVX2 static Vector Load(const float* values) { return _mm256_load_ps(values); }
+		APP_TARGET_AVX2 static void Store(float* values, const Vector vector) { _mm256_store_ps(values, vector); }
+		APP_TARGET_AVX2 static Vector Add(const Vector a, const Vector b) { return _mm256_add_ps(a, b); }
+		APP_TARGET_AVX2 static Vector Sub(const Vector a, const Vector b) { return _mm256_sub_ps(a, b); }
+		APP_TARGET_AVX2 static Vector Mul(const Vector a, const Vector b) { return _mm256_mul_ps(a, b); }
+		APP_TARGET_AVX2 static Mask Greater(const Vector a, const Vector b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+		APP_TARGET_AVX2 static Mask LessEqual(const Vector a, const Vector b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+		APP_TARGET_AVX2 static Mask None() { return _mm256_setzero_ps(); }
+		APP_TARGET_AVX2 static Mask And(const Mask a, const Mask b) { return _mm256_and_ps(a, b); }
+		APP_TARGET_AVX2 static Mask AndNot(const Mask a, const Mask b) { return _mm256_andnot_ps(b, a); }
+		APP_TARGET_AVX2 static Mask Or(const Mask a, const Mask b) { return _mm256_or_ps(a, b); }
+		APP_TARGET_AVX2 static Vector Select(const Mask mask, const Vector a, const Vector b) { return _mm256_blendv_ps(b, a, mask); }
+		APP_TARGET_AVX2 static uint32_t Bits(const Mask mask) { return static_cast<uint32_t>(_mm256_movemask_ps(mask)); }
+		APP_TARGET_AVX2 static Counter ZeroCounter() { return _mm256_setzero_si256(); }
+		APP_TARGET_AVX2 static Counter Increment(const Counter counter, const Mask mask) { return _mm256_sub_epi32(counter, _mm256_castps_si256(mask)); }
+		APP_TARGET_AVX2 static void StoreCounter(uint32_t* values, const Counter counter) { _mm256_store_si256(reinterpret_cast<__m256i*>(values), counter); }
+	};
+
+	template<>
+	struct AVX2Lanes<double>
+	{
+		using Vector = __m256d;
+		using Mask = __m256d;
+		using Counter = __m256i;
+		static constexpr uint32_t Count = 4;
+
+		APP_TARGET_AVX2 static Vector Broadcast(const double value) { return _mm256_set1_pd(value); }
+		APP_TARGET_AVX2 static Vector Load(const double* values) { return _mm256_load_pd(values); }
+		APP_TARGET_AVX2 static void Store(double* values, const Vector vector) { _mm256_store_pd(values, vector); }
+		APP_TARGET_AVX2 static Vector Add(const Vector a, const Vector b) { return _mm256_add_pd(a, b); }
+		APP_TARGET_AVX2 static Vector Sub(const Vector a, const Vector b) { return _mm256_sub_pd(a, b); }
+		APP_TARGET_AVX2 static Vector Mul(const Vector a, const Vector b) { return _mm256_mul_pd(a, b); }
+		APP_TARGET_AVX2 static Mask Greater(const Vector a, const Vector b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+		APP_TARGET_AVX2 static Mask LessEqual(const Vector a, const Vector b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+		APP_TARGET_AVX2 static Mask None() { return _mm256_setzero_pd(); }
+		APP_TARGET_AVX2 static Mask And(const Mask a, const Mask b) { return _mm256_and_pd(a, b); }
+		APP_TARGET_AVX2 static Mask AndNot(const Mask a, const Mask b) { return _mm256_andnot_pd(b, a); }
+		APP_TARGET_AVX2 static Mask Or(const Mask a, const Mask b) { return _mm256_or_pd(a, b); }
+		APP_TARGET_AVX2 static Vector Select(const Mask mask, const Vector a, const Vector b) { return _mm256_blendv_pd(b, a, mask); }
+		APP_TARGET_AVX2 static uint32_t Bits(const Mask mask) { return static_cast<uint32_t>(_mm256_movemask_pd(mask)); }
+		APP_TARGET_AVX2 static Counter ZeroCounter() { return _mm256_setzero_si256(); }
+		APP_TARGET_AVX2 static Counter Increment(const Counter counter, const Mask mask) { return _mm256_sub_epi64(counter, _mm256_castpd_si256(mask)); }
+		APP_TARGET_AVX2 static void StoreCounter(uint32_t* values, const Counter counter) { _mm_store_si128(reinterpret_cast<__m128i*>(values), _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(counter, _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7)))); }
+	};
+
+	template<typename Real>
+	struct AVX512Lanes;
+
+	template<>
+	struct AVX512Lanes<float>
+	{
+		using Vector = __m512;
+		using Mask = __mmask16;
+		using Counter = __m512i;
+		static constexpr uint32_t Count = 16;
+
+		APP_TARGET_AVX512 static Vector Broadcast(const float value) { return _mm512_set1_ps(value); }
+		APP_TARGET_AVX512 static Vector Load(const float* values) { return _mm512_load_ps(values); }
+		APP_TARGET_AVX512 static void Store(float* values, const Vector vector) { _mm512_store_ps(values, vector); }
+		APP_TARGET_AVX512 static Vector Add(const Vector a, const Vector b) { return _mm512_add_ps(a, b); }
+		APP_TARGET_AVX512 static Vector Sub(const Vector a, const Vector b) { return _mm512_sub_ps(a, b); }
+		APP_TARGET_AVX512 static Vector Mul(const Vector a, const Vector b) { return _mm512_mul_ps(a, b); }
+		APP_TARGET_AVX512 static Mask Greater(const Vector a, const Vector b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+		APP_TARGET_AVX512 static Mask LessEqual(const Vector a, const Vector b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+		APP_TARGET_AVX512 static Mask None() { return 0; }
+		APP_TARGET_AVX512 static Mask And(const Mask a, const Mask b) { return static_cast<Mask>(a & b); }
+		APP_TARGET_AVX512 static Mask AndNot(const Mask a, const Mask b) { return static_cast<Mask>(a & ~b); }
+		APP_TARGET_AVX512 static Mask Or(const Mask a, const Mask b) { return static_cast<Mask>(a | b); }
+		APP_TARGET_AVX512 static Vector Select(const Mask mask, const Vector a, const Vector b) { return _mm512_mask_mov_ps(b, mask, a); }
+		APP_TARGET_AVX512 static uint32_t Bits(const Mask mask) { return mask; }
+		APP_TARGET_AVX512 static Counter ZeroCounter() { return _mm512_setzero_si512(); }
+		APP_TARGET_AVX512 static Counter Increment(const Counter counter, const Mask mask) { return _mm512_mask_add_epi32(counter, mask, counter, _mm512_set1_epi32(1)); }
+		APP_TARGET_AVX512 static void StoreCounter(uint32_t* values, const Counter counter) { _mm512_store_si512(values, counter); }
+	};
+
+	template<>
+	struct AVX512Lanes<double>
+	{
+		using Vector = __m512d;
+		using Mask = __mmask8;
+		using Counter = __m512i;
+		static constexpr uint32_t Count = 8;
+
+		APP_TARGET_AVX512 static Vector Broadcast(const double value) { return _mm512_set1_pd(value); }
+		APP_TARGET_AVX512 static Vector Load(const double* values) { return _mm512_load_pd(values); }
+		APP_TARGET_AVX512 static void Store(double* values, const Vector vector) { _mm512_store_pd(values, vector); }
+		APP_TARGET_AVX512 static Vector Add(const Vector a, const Vector b) { return _mm512_add_pd(a, b); }
+		APP_TARGET_AVX512 static Vector Sub(const Vector a, const Vector b) { return _mm512_sub_pd(a, b); }
+		APP_TARGET_AVX512 static Vector Mul(const Vector a, const Vector b) { return _mm512_mul_pd(a, b); }
+		APP_TARGET_AVX512 static Mask Greater(const Vector a, const Vector b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+		APP_TARGET_AVX512 static Mask LessEqual(const Vector a, const Vector b) { return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ); }
+		APP_TARGET_AVX512 static Mask None() { return 0; }
+		APP_TARGET_AVX512 static Mask And(const Mask a, const Mask b) { return static_cast<Mask>(a & b); }
+		APP_TARGET_AVX512 static Mask AndNot(const Mask a, const Mask b) { return static_cast<Mask>(a & ~b); }
+		APP_TARGET_AVX512 static Mask Or(const Mask a, const Mask b) { return static_cast<Mask>(a | b); }
+		APP_TARGET_AVX512 static Vector Select(const Mask mask, const Vector a, const Vector b) { return _mm512_mask_mov_pd(b, mask, a); }
+		APP_TARGET_AVX512 static uint32_t Bits(const Mask mask) { return mask; }
+		APP_TARGET_AVX512 static Counter ZeroCounter() { return _mm512_setzero_si512(); }
+		APP_TARGET_AVX512 static Counter Increment(const Counter counter, const Mask mask) { return _mm512_mask_add_epi64(counter, mask, counter, _mm512_set1_epi64(1)); }
+		APP_TARGET_AVX512 static void StoreCounter(uint32_t* values, const Counter counter) { _mm512_mask_cvtepi64_storeu_epi32(values, 0xFF, counter); }
+	};
+#endif
+
+	INTERNALSCOPE uint32_t CountLanes(const uint32_t mask)
+	{
+		return static_cast<uint32_t>(std::bitset<32>(mask).count());
+	}
+
+	/* Iterates count points, see CpuKernels::IteratePoints() */
+	template<typename Real>
+	using PointKernel = uint64_t(*)(
+		const Real* reals, const Real* imaginaries, const uint32_t count,
+		const uint32_t maxIterations, const Real escapeRadiusSquared, const Real periodicityTolerance,
+		uint32_t* iterations, Real* magnitudes, InteriorCheckCounts& counts);
+
+	/* z^Power + c, power 2 in the operation order of computeShader.comp */
+	template<typename Lanes, uint32_t Power>
+	APP_FORCEINLINE void Step(typename Lanes::Vector& zx, typename Lanes::Vector& zy, const typename Lanes::Vector& real, const typename Lanes::Vector& imaginary)
+	{
+		using L = Lanes;
+		if constexpr (Power == 2)
+		{
+			const typename L::Vector nextX = L::Add(L::Sub(L::Mul(zx, zx), L::Mul(zy, zy)), real);
+			zy = L::Add(L::Mul(L::Add(zx, zx), zy), imaginary);
+			zx = nextX;
+		}
+		else
+		{
+			typename L::Vector powerX = zx;
+			typename L::Vector powerY = zy;
+			for (uint32_t i = 1; i < Power; ++i)
+			{
+				const typename L::Vector nextX = L::Sub(L::Mul(powerX, zx), L::Mul(powerY, zy));
+				powerY = L::Add(L::Mul(powerX, zy), L::Mul(powerY, zx));
+				powerX = nextX;
+			}
+
+			zx = L::Add(powerX, real);
+			zy = L::Add(powerY, imaginary);
+		}
+	}
+
+	/*
+	* Body of every kernel. Lanes iterate until all of them escaped or turned out periodic, escaped
+	* lanes keep iterating (towards infinity and NaN, which never compares greater) but are masked
+	* out of the counter, their |z|^2 is captured in the iteration they escaped. The Brent
+	* checkpoints depend on the iteration only, so all lanes save z together. Returns the iterations
+	* executed: an escaped or periodic orbit ran one past its escape iteration, one that reached the
+	* limit all of them, one the cardioid or bulb test settled none.
+	*/
+	template<typename Lanes, typename Real, uint32_t Power, uint32_t Checks>
+	APP_FORCEINLINE uint64_t IterateLanes(
+		const Real* reals, const Real* imaginaries, const uint32_t count,
+		const uint32_t maxIterations, const Real escapeRadiusSquared, const Real periodicityTolerance,
+		uint32_t* iterations, Real* magnitudes, InteriorCheckCounts& counts)
+	{
+		using L = Lanes;
+		using Vector = typename L::Vector;
+		using Mask = typename L::Mask;
+		using Counter = typename L::Counter;
+		constexpr uint32_t LaneCount = L::Count;
+		constexpr bool CardioidCheck = Power == 2 && (Checks & 1u) != 0;
+		constexpr bool BulbCheck = Power == 2 && (Checks & 2u) != 0;
+		constexpr bool PeriodicityCheck = (Checks & 4u) != 0;
+
+		const Vector radius = L::Broadcast(escapeRadiusSquared);
+		const Vector toleranceSquared = L::Broadcast(periodicityTolerance * periodicityTolerance);
+		const Vector zero = L::Broadcast(Real(0));
+		const Vector one = L::Broadcast(Real(1));
+		const Vector quarter = L::Broadcast(Real(0.25));
+		const Vector sixteenth = L::Broadcast(Real(0.0625));
+
+		alignas(64) Real laneIndices[LaneCount];
+		for (uint32_t lane = 0; lane < LaneCount; ++lane)
+			laneIndices[lane] = static_cast<Real>(lane);
+
+		const Vector laneIndex = L::Load(laneIndices);
+
+		uint64_t executedIterations = 0;
+		for (uint32_t i = 0; i < count; i += LaneCount)
+		{
+			/* The tail is padded with the origin, its lanes never become active */
+			const uint32_t rowLaneCount = std::min(LaneCount, count - i);
+			alignas(64) Real laneReals[LaneCount] = {};
+			alignas(64) Real laneImaginaries[LaneCount] = {};
+			memcpy(laneReals, reals + i, rowLaneCount * sizeof(Real));
+			memcpy(laneImaginaries, imaginaries + i, rowLaneCount * sizeof(Real));
+
+			const Vector real = L::Load(laneReals);
+			const Vector imaginary = L::Load(laneImaginaries);
+			const Mask rowMask = L::Greater(L::Broadcast(static_cast<Real>(rowLaneCount)), laneIndex);
+
+			/* Lanes reported as inside the set, settled by a check or periodic */
+			Mask inside = L::None();
+			if constexpr (CardioidCheck)
+			{
+				const Vector shifted = L::Sub(real, quarter);
+				const Vector imaginarySquared = L::Mul(imaginary, imaginary);
+				const Vector q = L::Add(L::Mul(shifted, shifted), imaginarySquared);
+				const Mask cardioid = L::And(L::LessEqual(L::Mul(q, L::Add(q, shifted)), L::Mul(quarter, imaginarySquared)), rowMask);
+				counts.Cardioid += CountLanes(L::Bits(cardioid));
+				inside = cardioid;
+			}
+
+			if constexpr (BulbCheck)
+			{
+				const Vector shifted = L::Add(real, one);
+				const Mask bulb = L::AndNot(L::And(L::LessEqual(L::Add(L::Mul(shifted, shifted), L::Mul(imaginary, imaginary)), sixteenth), rowMask), inside);
+				counts.Bulb += CountLanes(L::Bits(bulb));
+				inside = L::Or(inside, bulb);
+			}
+
+			const Mask iterated = L::AndNot(rowMask, inside);
+			Mask active = iterated;
+			Mask periodic = L::None();
+			Vector zx = zero;
+			Vector zy = zero;
+			Vector savedX = zero;
+			Vector savedY = zero;
+			Vector magnitude = zero;
+			Counter escapeIteration = L::ZeroCounter();
+			uint32_t nextSave = 1;
+			for (uint32_t iteration = 0; iteration < maxIterations && L::Bits(active) != 0; ++iteration)
+			{
+				Step<L, Power>(zx, zy, real, imaginary);
+
+				const Vector squared = L::Add(L::Mul(zx, zx), L::Mul(zy, zy));
+				const Mask escaped = L::And(L::Greater(squared, radius), active);
+				magnitude = L::Select(escaped, squared, magnitude);
+				active = L::AndNot(active, escaped);
+
+				if constexpr (PeriodicityCheck)
+				{
+					const Vector dx = L::Sub(zx, savedX);
+					const Vector dy = L::Sub(zy, savedY);
+					const Mask repeated = L::And(L::LessEqual(L::Add(L::Mul(dx, dx), L::Mul(dy, dy)), toleranceSquared), active);
+					periodic = L::Or(periodic, repeated);
+					active = L::AndNot(active, repeated);
+					if (iteration + 1 == nextSave)
+					{
+						savedX = zx;
+						savedY = zy;
+						nextSave <<= 1;
+					}
+				}
+
+				escapeIteration = L::Increment(escapeIteration, active);
+			}
+
+			const uint32_t insideBits = L::Bits(L::Or(inside, periodic));
+			const uint32_t stoppedBits = L::Bits(L::AndNot(iterated, active));
+			if constexpr (PeriodicityCheck)
+				counts.Periodicity += CountLanes(L::Bits(periodic));
+
+			alignas(64) uint32_t laneIterations[LaneCount];
+			alignas(64) Real laneMagnitudes[LaneCount];
+			L::StoreCounter(laneIterations, escapeIteration);
+			L::Store(laneMagnitudes, magnitude);
+			for (uint32_t lane = 0; lane < rowLaneCount; ++lane)
+			{
+				executedIterations += laneIterations[lane] + ((stoppedBits >> lane) & 1u);
+				iterations[i + lane] = (insideBits >> lane) & 1u ? maxIterations : laneIterations[lane];
+				magnitudes[i + lane] = laneMagnitudes[lane];
+			}
+		}
+
+		return executedIterations;
+	}
+
+	/* Entry points, the attribute of the level is what the body gets compiled for */
+	template<typename Real, uint32_t Power, uint32_t Checks>
+	INTERNALSCOPE uint64_t IteratePointsScalar(
+		const Real* reals, const Real* imaginaries, const uint32_t count,
+		const uint32_t maxIterations, const Real escapeRadiusSquared, const Real periodicityTolerance,
+		uint32_t* iterations, Real* magnitudes, InteriorCheckCounts& counts)
+	{
+		return IterateLanes<ScalarLanes<Real>, Real, Power, Checks>(reals, imaginaries, count, maxIterations, escapeRadiusSquared, periodicityTolerance, iterations, magnitudes, counts);
+	}
+
+#if APP_SIMD_X64
+	template<typename Real, uint32_t Power, uint32_t Checks>
+	INTERNALSCOPE uint64_t IteratePointsSSE2(
+		const Real* reals, const Real* imaginaries, const uint32_t count,
+		const uint32_t maxIterations, const Real escapeRadiusSquared, const Real periodicityTolerance,
+		uint32_t* iterations, Real* magnitudes, InteriorCheckCounts& counts)
+	{
+		return IterateLanes<SSE2Lanes<Real>, Real, Power, Checks>(reals, imaginaries, count, maxIterations, escapeRadiusSquared, periodicityTolerance, iterations, magnitudes, counts);
+	}
+
+	template<typename Real, uint32_t Power, uint32_t Checks>
+	APP_TARGET_AVX2 INTERNALSCOPE uint64_t IteratePointsAVX2(
+		const Real* reals, const Real* imaginaries, const uint32_t count,
+		const uint32_t maxIterations, const Real escapeRadiusSquared, const Real periodicityTolerance,
+		uint32_t* iterations, Real* magnitudes, InteriorCheckCounts& counts)
+	{
+		return IterateLanes<AVX2Lanes<Real>, Real, Power, Checks>(reals, imaginaries, count, maxIterations, escapeRadiusSquared, periodicityTolerance, iterations, magnitudes, counts);
+	}
+
+	template<typename Real, uint32_t Power, uint32_t Checks>
+	APP_TARGET_AVX512 INTERNALSCOPE uint64_t IteratePointsAVX512(
+		const Real* reals, const Real* imaginaries, const uint32_t count,
+		const uint32_t maxIterations, const Real escapeRadiusSquared, const Real periodicityTolerance,
+		uint32_t* iterations, Real* magnitudes, InteriorCheckCounts& counts)
+	{
+		return IterateLanes<AVX512Lanes<Real>, Real, Power, Checks>(reals, imaginaries, count, maxIterations, escapeRadiusSquared, periodicityTolerance, iterations, magnitudes, counts);
+	}
+#endif
+
+	constexpr uint32_t LevelCount = APP_SIMD_X64 ? 4 : 1;
+
+	template<typename Real, uint32_t Power, uint32_t Checks, ESimdLevel Level>
+	constexpr PointKernel<Real> GetPointKernel()
+	{
+#if APP_SIMD_X64
+		if constexpr (Level == ESimdLevel::AVX512)
+			return &IteratePointsAVX512<Real, Power, Checks>;
+		else if constexpr (Level == ESimdLevel::AVX2)
+			return &IteratePointsAVX2<Real, Power, Checks>;
+		else if constexpr (Level == ESimdLevel::SSE2)
+			return &IteratePointsSSE2<Real, Power, Checks>;
+		else
+#endif
+			return &IteratePointsScalar<Real, Power, Checks>;
+	}
+
+	/* Kernels of the CPU renderer: float32, power 2, every subset of the checks, the level varies fastest */
+	template<uint32_t Index>
+	constexpr PointKernel<float> GetRendererKernel()
+	{
+		return GetPointKernel<float, 2, Index / LevelCount, static_cast<ESimdLevel>(Index % LevelCount)>();
+	}
+
+	template<std::size_t... Indices>
+	constexpr std::array<PointKernel<float>, sizeof...(Indices)> MakeRendererDispatchTable(std::index_sequence<Indices...>)
+	{
+		return { GetRendererKernel<static_cast<uint32_t>(Indices)>()... };
+	}
+
+	constexpr std::array<PointKernel<float>, 8 * LevelCount> RendererDispatchTable = MakeRendererDispatchTable(std::make_index_sequence<8 * LevelCount>());
+
+	/* Variant of the family: the row's points go through the point kernel, smooth coloring converts its result */
+	template<typename Real, uint32_t Power, bool Smooth, uint32_t Checks, ESimdLevel Level>
+	INTERNALSCOPE uint64_t IterateRowVariant(
+		const EscapeTimeParameters& parameters, const uint32_t x, const uint32_t y, const uint32_t count,
+		float* escapeTimes, InteriorCheckCounts& counts)
+	{
+		constexpr PointKernel<Real> iteratePoints = GetPointKernel<Real, Power, Checks, Level>();
+		/* The shader's radius of the smooth count, |z| > 2 for the escape iteration */
+		constexpr Real EscapeRadiusSquared = Smooth ? Real(65536) : Real(4);
+
+		const Real width = static_cast<Real>(parameters.Width);
+		const Real height = static_cast<Real>(parameters.Height);
+		const Real scale = static_cast<Real>(parameters.Scale);
+		const Real centerX = static_cast<Real>(parameters.CenterX);
+		const Real imaginary = static_cast<Real>(parameters.CenterY) + (static_cast<Real>(y) / height - Real(0.5)) * (scale * (height / width));
+		const Real tolerance = static_cast<Real>(parameters.PeriodicityTolerance);
+
+		Real reals[RowChunkSize];
+		Real imaginaries[RowChunkSize];
+		uint32_t iterations[RowChunkSize];
+		Real magnitudes[RowChunkSize];
+		std::fill(std::begin(imaginaries), std::end(imaginaries), imaginary);
+
+		uint64_t executedIterations = 0;
+		for (uint32_t first = 0; first < count; first += RowChunkSize)
+		{
+			const uint32_t chunkSize = std::min(RowChunkSize, count - first);
+			for (uint32_t i = 0; i < chunkSize; ++i)
+				reals[i] = centerX + (static_cast<Real>(x + first + i) / width - Real(0.5)) * scale;
+
+			executedIterations += iteratePoints(reals, imaginaries, chunkSize, parameters.MaxIterations, EscapeRadiusSquared, tolerance, iterations, magnitudes, counts);
+			for (uint32_t i = 0; i < chunkSize; ++i)
+			{
+				Real escapeTime = static_cast<Real>(iterations[i]);
+				if constexpr (Smooth)
+					if (iterations[i] < parameters.MaxIterations)
+						escapeTime = escapeTime + Real(1) - log2(log2(magnitudes[i]) * Real(0.5)) / log2(static_cast<Real>(Power));
+
+				escapeTimes[first + i] = static_cast<float>(escapeTime);
+			}
+		}
+
+		return executedIterations;
+	}
+
+	/* Dimensions of the family's dispatch table, the level varies fastest */
+	constexpr uint32_t PrecisionCount = APP_ESCAPE_TIME_DOUBLE ? 2 : 1;
+	constexpr uint32_t PowerCount = APP_ESCAPE_TIME_MAX_POWER - 1;
+	constexpr uint32_t ColoringCount = 2;
+	constexpr uint32_t CheckVariantCount = APP_ESCAPE_TIME_CHECK_VARIANTS ? 8 : 2;
+	constexpr uint32_t VariantCount = PrecisionCount * PowerCount * ColoringCount * CheckVariantCount * LevelCount;
+
+	static_assert(APP_ESCAPE_TIME_MAX_POWER >= 2, "The kernel family needs at least power 2");
+
+	/* Keys that select the same kernel get the same flags, which also keeps them from being instantiated twice */
+	constexpr uint32_t NormalizeCheckFlags(const uint32_t power, const uint32_t flags)
+	{
+		return power == 2 ? flags & 7u : flags & 4u;
+	}
+
+	constexpr uint32_t GetCheckFlags(const uint32_t checkVariant)
+	{
+		return CheckVariantCount == 8 ? checkVariant : checkVariant * 7u;
+	}
+
+	constexpr EscapeTimeKernelKey DecodeKey(const uint32_t index)
+	{
+		EscapeTimeKernelKey key;
+		key.Level = static_cast<ESimdLevel>(index % LevelCount);
+		key.Smooth = (index / (LevelCount * CheckVariantCount)) % ColoringCount != 0;
+		key.Power = 2 + (index / (LevelCount * CheckVariantCount * ColoringCount)) % PowerCount;
+		key.DoublePrecision = index / (LevelCount * CheckVariantCount * ColoringCount * PowerCount) != 0;
+		key.InteriorCheckFlags = NormalizeCheckFlags(key.Power, GetCheckFlags((index / LevelCount) % CheckVariantCount));
+		return key;
+	}
+
+	template<uint32_t Index>
+	constexpr EscapeTimeKernel GetKernel()
+	{
+		constexpr EscapeTimeKernelKey key = DecodeKey(Index);
+		using Real = std::conditional_t<key.DoublePrecision, double, float>;
+		return &IterateRowVariant<Real, key.Power, key.Smooth, key.InteriorCheckFlags, key.Level>;
+	}
+
+	template<std::size_t... Indices>
+	constexpr std::array<EscapeTimeKernel, sizeof...(Indices)> MakeDispatchTable(std::index_sequence<Indices...>)
+	{
+		return { GetKernel<static_cast<uint32_t>(Indices)>()... };
+	}
+
+	/* Generated at compile time, one entry per combination of the template parameters */
+	constexpr std::array<EscapeTimeKernel, VariantCount> DispatchTable = MakeDispatchTable(std::make_index_sequence<VariantCount>());
+
+	/* VariantCount if the key is not compiled in */
+	INTERNALSCOPE uint32_t GetVariantIndex(const EscapeTimeKernelKey& key)
+	{
+		const uint32_t level = static_cast<uint32_t>(key.Level);
+		if ((key.DoublePrecision && PrecisionCount == 1) || key.Power < 2 || key.Power > APP_ESCAPE_TIME_MAX_POWER || level >= LevelCount)
+			return VariantCount;
+
+		const uint32_t flags = NormalizeCheckFlags(key.Power, key.InteriorCheckFlags);
+		uint32_t checkVariant = CheckVariantCount;
+		for (uint32_t variant = 0; variant < CheckVariantCount; ++variant)
+			if (NormalizeCheckFlags(key.Power, GetCheckFlags(variant)) == flags)
+			{
+				checkVariant = variant;
+				break;
+			}
+
+		if (checkVariant == CheckVariantCount)
+			return VariantCount;
+
+		const uint32_t precision = key.DoublePrecision ? 1 : 0;
+		const uint32_t coloring = key.Smooth ? 1 : 0;
+		return (((precision * PowerCount + (key.Power - 2)) * ColoringCount + coloring) * CheckVariantCount + checkVariant) * LevelCount + level;
+	}
+}
+
+float CpuKernels::PixelToReal(const KernelViewport& viewport, const uint32_t x)
+{
+	return Utilities::PixelToReal(viewport, x);
+}
+
+float CpuKernels::PixelToImaginary(const KernelViewport& viewport, const uint32_t y)
+{
+	return Utilities::PixelToImaginary(viewport, y);
+}
+
+uint64_t CpuKernels::IteratePoints(
+	const float* reals, const float* imaginaries, const uint32_t count,
+	const uint32_t maxIterations, const float escapeRadiusSquared, const InteriorChecks& checks,
+	uint32_t* iterations, float* magnitudes, InteriorCheckCounts& counts, const ESimdLevel level)
+{
+	const uint32_t levelIndex = static_cast<uint32_t>(level) < Utilities::LevelCount ? static_cast<uint32_t>(level) : 0;
+	const Utilities::PointKernel<float> kernel = Utilities::RendererDispatchTable[checks.GetFlags() * Utilities::LevelCount + levelIndex];
+	return kernel(reals, imaginaries, count, maxIterations, escapeRadiusSquared, checks.PeriodicityTolerance, iterations, magnitudes, counts);
+}
+
+uint64_t CpuKernels::IterateRow(
+	const KernelViewport& viewport, const uint32_t x, const uint32_t y, const uint32_t count,
+	const uint32_t maxIterations, const float escapeRadiusSquared, const InteriorChecks& checks,
+	uint32_t* iterations, float* magnitudes, InteriorCheckCounts& counts, const ESimdLevel level)
+{
+	float reals[Utilities::RowChunkSize];
+	float imaginaries[Utilities::RowChunkSize];
+	std::fill(std::begin(imaginaries), std::end(imaginaries), Utilities::PixelToImaginary(viewport, y));
+
+	uint64_t executedIterations = 0;
+	for (uint32_t first = 0; first < count; first += Utilities::RowChunkSize)
+	{
+		const uint32_t chunkSize = std::min(Utilities::RowChunkSize, count - first);
+		for (uint32_t i = 0; i < chunkSize; ++i)
+			reals[i] = Utilities::PixelToReal(viewport, x + first + i);
+
+		executedIterations += IteratePoints(reals, imaginaries, chunkSize, maxIterations, escapeRadiusSquared, checks, iterations + first, magnitudes + first, counts, level);
+	}
+
+	return executedIterations;
+}
+
+uint64_t CpuKernels::IterateRowReference(
+	const KernelViewport& viewport, const uint32_t x, const uint32_t y, const uint32_t count,
+	const uint32_t maxIterations, const float escapeRadiusSquared, const InteriorChecks& checks,
+	uint32_t* iterations, float* magnitudes, InteriorCheckCounts& counts)
+{
+	const float imaginary = Utilities::PixelToImaginary(viewport, y);
+	uint64_t executedIterations = 0;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const float real = Utilities::PixelToReal(viewport, x + i);
+		executedIterations += IteratePoints(&real, &imaginary, 1, maxIterations, escapeRadiusSquared, checks, iterations + i, magnitudes + i, counts, ESimdLevel::Scalar);
+	}
+
+	return executedIterations;
+}
+
+uint32_t CpuKernels::GetLaneCount(const ESimdLevel level)
+{
+	switch (level)
+	{
+		case ESimdLevel::SSE2: return 4;
+		case ESimdLevel::AVX2: return 8;
+		case ESimdLevel::AVX512: return 16;
+		default: return 1;
+	}
+}
+
+EscapeTimeKernel CpuKernels::Find(const EscapeTimeKernelKey& key)
+{
+	const uint32_t index = Utilities::GetVariantIndex(key);
+	if (index == Utilities::VariantCount || key.Level > Simd::GetSupportedLevel())
+		return nullptr;
+
+	return Utilities::DispatchTable[index];
+}
+
+std::vector<EscapeTimeKernelKey> CpuKernels::GetVariants()
+{
+	std::vector<EscapeTimeKernelKey> variants;
+	for (uint32_t index = 0; index < Utilities::VariantCount; ++index)
+	{
+		/* Normalized power 3+ flags repeat, the first index of a kernel is the one GetVariantIndex() returns */
+		const EscapeTimeKernelKey key = Utilities::DecodeKey(index);
+		if (Utilities::GetVariantIndex(key) == index)
+			variants.push_back(key);
+	}
+
+	return variants;
+}
+
+std::string CpuKernels::GetVariantName(const EscapeTimeKernelKey& key)
+{
+	const uint32_t flags = Utilities::NormalizeCheckFlags(key.Power, key.InteriorCheckFlags);
+	const char checks[4] = { (flags & 1u) ? 'c' : '-', (flags & 2u) ? 'b' : '-', (flags & 4u) ? 'p' : '-', '\0' };
+
+	char name[64];
+	snprintf(name, sizeof(name), "%s p%u %s %s %s",
+		key.DoublePrecision ? "f64" : "f32", key.Power, key.Smooth ? "smooth" : "iter", checks, Simd::GetLevelName(key.Level));
+	return name;
+}
+
+uint32_t CpuKernels::GetLaneCount(const EscapeTimeKernelKey& key)
+{
+	const uint32_t floatLaneCount = key.Level == ESimdLevel::AVX512 ? 16 : key.Level == ESimdLevel::AVX2 ? 8 : key.Level == ESimdLevel::SSE2 ? 4 : 1;
+	return key.DoublePrecision && floatLaneCount > 1 ? floatLaneCount / 2 : floatLaneCount;
+}
@@ -0,0 +1,566 @@
+#include "include/CpuRenderer.h"
+#include "include/CpuKernels.h"
+#include "include/Coloring.h"
+#include "include/OfflineRenderer.h"
+#include "include/Perturbation.h"
+#include "include/Platform.h"
+#include "include/ThreadPool.h"
+#include "glm/gtc/packing.hpp"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+namespace Utilities {
+	/* Must match the Iterate() calls in computeShader.comp */
+	constexpr float EscapeRadiusSquared = 2.0f;
+	constexpr float SmoothEscapeRadiusSquared = 65536.0f;
+
+	/* Tile edges are multiples of the widest kernel so rows split into full registers */
+	constexpr uint32_t TileEdgeGranularity = 16;
+	constexpr uint32_t MinTileEdge = 16;
+	constexpr uint32_t MaxTileEdge = 512;
+	constexpr uint32_t InitialTileEdge = 64;
+	/* Long enough that taking or stealing a tile costs nothing in comparison, short enough to balance */
+	constexpr double TargetTileSeconds = 0.5e-3;
+	/* A region always splits into at least this many tiles per thread, work stealing needs some slack */
+	constexpr uint32_t MinTilesPerThread = 8;
+
+	/* Glitch correction: each new reference costs a full BigFixed orbit, they are shared by the tiles of a render */
+	constexpr uint32_t MaxNewReferencesPerTile = 8;
+	constexpr std::size_t MaxReferences = 64;
+	/* Glitched pixels iterated per thread pool index */
+	constexpr uint32_t GlitchBatchSize = 64;
+
+	/* Converts count pixels of escape data into the output format at pixel firstPixel of tile */
+	INTERNALSCOPE void StoreRow(
+		const EOutputFormat format, const CosinePaletteCoefficients& coefficients, const uint32_t maxIterations,
+		const uint32_t* iterations, const float* magnitudes, const uint32_t count, void* tile, const std::size_t firstPixel)
+	{
+		const float limit = static_cast<float>(maxIterations);
+		switch (format)
+		{
+			case EOutputFormat::RGBA8:
+			{
+				uint8_t* rgba = static_cast<uint8_t*>(tile) + firstPixel * 4;
+				for (uint32_t x = 0; x < count; ++x)
+					Coloring::Palette(coefficients, static_cast<float>(iterations[x]) / limit, rgba + x * 4);
+
+				break;
+			}
+			case EOutputFormat::Iterations:
+				memcpy(static_cast<uint32_t*>(tile) + firstPixel, iterations, count * sizeof(uint32_t));
+				break;
+			case EOutputFormat::SmoothIterations:
+			{
+				uint16_t* smoothIterations = static_cast<uint16_t*>(tile) + firstPixel;
+				for (uint32_t x = 0; x < count; ++x)
+				{
+					const float value = iterations[x] == maxIterations ? limit : static_cast<float>(iterations[x]) + 1.0f - log2f(log2f(magnitudes[x]) * 0.5f);
+					smoothIterations[x] = glm::packHalf1x16(value);
+				}
+
+				break;
+			}
+			case EOutputFormat::LinearFloat:
+			{
+				float* rgba = static_cast<float*>(tile) + firstPixel * 4;
+				for (uint32_t x = 0; x < count; ++x)
+					Coloring::PaletteLinear(coefficients, static_cast<float>(iterations[x]) / limit, rgba + x * 4);
+
+				break;
+			}
+		}
+	}
+
+	/* The glitched pixel closest to the centroid of all of them, so the new reference lands inside the glitch */
+	INTERNALSCOPE uint32_t GetCentralPixel(const std::vector<uint32_t>& pixels, const uint32_t tileWidth)
+	{
+		double sumX = 0.0;
+		double sumY = 0.0;
+		for (const uint32_t pixel : pixels)
+		{
+			sumX += static_cast<double>(pixel % tileWidth);
+			sumY += static_cast<double>(pixel / tileWidth);
+		}
+
+		const double centroidX = sumX / static_cast<double>(pixels.size());
+		const double centroidY = sumY / static_cast<double>(pixels.size());
+		uint32_t central = pixels.front();
+		double closestDistance = DBL_MAX;
+		for (const uint32_t pixel : pixels)
+		{
+			const double dx = static_cast<double>(pixel % tileWidth) - centroidX;
+			const double dy = static_cast<double>(pixel / tileWidth) - centroidY;
+			if (dx * dx + dy * dy < closestDistance)
+			{
+				closestDistance = dx * dx + dy * dy;
+				central = pixel;
+			}
+		}
+
+		return central;
+	}
+
+	/*
+	* Escape data of one tile rendered by Mariani-Silver subdivision. Rectangles are given by their
+	* inclusive corners in tile coordinates and own their border, which the caller has computed.
+	* Pixels to iterate are queued and go through the SIMD kernels together, columns included.
+	*/
+	class SubdivisionTile
+	{
+	public:
+		SubdivisionTile(
+			const KernelViewport& viewport, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height,
+			const uint32_t maxIterations, const float escapeRadiusSquared, const InteriorChecks& checks, const ESimdLevel simdLevel,
+			const SubdivisionSettings& settings, const bool fillsOutside)
+			:
+			m_Width(width),
+			m_Height(height),
+			m_MaxIterations(maxIterations),
+			m_EscapeRadiusSquared(escapeRadiusSquared),
+			m_Checks(checks),
+			m_SimdLevel(simdLevel),
+			m_Settings(settings),
+			m_FillsOutside(fillsOutside),
+			m_Reals(width),
+			m_Imaginaries(height),
+			m_Iterations(static_cast<std::size_t>(width) * height),
+			m_Magnitudes(m_Iterations.size()),
+			m_Computed(m_Iterations.size(), 0),
+			m_IterationCount(0),
+			m_FilledPixelCount(0),
+			m_CheckCounts()
+		{
+			for (uint32_t column = 0; column < width; ++column)
+				m_Reals[column] = CpuKernels::PixelToReal(viewport, x + column);
+
+			for (uint32_t row = 0; row < height; ++row)
+				m_Imaginaries[row] = CpuKernels::PixelToImaginary(viewport, y + row);
+		}
+
+		void Render()
+		{
+			QueueRing(0, 0, m_Width - 1, m_Height - 1);
+			ComputeQueued();
+			Subdivide(0, 0, m_Width - 1, m_Height - 1, 0);
+		}
+
+		const uint32_t* GetIterations(const uint32_t row) const { return m_Iterations.data() + static_cast<std::size_t>(row) * m_Width; }
+		const float* GetMagnitudes(const uint32_t row) const { return m_Magnitudes.data() + static_cast<std::size_t>(row) * m_Width; }
+		uint64_t GetIterationCount() const { return m_IterationCount; }
+		uint64_t GetFilledPixelCount() const { return m_FilledPixelCount; }
+		const InteriorCheckCounts& GetCheckCounts() const { return m_CheckCounts; }
+	private:
+		void Subdivide(const uint32_t x0, const uint32_t y0, const uint32_t x1, const uint32_t y1, const uint32_t depth)
+		{
+			if (x1 - x0 < 2 || y1 - y0 < 2)
+				return;
+
+			if (CanFill(x0, y0, x1, y1))
+			{
+				const uint32_t value = m_Iterations[GetPixel(x0, y0)];
+				for (uint32_t y = y0 + 1; y < y1; ++y)
+					for (std::size_t pixel = GetPixel(x0 + 1, y); pixel < GetPixel(x1, y); ++pixel)
+						if (!m_Computed[pixel])
+						{
+							m_Iterations[pixel] = value;
+							m_Computed[pixel] = 1;
+							++m_FilledPixelCount;
+						}
+
+				return;
+			}
+
+			const uint32_t innerWidth = x1 - x0 - 1;
+			const uint32_t innerHeight = y1 - y0 - 1;
+			if (depth >= m_Settings.MaxDepth || std::max(innerWidth, innerHeight) <= m_Settings.MinEdge)
+			{
+				for (uint32_t y = y0 + 1; y < y1; ++y)
+					for (uint32_t x = x0 + 1; x < x1; ++x)
+						Queue(x, y);
+
+				ComputeQueued();
+				return;
+			}
+
+			/* Split the longer side, the dividing line becomes the border of both halves */
+			if (innerWidth >= innerHeight)
+			{
+				const uint32_t middle = x0 + (x1 - x0) / 2;
+				for (uint32_t y = y0 + 1; y < y1; ++y)
+					Queue(middle, y);
+
+				ComputeQueued();
+				Subdivide(x0, y0, middle, y1, depth + 1);
+				Subdivide(middle, y0, x1, y1, depth + 1);
+			}
+			else
+			{
+				const uint32_t middle = y0 + (y1 - y0) / 2;
+				for (uint32_t x = x0 + 1; x < x1; ++x)
+					Queue(x, middle);
+
+				ComputeQueued();
+				Subdivide(x0, y0, x1, middle, depth + 1);
+				Subdivide(x0, middle, x1, y1, depth + 1);
+			}
+		}
+
+		/* The border and every margin ring inside it hold the same iteration */
+		bool CanFill(const uint32_t x0, const uint32_t y0, const uint32_t x1, const uint32_t y1)
+		{
+			const uint32_t value = m_Iterations[GetPixel(x0, y0)];
+			if (!m_FillsOutside && value != m_MaxIterations)
+				return false;
+
+			if (!IsRingUniform(x0, y0, x1, y1, value))
+				return false;
+
+			for (uint32_t ring = 1; ring <= m_Settings.Margin; ++ring)
+			{
+				/* Margin rings have to leave something to fill */
+				if (x1 - x0 < 2 * ring + 2 || y1 - y0 < 2 * ring + 2)
+					return false;
+
+				QueueRing(x0 + ring, y0 + ring, x1 - ring, y1 - ring);
+				ComputeQueued();
+				if (!IsRingUniform(x0 + ring, y0 + ring, x1 - ring, y1 - ring, value))
+					return false;
+			}
+
+			return true;
+		}
+
+		bool IsRingUniform(const uint32_t x0, const uint32_t y0, const uint32_t x1, const uint32_t y1, const uint32_t value) const
+		{
+			for (uint32_t x = x0; x <= x1; ++x)
+				if (m_Iterations[GetPixel(x, y0)] != value || m_Iterations[GetPixel(x, y1)] != value)
+					return false;
+
+			for (uint32_t y = y0 + 1; y < y1; ++y)
+				if (m_Iterations[GetPixel(x0, y)] != value || m_Iterations[GetPixel(x1, y)] != value)
+					return false;
+
+			return true;
+		}
+
+		void QueueRing(const uint32_t x0, const uint32_t y0, const uint32_t x1, const uint32_t y1)
+		{
+			for (uint32_t x = x0; x <= x1; ++x)
+			{
+				Queue(x, y0);
+				Queue(x, y1);
+			}
+
+			for (uint32_t y = y0 + 1; y < y1; ++y)
+			{
+				Queue(x0, y);
+				Queue(x1, y);
+			}
+		}
+
+		/* Pixels already computed (or queued) are skipped, rings of one row or column name them twice */
+		void Queue(const uint32_t x, const uint32_t y)
+		{
+			const std::size_t pixel = GetPixel(x, y);
+			if (m_Computed[pixel])
+				return;
+
+			m_Computed[pixel] = 1;
+			m_QueuedPixels.push_back(pixel);
+			m_QueuedReals.push_back(m_Reals[x]);
+			m_QueuedImaginaries.push_back(m_Imaginaries[y]);
+		}
+
+		void ComputeQueued()
+		{
+			const uint32_t count = static_cast<uint32_t>(m_QueuedPixels.size());
+			m_QueuedIterations.resize(count);
+			m_QueuedMagnitudes.resize(count);
+			m_IterationCount += CpuKernels::IteratePoints(
+				m_QueuedReals.data(), m_QueuedImaginaries.data(), count, m_MaxIterations, m_EscapeRadiusSquared, m_Checks,
+				m_QueuedIterations.data(), m_QueuedMagnitudes.data(), m_CheckCounts, m_SimdLevel);
+
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				m_Iterations[m_QueuedPixels[i]] = m_QueuedIterations[i];
+				m_Magnitudes[m_QueuedPixels[i]] = m_QueuedMagnitudes[i];
+			}
+
+			m_QueuedPixels.clear();
+			m_QueuedReals.clear();
+			m_QueuedImaginaries.clear();
+		}
+
+		std::size_t GetPixel(const uint32_t x, const uint32_t y) const { return static_cast<std::size_t>(y) * m_Width + x; }
+	private:
+		uint32_t m_Width;
+		uint32_t m_Height;
+		uint32_t m_MaxIterations;
+		float m_EscapeRadiusSquared;
+		const InteriorChecks& m_Checks;
+		ESimdLevel m_SimdLevel;
+		const SubdivisionSettings& m_Settings;
+		bool m_FillsOutside;
+
+		/* Point of every tile column and row */
+		std::vector<float> m_Reals;
+		std::vector<float> m_Imaginaries;
+		std::vector<uint32_t> m_Iterations;
+		std::vector<float> m_Magnitudes;
+		std::vector<uint8_t> m_Computed;
+
+		std::vector<std::size_t> m_QueuedPixels;
+		std::vector<float> m_QueuedReals;
+		std::vector<float> m_QueuedImaginaries;
+		std::vector<uint32_t> m_QueuedIterations;
+		std::vector<float> m_QueuedMagnitudes;
+
+		uint64_t m_IterationCount;
+		uint64_t m_FilledPixelCount;
+		InteriorCheckCounts m_CheckCounts;
+	};
+}
+
+CpuRenderer::CpuRenderer(ThreadPool& threadPool)
+	:
+	m_ThreadPool(threadPool),
+	m_SimdLevel(Simd::GetSupportedLevel()),
+	m_IterationCount(0),
+	m_SkippedPixelCount(0),
+	m_CardioidCount(0),
+	m_BulbCount(0),
+	m_PeriodicityCount(0),
+	m_TileEdge(Utilities::InitialTileEdge)
+{}
+
+void CpuRenderer::SetSimdLevel(const ESimdLevel level)
+{
+	m_SimdLevel = std::min(level, Simd::GetSupportedLevel());
+}
+
+void CpuRenderer::RenderTile(const OfflineRenderSettings& settings, const TileRegion& region, void* tile, const uint32_t tileWidth)
+{
+	/* The shader gets the viewport as float push constants */
+	KernelViewport viewport;
+	viewport.CenterX = static_cast<float>(settings.CenterX);
+	viewport.CenterY = static_cast<float>(settings.CenterY);
+	viewport.Scale = static_cast<float>(settings.Scale);
+	viewport.Width = settings.Width;
+	viewport.Height = settings.Height;
+
+	const EOutputFormat format = settings.OutputFormat;
+	const uint32_t maxIterations = settings.MaxIterations;
+	const float escapeRadiusSquared = format == EOutputFormat::SmoothIterations ? Utilities::SmoothEscapeRadiusSquared : Utilities::EscapeRadiusSquared;
+	const CosinePaletteCoefficients& coefficients = Coloring::GetCoefficients(EPalette::Twilight);
+
+	/* Subdivision skips more the larger the tile, and its cost does not scale with the pixel count the edge adapts to */
+	const uint64_t regionPixelCount = static_cast<uint64_t>(region.Width) * region.Height;
+	const uint32_t tileEdge = settings.Subdivision.Enabled ? RoundTileEdge(GetBalancedTilePixelCount(regionPixelCount)) : m_TileEdge;
+	const uint32_t tileCountX = (region.Width + tileEdge - 1) / tileEdge;
+	const uint32_t tileCountY = (region.Height + tileEdge - 1) / tileEdge;
+	std::vector<double> tileSeconds(static_cast<std::size_t>(tileCountX) * tileCountY);
+	std::vector<uint32_t> tilePixelCounts(tileSeconds.size());
+
+	/* Smooth iterations need the escape magnitude of every pixel outside the set, only the inside can be filled */
+	const bool fillsOutside = format != EOutputFormat::SmoothIterations;
+
+	m_ThreadPool.ParallelFor(static_cast<uint32_t>(tileSeconds.size()), [&](const uint32_t tileIndex) {
+		const double startTime = Platform::GetAbsoluteTime();
+		const uint32_t firstColumn = (tileIndex % tileCountX) * tileEdge;
+		const uint32_t firstRow = (tileIndex / tileCountX) * tileEdge;
+		const uint32_t columnCount = std::min(tileEdge, region.Width - firstColumn);
+		const uint32_t endRow = std::min(firstRow + tileEdge, region.Height);
+
+		if (settings.Subdivision.Enabled)
+		{
+			Utilities::SubdivisionTile subdivisionTile(
+				viewport, region.X + firstColumn, region.Y + firstRow, columnCount, endRow - firstRow,
+				maxIterations, escapeRadiusSquared, settings.Interior, m_SimdLevel, settings.Subdivision, fillsOutside);
+			subdivisionTile.Render();
+
+			for (uint32_t row = firstRow; row < endRow; ++row)
+				Utilities::StoreRow(
+					format, coefficients, maxIterations, subdivisionTile.GetIterations(row - firstRow), subdivisionTile.GetMagnitudes(row - firstRow),
+					columnCount, tile, static_cast<std::size_t>(row) * tileWidth + firstColumn);
+
+			m_IterationCount += subdivisionTile.GetIterationCount();
+			m_SkippedPixelCount += subdivisionTile.GetFilledPixelCount();
+			AddCheckCounts(subdivisionTile.GetCheckCounts());
+		}
+		else
+		{
+			std::vector<uint32_t> iterations(columnCount);
+			std::vector<float> magnitudes(columnCount);
+			uint64_t iterationCount = 0;
+			InteriorCheckCounts checkCounts;
+			for (uint32_t row = firstRow; row < endRow; ++row)
+			{
+				iterationCount += CpuKernels::IterateRow(
+					viewport, region.X + firstColumn, region.Y + row, columnCount, maxIterations, escapeRadiusSquared, settings.Interior,
+					iterations.data(), magnitudes.data(), checkCounts, m_SimdLevel);
+
+				Utilities::StoreRow(
+					format, coefficients, maxIterations, iterations.data(), magnitudes.data(),
+					columnCount, tile, static_cast<std::size_t>(row) * tileWidth + firstColumn);
+			}
+
+			m_IterationCount += iterationCount;
+			AddCheckCounts(checkCounts);
+		}
+
+		tileSeconds[tileIndex] = Platform::GetAbsoluteTime() - startTime;
+		tilePixelCounts[tileIndex] = columnCount * (endRow - firstRow);
+	});
+
+	if (!settings.Subdivision.Enabled)
+		AdaptTileEdge(tileSeconds, tilePixelCounts, regionPixelCount);
+}
+
+void CpuRenderer::RenderPerturbationTile(
+	const OfflineRenderSettings& settings, const PerturbationView& view, const ReferenceOrbit& reference, const SeriesApproximation* series,
+	const TileRegion& region, void* tile, const uint32_t tileWidth, std::vector<uint32_t>& glitchedPixels)
+{
+	const EOutputFormat format = settings.OutputFormat;
+	const uint32_t maxIterations = view.MaxIterations;
+	const double escapeRadiusSquared = format == EOutputFormat::SmoothIterations ? Utilities::SmoothEscapeRadiusSquared : Utilities::EscapeRadiusSquared;
+	const CosinePaletteCoefficients& coefficients = Coloring::GetCoefficients(EPalette::Twilight);
+
+	/* One row per index, the pool balances them by stealing */
+	std::vector<std::vector<uint32_t>> rowGlitchedPixels(region.Height);
+	m_ThreadPool.ParallelFor(region.Height, [&](const uint32_t row) {
+		std::vector<uint32_t> iterations(region.Width);
+		std::vector<float> magnitudes(region.Width);
+		uint64_t iterationCount = 0;
+		for (uint32_t column = 0; column < region.Width; ++column)
+		{
+			double offsetX;
+			double offsetY;
+			Perturbation::GetPixelOffset(view, region.X + column, region.Y + row, offsetX, offsetY);
+			if (!Perturbation::IteratePixel(
+				reference, series, offsetX - reference.OffsetX, offsetY - reference.OffsetY, maxIterations, escapeRadiusSquared,
+				iterations[column], magnitudes[column], iterationCount))
+				rowGlitchedPixels[row].push_back(row * tileWidth + column);
+		}
+
+		Utilities::StoreRow(
+			format, coefficients, maxIterations, iterations.data(), magnitudes.data(),
+			region.Width, tile, static_cast<std::size_t>(row) * tileWidth);
+		m_IterationCount += iterationCount;
+	});
+
+	for (const std::vector<uint32_t>& pixels : rowGlitchedPixels)
+		glitchedPixels.insert(glitchedPixels.end(), pixels.begin(), pixels.end());
+}
+
+void CpuRenderer::CorrectGlitches(
+	const OfflineRenderSettings& settings, const PerturbationView& view, const TileRegion& region, void* tile, const uint32_t tileWidth,
+	std::vector<uint32_t>& glitchedPixels, std::vector<ReferenceOrbit>& references)
+{
+	const EOutputFormat format = settings.OutputFormat;
+	const uint32_t maxIterations = view.MaxIterations;
+	const double escapeRadiusSquared = format == EOutputFormat::SmoothIterations ? Utilities::SmoothEscapeRadiusSquared : Utilities::EscapeRadiusSquared;
+	const CosinePaletteCoefficients& coefficients = Coloring::GetCoefficients(EPalette::Twilight);
+
+	uint32_t newReferenceCount = 0;
+	std::vector<uint8_t> glitched;
+	for (std::size_t referenceIndex = 0; !glitchedPixels.empty(); ++referenceIndex)
+	{
+		/* Every existing reference failed the remaining pixels, the next one starts inside their glitch */
+		if (referenceIndex == references.size())
+		{
+			if (newReferenceCount == Utilities::MaxNewReferencesPerTile || references.size() >= Utilities::MaxReferences)
+				break;
+
+			const uint32_t pixel = Utilities::GetCentralPixel(glitchedPixels, tileWidth);
+			double offsetX;
+			double offsetY;
+			Perturbation::GetPixelOffset(view, region.X + pixel % tileWidth, region.Y + pixel / tileWidth, offsetX, offsetY);
+			references.push_back(Perturbation::ComputeReferenceOrbit(view, offsetX, offsetY));
+			++newReferenceCount;
+		}
+
+		const ReferenceOrbit& reference = references[referenceIndex];
+		const uint32_t pixelCount = static_cast<uint32_t>(glitchedPixels.size());
+		glitched.assign(pixelCount, 0);
+		m_ThreadPool.ParallelFor((pixelCount + Utilities::GlitchBatchSize - 1) / Utilities::GlitchBatchSize, [&](const uint32_t batch) {
+			uint64_t iterationCount = 0;
+			const uint32_t end = std::min(pixelCount, (batch + 1) * Utilities::GlitchBatchSize);
+			for (uint32_t i = batch * Utilities::GlitchBatchSize; i < end; ++i)
+			{
+				const uint32_t pixel = glitchedPixels[i];
+				double offsetX;
+				double offsetY;
+				Perturbation::GetPixelOffset(view, region.X + pixel % tileWidth, region.Y + pixel / tileWidth, offsetX, offsetY);
+
+				/* The series belongs to the main reference, the others iterate from the start */
+				uint32_t iterations;
+				float magnitude;
+				glitched[i] = Perturbation::IteratePixel(
+					reference, nullptr, offsetX - reference.OffsetX, offsetY - reference.OffsetY, maxIterations, escapeRadiusSquared,
+					iterations, magnitude, iterationCount) ? 0 : 1;
+				Utilities::StoreRow(format, coefficients, maxIterations, &iterations, &magnitude, 1, tile, pixel);
+			}
+
+			m_IterationCount += iterationCount;
+		});
+
+		std::size_t remaining = 0;
+		for (uint32_t i = 0; i < pixelCount; ++i)
+			if (glitched[i])
+				glitchedPixels[remaining++] = glitchedPixels[i];
+
+		glitchedPixels.resize(remaining);
+	}
+}
+
+void CpuRenderer::AdaptTileEdge(const std::vector<double>& tileSeconds, const std::vector<uint32_t>& tilePixelCounts, const uint64_t regionPixelCount)
+{
+	/* Sized by the densest tile, a cheap average would hide the tiles that finish last */
+	double maxSecondsPerPixel = 0.0;
+	for (std::size_t i = 0; i < tileSeconds.size(); ++i)
+		if (tilePixelCounts[i] != 0)
+			maxSecondsPerPixel = std::max(maxSecondsPerPixel, tileSeconds[i] / tilePixelCounts[i]);
+
+	if (!(maxSecondsPerPixel > 0.0))
+		return;
+
+	const double pixelsForCost = Utilities::TargetTileSeconds / maxSecondsPerPixel;
+	m_TileEdge = RoundTileEdge(std::min(pixelsForCost, GetBalancedTilePixelCount(regionPixelCount)));
+}
+
+InteriorCheckCounts CpuRenderer::GetCheckCounts() const
+{
+	InteriorCheckCounts counts;
+	counts.Cardioid = m_CardioidCount.load();
+	counts.Bulb = m_BulbCount.load();
+	counts.Periodicity = m_PeriodicityCount.load();
+	return counts;
+}
+
+void CpuRenderer::ResetCounters()
+{
+	m_IterationCount = 0;
+	m_SkippedPixelCount = 0;
+	m_CardioidCount = 0;
+	m_BulbCount = 0;
+	m_PeriodicityCount = 0;
+}
+
+void CpuRenderer::AddCheckCounts(const InteriorCheckCounts& counts)
+{
+	m_CardioidCount += counts.Cardioid;
+	m_BulbCount += counts.Bulb;
+	m_PeriodicityCount += counts.Periodicity;
+}
+
+double CpuRenderer::GetBalancedTilePixelCount(const uint64_t regionPixelCount) const
+{
+	return static_cast<double>(regionPixelCount) / (static_cast<double>(m_ThreadPool.GetThreadCount()) * Utilities::MinTilesPerThread);
+}
+
+uint32_t CpuRenderer::RoundTileEdge(const double tilePixelCount)
+{
+	const double edge = std::min(sqrt(tilePixelCount), static_cast<double>(Utilities::MaxTileEdge));
+	return std::max(Utilities::MinTileEdge, static_cast<uint32_t>(edge) / Utilities::TileEdgeGranularity * Utilities::TileEdgeGranularity);
+}
@@ -0,0 +1,86 @@
+#include "include/EscapeTimeFile.h"
+
+bool EscapeTimeWriter::Open(const std::string& filepath, const uint32_t width, const uint32_t height, const uint32_t maxIterations)
+{
+	/* A failed render may have left the previous file open */
+	if (m_File.is_open())
+		m_File.close();
+
+	m_File.open(filepath, std::ios::binary | std::ios::trunc);
+	if (!m_File.is_open())
+	{
+		printf("Failed to open escape time file: %s\n", filepath.c_str());
+		return false;
+	}
+
+	m_Width = width;
+
+	EscapeTime::FileHeader header;
+	memcpy(header.Magic, EscapeTime::FileMagic, sizeof(header.Magic));
+	header.Width = width;
+	header.Height = height;
+	header.MaxIterations = maxIterations;
+	header.Reserved = 0;
+	m_File.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	return m_File.good();
+}
+
+bool EscapeTimeWriter::WriteTile(const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, const uint16_t* values, const std::size_t rowPitch)
+{
+	for (uint32_t row = 0; row < height; ++row)
+	{
+		const uint64_t offset = sizeof(EscapeTime::FileHeader) + ((static_cast<uint64_t>(y) + row) * m_Width + x) * sizeof(uint16_t);
+		m_File.seekp(static_cast<std::streamoff>(offset));
+		m_File.write(reinterpret_cast<const char*>(values) + row * rowPitch, static_cast<std::streamsize>(width) * sizeof(uint16_t));
+	}
+
+	if (!m_File.good())
+	{
+		printf("Failed to write escape time tile at %u, %u\n", x, y);
+		return false;
+	}
+
+	return true;
+}
+
+bool EscapeTimeWriter::Close()
+{
+	m_File.close();
+	return !m_File.fail();
+}
+
+bool EscapeTimeReader::Open(const std::string& filepath)
+{
+	m_File.open(filepath, std::ios::binary | std::ios::ate);
+	if (!m_File.is_open())
+	{
+		printf("Failed to open escape time file: %s\n", filepath.c_str());
+		return false;
+	}
+
+	const uint64_t fileSize = static_cast<uint64_t>(m_File.tellg());
+	m_File.seekg(0);
+	m_File.read(reinterpret_cast<char*>(&m_Header), sizeof(m_Header));
+	if (!m_File.good() || memcmp(m_Header.Magic, EscapeTime::FileMagic, sizeof(m_Header.Magic)) != 0)
+	{
+		printf("Not an escape time file: %s\n", filepath.c_str());
+		return false;
+	}
+
+	const uint64_t expectedSize = sizeof(m_Header) + static_cast<uint64_t>(m_Header.Width) * m_Header.Height * sizeof(uint16_t);
+	if (m_Header.Width == 0 || m_Header.Height == 0 || m_Header.MaxIterations == 0 || fileSize < expectedSize)
+	{
+		printf("Truncated or invalid escape time file: %s (%ux%u)\n", filepath.c_str(), m_Header.Width, m_Header.Height);
+		return false;
+	}
+
+	return true;
+}
+
+bool EscapeTimeReader::ReadRows(const uint32_t y, const uint32_t rowCount, uint16_t* values)
+{
+	const uint64_t offset = sizeof(m_Header) + static_cast<uint64_t>(y) * m_Header.Width * sizeof(uint16_t);
+	m_File.seekg(static_cast<std::streamoff>(offset));
+	m_File.read(reinterpret_cast<char*>(values), static_cast<std::streamsize>(static_cast<uint64_t>(rowCount) * m_Header.Width * sizeof(uint16_t)));
+	return m_File.good();
+}
@@ -0,0 +1,189 @@
+#include "include/ImageWriter.h"
+#include <algorithm>
+#include <ctype.h>
+
+namespace Utilities {
+	/* Bytes of one PNG band, each band is handed to the encoder as one batch */
+	constexpr std::size_t PngBandSize = 16 << 20;
+	/* Bytes of the tile row in flight, bounds how many bands wait for their last tile */
+	constexpr std::size_t PngMaxTileBandSize = 64 << 20;
+
+	INTERNALSCOPE bool HasExtension(const std::string& filepath, const std::string_view extension)
+	{
+		if (filepath.size() < extension.size())
+			return false;
+
+		for (std::size_t i = 0; i < extension.size(); ++i)
+			if (tolower(static_cast<unsigned char>(filepath[filepath.size() - extension.size() + i])) != extension[i])
+				return false;
+
+		return true;
+	}
+}
+
+std::unique_ptr<ImageWriter> ImageWriter::Create(const std::string& filepath, ThreadPool& threadPool)
+{
+	if (Utilities::HasExtension(filepath, ".pam"))
+		return std::make_unique<PamImageWriter>();
+
+	return std::make_unique<PngImageWriter>(threadPool);
+}
+
+PngImageWriter::PngImageWriter(ThreadPool& threadPool)
+	:
+	m_Encoder(threadPool)
+{}
+
+bool PngImageWriter::Open(const std::string& filepath, const uint32_t width, const uint32_t height)
+{
+	m_File.open(filepath, std::ios::binary | std::ios::trunc);
+	if (!m_File.is_open())
+	{
+		printf("Failed to open output file: %s\n", filepath.c_str());
+		return false;
+	}
+
+	m_Width = width;
+	m_Height = height;
+	m_BandHeight = static_cast<uint32_t>(std::min<std::size_t>(height, std::max<std::size_t>(1, Utilities::PngBandSize / (static_cast<std::size_t>(width) * 4))));
+	m_NextBand = 0;
+	m_Bands.clear();
+
+	m_EncodedData.clear();
+	if (!m_Encoder.Begin(width, height, m_EncodedData))
+		return false;
+
+	m_File.write(reinterpret_cast<const char*>(m_EncodedData.data()), static_cast<std::streamsize>(m_EncodedData.size()));
+	return m_File.good();
+}
+
+bool PngImageWriter::WriteTile(const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, const uint8_t* pixels, const std::size_t rowPitch)
+{
+	const std::size_t imageRowSize = static_cast<std::size_t>(m_Width) * 4;
+	for (uint32_t bandIndex = y / m_BandHeight; bandIndex * m_BandHeight < y + height; ++bandIndex)
+	{
+		const uint32_t bandY = bandIndex * m_BandHeight;
+		const uint32_t bandRowCount = std::min(m_BandHeight, m_Height - bandY);
+		const uint32_t firstRow = std::max(y, bandY);
+		const uint32_t endRow = std::min(y + height, bandY + bandRowCount);
+
+		Band& band = m_Bands[bandIndex];
+		if (band.Pixels.empty())
+			band.Pixels.resize(bandRowCount * imageRowSize);
+
+		for (uint32_t row = firstRow; row < endRow; ++row)
+			memcpy(
+				band.Pixels.data() + (row - bandY) * imageRowSize + static_cast<std::size_t>(x) * 4,
+				pixels + (row - y) * rowPitch,
+				static_cast<std::size_t>(width) * 4);
+
+		band.WrittenPixelCount += static_cast<uint64_t>(width) * (endRow - firstRow);
+	}
+
+	return FlushBands();
+}
+
+bool PngImageWriter::FlushBands()
+{
+	for (auto band = m_Bands.find(m_NextBand); band != m_Bands.end(); band = m_Bands.find(m_NextBand))
+	{
+		const uint32_t bandRowCount = std::min(m_BandHeight, m_Height - m_NextBand * m_BandHeight);
+		if (band->second.WrittenPixelCount < static_cast<uint64_t>(m_Width) * bandRowCount)
+			break;
+
+		m_EncodedData.clear();
+		if (!m_Encoder.AppendRows(band->second.Pixels.data(), bandRowCount, m_EncodedData))
+			return false;
+
+		m_Bands.erase(band);
+		++m_NextBand;
+
+		m_File.write(reinterpret_cast<const char*>(m_EncodedData.data()), static_cast<std::streamsize>(m_EncodedData.size()));
+		if (!m_File.good())
+		{
+			printf("Failed to write band %u of the output file\n", m_NextBand - 1);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool PngImageWriter::Close()
+{
+	const bool complete = m_Encoder.IsComplete();
+	m_Bands.clear();
+	m_EncodedData = std::vector<uint8_t>();
+	m_File.close();
+	if (!complete)
+	{
+		printf("PNG closed before all rows were written, the file is truncated\n");
+		return false;
+	}
+
+	return !m_File.fail();
+}
+
+uint32_t PngImageWriter::GetMaxTileHeight() const
+{
+	return static_cast<uint32_t>(std::max<std::size_t>(1, Utilities::PngMaxTileBandSize / (static_cast<std::size_t>(m_Width) * 4)));
+}
+
+bool PamImageWriter::Open(const std::string& filepath, const uint32_t width, const uint32_t height)
+{
+	m_File.open(filepath, std::ios::binary | std::ios::trunc);
+	if (!m_File.is_open())
+	{
+		printf("Failed to open output file: %s\n", filepath.c_str());
+		return false;
+	}
+
+	m_Width = width;
+	m_Height = height;
+
+	char header[128];
+	const int headerSize = snprintf(header, sizeof(header), "P7\nWIDTH %u\nHEIGHT %u\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", width, height);
+	m_HeaderSize = static_cast<uint64_t>(headerSize);
+	m_File.write(header, headerSize);
+	return m_File.good();
+}
+
+bool PamImageWriter::WriteTile(const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, const uint8_t* pixels, const std::size_t rowPitch)
+{
+	for (uint32_t row = 0; row < height; ++row)
+	{
+		const uint64_t offset = m_HeaderSize + ((static_cast<uint64_t>(y) + row) * m_Width + x) * 4;
+		m_File.seekp(static_cast<std::streamoff>(offset));
+		m_File.write(reinterpret_cast<const char*>(pixels + row * rowPitch), static_cast<std::streamsize>(width) * 4);
+	}
+
+	if (!m_File.good())
+	{
+		printf("Failed to write tile at %u, %u\n", x, y);
+		return false;
+	}
+
+	return true;
+}
+
+bool PamImageWriter::Close()
+{
+	m_File.close();
+	return !m_File.fail();
+}
+
+bool MemoryImageWriter::Open(const std::string& /*filepath*/, const uint32_t width, const uint32_t height)
+{
+	m_Width = width;
+	m_Height = height;
+	m_Pixels.resize(static_cast<std::size_t>(width) * height * 4);
+	return true;
+}
+
+bool MemoryImageWriter::WriteTile(const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, const uint8_t* pixels, const std::size_t rowPitch)
+{
+	for (uint32_t row = 0; row < height; ++row)
+		memcpy(m_Pixels.data() + ((static_cast<std::size_t>(y) + row) * m_Width + x) * 4, pixels + row * rowPitch, static_cast<std::size_t>(width) * 4);
+
+	return true;
+}
@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <cstdio>
+#include <wchar.h>
 #include "include/Core.h"
 
 #include "include/Application.h"
@@ -14,7 +15,9 @@ INT WINAPI wWinMain(
 	PWSTR pCmdLine,
 	INT cmdShow)
 {
-	VulkanApp* application = new VulkanApp(VulkanApp::ERenderMethod::Graphics, hInstance, cmdShow);
+	/* --async-compute moves the escape time pass to the async compute queue */
+	const VulkanApp::ERenderMethod renderMethod = pCmdLine && wcsstr(pCmdLine, L"--async-compute") ? VulkanApp::ERenderMethod::AsyncCompute : VulkanApp::ERenderMethod::Graphics;
+	VulkanApp* application = new VulkanApp(renderMethod, hInstance, cmdShow);
 	if (application->Initialize())
 	{
 		if (application->Run())
@@ -0,0 +1,164 @@
+#include "include/MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::OpenForReading(const std::string& filepath)
+{
+	Close();
+	m_File = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_File == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_File, &size) || size.QuadPart <= 0)
+	{
+		Close();
+		return false;
+	}
+
+	return Map(static_cast<uint64_t>(size.QuadPart), false);
+}
+
+bool MappedFile::Create(const std::string& filepath, const uint64_t size)
+{
+	Close();
+	m_File = CreateFileA(filepath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_File == INVALID_HANDLE_VALUE)
+		return false;
+
+	/* The mapping extends the file to its size */
+	return Map(size, true);
+}
+
+bool MappedFile::Map(const uint64_t size, const bool writable)
+{
+	m_Mapping = CreateFileMappingA(
+		m_File,
+		nullptr,
+		writable ? PAGE_READWRITE : PAGE_READONLY,
+		static_cast<DWORD>(size >> 32),
+		static_cast<DWORD>(size & 0xFFFFFFFFull),
+		nullptr);
+	if (!m_Mapping)
+	{
+		Close();
+		return false;
+	}
+
+	m_Data = static_cast<uint8_t*>(MapViewOfFile(m_Mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, static_cast<SIZE_T>(size)));
+	if (!m_Data)
+	{
+		Close();
+		return false;
+	}
+
+	m_Size = size;
+	m_Writable = writable;
+	return true;
+}
+
+bool MappedFile::Close()
+{
+	bool succeeded = true;
+	if (m_Data)
+	{
+		if (m_Writable)
+			succeeded = FlushViewOfFile(m_Data, 0) != 0;
+
+		UnmapViewOfFile(m_Data);
+	}
+
+	if (m_Mapping)
+		CloseHandle(m_Mapping);
+
+	if (m_File != INVALID_HANDLE_VALUE)
+		CloseHandle(m_File);
+
+	m_Data = nullptr;
+	m_Size = 0;
+	m_Writable = false;
+	m_Mapping = nullptr;
+	m_File = INVALID_HANDLE_VALUE;
+	return succeeded;
+}
+#else
+bool MappedFile::OpenForReading(const std::string& filepath)
+{
+	Close();
+	m_File = open(filepath.c_str(), O_RDONLY);
+	if (m_File < 0)
+		return false;
+
+	struct stat status;
+	if (fstat(m_File, &status) != 0 || status.st_size <= 0)
+	{
+		Close();
+		return false;
+	}
+
+	return Map(static_cast<uint64_t>(status.st_size), false);
+}
+
+bool MappedFile::Create(const std::string& filepath, const uint64_t size)
+{
+	Close();
+	m_File = open(filepath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (m_File < 0)
+		return false;
+
+	if (ftruncate(m_File, static_cast<off_t>(size)) != 0)
+	{
+		Close();
+		return false;
+	}
+
+	return Map(size, true);
+}
+
+bool MappedFile::Map(const uint64_t size, const bool writable)
+{
+	void* data = mmap(nullptr, static_cast<std::size_t>(size), writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, m_File, 0);
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	m_Data = static_cast<uint8_t*>(data);
+	m_Size = size;
+	m_Writable = writable;
+	return true;
+}
+
+bool MappedFile::Close()
+{
+	bool succeeded = true;
+	if (m_Data)
+	{
+		if (m_Writable)
+			succeeded = msync(m_Data, static_cast<std::size_t>(m_Size), MS_ASYNC) == 0;
+
+		munmap(m_Data, static_cast<std::size_t>(m_Size));
+	}
+
+	if (m_File >= 0)
+		close(m_File);
+
+	m_Data = nullptr;
+	m_Size = 0;
+	m_Writable = false;
+	m_File = -1;
+	return succeeded;
+}
+#endif
@@ -0,0 +1,2290 @@
+#include "include/OfflineRenderer.h"
+#include "include/ImageWriter.h"
+#include "include/OrbitCache.h"
+#include "include/Platform.h"
+#include "glm/gtc/packing.hpp"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
+
+namespace Utilities {
+	/* No surface extensions, the offline renderer never presents */
+	#ifdef APP_DEBUG
+	INTERNALSCOPE const std::vector<const char*> OfflineRequestedLayers = { "VK_LAYER_KHRONOS_validation" };
+	#else
+	INTERNALSCOPE const std::vector<const char*> OfflineRequestedLayers = {};
+	#endif
+
+	/* Must match local_size_x/local_size_y in computeShader.comp */
+	constexpr uint32_t ComputeWorkgroupSize = 32;
+	/* Upper bound for a single tile buffer when the tile size is derived from the budget */
+	constexpr VkDeviceSize MaxTileBufferSize = 256ull * 1024 * 1024;
+	/* Escape time bytes read per band when recoloring */
+	constexpr std::size_t RecolorBandSize = 16 << 20;
+	/* Upper bound for one band of the CPU renderer */
+	constexpr std::size_t CpuTileBufferSize = 64 << 20;
+
+	INTERNALSCOPE uint32_t AlignToWorkgroupSize(const uint32_t value)
+	{
+		return (value + ComputeWorkgroupSize - 1) / ComputeWorkgroupSize * ComputeWorkgroupSize;
+	}
+
+	INTERNALSCOPE std::size_t GetOutputPixelSize(const EOutputFormat format)
+	{
+		switch (format)
+		{
+			case EOutputFormat::RGBA8: return sizeof(uint32_t);
+			case EOutputFormat::Iterations: return sizeof(uint32_t);
+			case EOutputFormat::SmoothIterations: return sizeof(uint16_t);
+			case EOutputFormat::LinearFloat: return sizeof(float) * 4;
+		}
+
+		assert(false);
+		return 0;
+	}
+
+	/* float32 has to resolve the pixel spacing with 8 bits to spare, iteration amplifies the rounding long before pixels merge */
+	INTERNALSCOPE bool NeedsDoublePrecision(const OfflineRenderSettings& settings)
+	{
+		const double magnitude = std::max(fabs(settings.CenterX), fabs(settings.CenterY)) + settings.Scale;
+		const double pixelSpacing = settings.Scale / static_cast<double>(settings.Width);
+		return pixelSpacing < magnitude * static_cast<double>(FLT_EPSILON) * 256.0;
+	}
+}
+
+OfflineRenderer::OfflineRenderer(const OfflineRenderSettings& settings)
+	:
+	m_Settings(settings),
+	m_Instance(VK_NULL_HANDLE),
+	m_PhysicalDevice(VK_NULL_HANDLE),
+	m_PhysicalDeviceProperties(),
+	m_PhysicalDeviceMemoryProperties(),
+	m_LogicalDevice(VK_NULL_HANDLE),
+	m_ComputeQueueIndex(-1),
+	m_ComputeQueue(VK_NULL_HANDLE),
+	m_ComputeCommandPool(VK_NULL_HANDLE),
+	m_TransferQueueIndex(-1),
+	m_TransferQueue(VK_NULL_HANDLE),
+	m_TransferCommandPool(VK_NULL_HANDLE),
+	m_MemoryBudgetSupported(false),
+	m_HostQueryResetSupported(false),
+	m_ShaderFloat64Supported(false),
+	m_ComputeTimeline(VK_NULL_HANDLE),
+	m_TransferTimeline(VK_NULL_HANDLE),
+	m_SubmittedTileCount(0),
+	m_ComputeQueryPool(VK_NULL_HANDLE),
+	m_TransferQueryPool(VK_NULL_HANDLE),
+	m_Timings(),
+	m_ComputeSlots(),
+	m_ReadbackSlots(),
+	m_TileBufferSize(0),
+	m_TileWidth(0),
+	m_DoublePrecision(false),
+	m_Perturbation(false),
+	m_TileImage(),
+	m_ThreadPool(),
+	m_SimdLevel(Simd::GetSupportedLevel()),
+	m_CpuRenderer(m_ThreadPool),
+	m_CpuTile(),
+	m_VerifiedPixelCount(0),
+	m_MismatchedPixelCount(0),
+	m_EscapeTimeWriter(),
+	m_CheckCountBuffer(),
+	m_CheckCounts(nullptr),
+	m_PerturbationView(),
+	m_MainReference(),
+	m_Series(),
+	m_ReferenceCenter(),
+	m_GlitchReferences(),
+	m_GlitchedPixels(),
+	m_GlitchedPixelCount(0),
+	m_UncorrectedPixelCount(0),
+	m_GlitchMaskOffset(0),
+	m_GlitchMaskSize(0),
+	m_ReferenceOrbitBuffer(),
+	m_ReferenceOrbitBufferSize(0),
+	m_MappedReferenceOrbit(nullptr),
+	m_DescriptorSetLayout(VK_NULL_HANDLE),
+	m_DescriptorPool(VK_NULL_HANDLE),
+	m_ComputeShaderModule(VK_NULL_HANDLE),
+	m_DoublePrecisionComputeShaderModule(VK_NULL_HANDLE),
+	m_PerturbationShaderModule(VK_NULL_HANDLE),
+	m_DoublePrecisionPerturbationShaderModule(VK_NULL_HANDLE),
+	m_ComputePipelineLayout(VK_NULL_HANDLE),
+	m_PipelineCache(VK_NULL_HANDLE),
+	m_ComputePipelines()
+{}
+
+OfflineRenderer::~OfflineRenderer()
+{
+}
+
+bool OfflineRenderer::Initialize()
+{
+	/* Without a usable device every render runs on the CpuRenderer */
+	if (!CreateInstance() || !CreateLogicalDevice())
+	{
+		printf("No suitable vulkan device, rendering on the CPU (%s)\n", Simd::GetLevelName(m_CpuRenderer.GetSimdLevel()));
+		return true;
+	}
+
+	if (!CreateComputePipelineLayout())
+	{
+		printf("Failed to create compute based pipeline\n");
+		return false;
+	}
+
+	if (!AllocateCommandBuffers())
+	{
+		printf("Failed to allocate compute commands buffers\n");
+		return false;
+	}
+
+	if (!CreateSynchronizationObjects())
+	{
+		printf("Failed to create synchronization objects\n");
+		return false;
+	}
+
+	return true;
+}
+
+bool OfflineRenderer::Render(const OfflineRenderSettings& settings)
+{
+	m_Settings = settings;
+	return Render();
+}
+
+bool OfflineRenderer::Render(const OfflineRenderSettings& settings, ImageWriter& writer)
+{
+	m_Settings = settings;
+	return RenderImage(writer);
+}
+
+bool OfflineRenderer::Render()
+{
+	if (!m_Settings.RecolorPath.empty())
+		return Recolor();
+
+	std::unique_ptr<ImageWriter> writer = ImageWriter::Create(m_Settings.OutputPath, m_ThreadPool);
+	return RenderImage(*writer);
+}
+
+bool OfflineRenderer::RenderImage(ImageWriter& writer)
+{
+	if (m_Settings.Width == 0 || m_Settings.Height == 0 || m_Settings.MaxIterations == 0)
+	{
+		printf("Invalid offline render settings: %ux%u, %u iterations\n", m_Settings.Width, m_Settings.Height, m_Settings.MaxIterations);
+		return false;
+	}
+
+	if (!m_Settings.EscapeTimePath.empty() && m_Settings.OutputFormat != EOutputFormat::SmoothIterations)
+	{
+		printf("Saving the escape time buffer requires the smooth output format\n");
+		return false;
+	}
+
+	m_Perturbation = UsePerturbation();
+	if (m_Perturbation && !PreparePerturbation())
+		return false;
+
+	m_SimdLevel = std::min(m_Settings.SimdLevel, Simd::GetSupportedLevel());
+	m_CpuRenderer.SetSimdLevel(m_SimdLevel);
+	if (m_Settings.RenderOnCpu || !m_LogicalDevice)
+	{
+		if (m_Settings.Precision == EShaderPrecision::Double && !m_Perturbation)
+			printf("The CPU kernels render in float32, double precision only applies to device renders\n");
+
+		return RenderImageOnCpu(writer);
+	}
+
+	/* Float deltas underflow on deep zooms, without the shader for the depth the CPU renders in double */
+	if (m_Perturbation && !GetShaderModule(true, UseDoublePrecision()))
+	{
+		printf("No %s perturbation shader on this device, rendering on the CPU\n", UseDoublePrecision() ? "float64" : "float32");
+		return RenderImageOnCpu(writer);
+	}
+
+	/* Workgroups iterate every pixel of their tile, there is nothing to subdivide */
+	if (m_Settings.Subdivision.Enabled)
+	{
+		printf("Subdivision only applies to CPU renders, pass --cpu with --subdivide\n");
+		return false;
+	}
+
+	const std::size_t pixelSize = Utilities::GetOutputPixelSize(m_Settings.OutputFormat);
+	const uint32_t tileSize = ChooseTileSize(pixelSize);
+	if (tileSize == 0)
+	{
+		printf("Failed to find a tile size that fits into the available device memory\n");
+		return false;
+	}
+
+	if (!writer.Open(m_Settings.OutputPath, m_Settings.Width, m_Settings.Height))
+		return false;
+
+	if (!m_Settings.EscapeTimePath.empty() && !m_EscapeTimeWriter.Open(m_Settings.EscapeTimePath, m_Settings.Width, m_Settings.Height, m_Settings.MaxIterations))
+	{
+		writer.Close();
+		return false;
+	}
+
+	ComputePipelineKey pipelineKey;
+	pipelineKey.Width = m_Settings.Width;
+	pipelineKey.Height = m_Settings.Height;
+	pipelineKey.MaxIterations = m_Settings.MaxIterations;
+	pipelineKey.TileWidth = std::min(tileSize, Utilities::AlignToWorkgroupSize(m_Settings.Width));
+	pipelineKey.TileHeight = std::min(tileSize, Utilities::AlignToWorkgroupSize(m_Settings.Height));
+	pipelineKey.OutputFormat = m_Settings.OutputFormat;
+	pipelineKey.InteriorCheckFlags = m_Settings.Interior.GetFlags();
+	pipelineKey.PeriodicityTolerance = m_Settings.Interior.Periodicity ? m_Settings.Interior.PeriodicityTolerance : 0.0f;
+	pipelineKey.DoublePrecision = UseDoublePrecision();
+	pipelineKey.Perturbation = m_Perturbation;
+	m_DoublePrecision = pipelineKey.DoublePrecision;
+
+	/* The CpuRenderer only mirrors the float32 shader, a float64 render differs wherever float32 runs out of precision */
+	const bool verifyWithCpu = m_Settings.VerifyWithCpu && !m_DoublePrecision && !m_Perturbation;
+	if (m_Settings.VerifyWithCpu && !verifyWithCpu)
+		printf("The CPU reference is float32, --verify-cpu is skipped for this %s render\n", m_Perturbation ? "perturbation" : "double precision");
+
+	if (m_Perturbation && !UploadReferenceOrbit(m_DoublePrecision))
+	{
+		CloseWriters(writer);
+		return false;
+	}
+
+	/* Streaming writers hold every band a tile row touches, trade tile height for width at the same buffer size */
+	const uint32_t maxTileHeight = writer.GetMaxTileHeight();
+	if (maxTileHeight != 0 && pipelineKey.TileHeight > maxTileHeight)
+	{
+		const uint32_t tileHeight = std::max(Utilities::ComputeWorkgroupSize, maxTileHeight / Utilities::ComputeWorkgroupSize * Utilities::ComputeWorkgroupSize);
+		const uint64_t tilePixelCount = static_cast<uint64_t>(pipelineKey.TileWidth) * pipelineKey.TileHeight;
+		const uint32_t tileWidth = static_cast<uint32_t>(std::min<uint64_t>(tilePixelCount / tileHeight, Utilities::AlignToWorkgroupSize(m_Settings.Width)));
+		pipelineKey.TileWidth = std::max(Utilities::ComputeWorkgroupSize, tileWidth / Utilities::ComputeWorkgroupSize * Utilities::ComputeWorkgroupSize);
+		pipelineKey.TileHeight = tileHeight;
+	}
+
+	/* Perturbation renders also copy back one glitch bit per pixel */
+	const VkDeviceSize tilePixelCount = static_cast<VkDeviceSize>(pipelineKey.TileWidth) * pipelineKey.TileHeight;
+	m_GlitchMaskOffset = tilePixelCount * pixelSize;
+	m_GlitchMaskSize = m_Perturbation ? (tilePixelCount + 31) / 32 * sizeof(uint32_t) : 0;
+
+	const VkDeviceSize requiredTileBufferSize = m_GlitchMaskOffset + m_GlitchMaskSize;
+	if (requiredTileBufferSize > m_TileBufferSize)
+	{
+		DestroyTileBuffers();
+		if (!CreateTileBuffers(requiredTileBufferSize))
+		{
+			CloseWriters(writer);
+			return false;
+		}
+	}
+
+	m_TileWidth = pipelineKey.TileWidth;
+
+	/* RGBA8 tiles go to the writer straight from the mapped buffer, only the iteration formats need a colored copy */
+	if (m_Settings.OutputFormat == EOutputFormat::RGBA8)
+		m_TileImage = std::vector<uint8_t>();
+	else
+		m_TileImage.resize(static_cast<std::size_t>(pipelineKey.TileWidth) * pipelineKey.TileHeight * 4);
+
+	if (verifyWithCpu)
+		m_CpuTile.resize(static_cast<std::size_t>(pipelineKey.TileWidth) * pipelineKey.TileHeight * pixelSize);
+
+	m_VerifiedPixelCount = 0;
+	m_MismatchedPixelCount = 0;
+	/* Nothing is in flight between renders, the shaders only add to the counters */
+	std::fill_n(m_CheckCounts, 3, 0u);
+
+	const VkPipeline pipeline = GetComputePipeline(pipelineKey);
+	if (!pipeline)
+	{
+		CloseWriters(writer);
+		return false;
+	}
+
+	const uint32_t tileCountX = (m_Settings.Width + pipelineKey.TileWidth - 1) / pipelineKey.TileWidth;
+	const uint32_t tileCountY = (m_Settings.Height + pipelineKey.TileHeight - 1) / pipelineKey.TileHeight;
+	const uint32_t tileCount = tileCountX * tileCountY;
+	printf("Rendering %ux%u in %u tiles of %ux%u in %s precision%s\n",
+		m_Settings.Width, m_Settings.Height, tileCount, pipelineKey.TileWidth, pipelineKey.TileHeight, m_DoublePrecision ? "double" : "single",
+		m_Perturbation ? " with perturbation" : "");
+
+	m_Timings = StageTimings();
+	const uint64_t firstTileNumber = m_SubmittedTileCount;
+	const double renderStartTime = Platform::GetAbsoluteTime();
+
+	bool succeeded = true;
+	uint32_t consumedTileCount = 0;
+	for (uint32_t tileIndex = 0; tileIndex < tileCount && succeeded; ++tileIndex)
+	{
+		/* The readback slot of this tile is free once the tile ReadbackSlotCount before it was written out */
+		while (succeeded && consumedTileCount + ReadbackSlotCount <= tileIndex)
+			succeeded = ConsumeTile(firstTileNumber + consumedTileCount++, writer);
+
+		if (!succeeded)
+			break;
+
+		TileRegion region;
+		region.X = (tileIndex % tileCountX) * pipelineKey.TileWidth;
+		region.Y = (tileIndex / tileCountX) * pipelineKey.TileHeight;
+		region.Width = std::min(pipelineKey.TileWidth, m_Settings.Width - region.X);
+		region.Height = std::min(pipelineKey.TileHeight, m_Settings.Height - region.Y);
+
+		if (!SubmitCompute(m_SubmittedTileCount, region, pipeline) || !SubmitReadback(m_SubmittedTileCount, region))
+		{
+			succeeded = false;
+			break;
+		}
+
+		++m_SubmittedTileCount;
+	}
+
+	const uint64_t submittedTileCount = m_SubmittedTileCount - firstTileNumber;
+	while (succeeded && consumedTileCount < submittedTileCount)
+		succeeded = ConsumeTile(firstTileNumber + consumedTileCount++, writer);
+
+	if (!succeeded)
+	{
+		/* Nothing may stay in flight, the slots are reused by the next render */
+		VK_CHECK(vkDeviceWaitIdle(m_LogicalDevice));
+		CloseWriters(writer);
+		return false;
+	}
+
+	const double renderTime = Platform::GetAbsoluteTime() - renderStartTime;
+	const double pixelCount = static_cast<double>(m_Settings.Width) * static_cast<double>(m_Settings.Height);
+	printf("Rendered %ux%u (%u iterations) in %.3f s, %.2f MPixel/s\n",
+		m_Settings.Width, m_Settings.Height, m_Settings.MaxIterations, renderTime, pixelCount / renderTime / 1.0e6);
+
+	/* Busy time per stage against the wall time, the difference is what the overlap saved */
+	if (m_ComputeQueryPool && m_TransferQueryPool)
+		printf("Stages: compute %.3f s, copy %.3f s, host %.3f s (%.3f s waiting), %.3f s serial vs %.3f s wall\n",
+			m_Timings.ComputeTime, m_Timings.CopyTime, m_Timings.HostTime, m_Timings.HostWaitTime,
+			m_Timings.ComputeTime + m_Timings.CopyTime + m_Timings.HostTime, renderTime);
+	else
+		printf("Stages: host %.3f s (%.3f s waiting), no GPU timestamps on this queue family\n", m_Timings.HostTime, m_Timings.HostWaitTime);
+
+	if (m_Perturbation)
+		PrintPerturbationStatistics(pixelCount);
+	else
+	{
+		InteriorCheckCounts checkCounts;
+		checkCounts.Cardioid = m_CheckCounts[0];
+		checkCounts.Bulb = m_CheckCounts[1];
+		checkCounts.Periodicity = m_CheckCounts[2];
+		InteriorCheck::PrintHitRates(m_Settings.Interior, checkCounts, pixelCount);
+	}
+
+	if (verifyWithCpu)
+		printf("CPU reference: %llu of %llu pixels differ (%.4f%%)\n",
+			static_cast<unsigned long long>(m_MismatchedPixelCount), static_cast<unsigned long long>(m_VerifiedPixelCount),
+			m_VerifiedPixelCount != 0 ? 100.0 * static_cast<double>(m_MismatchedPixelCount) / static_cast<double>(m_VerifiedPixelCount) : 0.0);
+
+	const double writeStartTime = Platform::GetAbsoluteTime();
+	if (m_EscapeTimeWriter.IsOpen() && !m_EscapeTimeWriter.Close())
+	{
+		printf("Failed to write escape time file: %s\n", m_Settings.EscapeTimePath.c_str());
+		writer.Close();
+		return false;
+	}
+
+	if (!writer.Close())
+		return false;
+
+	printf("Wrote %s in %.3f s\n", m_Settings.OutputPath.c_str(), Platform::GetAbsoluteTime() - writeStartTime);
+	return true;
+}
+
+void OfflineRenderer::CloseWriters(ImageWriter& writer)
+{
+	writer.Close();
+	if (m_EscapeTimeWriter.IsOpen())
+		m_EscapeTimeWriter.Close();
+}
+
+bool OfflineRenderer::RenderImageOnCpu(ImageWriter& writer)
+{
+	if (!writer.Open(m_Settings.OutputPath, m_Settings.Width, m_Settings.Height))
+		return false;
+
+	if (!m_Settings.EscapeTimePath.empty() && !m_EscapeTimeWriter.Open(m_Settings.EscapeTimePath, m_Settings.Width, m_Settings.Height, m_Settings.MaxIterations))
+	{
+		writer.Close();
+		return false;
+	}
+
+	/* Full-width bands, the CPU has no workgroup size to align to */
+	const std::size_t pixelSize = Utilities::GetOutputPixelSize(m_Settings.OutputFormat);
+	uint32_t bandHeight = static_cast<uint32_t>(std::max<std::size_t>(1, Utilities::CpuTileBufferSize / (static_cast<std::size_t>(m_Settings.Width) * pixelSize)));
+	if (writer.GetMaxTileHeight() != 0)
+		bandHeight = std::min(bandHeight, writer.GetMaxTileHeight());
+
+	bandHeight = std::min(bandHeight, m_Settings.Height);
+
+	m_TileWidth = m_Settings.Width;
+	m_CpuTile.resize(static_cast<std::size_t>(m_Settings.Width) * bandHeight * pixelSize);
+	if (m_Settings.OutputFormat != EOutputFormat::RGBA8)
+		m_TileImage.resize(static_cast<std::size_t>(m_Settings.Width) * bandHeight * 4);
+
+	if (m_Perturbation)
+		printf("Rendering %ux%u on the CPU with perturbation (double deltas, %u threads) in bands of %u rows\n",
+			m_Settings.Width, m_Settings.Height, m_ThreadPool.GetThreadCount(), bandHeight);
+	else
+		printf("Rendering %ux%u on the CPU (%s, %u threads) in bands of %u rows\n",
+			m_Settings.Width, m_Settings.Height, Simd::GetLevelName(m_CpuRenderer.GetSimdLevel()), m_ThreadPool.GetThreadCount(), bandHeight);
+
+	m_CpuRenderer.ResetCounters();
+	const uint64_t firstStealCount = m_ThreadPool.GetStealCount();
+	const double renderStartTime = Platform::GetAbsoluteTime();
+	double iterationTime = 0.0;
+	for (uint32_t y = 0; y < m_Settings.Height; y += bandHeight)
+	{
+		TileRegion region;
+		region.X = 0;
+		region.Y = y;
+		region.Width = m_Settings.Width;
+		region.Height = std::min(bandHeight, m_Settings.Height - y);
+
+		const double bandStartTime = Platform::GetAbsoluteTime();
+		if (m_Perturbation)
+		{
+			m_GlitchedPixels.clear();
+			m_CpuRenderer.RenderPerturbationTile(m_Settings, m_PerturbationView, m_MainReference, &m_Series, region, m_CpuTile.data(), m_TileWidth, m_GlitchedPixels);
+			CorrectGlitches(m_CpuTile.data(), region);
+		}
+		else
+			m_CpuRenderer.RenderTile(m_Settings, region, m_CpuTile.data(), m_TileWidth);
+
+		iterationTime += Platform::GetAbsoluteTime() - bandStartTime;
+
+		if (!WriteTile(m_CpuTile.data(), region, writer))
+		{
+			CloseWriters(writer);
+			return false;
+		}
+	}
+
+	const double renderTime = Platform::GetAbsoluteTime() - renderStartTime;
+	const double pixelCount = static_cast<double>(m_Settings.Width) * static_cast<double>(m_Settings.Height);
+	const double iterationCount = static_cast<double>(m_CpuRenderer.GetIterationCount());
+	printf("Rendered %ux%u (%u iterations) on the CPU in %.3f s, %.2f MPixel/s, %.3f GIterations/s (%.3f s iterating)\n",
+		m_Settings.Width, m_Settings.Height, m_Settings.MaxIterations, renderTime, pixelCount / renderTime / 1.0e6,
+		iterationCount / iterationTime / 1.0e9, iterationTime);
+	const unsigned long long stealCount = static_cast<unsigned long long>(m_ThreadPool.GetStealCount() - firstStealCount);
+	if (m_Perturbation)
+		PrintPerturbationStatistics(pixelCount);
+	else if (m_Settings.Subdivision.Enabled)
+	{
+		const uint64_t skippedPixelCount = m_CpuRenderer.GetSkippedPixelCount();
+		printf("Subdivision: %llu of %.0f pixels filled without iterating (%.1f%%), %llu ranges stolen between threads\n",
+			static_cast<unsigned long long>(skippedPixelCount), pixelCount, 100.0 * static_cast<double>(skippedPixelCount) / pixelCount, stealCount);
+	}
+	else
+		printf("Scheduling: tiles adapted to %ux%u, %llu ranges stolen between threads\n", m_CpuRenderer.GetTileEdge(), m_CpuRenderer.GetTileEdge(), stealCount);
+
+	/* Pixels filled by subdivision never reach a check */
+	if (!m_Perturbation)
+		InteriorCheck::PrintHitRates(m_Settings.Interior, m_CpuRenderer.GetCheckCounts(), pixelCount);
+
+	if (m_EscapeTimeWriter.IsOpen() && !m_EscapeTimeWriter.Close())
+	{
+		printf("Failed to write escape time file: %s\n", m_Settings.EscapeTimePath.c_str());
+		writer.Close();
+		return false;
+	}
+
+	if (!writer.Close())
+		return false;
+
+	printf("Wrote %s\n", m_Settings.OutputPath.c_str());
+	return true;
+}
+
+bool OfflineRenderer::Recolor()
+{
+	const double startTime = Platform::GetAbsoluteTime();
+	EscapeTimeReader reader;
+	if (!reader.Open(m_Settings.RecolorPath))
+		return false;
+
+	const uint32_t width = reader.GetWidth();
+	const uint32_t height = reader.GetHeight();
+	std::unique_ptr<ImageWriter> writer = ImageWriter::Create(m_Settings.OutputPath, m_ThreadPool);
+	if (!writer->Open(m_Settings.OutputPath, width, height))
+		return false;
+
+	uint32_t bandHeight = static_cast<uint32_t>(std::max<std::size_t>(1, Utilities::RecolorBandSize / (static_cast<std::size_t>(width) * sizeof(uint16_t))));
+	if (writer->GetMaxTileHeight() != 0)
+		bandHeight = std::min(bandHeight, writer->GetMaxTileHeight());
+
+	bandHeight = std::min(bandHeight, height);
+
+	std::vector<uint16_t> escapeTimes(static_cast<std::size_t>(width) * bandHeight);
+	m_TileImage.resize(static_cast<std::size_t>(width) * bandHeight * 4);
+	for (uint32_t y = 0; y < height; y += bandHeight)
+	{
+		const uint32_t rowCount = std::min(bandHeight, height - y);
+		if (!reader.ReadRows(y, rowCount, escapeTimes.data()))
+		{
+			printf("Failed to read rows %u..%u of %s\n", y, y + rowCount, m_Settings.RecolorPath.c_str());
+			writer->Close();
+			return false;
+		}
+
+		PostProcess::ColorSmoothIterations(
+			escapeTimes.data(), static_cast<std::size_t>(width) * sizeof(uint16_t), m_TileImage.data(), static_cast<std::size_t>(width) * 4,
+			width, rowCount, reader.GetMaxIterations(), m_Settings.Coloring, m_ThreadPool);
+
+		if (!writer->WriteTile(0, y, width, rowCount, m_TileImage.data(), static_cast<std::size_t>(width) * 4))
+		{
+			writer->Close();
+			return false;
+		}
+	}
+
+	if (!writer->Close())
+		return false;
+
+	printf("Recolored %s (%ux%u, %u iterations) with the %s palette into %s in %.3f s\n",
+		m_Settings.RecolorPath.c_str(), width, height, reader.GetMaxIterations(), Coloring::GetPaletteName(m_Settings.Coloring.Palette),
+		m_Settings.OutputPath.c_str(), Platform::GetAbsoluteTime() - startTime);
+	return true;
+}
+
+bool OfflineRenderer::PreparePerturbation()
+{
+	/* A zoom video's deepest frame decides the precision, so all of its keyframes share one reference */
+	const double deepestScale = m_Settings.ZoomFrameCount != 0 && m_Settings.ZoomFinalScale > 0.0 ? std::min(m_Settings.Scale, m_Settings.ZoomFinalScale) : m_Settings.Scale;
+	const uint32_t fractionBits = Perturbation::GetFractionBits(deepestScale, m_Settings.Width);
+	const bool hasPreciseCenter = !m_Settings.PreciseCenterX.empty() && !m_Settings.PreciseCenterY.empty();
+
+	/* Without the decimal text the doubles are the exact center, their hex form identifies them */
+	std::string center;
+	if (hasPreciseCenter)
+		center = m_Settings.PreciseCenterX + " " + m_Settings.PreciseCenterY;
+	else
+	{
+		std::array<char, 64> text;
+		snprintf(text.data(), text.size(), "%a %a", m_Settings.CenterX, m_Settings.CenterY);
+		center = text.data();
+	}
+
+	m_PerturbationView.Scale = m_Settings.Scale;
+	m_PerturbationView.Width = m_Settings.Width;
+	m_PerturbationView.Height = m_Settings.Height;
+	m_GlitchReferences.clear();
+	m_GlitchedPixelCount = 0;
+	m_UncorrectedPixelCount = 0;
+
+	/* A reference away from the center only serves views around it, further out its offset would swallow the pixels' */
+	const bool referenceFits =
+		center == m_ReferenceCenter &&
+		m_PerturbationView.MaxIterations == m_Settings.MaxIterations &&
+		m_PerturbationView.CenterX.GetFractionBits() >= fractionBits &&
+		std::max(fabs(m_MainReference.OffsetX), fabs(m_MainReference.OffsetY)) <= m_Settings.Scale * 0.5;
+	if (referenceFits)
+	{
+		PrepareSeries();
+		return true;
+	}
+
+	m_ReferenceCenter.clear();
+	if (!hasPreciseCenter)
+	{
+		m_PerturbationView.CenterX = BigFixed::FromDouble(m_Settings.CenterX, fractionBits);
+		m_PerturbationView.CenterY = BigFixed::FromDouble(m_Settings.CenterY, fractionBits);
+	}
+	else if (!BigFixed::Parse(m_Settings.PreciseCenterX, fractionBits, m_PerturbationView.CenterX) ||
+		!BigFixed::Parse(m_Settings.PreciseCenterY, fractionBits, m_PerturbationView.CenterY))
+	{
+		printf("Invalid center for a perturbation render: %s %s\n", m_Settings.PreciseCenterX.c_str(), m_Settings.PreciseCenterY.c_str());
+		return false;
+	}
+
+	m_PerturbationView.MaxIterations = m_Settings.MaxIterations;
+
+	/* Keyed by the precision of the parsed center, whole limbs, so nearby resolutions share a file */
+	const double startTime = Platform::GetAbsoluteTime();
+	const uint32_t limbFractionBits = m_PerturbationView.CenterX.GetFractionBits();
+	std::string cachePath;
+	if (!m_Settings.OrbitCacheDirectory.empty())
+	{
+		cachePath = OrbitCache::GetFilePath(m_Settings.OrbitCacheDirectory, center, limbFractionBits, m_Settings.MaxIterations);
+		if (OrbitCache::Load(cachePath, center, limbFractionBits, m_Settings.MaxIterations, m_MainReference) &&
+			std::max(fabs(m_MainReference.OffsetX), fabs(m_MainReference.OffsetY)) <= m_Settings.Scale * 0.5)
+		{
+			m_ReferenceCenter = center;
+			printf("Reference orbit: %u of %u iterations loaded from %s, %.3f s\n",
+				m_MainReference.GetLength(), m_Settings.MaxIterations, cachePath.c_str(), Platform::GetAbsoluteTime() - startTime);
+			PrepareSeries();
+			return true;
+		}
+	}
+
+	m_MainReference = Perturbation::ComputeMainReference(m_PerturbationView);
+	m_ReferenceCenter = center;
+	printf("Reference orbit: %u of %u iterations in %u fraction bits, offset %g %g from the center, %.3f s\n",
+		m_MainReference.GetLength(), m_Settings.MaxIterations, limbFractionBits, m_MainReference.OffsetX, m_MainReference.OffsetY,
+		Platform::GetAbsoluteTime() - startTime);
+
+	/* A failed store only costs the next render the computation */
+	if (!cachePath.empty())
+		OrbitCache::Store(cachePath, center, limbFractionBits, m_Settings.MaxIterations, m_MainReference);
+
+	PrepareSeries();
+	return true;
+}
+
+void OfflineRenderer::PrepareSeries()
+{
+	m_Series = SeriesApproximation();
+	if (!m_Settings.Series)
+		return;
+
+	const double startTime = Platform::GetAbsoluteTime();
+	m_Series = Perturbation::ComputeSeriesApproximation(m_PerturbationView, m_MainReference);
+	printf("Series approximation: %u terms skip %u of %u iterations, %.3f s\n",
+		Perturbation::SeriesTermCount, m_Series.SkipIterations, m_MainReference.GetLength(), Platform::GetAbsoluteTime() - startTime);
+}
+
+bool OfflineRenderer::UploadReferenceOrbit(const bool doublePrecision)
+{
+	/* The series coefficients follow the points, perturbationShader.comp finds them past ReferenceLength */
+	const std::size_t pointValueCount = m_MainReference.Points.size();
+	const std::size_t valueCount = pointValueCount + m_Series.Coefficients.size();
+	const VkDeviceSize size = valueCount * (doublePrecision ? sizeof(double) : sizeof(float));
+	if (size > m_ReferenceOrbitBufferSize)
+	{
+		DestroyBuffer(m_ReferenceOrbitBuffer);
+		m_ReferenceOrbitBufferSize = 0;
+		m_MappedReferenceOrbit = nullptr;
+
+		/* Every pixel reads it, but it is small enough to stay in the device caches, so host-visible memory needs no staging copy */
+		if (!CreateBuffer(
+			size,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			false,
+			m_ReferenceOrbitBuffer))
+			return false;
+
+		m_ReferenceOrbitBufferSize = size;
+		VK_CHECK(vkMapMemory(
+			m_LogicalDevice,
+			m_ReferenceOrbitBuffer.DeviceMemory,
+			0,
+			size,
+			0,
+			&m_MappedReferenceOrbit));
+
+		VkDescriptorBufferInfo bufferInfo;
+		bufferInfo.buffer = m_ReferenceOrbitBuffer.Handle;
+		bufferInfo.range = size;
+		bufferInfo.offset = 0;
+
+		for (const ComputeSlot& slot : m_ComputeSlots)
+		{
+			VkWriteDescriptorSet descriptorSetWrite;
+			descriptorSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			descriptorSetWrite.dstBinding = 2;
+			descriptorSetWrite.dstArrayElement = 0;
+			descriptorSetWrite.descriptorCount = 1;
+			descriptorSetWrite.dstSet = slot.DescriptorSet;
+			descriptorSetWrite.pBufferInfo = &bufferInfo;
+			descriptorSetWrite.pImageInfo = nullptr;
+			descriptorSetWrite.pTexelBufferView = nullptr;
+			descriptorSetWrite.pNext = nullptr;
+
+			vkUpdateDescriptorSets(
+				m_LogicalDevice,
+				1,
+				&descriptorSetWrite,
+				0,
+				nullptr);
+		}
+	}
+
+	/* Nothing is in flight between renders, the shaders are done with the previous reference */
+	if (doublePrecision)
+	{
+		double* values = static_cast<double*>(m_MappedReferenceOrbit);
+		memcpy(values, m_MainReference.Points.data(), pointValueCount * sizeof(double));
+		memcpy(values + pointValueCount, m_Series.Coefficients.data(), m_Series.Coefficients.size() * sizeof(double));
+	}
+	else
+	{
+		float* values = static_cast<float*>(m_MappedReferenceOrbit);
+		for (std::size_t i = 0; i < pointValueCount; ++i)
+			values[i] = static_cast<float>(m_MainReference.Points[i]);
+
+		for (std::size_t i = 0; i < m_Series.Coefficients.size(); ++i)
+			values[pointValueCount + i] = static_cast<float>(m_Series.Coefficients[i]);
+	}
+
+	return true;
+}
+
+void OfflineRenderer::CorrectGlitches(void* tile, const TileRegion& region)
+{
+	m_GlitchedPixelCount += m_GlitchedPixels.size();
+	if (!m_GlitchedPixels.empty())
+		m_CpuRenderer.CorrectGlitches(m_Settings, m_PerturbationView, region, tile, m_TileWidth, m_GlitchedPixels, m_GlitchReferences);
+
+	m_UncorrectedPixelCount += m_GlitchedPixels.size();
+}
+
+void OfflineRenderer::PrintPerturbationStatistics(const double pixelCount) const
+{
+	printf("Perturbation: %llu glitched pixels (%.4f%%) iterated again against %zu more references, %llu left uncorrected\n",
+		static_cast<unsigned long long>(m_GlitchedPixelCount), pixelCount > 0.0 ? 100.0 * static_cast<double>(m_GlitchedPixelCount) / pixelCount : 0.0,
+		m_GlitchReferences.size(), static_cast<unsigned long long>(m_UncorrectedPixelCount));
+
+	/* Glitched pixels start over against their new reference, only the others keep what the series skipped */
+	if (m_Series.SkipIterations != 0)
+		printf("Series approximation: skipped %.4g iterations, %u for every pixel that kept the main reference\n",
+			(pixelCount - static_cast<double>(m_GlitchedPixelCount)) * m_Series.SkipIterations, m_Series.SkipIterations);
+}
+
+bool OfflineRenderer::Shutdown()
+{
+	if (!m_LogicalDevice)
+	{
+		if (m_Instance)
+			vkDestroyInstance(
+				m_Instance,
+				nullptr);
+
+		return true;
+	}
+
+	VK_CHECK(vkDeviceWaitIdle(m_LogicalDevice));
+	DestroyTileBuffers();
+	DestroyBuffer(m_CheckCountBuffer);
+	m_CheckCounts = nullptr;
+	DestroyBuffer(m_ReferenceOrbitBuffer);
+	m_MappedReferenceOrbit = nullptr;
+	m_ReferenceOrbitBufferSize = 0;
+
+	for (const VkSemaphore timeline : { m_ComputeTimeline, m_TransferTimeline })
+		if (timeline)
+			vkDestroySemaphore(
+				m_LogicalDevice,
+				timeline,
+				nullptr);
+
+	for (const VkQueryPool queryPool : { m_ComputeQueryPool, m_TransferQueryPool })
+		if (queryPool)
+			vkDestroyQueryPool(
+				m_LogicalDevice,
+				queryPool,
+				nullptr);
+
+	for (const auto& [key, pipeline] : m_ComputePipelines)
+		vkDestroyPipeline(
+			m_LogicalDevice,
+			pipeline,
+			nullptr);
+
+	m_ComputePipelines.clear();
+
+	if (m_PipelineCache)
+	{
+		SavePipelineCache();
+		vkDestroyPipelineCache(
+			m_LogicalDevice,
+			m_PipelineCache,
+			nullptr);
+	}
+
+	if (m_ComputeShaderModule)
+		vkDestroyShaderModule(
+			m_LogicalDevice,
+			m_ComputeShaderModule,
+			nullptr);
+
+	for (const VkShaderModule shaderModule : { m_DoublePrecisionComputeShaderModule, m_PerturbationShaderModule, m_DoublePrecisionPerturbationShaderModule })
+		if (shaderModule)
+			vkDestroyShaderModule(
+				m_LogicalDevice,
+				shaderModule,
+				nullptr);
+
+	if (m_ComputePipelineLayout)
+		vkDestroyPipelineLayout(
+			m_LogicalDevice,
+			m_ComputePipelineLayout,
+			nullptr);
+
+	if (m_DescriptorSetLayout)
+		vkDestroyDescriptorSetLayout(
+			m_LogicalDevice,
+			m_DescriptorSetLayout,
+			nullptr);
+
+	if (m_DescriptorPool)
+		vkDestroyDescriptorPool(
+			m_LogicalDevice,
+			m_DescriptorPool,
+			nullptr);
+
+	if (m_ComputeCommandPool)
+		vkDestroyCommandPool(
+			m_LogicalDevice,
+			m_ComputeCommandPool,
+			nullptr);
+
+	if (m_TransferCommandPool)
+		vkDestroyCommandPool(
+			m_LogicalDevice,
+			m_TransferCommandPool,
+			nullptr);
+
+	vkDestroyDevice(
+		m_LogicalDevice,
+		nullptr);
+
+	vkDestroyInstance(
+		m_Instance,
+		nullptr);
+
+	m_LogicalDevice = VK_NULL_HANDLE;
+	m_Instance = VK_NULL_HANDLE;
+	return true;
+}
+
+bool OfflineRenderer::CreateInstance()
+{
+	VkApplicationInfo applicationInfo;
+	applicationInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	applicationInfo.applicationVersion = VK_MAKE_VERSION(0, 0, 1);
+	applicationInfo.pApplicationName = "Mandelbrot Offline Renderer";
+	applicationInfo.engineVersion = VK_MAKE_VERSION(0, 0, 1);
+	applicationInfo.pEngineName = "Good engine name";
+	applicationInfo.apiVersion = VK_API_VERSION_1_2;
+	applicationInfo.pNext = nullptr;
+
+	/* Verify availibility of instance layers (requested, not required) */
+	uint32_t instanceLayerCount = 0;
+	vkEnumerateInstanceLayerProperties(&instanceLayerCount, nullptr);
+	std::vector<VkLayerProperties> availableInstanceLayers(instanceLayerCount);
+	vkEnumerateInstanceLayerProperties(&instanceLayerCount, availableInstanceLayers.data());
+
+	std::vector<const char*> availableRequestedLayers;
+	for (const char* requestedLayer : Utilities::OfflineRequestedLayers)
+	{
+		bool found = false;
+		for (const VkLayerProperties& layerProperties : availableInstanceLayers)
+			if (strcmp(requestedLayer, layerProperties.layerName) == 0)
+			{
+				found = true;
+				break;
+			}
+
+		if (found)
+			availableRequestedLayers.push_back(requestedLayer);
+		else
+			printf("Failed to find a requested instance-level layer with given name: %s\n", requestedLayer);
+	}
+
+	VkInstanceCreateInfo instanceCreateInfo;
+	instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	instanceCreateInfo.pApplicationInfo = &applicationInfo;
+	instanceCreateInfo.enabledExtensionCount = 0;
+	instanceCreateInfo.ppEnabledExtensionNames = nullptr;
+	instanceCreateInfo.enabledLayerCount = static_cast<uint32_t>(availableRequestedLayers.size());
+	instanceCreateInfo.ppEnabledLayerNames = availableRequestedLayers.data();
+	instanceCreateInfo.flags = 0;
+	instanceCreateInfo.pNext = nullptr;
+
+	if (vkCreateInstance(&instanceCreateInfo, nullptr, &m_Instance) != VK_SUCCESS)
+	{
+		printf("Failed to initialize vulkan instance. Make sure a vulkan driver (or a software ICD such as lavapipe) is installed\n");
+		return false;
+	}
+
+	return true;
+}
+
+bool OfflineRenderer::CreateLogicalDevice()
+{
+	uint32_t physicalDeviceCount = 0;
+	VK_CHECK(vkEnumeratePhysicalDevices(m_Instance, &physicalDeviceCount, nullptr));
+	if (physicalDeviceCount == 0)
+	{
+		printf("Failed to find any vulkan capable device\n");
+		return false;
+	}
+
+	std::vector<VkPhysicalDevice> availablePhysicalDevices(physicalDeviceCount);
+	VK_CHECK(vkEnumeratePhysicalDevices(m_Instance, &physicalDeviceCount, availablePhysicalDevices.data()));
+
+	/* Prefer a discrete GPU, but anything with a compute queue will do (including CPU implementations) */
+	int32_t bestScore = -1;
+	for (const VkPhysicalDevice availablePhysicalDevice : availablePhysicalDevices)
+	{
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(availablePhysicalDevice, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(availablePhysicalDevice, &queueFamilyCount, queueFamilyProperties.data());
+
+		/* Dedicated compute family first, any compute capable family otherwise */
+		int32_t computeQueueIndex = -1;
+		for (uint32_t i = 0; i < queueFamilyCount; ++i)
+			if ((queueFamilyProperties[i].queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFamilyProperties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+			{
+				computeQueueIndex = i;
+				break;
+			}
+
+		if (computeQueueIndex == -1)
+			for (uint32_t i = 0; i < queueFamilyCount; ++i)
+				if (queueFamilyProperties[i].queueFlags & VK_QUEUE_COMPUTE_BIT)
+				{
+					computeQueueIndex = i;
+					break;
+				}
+
+		if (computeQueueIndex == -1)
+			continue;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(availablePhysicalDevice, &properties);
+
+		/* Tile stages are ordered with timeline semaphores (core in Vulkan 1.2) */
+		VkPhysicalDeviceHostQueryResetFeatures hostQueryResetFeatures{};
+		hostQueryResetFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES;
+		hostQueryResetFeatures.pNext = nullptr;
+
+		VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures{};
+		timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+		timelineSemaphoreFeatures.pNext = &hostQueryResetFeatures;
+
+		VkPhysicalDeviceFeatures2 features{};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &timelineSemaphoreFeatures;
+
+		if (properties.apiVersion >= VK_API_VERSION_1_2)
+			vkGetPhysicalDeviceFeatures2(availablePhysicalDevice, &features);
+
+		if (!timelineSemaphoreFeatures.timelineSemaphore)
+		{
+			printf("Skipping device without timeline semaphore support: %s\n", properties.deviceName);
+			continue;
+		}
+
+		int32_t score = 0;
+		switch (properties.deviceType)
+		{
+			case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: score = 3; break;
+			case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score = 2; break;
+			case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: score = 1; break;
+			default: score = 0; break;
+		}
+
+		if (score > bestScore)
+		{
+			bestScore = score;
+			m_PhysicalDevice = availablePhysicalDevice;
+			m_PhysicalDeviceProperties = properties;
+			m_ComputeQueueIndex = computeQueueIndex;
+			m_HostQueryResetSupported = hostQueryResetFeatures.hostQueryReset == VK_TRUE;
+			m_ShaderFloat64Supported = features.features.shaderFloat64 == VK_TRUE;
+		}
+	}
+
+	if (!m_PhysicalDevice)
+	{
+		printf("Failed to find a device with a compute queue\n");
+		return false;
+	}
+
+	vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &m_PhysicalDeviceMemoryProperties);
+	printf("Using device: %s\n", m_PhysicalDeviceProperties.deviceName);
+
+	/* A transfer-only family maps to the copy engines, so readback runs next to compute instead of between dispatches */
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, queueFamilyProperties.data());
+
+	m_TransferQueueIndex = m_ComputeQueueIndex;
+	for (uint32_t i = 0; i < queueFamilyCount; ++i)
+		if ((queueFamilyProperties[i].queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamilyProperties[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+		{
+			m_TransferQueueIndex = i;
+			break;
+		}
+
+	printf("Copying tiles on %s\n", m_TransferQueueIndex != m_ComputeQueueIndex ? "a dedicated transfer queue" : "the compute queue");
+	printf("Post-processing readback with %s on %u threads\n", Simd::GetLevelName(m_SimdLevel), m_ThreadPool.GetThreadCount());
+
+	constexpr float defaultQueuePriority = 1.0f;
+	std::vector<VkDeviceQueueCreateInfo> queueInfos;
+	for (const int32_t queueFamilyIndex : { m_ComputeQueueIndex, m_TransferQueueIndex })
+	{
+		if (!queueInfos.empty() && queueInfos.front().queueFamilyIndex == static_cast<uint32_t>(queueFamilyIndex))
+			continue;
+
+		VkDeviceQueueCreateInfo queueInfo{};
+		queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueInfo.queueFamilyIndex = queueFamilyIndex;
+		queueInfo.queueCount = 1;
+		queueInfo.pQueuePriorities = &defaultQueuePriority;
+		queueInfos.push_back(queueInfo);
+	}
+
+	/* Deep zooms switch to computeShaderDoublePrecision.spv, see EShaderPrecision */
+	VkPhysicalDeviceFeatures enabledFeatures = {};
+	enabledFeatures.shaderFloat64 = m_ShaderFloat64Supported ? VK_TRUE : VK_FALSE;
+
+	VkPhysicalDeviceHostQueryResetFeatures enabledHostQueryResetFeatures{};
+	enabledHostQueryResetFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES;
+	enabledHostQueryResetFeatures.hostQueryReset = m_HostQueryResetSupported ? VK_TRUE : VK_FALSE;
+	enabledHostQueryResetFeatures.pNext = nullptr;
+
+	VkPhysicalDeviceTimelineSemaphoreFeatures enabledTimelineSemaphoreFeatures{};
+	enabledTimelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+	enabledTimelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+	enabledTimelineSemaphoreFeatures.pNext = &enabledHostQueryResetFeatures;
+
+	/* Optional, lets ChooseTileSize() respect what other processes already use */
+	uint32_t deviceExtensionCount = 0;
+	VK_CHECK(vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &deviceExtensionCount, nullptr));
+	std::vector<VkExtensionProperties> availableDeviceExtensions(deviceExtensionCount);
+	VK_CHECK(vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &deviceExtensionCount, availableDeviceExtensions.data()));
+
+	std::vector<const char*> enabledDeviceExtensions;
+	for (const VkExtensionProperties& extensionProperties : availableDeviceExtensions)
+		if (strcmp(extensionProperties.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0 && m_PhysicalDeviceProperties.apiVersion >= VK_API_VERSION_1_1)
+		{
+			enabledDeviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+			m_MemoryBudgetSupported = true;
+		}
+
+	VkDeviceCreateInfo deviceCreateInfo;
+	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(enabledDeviceExtensions.size());
+	deviceCreateInfo.ppEnabledExtensionNames = enabledDeviceExtensions.data();
+	deviceCreateInfo.enabledLayerCount = 0;
+	deviceCreateInfo.ppEnabledLayerNames = nullptr;
+	deviceCreateInfo.pEnabledFeatures = &enabledFeatures;
+	deviceCreateInfo.pQueueCreateInfos = queueInfos.data();
+	deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueInfos.size());
+	deviceCreateInfo.flags = 0;
+	deviceCreateInfo.pNext = &enabledTimelineSemaphoreFeatures;
+
+	if (vkCreateDevice(
+		m_PhysicalDevice,
+		&deviceCreateInfo,
+		nullptr,
+		&m_LogicalDevice) != VK_SUCCESS)
+	{
+		printf("Failed to create vulkan logical device\n");
+		return false;
+	}
+
+	vkGetDeviceQueue(
+		m_LogicalDevice,
+		m_ComputeQueueIndex,
+		0,
+		&m_ComputeQueue);
+
+	VkCommandPoolCreateInfo computeCommandPoolCreateInfo;
+	computeCommandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	computeCommandPoolCreateInfo.queueFamilyIndex = m_ComputeQueueIndex;
+	computeCommandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	computeCommandPoolCreateInfo.pNext = nullptr;
+
+	VK_CHECK(vkCreateCommandPool(
+		m_LogicalDevice,
+		&computeCommandPoolCreateInfo,
+		nullptr,
+		&m_ComputeCommandPool));
+
+	vkGetDeviceQueue(
+		m_LogicalDevice,
+		m_TransferQueueIndex,
+		0,
+		&m_TransferQueue);
+
+	VkCommandPoolCreateInfo transferCommandPoolCreateInfo;
+	transferCommandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	transferCommandPoolCreateInfo.queueFamilyIndex = m_TransferQueueIndex;
+	transferCommandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	transferCommandPoolCreateInfo.pNext = nullptr;
+
+	VK_CHECK(vkCreateCommandPool(
+		m_LogicalDevice,
+		&transferCommandPoolCreateInfo,
+		nullptr,
+		&m_TransferCommandPool));
+
+	return true;
+}
+
+bool OfflineRenderer::CreateComputePipelineLayout()
+{
+	m_ComputeShaderModule = CreateShaderModule(m_Settings.ShaderDirectory + "computeShader.spv");
+	if (!m_ComputeShaderModule)
+	{
+		printf("Failed to create compute shader\n");
+		return false;
+	}
+
+	/* Optional, renders stay in float32 without it */
+	if (m_ShaderFloat64Supported)
+	{
+		m_DoublePrecisionComputeShaderModule = CreateShaderModule(m_Settings.ShaderDirectory + "computeShaderDoublePrecision.spv");
+		if (!m_DoublePrecisionComputeShaderModule)
+			printf("Failed to create double precision compute shader, rendering in single precision\n");
+	}
+
+	printf("Double precision shaders: %s\n", m_DoublePrecisionComputeShaderModule ? "available" : m_ShaderFloat64Supported ? "not loaded" : "no shaderFloat64 on this device");
+
+	/* Optional as well, deep zooms render on the CPU without them */
+	m_PerturbationShaderModule = CreateShaderModule(m_Settings.ShaderDirectory + "perturbationShader.spv");
+	if (m_ShaderFloat64Supported)
+		m_DoublePrecisionPerturbationShaderModule = CreateShaderModule(m_Settings.ShaderDirectory + "perturbationShaderDoublePrecision.spv");
+
+	printf("Perturbation shaders: float32 deltas %s, float64 deltas %s\n",
+		m_PerturbationShaderModule ? "available" : "not loaded", m_DoublePrecisionPerturbationShaderModule ? "available" : "not loaded");
+
+	VkDescriptorSetLayoutBinding outImageBufferBinding;
+	outImageBufferBinding.binding = 0;
+	outImageBufferBinding.descriptorCount = 1;
+	outImageBufferBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	outImageBufferBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	outImageBufferBinding.pImmutableSamplers = nullptr;
+
+	VkDescriptorSetLayoutBinding checkCountBufferBinding;
+	checkCountBufferBinding.binding = 1;
+	checkCountBufferBinding.descriptorCount = 1;
+	checkCountBufferBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	checkCountBufferBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	checkCountBufferBinding.pImmutableSamplers = nullptr;
+
+	/* Only used by perturbationShader.comp, written once a perturbation render uploads its reference */
+	VkDescriptorSetLayoutBinding referenceOrbitBufferBinding;
+	referenceOrbitBufferBinding.binding = 2;
+	referenceOrbitBufferBinding.descriptorCount = 1;
+	referenceOrbitBufferBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	referenceOrbitBufferBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	referenceOrbitBufferBinding.pImmutableSamplers = nullptr;
+
+	const std::array<VkDescriptorSetLayoutBinding, 3> bindings{ outImageBufferBinding, checkCountBufferBinding, referenceOrbitBufferBinding };
+	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo;
+	descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	descriptorSetLayoutCreateInfo.pBindings = bindings.data();
+	descriptorSetLayoutCreateInfo.flags = 0;
+	descriptorSetLayoutCreateInfo.pNext = nullptr;
+
+	if (vkCreateDescriptorSetLayout(
+		m_LogicalDevice,
+		&descriptorSetLayoutCreateInfo,
+		nullptr,
+		&m_DescriptorSetLayout) != VK_SUCCESS)
+	{
+		printf("Failed to create compute pipeline descriptor set layout\n");
+		return false;
+	}
+
+	VkPushConstantRange pushConstantRange;
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	/* Covers both blocks, the float32 shaders only read the first 32 bytes */
+	pushConstantRange.size = static_cast<uint32_t>(std::max(sizeof(PushConstants), sizeof(DoublePrecisionPushConstants)));
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo;
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+	pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+	pipelineLayoutCreateInfo.setLayoutCount = 1;
+	pipelineLayoutCreateInfo.pSetLayouts = &m_DescriptorSetLayout;
+	pipelineLayoutCreateInfo.flags = 0;
+	pipelineLayoutCreateInfo.pNext = nullptr;
+
+	if (vkCreatePipelineLayout(
+		m_LogicalDevice,
+		&pipelineLayoutCreateInfo,
+		nullptr,
+		&m_ComputePipelineLayout) != VK_SUCCESS)
+	{
+		printf("Failed to create compute pipeline layout\n");
+		return false;
+	}
+
+	VkDescriptorPoolSize storageBufferPoolSize;
+	storageBufferPoolSize.descriptorCount = ComputeSlotCount * 3;
+	storageBufferPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
+	const std::array<VkDescriptorPoolSize, 1> poolSizes{ storageBufferPoolSize };
+	VkDescriptorPoolCreateInfo descriptorPoolCreateInfo;
+	descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptorPoolCreateInfo.maxSets = ComputeSlotCount;
+	descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	descriptorPoolCreateInfo.pPoolSizes = poolSizes.data();
+	descriptorPoolCreateInfo.flags = 0;
+	descriptorPoolCreateInfo.pNext = nullptr;
+
+	VK_CHECK(vkCreateDescriptorPool(
+		m_LogicalDevice,
+		&descriptorPoolCreateInfo,
+		nullptr,
+		&m_DescriptorPool));
+
+	std::array<VkDescriptorSetLayout, ComputeSlotCount> descriptorSetLayouts;
+	descriptorSetLayouts.fill(m_DescriptorSetLayout);
+	std::array<VkDescriptorSet, ComputeSlotCount> descriptorSets;
+
+	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo;
+	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptorSetAllocateInfo.descriptorSetCount = ComputeSlotCount;
+	descriptorSetAllocateInfo.pSetLayouts = descriptorSetLayouts.data();
+	descriptorSetAllocateInfo.descriptorPool = m_DescriptorPool;
+	descriptorSetAllocateInfo.pNext = nullptr;
+
+	VK_CHECK(vkAllocateDescriptorSets(
+		m_LogicalDevice,
+		&descriptorSetAllocateInfo,
+		descriptorSets.data()));
+
+	for (uint32_t i = 0; i < ComputeSlotCount; ++i)
+		m_ComputeSlots[i].DescriptorSet = descriptorSets[i];
+
+	if (!CreateCheckCountBuffer())
+		return false;
+
+	LoadPipelineCache();
+	return true;
+}
+
+bool OfflineRenderer::CreateCheckCountBuffer()
+{
+	const VkDeviceSize size = 3 * sizeof(uint32_t);
+
+	/* A handful of atomics per workgroup, host-visible memory is fast enough and needs no readback copy */
+	if (!CreateBuffer(
+		size,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		false,
+		m_CheckCountBuffer))
+		return false;
+
+	void* mappedMemory;
+	VK_CHECK(vkMapMemory(
+		m_LogicalDevice,
+		m_CheckCountBuffer.DeviceMemory,
+		0,
+		size,
+		0,
+		&mappedMemory));
+	m_CheckCounts = static_cast<uint32_t*>(mappedMemory);
+
+	VkDescriptorBufferInfo bufferInfo;
+	bufferInfo.buffer = m_CheckCountBuffer.Handle;
+	bufferInfo.range = size;
+	bufferInfo.offset = 0;
+
+	for (const ComputeSlot& slot : m_ComputeSlots)
+	{
+		VkWriteDescriptorSet descriptorSetWrite;
+		descriptorSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptorSetWrite.dstBinding = 1;
+		descriptorSetWrite.dstArrayElement = 0;
+		descriptorSetWrite.descriptorCount = 1;
+		descriptorSetWrite.dstSet = slot.DescriptorSet;
+		descriptorSetWrite.pBufferInfo = &bufferInfo;
+		descriptorSetWrite.pImageInfo = nullptr;
+		descriptorSetWrite.pTexelBufferView = nullptr;
+		descriptorSetWrite.pNext = nullptr;
+
+		vkUpdateDescriptorSets(
+			m_LogicalDevice,
+			1,
+			&descriptorSetWrite,
+			0,
+			nullptr);
+	}
+
+	return true;
+}
+
+bool OfflineRenderer::CreateTileBuffers(const VkDeviceSize size)
+{
+	m_TileBufferSize = size;
+
+	for (ComputeSlot& slot : m_ComputeSlots)
+	{
+		/* Transfer destination for clearing the glitch mask */
+		if (!CreateBuffer(
+			m_TileBufferSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			true,
+			slot.StorageBuffer))
+			return false;
+
+		VkDescriptorBufferInfo bufferInfo;
+		bufferInfo.buffer = slot.StorageBuffer.Handle;
+		bufferInfo.range = m_TileBufferSize;
+		bufferInfo.offset = 0;
+
+		VkWriteDescriptorSet descriptorSetWrite;
+		descriptorSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptorSetWrite.dstBinding = 0;
+		descriptorSetWrite.dstArrayElement = 0;
+		descriptorSetWrite.descriptorCount = 1;
+		descriptorSetWrite.dstSet = slot.DescriptorSet;
+		descriptorSetWrite.pBufferInfo = &bufferInfo;
+		descriptorSetWrite.pImageInfo = nullptr;
+		descriptorSetWrite.pTexelBufferView = nullptr;
+		descriptorSetWrite.pNext = nullptr;
+
+		vkUpdateDescriptorSets(
+			m_LogicalDevice,
+			1,
+			&descriptorSetWrite,
+			0,
+			nullptr);
+	}
+
+	for (ReadbackSlot& slot : m_ReadbackSlots)
+	{
+		if (!CreateBuffer(
+			m_TileBufferSize,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			GetReadbackMemoryPropertyFlags(),
+			false,
+			slot.Buffer))
+			return false;
+
+		/* Stays mapped for the lifetime of the buffer */
+		VK_CHECK(vkMapMemory(
+			m_LogicalDevice,
+			slot.Buffer.DeviceMemory,
+			0,
+			m_TileBufferSize,
+			0,
+			&slot.MappedMemory));
+	}
+
+	return true;
+}
+
+void OfflineRenderer::DestroyTileBuffers()
+{
+	for (ComputeSlot& slot : m_ComputeSlots)
+		DestroyBuffer(slot.StorageBuffer);
+
+	for (ReadbackSlot& slot : m_ReadbackSlots)
+	{
+		DestroyBuffer(slot.Buffer);
+		slot.MappedMemory = nullptr;
+	}
+
+	m_TileBufferSize = 0;
+}
+
+bool OfflineRenderer::CreateBuffer(const VkDeviceSize size, const VkBufferUsageFlags usage, const VkMemoryPropertyFlags memoryPropertyFlags, const bool sharedWithTransferQueue, VulkanBuffer& buffer) const
+{
+	/* Concurrent sharing avoids queue family ownership transfers between the compute and transfer queue */
+	const std::array<uint32_t, 2> queueFamilyIndices{ static_cast<uint32_t>(m_ComputeQueueIndex), static_cast<uint32_t>(m_TransferQueueIndex) };
+	const bool concurrent = sharedWithTransferQueue && m_ComputeQueueIndex != m_TransferQueueIndex;
+
+	VkBufferCreateInfo bufferCreateInfo;
+	bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferCreateInfo.usage = usage;
+	bufferCreateInfo.size = size;
+	bufferCreateInfo.queueFamilyIndexCount = concurrent ? static_cast<uint32_t>(queueFamilyIndices.size()) : 0;
+	bufferCreateInfo.pQueueFamilyIndices = concurrent ? queueFamilyIndices.data() : nullptr;
+	bufferCreateInfo.sharingMode = concurrent ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+	bufferCreateInfo.flags = 0;
+	bufferCreateInfo.pNext = nullptr;
+
+	if (vkCreateBuffer(
+		m_LogicalDevice,
+		&bufferCreateInfo,
+		nullptr,
+		&buffer.Handle) != VK_SUCCESS)
+	{
+		printf("Failed to create a tile buffer of %llu bytes\n", static_cast<unsigned long long>(size));
+		return false;
+	}
+
+	VkMemoryRequirements memoryRequirements;
+	vkGetBufferMemoryRequirements(
+		m_LogicalDevice,
+		buffer.Handle,
+		&memoryRequirements);
+
+	VkMemoryAllocateInfo memoryAllocateInfo;
+	memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memoryAllocateInfo.allocationSize = memoryRequirements.size;
+	memoryAllocateInfo.memoryTypeIndex = RetrieveMemoryTypeIndex(memoryRequirements.memoryTypeBits, memoryPropertyFlags);
+	memoryAllocateInfo.pNext = nullptr;
+
+	if (vkAllocateMemory(
+		m_LogicalDevice,
+		&memoryAllocateInfo,
+		nullptr,
+		&buffer.DeviceMemory) != VK_SUCCESS)
+	{
+		printf("Failed to allocate %llu bytes of tile buffer memory\n", static_cast<unsigned long long>(memoryRequirements.size));
+		return false;
+	}
+
+	VK_CHECK(vkBindBufferMemory(
+		m_LogicalDevice,
+		buffer.Handle,
+		buffer.DeviceMemory,
+		0));
+
+	return true;
+}
+
+void OfflineRenderer::DestroyBuffer(VulkanBuffer& buffer) const
+{
+	if (buffer.Handle)
+		vkDestroyBuffer(
+			m_LogicalDevice,
+			buffer.Handle,
+			nullptr);
+
+	if (buffer.DeviceMemory)
+		vkFreeMemory(
+			m_LogicalDevice,
+			buffer.DeviceMemory,
+			nullptr);
+
+	buffer.Handle = VK_NULL_HANDLE;
+	buffer.DeviceMemory = VK_NULL_HANDLE;
+}
+
+uint32_t OfflineRenderer::ChooseTileSize(const std::size_t pixelSize) const
+{
+	if (m_Settings.TileSize != 0)
+		return Utilities::AlignToWorkgroupSize(m_Settings.TileSize);
+
+	/* Same memory types the tile buffers are allocated from, see CreateTileBuffers() */
+	const uint32_t deviceLocalTypeIndex = RetrieveMemoryTypeIndex(~0u, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	const uint32_t readbackTypeIndex = RetrieveMemoryTypeIndex(~0u, GetReadbackMemoryPropertyFlags());
+	const uint32_t deviceLocalHeapIndex = m_PhysicalDeviceMemoryProperties.memoryTypes[deviceLocalTypeIndex].heapIndex;
+	const uint32_t readbackHeapIndex = m_PhysicalDeviceMemoryProperties.memoryTypes[readbackTypeIndex].heapIndex;
+
+	/* Half of what is available is left to everyone else, the rest is shared by the slots living in that heap */
+	VkDeviceSize tileBufferSize;
+	if (deviceLocalHeapIndex == readbackHeapIndex)
+	{
+		constexpr uint32_t bufferCount = ComputeSlotCount + ReadbackSlotCount;
+		tileBufferSize = QueryAvailableMemory(deviceLocalTypeIndex, m_TileBufferSize * bufferCount) / 2 / bufferCount;
+	}
+	else
+		tileBufferSize = std::min(
+			QueryAvailableMemory(deviceLocalTypeIndex, m_TileBufferSize * ComputeSlotCount) / 2 / ComputeSlotCount,
+			QueryAvailableMemory(readbackTypeIndex, m_TileBufferSize * ReadbackSlotCount) / 2 / ReadbackSlotCount);
+
+	tileBufferSize = std::min<VkDeviceSize>(tileBufferSize, m_PhysicalDeviceProperties.limits.maxStorageBufferRange);
+	tileBufferSize = std::min<VkDeviceSize>(tileBufferSize, Utilities::MaxTileBufferSize);
+
+	uint32_t tileSize = static_cast<uint32_t>(sqrt(static_cast<double>(tileBufferSize / pixelSize)));
+	tileSize = std::min(tileSize, m_PhysicalDeviceProperties.limits.maxComputeWorkGroupCount[0] * Utilities::ComputeWorkgroupSize);
+	tileSize = std::min(tileSize, m_PhysicalDeviceProperties.limits.maxComputeWorkGroupCount[1] * Utilities::ComputeWorkgroupSize);
+	return tileSize / Utilities::ComputeWorkgroupSize * Utilities::ComputeWorkgroupSize;
+}
+
+VkDeviceSize OfflineRenderer::QueryAvailableMemory(const uint32_t memoryTypeIndex, const VkDeviceSize ownUsage) const
+{
+	const uint32_t heapIndex = m_PhysicalDeviceMemoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+	if (!m_MemoryBudgetSupported)
+		return m_PhysicalDeviceMemoryProperties.memoryHeaps[heapIndex].size;
+
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT memoryBudgetProperties{};
+	memoryBudgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+	memoryBudgetProperties.pNext = nullptr;
+
+	VkPhysicalDeviceMemoryProperties2 memoryProperties{};
+	memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+	memoryProperties.pNext = &memoryBudgetProperties;
+
+	vkGetPhysicalDeviceMemoryProperties2(m_PhysicalDevice, &memoryProperties);
+
+	const VkDeviceSize budget = memoryBudgetProperties.heapBudget[heapIndex];
+	const VkDeviceSize usage = memoryBudgetProperties.heapUsage[heapIndex] - std::min(ownUsage, memoryBudgetProperties.heapUsage[heapIndex]);
+	return budget > usage ? budget - usage : 0;
+}
+
+VkMemoryPropertyFlags OfflineRenderer::GetReadbackMemoryPropertyFlags() const
+{
+	constexpr VkMemoryPropertyFlags cachedMemoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+	if (HasMemoryType(~0u, cachedMemoryPropertyFlags))
+		return cachedMemoryPropertyFlags;
+
+	return VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+}
+
+bool OfflineRenderer::HasMemoryType(const uint32_t memoryTypeBits, const VkMemoryPropertyFlags memoryPropertyFlags) const
+{
+	for (uint32_t i = 0; i < m_PhysicalDeviceMemoryProperties.memoryTypeCount; ++i)
+		if ((memoryTypeBits & (1 << i)) && (m_PhysicalDeviceMemoryProperties.memoryTypes[i].propertyFlags & memoryPropertyFlags) == memoryPropertyFlags)
+			return true;
+
+	return false;
+}
+
+bool OfflineRenderer::UseDoublePrecision() const
+{
+	/* Float deltas run out of exponent rather than digits, so only the depth decides */
+	if (m_Perturbation)
+		return m_Settings.Precision == EShaderPrecision::Double || Perturbation::NeedsDoubleDeltas(m_Settings.Scale, m_Settings.Width);
+
+	if (m_Settings.Precision == EShaderPrecision::Single)
+		return false;
+
+	if (!SupportsDoublePrecision())
+	{
+		if (m_Settings.Precision == EShaderPrecision::Double)
+			printf("Double precision needs shaderFloat64 and computeShaderDoublePrecision.spv, rendering in single precision\n");
+
+		return false;
+	}
+
+	return m_Settings.Precision == EShaderPrecision::Double || Utilities::NeedsDoublePrecision(m_Settings);
+}
+
+bool OfflineRenderer::UsePerturbation() const
+{
+	if (m_Settings.Perturbation == EPerturbation::Auto)
+		return Perturbation::IsBeyondDoublePrecision(m_Settings.CenterX, m_Settings.CenterY, m_Settings.Scale, m_Settings.Width);
+
+	return m_Settings.Perturbation == EPerturbation::On;
+}
+
+VkShaderModule OfflineRenderer::GetShaderModule(const bool perturbation, const bool doublePrecision) const
+{
+	if (perturbation)
+		return doublePrecision ? m_DoublePrecisionPerturbationShaderModule : m_PerturbationShaderModule;
+
+	return doublePrecision ? m_DoublePrecisionComputeShaderModule : m_ComputeShaderModule;
+}
+
+VkPipeline OfflineRenderer::GetComputePipeline(const ComputePipelineKey& key)
+{
+	const auto cachedPipeline = m_ComputePipelines.find(key);
+	if (cachedPipeline != m_ComputePipelines.end())
+		return cachedPipeline->second;
+
+	/* Image size and iteration limit become compile-time constants of the variant, so the driver can fold and unroll them */
+	SpecializationConstants specializationConstants;
+	specializationConstants.Width = key.Width;
+	specializationConstants.Height = key.Height;
+	specializationConstants.MaxIterations = key.MaxIterations;
+
+	specializationConstants.TileWidth = key.TileWidth;
+	specializationConstants.TileHeight = key.TileHeight;
+	specializationConstants.OutputFormat = static_cast<uint32_t>(key.OutputFormat);
+
+	/* Disabled checks are compiled out of the variant */
+	specializationConstants.CardioidCheck = (key.InteriorCheckFlags & 1u) != 0 ? VK_TRUE : VK_FALSE;
+	specializationConstants.BulbCheck = (key.InteriorCheckFlags & 2u) != 0 ? VK_TRUE : VK_FALSE;
+	specializationConstants.PeriodicityCheck = (key.InteriorCheckFlags & 4u) != 0 ? VK_TRUE : VK_FALSE;
+	specializationConstants.PeriodicityTolerance = key.PeriodicityTolerance;
+
+	const std::array<VkSpecializationMapEntry, 10> specializationMapEntries{
+		VkSpecializationMapEntry{ 0, offsetof(SpecializationConstants, Width), sizeof(uint32_t) },
+		VkSpecializationMapEntry{ 1, offsetof(SpecializationConstants, Height), sizeof(uint32_t) },
+		VkSpecializationMapEntry{ 2, offsetof(SpecializationConstants, MaxIterations), sizeof(uint32_t) },
+		VkSpecializationMapEntry{ 3, offsetof(SpecializationConstants, TileWidth), sizeof(uint32_t) },
+		VkSpecializationMapEntry{ 4, offsetof(SpecializationConstants, TileHeight), sizeof(uint32_t) },
+		VkSpecializationMapEntry{ 5, offsetof(SpecializationConstants, OutputFormat), sizeof(uint32_t) },
+		VkSpecializationMapEntry{ 6, offsetof(SpecializationConstants, CardioidCheck), sizeof(VkBool32) },
+		VkSpecializationMapEntry{ 7, offsetof(SpecializationConstants, BulbCheck), sizeof(VkBool32) },
+		VkSpecializationMapEntry{ 8, offsetof(SpecializationConstants, PeriodicityCheck), sizeof(VkBool32) },
+		VkSpecializationMapEntry{ 9, offsetof(SpecializationConstants, PeriodicityTolerance), sizeof(float) },
+	};
+
+	VkSpecializationInfo specializationInfo;
+	specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationMapEntries.size());
+	specializationInfo.pMapEntries = specializationMapEntries.data();
+	specializationInfo.dataSize = sizeof(SpecializationConstants);
+	specializationInfo.pData = &specializationConstants;
+
+	VkPipelineShaderStageCreateInfo computeShaderStageInfo{};
+	computeShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	computeShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	computeShaderStageInfo.module = GetShaderModule(key.Perturbation, key.DoublePrecision);
+	computeShaderStageInfo.pName = "main";
+	computeShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
+	VkComputePipelineCreateInfo pipelineCreateInfo{};
+	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineCreateInfo.stage = computeShaderStageInfo;
+	pipelineCreateInfo.layout = m_ComputePipelineLayout;
+	pipelineCreateInfo.basePipelineIndex = 0;
+	pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+	pipelineCreateInfo.flags = 0;
+	pipelineCreateInfo.pNext = nullptr;
+
+	const double compileStartTime = Platform::GetAbsoluteTime();
+	VkPipeline pipeline;
+	if (vkCreateComputePipelines(
+		m_LogicalDevice,
+		m_PipelineCache,
+		1,
+		&pipelineCreateInfo,
+		nullptr,
+		&pipeline) != VK_SUCCESS)
+	{
+		printf("Failed to create compute pipeline\n");
+		return VK_NULL_HANDLE;
+	}
+
+	printf("Created compute pipeline variant %ux%u, %u iterations, %ux%u tiles, format %u, interior checks 0x%x, %s%s in %.3f s\n",
+		key.Width, key.Height, key.MaxIterations, key.TileWidth, key.TileHeight, static_cast<uint32_t>(key.OutputFormat), key.InteriorCheckFlags,
+		key.DoublePrecision ? "float64" : "float32", key.Perturbation ? " perturbation" : "",
+		Platform::GetAbsoluteTime() - compileStartTime);
+	m_ComputePipelines.emplace(key, pipeline);
+	return pipeline;
+}
+
+void OfflineRenderer::LoadPipelineCache()
+{
+	std::vector<char> initialData;
+	if (!m_Settings.PipelineCachePath.empty())
+	{
+		std::ifstream file(m_Settings.PipelineCachePath, std::ios::ate | std::ios::binary);
+		if (file.is_open())
+		{
+			initialData.resize(static_cast<std::size_t>(file.tellg()));
+			file.seekg(std::ios::beg);
+			file.read(initialData.data(), initialData.size());
+		}
+	}
+
+	VkPipelineCacheCreateInfo pipelineCacheCreateInfo;
+	pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	pipelineCacheCreateInfo.initialDataSize = initialData.size();
+	pipelineCacheCreateInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+	pipelineCacheCreateInfo.flags = 0;
+	pipelineCacheCreateInfo.pNext = nullptr;
+
+	/* The driver validates the header and ignores data written by another device or driver version */
+	if (vkCreatePipelineCache(m_LogicalDevice, &pipelineCacheCreateInfo, nullptr, &m_PipelineCache) != VK_SUCCESS)
+	{
+		pipelineCacheCreateInfo.initialDataSize = 0;
+		pipelineCacheCreateInfo.pInitialData = nullptr;
+		VK_CHECK(vkCreatePipelineCache(m_LogicalDevice, &pipelineCacheCreateInfo, nullptr, &m_PipelineCache));
+	}
+}
+
+void OfflineRenderer::SavePipelineCache() const
+{
+	if (m_Settings.PipelineCachePath.empty())
+		return;
+
+	std::size_t dataSize = 0;
+	VK_CHECK(vkGetPipelineCacheData(m_LogicalDevice, m_PipelineCache, &dataSize, nullptr));
+	std::vector<char> data(dataSize);
+	VK_CHECK(vkGetPipelineCacheData(m_LogicalDevice, m_PipelineCache, &dataSize, data.data()));
+
+	std::ofstream file(m_Settings.PipelineCachePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		printf("Failed to write pipeline cache: %s\n", m_Settings.PipelineCachePath.c_str());
+		return;
+	}
+
+	file.write(data.data(), dataSize);
+}
+
+bool OfflineRenderer::AllocateCommandBuffers()
+{
+	std::array<VkCommandBuffer, ComputeSlotCount> computeCommandBuffers;
+
+	VkCommandBufferAllocateInfo commandBufferAllocateInfo;
+	commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	commandBufferAllocateInfo.commandPool = m_ComputeCommandPool;
+	commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	commandBufferAllocateInfo.commandBufferCount = ComputeSlotCount;
+	commandBufferAllocateInfo.pNext = nullptr;
+
+	VK_CHECK(vkAllocateCommandBuffers(
+		m_LogicalDevice,
+		&commandBufferAllocateInfo,
+		computeCommandBuffers.data()));
+
+	for (uint32_t i = 0; i < ComputeSlotCount; ++i)
+		m_ComputeSlots[i].CommandBuffer = computeCommandBuffers[i];
+
+	std::array<VkCommandBuffer, ReadbackSlotCount> transferCommandBuffers;
+	commandBufferAllocateInfo.commandPool = m_TransferCommandPool;
+	commandBufferAllocateInfo.commandBufferCount = ReadbackSlotCount;
+
+	VK_CHECK(vkAllocateCommandBuffers(
+		m_LogicalDevice,
+		&commandBufferAllocateInfo,
+		transferCommandBuffers.data()));
+
+	for (uint32_t i = 0; i < ReadbackSlotCount; ++i)
+		m_ReadbackSlots[i].CommandBuffer = transferCommandBuffers[i];
+
+	return true;
+}
+
+bool OfflineRenderer::CreateSynchronizationObjects()
+{
+	VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo;
+	semaphoreTypeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	semaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	semaphoreTypeCreateInfo.initialValue = 0;
+	semaphoreTypeCreateInfo.pNext = nullptr;
+
+	VkSemaphoreCreateInfo semaphoreCreateInfo;
+	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreCreateInfo.flags = 0;
+	semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+
+	VK_CHECK(vkCreateSemaphore(
+		m_LogicalDevice,
+		&semaphoreCreateInfo,
+		nullptr,
+		&m_ComputeTimeline));
+
+	VK_CHECK(vkCreateSemaphore(
+		m_LogicalDevice,
+		&semaphoreCreateInfo,
+		nullptr,
+		&m_TransferTimeline));
+
+	/* Begin and end timestamp per readback slot, only where the queue family supports timestamps */
+	if (!m_HostQueryResetSupported)
+		return true;
+
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, queueFamilyProperties.data());
+
+	VkQueryPoolCreateInfo queryPoolCreateInfo;
+	queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolCreateInfo.queryCount = ReadbackSlotCount * 2;
+	queryPoolCreateInfo.pipelineStatistics = 0;
+	queryPoolCreateInfo.flags = 0;
+	queryPoolCreateInfo.pNext = nullptr;
+
+	if (queueFamilyProperties[m_ComputeQueueIndex].timestampValidBits != 0)
+		VK_CHECK(vkCreateQueryPool(
+			m_LogicalDevice,
+			&queryPoolCreateInfo,
+			nullptr,
+			&m_ComputeQueryPool));
+
+	if (queueFamilyProperties[m_TransferQueueIndex].timestampValidBits != 0)
+		VK_CHECK(vkCreateQueryPool(
+			m_LogicalDevice,
+			&queryPoolCreateInfo,
+			nullptr,
+			&m_TransferQueryPool));
+
+	return true;
+}
+
+bool OfflineRenderer::SubmitCompute(const uint64_t tileNumber, const TileRegion& region, VkPipeline pipeline)
+{
+	ComputeSlot& slot = m_ComputeSlots[tileNumber % ComputeSlotCount];
+	const uint32_t queryIndex = static_cast<uint32_t>(tileNumber % ReadbackSlotCount) * 2;
+
+	/* The tile that used this slot before has to be rendered (command buffer reuse) and copied out (target reuse) */
+	const uint64_t previousTileValue = tileNumber >= ComputeSlotCount ? tileNumber - ComputeSlotCount + 1 : 0;
+	if (!WaitForTimeline(m_ComputeTimeline, previousTileValue))
+		return false;
+
+	VkCommandBufferBeginInfo commandBufferBeginInfo;
+	commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	commandBufferBeginInfo.pInheritanceInfo = nullptr;
+	commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	commandBufferBeginInfo.pNext = nullptr;
+
+	VkCommandBuffer commandBuffer = slot.CommandBuffer;
+	VK_CHECK(vkBeginCommandBuffer(
+		commandBuffer,
+		&commandBufferBeginInfo));
+
+	/* The queries were last used by the tile ReadbackSlotCount before, which was already consumed */
+	if (m_ComputeQueryPool)
+	{
+		vkResetQueryPool(m_LogicalDevice, m_ComputeQueryPool, queryIndex, 2);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_ComputeQueryPool, queryIndex);
+	}
+
+	/* Shaders only ever set glitch bits, the previous tile's are cleared first */
+	if (m_Perturbation)
+	{
+		vkCmdFillBuffer(
+			commandBuffer,
+			slot.StorageBuffer.Handle,
+			m_GlitchMaskOffset,
+			m_GlitchMaskSize,
+			0);
+
+		VkMemoryBarrier clearBarrier;
+		clearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		clearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		clearBarrier.pNext = nullptr;
+
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			1,
+			&clearBarrier,
+			0,
+			nullptr,
+			0,
+			nullptr);
+	}
+
+	vkCmdBindPipeline(
+		commandBuffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		pipeline);
+
+	vkCmdBindDescriptorSets(
+		commandBuffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		m_ComputePipelineLayout,
+		0,
+		1,
+		&slot.DescriptorSet,
+		0,
+		nullptr);
+
+	/* Perturbation shaders get the view center relative to the reference, so pixels come out as their difference to it */
+	const double centerX = m_Perturbation ? -m_MainReference.OffsetX : m_Settings.CenterX;
+	const double centerY = m_Perturbation ? -m_MainReference.OffsetY : m_Settings.CenterY;
+	const uint32_t referenceLength = m_Perturbation ? m_MainReference.GetLength() : 0;
+	const uint32_t skipIterations = m_Perturbation ? m_Series.SkipIterations : 0;
+	const double inverseSeriesRadius = skipIterations != 0 ? 1.0 / m_Series.Radius : 0.0;
+	if (m_DoublePrecision)
+	{
+		DoublePrecisionPushConstants pushConstants;
+		pushConstants.CenterX = centerX;
+		pushConstants.CenterY = centerY;
+		pushConstants.TileOffsetX = region.X;
+		pushConstants.TileOffsetY = region.Y;
+		pushConstants.Scale = m_Settings.Scale;
+		pushConstants.ReferenceLength = referenceLength;
+		pushConstants.SkipIterations = skipIterations;
+		pushConstants.InverseSeriesRadius = inverseSeriesRadius;
+
+		vkCmdPushConstants(
+			commandBuffer,
+			m_ComputePipelineLayout,
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			sizeof(DoublePrecisionPushConstants),
+			&pushConstants);
+	}
+	else
+	{
+		PushConstants pushConstants;
+		pushConstants.CenterX = static_cast<float>(centerX);
+		pushConstants.CenterY = static_cast<float>(centerY);
+		pushConstants.TileOffsetX = region.X;
+		pushConstants.TileOffsetY = region.Y;
+		pushConstants.Scale = static_cast<float>(m_Settings.Scale);
+		pushConstants.ReferenceLength = referenceLength;
+		pushConstants.SkipIterations = skipIterations;
+		pushConstants.InverseSeriesRadius = static_cast<float>(inverseSeriesRadius);
+
+		vkCmdPushConstants(
+			commandBuffer,
+			m_ComputePipelineLayout,
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			sizeof(PushConstants),
+			&pushConstants);
+	}
+
+	/* Smooth iteration invocations produce two pixels each (one packHalf2x16 word) */
+	const uint32_t pixelsPerInvocation = m_Settings.OutputFormat == EOutputFormat::SmoothIterations ? 2 : 1;
+	const uint32_t invocationCountX = (region.Width + pixelsPerInvocation - 1) / pixelsPerInvocation;
+
+	vkCmdDispatch(
+		commandBuffer,
+		(invocationCountX + Utilities::ComputeWorkgroupSize - 1) / Utilities::ComputeWorkgroupSize,
+		(region.Height + Utilities::ComputeWorkgroupSize - 1) / Utilities::ComputeWorkgroupSize,
+		1);
+
+	/* Semaphores do not make shader writes visible to the host, the check counters are read after the render */
+	VkMemoryBarrier checkCountBarrier;
+	checkCountBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	checkCountBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	checkCountBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	checkCountBarrier.pNext = nullptr;
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT,
+		0,
+		1,
+		&checkCountBarrier,
+		0,
+		nullptr,
+		0,
+		nullptr);
+
+	if (m_ComputeQueryPool)
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_ComputeQueryPool, queryIndex + 1);
+
+	VK_CHECK(vkEndCommandBuffer(commandBuffer));
+
+	/* Signal and wait are full memory dependencies, the transfer queue sees the shader writes without a barrier */
+	const uint64_t signalValue = tileNumber + 1;
+	VkTimelineSemaphoreSubmitInfo timelineSubmitInfo;
+	timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineSubmitInfo.waitSemaphoreValueCount = 1;
+	timelineSubmitInfo.pWaitSemaphoreValues = &previousTileValue;
+	timelineSubmitInfo.signalSemaphoreValueCount = 1;
+	timelineSubmitInfo.pSignalSemaphoreValues = &signalValue;
+	timelineSubmitInfo.pNext = nullptr;
+
+	/* The glitch mask clear is a transfer write to the target as well */
+	const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	VkSubmitInfo submitInfo;
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.waitSemaphoreCount = 1;
+	submitInfo.pWaitSemaphores = &m_TransferTimeline;
+	submitInfo.pWaitDstStageMask = &waitStage;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &m_ComputeTimeline;
+	submitInfo.pNext = &timelineSubmitInfo;
+
+	if (vkQueueSubmit(m_ComputeQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+	{
+		printf("Failed to submit tile %llu to the compute queue\n", static_cast<unsigned long long>(tileNumber));
+		return false;
+	}
+
+	return true;
+}
+
+bool OfflineRenderer::SubmitReadback(const uint64_t tileNumber, const TileRegion& region)
+{
+	ReadbackSlot& slot = m_ReadbackSlots[tileNumber % ReadbackSlotCount];
+	const ComputeSlot& source = m_ComputeSlots[tileNumber % ComputeSlotCount];
+	const uint32_t queryIndex = static_cast<uint32_t>(tileNumber % ReadbackSlotCount) * 2;
+	slot.Region = region;
+
+	VkCommandBufferBeginInfo commandBufferBeginInfo;
+	commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	commandBufferBeginInfo.pInheritanceInfo = nullptr;
+	commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	commandBufferBeginInfo.pNext = nullptr;
+
+	VkCommandBuffer commandBuffer = slot.CommandBuffer;
+	VK_CHECK(vkBeginCommandBuffer(
+		commandBuffer,
+		&commandBufferBeginInfo));
+
+	if (m_TransferQueryPool)
+	{
+		vkResetQueryPool(m_LogicalDevice, m_TransferQueryPool, queryIndex, 2);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_TransferQueryPool, queryIndex);
+	}
+
+	/* Only the rows the tile covers, tiles at the bottom edge are shorter. The glitch mask sits at the same offset in both buffers */
+	std::array<VkBufferCopy, 2> copyRegions;
+	copyRegions[0].srcOffset = 0;
+	copyRegions[0].dstOffset = 0;
+	copyRegions[0].size = static_cast<VkDeviceSize>(region.Height) * m_TileWidth * Utilities::GetOutputPixelSize(m_Settings.OutputFormat);
+	copyRegions[1].srcOffset = m_GlitchMaskOffset;
+	copyRegions[1].dstOffset = m_GlitchMaskOffset;
+	copyRegions[1].size = m_GlitchMaskSize;
+
+	vkCmdCopyBuffer(
+		commandBuffer,
+		source.StorageBuffer.Handle,
+		slot.Buffer.Handle,
+		m_Perturbation ? 2 : 1,
+		copyRegions.data());
+
+	VkMemoryBarrier memoryBarrier;
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	memoryBarrier.pNext = nullptr;
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT,
+		0,
+		1,
+		&memoryBarrier,
+		0,
+		nullptr,
+		0,
+		nullptr);
+
+	if (m_TransferQueryPool)
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_TransferQueryPool, queryIndex + 1);
+
+	VK_CHECK(vkEndCommandBuffer(commandBuffer));
+
+	const uint64_t waitValue = tileNumber + 1;
+	const uint64_t signalValue = tileNumber + 1;
+	VkTimelineSemaphoreSubmitInfo timelineSubmitInfo;
+	timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineSubmitInfo.waitSemaphoreValueCount = 1;
+	timelineSubmitInfo.pWaitSemaphoreValues = &waitValue;
+	timelineSubmitInfo.signalSemaphoreValueCount = 1;
+	timelineSubmitInfo.pSignalSemaphoreValues = &signalValue;
+	timelineSubmitInfo.pNext = nullptr;
+
+	const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	VkSubmitInfo submitInfo;
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.waitSemaphoreCount = 1;
+	submitInfo.pWaitSemaphores = &m_ComputeTimeline;
+	submitInfo.pWaitDstStageMask = &waitStage;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &m_TransferTimeline;
+	submitInfo.pNext = &timelineSubmitInfo;
+
+	if (vkQueueSubmit(m_TransferQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+	{
+		printf("Failed to submit tile %llu to the transfer queue\n", static_cast<unsigned long long>(tileNumber));
+		return false;
+	}
+
+	return true;
+}
+
+bool OfflineRenderer::WaitForTimeline(VkSemaphore timeline, const uint64_t value)
+{
+	if (value == 0)
+		return true;
+
+	VkSemaphoreWaitInfo semaphoreWaitInfo;
+	semaphoreWaitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	semaphoreWaitInfo.flags = 0;
+	semaphoreWaitInfo.semaphoreCount = 1;
+	semaphoreWaitInfo.pSemaphores = &timeline;
+	semaphoreWaitInfo.pValues = &value;
+	semaphoreWaitInfo.pNext = nullptr;
+
+	if (vkWaitSemaphores(m_LogicalDevice, &semaphoreWaitInfo, UINT64_MAX) != VK_SUCCESS)
+	{
+		printf("Failed to wait for a timeline semaphore\n");
+		return false;
+	}
+
+	return true;
+}
+
+bool OfflineRenderer::ConsumeTile(const uint64_t tileNumber, ImageWriter& writer)
+{
+	ReadbackSlot& slot = m_ReadbackSlots[tileNumber % ReadbackSlotCount];
+	const uint32_t queryIndex = static_cast<uint32_t>(tileNumber % ReadbackSlotCount) * 2;
+
+	const double waitStartTime = Platform::GetAbsoluteTime();
+	if (!WaitForTimeline(m_TransferTimeline, tileNumber + 1))
+		return false;
+
+	const double hostStartTime = Platform::GetAbsoluteTime();
+	m_Timings.HostWaitTime += hostStartTime - waitStartTime;
+
+	/* Required for HOST_CACHED memory without HOST_COHERENT, a no-op otherwise */
+	VkMappedMemoryRange mappedMemoryRange;
+	mappedMemoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	mappedMemoryRange.memory = slot.Buffer.DeviceMemory;
+	mappedMemoryRange.offset = 0;
+	mappedMemoryRange.size = VK_WHOLE_SIZE;
+	mappedMemoryRange.pNext = nullptr;
+
+	VK_CHECK(vkInvalidateMappedMemoryRanges(
+		m_LogicalDevice,
+		1,
+		&mappedMemoryRange));
+
+	/* Both command buffers of this tile are complete, so the results are available */
+	const double nanosecondsToSeconds = static_cast<double>(m_PhysicalDeviceProperties.limits.timestampPeriod) * 1.0e-9;
+	std::array<uint64_t, 2> timestamps;
+	if (m_ComputeQueryPool && vkGetQueryPoolResults(m_LogicalDevice, m_ComputeQueryPool, queryIndex, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+		m_Timings.ComputeTime += static_cast<double>(timestamps[1] - timestamps[0]) * nanosecondsToSeconds;
+
+	if (m_TransferQueryPool && vkGetQueryPoolResults(m_LogicalDevice, m_TransferQueryPool, queryIndex, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+		m_Timings.CopyTime += static_cast<double>(timestamps[1] - timestamps[0]) * nanosecondsToSeconds;
+
+	if (m_Settings.VerifyWithCpu && !m_DoublePrecision && !m_Perturbation)
+		VerifyTile(slot.MappedMemory, slot.Region);
+
+	/* Glitched pixels of the tile are iterated again on the CPU before it goes out */
+	if (m_Perturbation)
+	{
+		const uint32_t* glitchMask = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(slot.MappedMemory) + m_GlitchMaskOffset);
+		m_GlitchedPixels.clear();
+		const uint32_t wordCount = static_cast<uint32_t>(m_GlitchMaskSize / sizeof(uint32_t));
+		for (uint32_t word = 0; word < wordCount; ++word)
+		{
+			if (glitchMask[word] == 0)
+				continue;
+
+			for (uint32_t bit = 0; bit < 32; ++bit)
+			{
+				/* The shaders skip pixels outside the image, edge tiles only flag the part of the region */
+				if (glitchMask[word] & (1u << bit))
+					m_GlitchedPixels.push_back(word * 32 + bit);
+			}
+		}
+
+		CorrectGlitches(slot.MappedMemory, slot.Region);
+	}
+
+	const bool written = WriteTile(slot.MappedMemory, slot.Region, writer);
+	m_Timings.HostTime += Platform::GetAbsoluteTime() - hostStartTime;
+	return written;
+}
+
+bool OfflineRenderer::WriteTile(const void* tile, const TileRegion& region, ImageWriter& writer)
+{
+	/* Rows in the tile buffer are m_TileWidth pixels apart, edge tiles only fill part of each row */
+	if (m_Settings.OutputFormat == EOutputFormat::RGBA8)
+		return writer.WriteTile(region.X, region.Y, region.Width, region.Height, static_cast<const uint8_t*>(tile), static_cast<std::size_t>(m_TileWidth) * 4);
+
+	const std::size_t sourcePitch = static_cast<std::size_t>(m_TileWidth) * Utilities::GetOutputPixelSize(m_Settings.OutputFormat);
+	const std::size_t rowPitch = static_cast<std::size_t>(region.Width) * 4;
+	switch (m_Settings.OutputFormat)
+	{
+		case EOutputFormat::Iterations:
+			PostProcess::ColorIterations(
+				static_cast<const uint32_t*>(tile), sourcePitch, m_TileImage.data(), rowPitch,
+				region.Width, region.Height, m_Settings.MaxIterations, m_Settings.Coloring, m_ThreadPool);
+			break;
+		case EOutputFormat::SmoothIterations:
+			if (m_EscapeTimeWriter.IsOpen() && !m_EscapeTimeWriter.WriteTile(region.X, region.Y, region.Width, region.Height, static_cast<const uint16_t*>(tile), sourcePitch))
+				return false;
+
+			PostProcess::ColorSmoothIterations(
+				static_cast<const uint16_t*>(tile), sourcePitch, m_TileImage.data(), rowPitch,
+				region.Width, region.Height, m_Settings.MaxIterations, m_Settings.Coloring, m_ThreadPool);
+			break;
+		case EOutputFormat::LinearFloat:
+			PostProcess::ConvertFloatToRGBA8(
+				static_cast<const float*>(tile), sourcePitch, m_TileImage.data(), rowPitch,
+				region.Width, region.Height, region.X, region.Y, m_Settings.Conversion, m_ThreadPool, m_SimdLevel);
+			break;
+		default:
+			assert(false);
+			return false;
+	}
+
+	return writer.WriteTile(region.X, region.Y, region.Width, region.Height, m_TileImage.data(), rowPitch);
+}
+
+void OfflineRenderer::VerifyTile(const void* tile, const TileRegion& region)
+{
+	/* The reference iterates every pixel, subdivision could hide a device error behind a filled rectangle */
+	OfflineRenderSettings referenceSettings = m_Settings;
+	referenceSettings.Subdivision.Enabled = false;
+	m_CpuRenderer.RenderTile(referenceSettings, region, m_CpuTile.data(), m_TileWidth);
+
+	/*
+	* The device may fuse multiply-adds and approximates cos() and log2(), so the palette formats allow
+	* one RGBA8 step (or 1 / 255) and smooth iterations 1e-2. Escape iterations have to match exactly,
+	* orbits on the edge of escaping still differ then.
+	*/
+	uint64_t mismatchedPixelCount = 0;
+	for (uint32_t row = 0; row < region.Height; ++row)
+	{
+		const std::size_t rowOffset = static_cast<std::size_t>(row) * m_TileWidth;
+		for (uint32_t x = 0; x < region.Width; ++x)
+		{
+			const std::size_t pixel = rowOffset + x;
+			bool matches = true;
+			switch (m_Settings.OutputFormat)
+			{
+				case EOutputFormat::RGBA8:
+					for (uint32_t channel = 0; channel < 4; ++channel)
+						matches = matches && abs(static_cast<const uint8_t*>(tile)[pixel * 4 + channel] - m_CpuTile[pixel * 4 + channel]) <= 1;
+					break;
+				case EOutputFormat::Iterations:
+					matches = static_cast<const uint32_t*>(tile)[pixel] == reinterpret_cast<const uint32_t*>(m_CpuTile.data())[pixel];
+					break;
+				case EOutputFormat::SmoothIterations:
+					matches = fabsf(glm::unpackHalf1x16(static_cast<const uint16_t*>(tile)[pixel]) - glm::unpackHalf1x16(reinterpret_cast<const uint16_t*>(m_CpuTile.data())[pixel])) <= 1.0e-2f;
+					break;
+				case EOutputFormat::LinearFloat:
+					for (uint32_t channel = 0; channel < 4; ++channel)
+						matches = matches && fabsf(static_cast<const float*>(tile)[pixel * 4 + channel] - reinterpret_cast<const float*>(m_CpuTile.data())[pixel * 4 + channel]) <= 1.0f / 255.0f;
+					break;
+			}
+
+			mismatchedPixelCount += matches ? 0 : 1;
+		}
+	}
+
+	m_VerifiedPixelCount += static_cast<uint64_t>(region.Width) * region.Height;
+	m_MismatchedPixelCount += mismatchedPixelCount;
+}
+
+VkShaderModule OfflineRenderer::CreateShaderModule(const std::string_view filepath) const
+{
+	std::ifstream file(filepath.data(), std::ios::ate | std::ios::binary);
+	if (!file.is_open())
+	{
+		printf("Failed to open file with given filepath: %s\n", filepath.data());
+		return VK_NULL_HANDLE;
+	}
+
+	const uint64_t fileSize = file.tellg();
+	std::vector<uint32_t> code((fileSize + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+	file.seekg(std::ios::beg);
+	file.read(reinterpret_cast<char*>(code.data()), fileSize);
+	file.close();
+
+	VkShaderModuleCreateInfo shaderModuleCreateInfo;
+	shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	shaderModuleCreateInfo.codeSize = static_cast<std::size_t>(fileSize);
+	shaderModuleCreateInfo.pCode = code.data();
+	shaderModuleCreateInfo.flags = 0;
+	shaderModuleCreateInfo.pNext = nullptr;
+
+	VkShaderModule module;
+	if (vkCreateShaderModule(
+		m_LogicalDevice,
+		&shaderModuleCreateInfo,
+		nullptr,
+		&module) != VK_SUCCESS)
+	{
+		printf("Failed to create shader module from given filepath: %s\n", filepath.data());
+		return VK_NULL_HANDLE;
+	}
+
+	return module;
+}
+
+uint32_t OfflineRenderer::RetrieveMemoryTypeIndex(const uint32_t memoryTypeBits, const VkMemoryPropertyFlags memoryPropertyFlags) const
+{
+	for (uint32_t i = 0; i < m_PhysicalDeviceMemoryProperties.memoryTypeCount; ++i)
+		if ((memoryTypeBits & (1 << i)) && (m_PhysicalDeviceMemoryProperties.memoryTypes[i].propertyFlags & memoryPropertyFlags) == memoryPropertyFlags)
+			return i;
+
+	assert(false);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "include/OrbitCache.h"
+#include "include/MappedFile.h"
+#include "include/Perturbation.h"
+
+namespace Utilities {
+	/* FNV-1a, only has to spread center texts over file names */
+	INTERNALSCOPE uint64_t HashText(const std::string& text)
+	{
+		uint64_t hash = 0xCBF29CE484222325ull;
+		for (const char character : text)
+		{
+			hash ^= static_cast<uint8_t>(character);
+			hash *= 0x100000001B3ull;
+		}
+
+		return hash;
+	}
+
+	INTERNALSCOPE uint64_t GetPointsOffset(const uint32_t centerSize)
+	{
+		return (sizeof(OrbitCache::FileHeader) + centerSize + 7) & ~7ull;
+	}
+}
+
+namespace OrbitCache {
+	std::string GetFilePath(const std::string& directory, const std::string& center, const uint32_t fractionBits, const uint32_t maxIterations)
+	{
+		std::array<char, 64> filename;
+		snprintf(filename.data(), filename.size(), "orbit-%016llx-%u-%u.bin",
+			static_cast<unsigned long long>(Utilities::HashText(center)), fractionBits, maxIterations);
+		return (std::filesystem::path(directory) / filename.data()).string();
+	}
+
+	bool Load(const std::string& filepath, const std::string& center, const uint32_t fractionBits, const uint32_t maxIterations, ReferenceOrbit& reference)
+	{
+		MappedFile file;
+		if (!file.OpenForReading(filepath) || file.GetSize() < sizeof(FileHeader))
+			return false;
+
+		FileHeader header;
+		memcpy(&header, file.GetData(), sizeof(header));
+		if (memcmp(header.Magic, FileMagic, sizeof(header.Magic)) != 0 ||
+			header.FractionBits != fractionBits ||
+			header.MaxIterations != maxIterations ||
+			header.Length > maxIterations ||
+			header.CenterSize != center.size())
+			return false;
+
+		const uint64_t pointsOffset = Utilities::GetPointsOffset(header.CenterSize);
+		const uint64_t valueCount = (static_cast<uint64_t>(header.Length) + 1) * 2;
+		if (file.GetSize() < pointsOffset + valueCount * sizeof(double) ||
+			memcmp(file.GetData() + sizeof(header), center.data(), center.size()) != 0)
+			return false;
+
+		reference.OffsetX = header.OffsetX;
+		reference.OffsetY = header.OffsetY;
+		reference.Points.resize(static_cast<std::size_t>(valueCount));
+		memcpy(reference.Points.data(), file.GetData() + pointsOffset, static_cast<std::size_t>(valueCount) * sizeof(double));
+		return true;
+	}
+
+	bool Store(const std::string& filepath, const std::string& center, const uint32_t fractionBits, const uint32_t maxIterations, const ReferenceOrbit& reference)
+	{
+		std::error_code error;
+		const std::filesystem::path directory = std::filesystem::path(filepath).parent_path();
+		if (!directory.empty())
+			std::filesystem::create_directories(directory, error);
+
+		FileHeader header;
+		memcpy(header.Magic, FileMagic, sizeof(header.Magic));
+		header.FractionBits = fractionBits;
+		header.MaxIterations = maxIterations;
+		header.Length = reference.GetLength();
+		header.CenterSize = static_cast<uint32_t>(center.size());
+		header.OffsetX = reference.OffsetX;
+		header.OffsetY = reference.OffsetY;
+
+		const uint64_t pointsOffset = Utilities::GetPointsOffset(header.CenterSize);
+		const uint64_t pointsSize = reference.Points.size() * sizeof(double);
+		/* Written aside and renamed over the key's file, a render that dies halfway leaves no truncated orbit behind */
+		const std::string temporaryPath = filepath + ".tmp";
+		MappedFile file;
+		if (!file.Create(temporaryPath, pointsOffset + pointsSize))
+		{
+			printf("Failed to create orbit cache file: %s\n", temporaryPath.c_str());
+			return false;
+		}
+
+		uint8_t* data = file.GetWritableData();
+		memcpy(data, &header, sizeof(header));
+		memcpy(data + sizeof(header), center.data(), center.size());
+		memset(data + sizeof(header) + center.size(), 0, static_cast<std::size_t>(pointsOffset - sizeof(header) - center.size()));
+		memcpy(data + pointsOffset, reference.Points.data(), static_cast<std::size_t>(pointsSize));
+		if (!file.Close())
+		{
+			printf("Failed to write orbit cache file: %s\n", temporaryPath.c_str());
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+
+		std::filesystem::rename(temporaryPath, filepath, error);
+		if (error)
+		{
+			printf("Failed to replace orbit cache file: %s\n", filepath.c_str());
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+
+		return true;
+	}
+}
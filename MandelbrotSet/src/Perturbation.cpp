@@ -0,0 +1,342 @@
+#include "include/Perturbation.h"
+#include <algorithm>
+#include <atomic>
+#include <float.h>
+#include <math.h>
+#include <memory>
+#include <thread>
+
+namespace Utilities {
+	/*
+	* Squares x and y on two helper threads while the caller computes the product of an iteration.
+	* The helpers spin between iterations, a condition variable would take as long to wake them as
+	* the squares take at these precisions.
+	*/
+	class ParallelSquares
+	{
+	public:
+		ParallelSquares(const BigFixed& x, const BigFixed& y, BigFixed& squareX, BigFixed& squareY)
+			:
+			m_Generation(0),
+			m_DoneCount(0),
+			m_Stop(false)
+		{
+			m_Threads[0] = std::thread([this, &x, &squareX]() { Run(x, squareX); });
+			m_Threads[1] = std::thread([this, &y, &squareY]() { Run(y, squareY); });
+		}
+
+		~ParallelSquares()
+		{
+			m_Stop.store(true, std::memory_order_release);
+			for (std::thread& thread : m_Threads)
+				thread.join();
+		}
+
+		ParallelSquares(const ParallelSquares&) = delete;
+		ParallelSquares& operator=(const ParallelSquares&) = delete;
+
+		/* Squares the current x and y, neither may change before Wait returns */
+		void Start()
+		{
+			m_Generation.fetch_add(1, std::memory_order_release);
+		}
+
+		void Wait()
+		{
+			const uint64_t target = m_Generation.load(std::memory_order_relaxed) * 2;
+			for (uint32_t spin = 0; m_DoneCount.load(std::memory_order_acquire) != target; ++spin)
+				if (spin > 1024)
+					std::this_thread::yield();
+		}
+	private:
+		void Run(const BigFixed& value, BigFixed& square)
+		{
+			uint64_t generation = 0;
+			for (;;)
+			{
+				for (uint32_t spin = 0; m_Generation.load(std::memory_order_acquire) == generation; ++spin)
+				{
+					if (m_Stop.load(std::memory_order_acquire))
+						return;
+
+					if (spin > 1024)
+						std::this_thread::yield();
+				}
+
+				++generation;
+				BigFixed::Square(value, square);
+				m_DoneCount.fetch_add(1, std::memory_order_release);
+			}
+		}
+	private:
+		std::array<std::thread, 2> m_Threads;
+		std::atomic<uint64_t> m_Generation;
+		std::atomic<uint64_t> m_DoneCount;
+		std::atomic<bool> m_Stop;
+	};
+}
+
+namespace Perturbation {
+	uint32_t GetFractionBits(const double scale, const uint32_t width)
+	{
+		const double pixelSpacing = scale / static_cast<double>(width);
+		return std::max(64u, static_cast<uint32_t>(ceil(-log2(pixelSpacing))) + 64u);
+	}
+
+	bool IsBeyondDoublePrecision(const double centerX, const double centerY, const double scale, const uint32_t width)
+	{
+		const double magnitude = std::max(fabs(centerX), fabs(centerY)) + scale;
+		const double pixelSpacing = scale / static_cast<double>(width);
+		return pixelSpacing < magnitude * DBL_EPSILON * 256.0;
+	}
+
+	bool NeedsDoubleDeltas(const double scale, const uint32_t width)
+	{
+		return scale / static_cast<double>(width) < 1.0e-30;
+	}
+
+	ReferenceOrbit ComputeReferenceOrbit(const PerturbationView& view, const double offsetX, const double offsetY)
+	{
+		const uint32_t fractionBits = view.CenterX.GetFractionBits();
+		const BigFixed cx = view.CenterX + BigFixed::FromDouble(offsetX, fractionBits);
+		const BigFixed cy = view.CenterY + BigFixed::FromDouble(offsetY, fractionBits);
+
+		ReferenceOrbit reference;
+		reference.OffsetX = offsetX;
+		reference.OffsetY = offsetY;
+		reference.Points.reserve(static_cast<std::size_t>(view.MaxIterations + 1) * 2);
+		reference.Points.push_back(0.0);
+		reference.Points.push_back(0.0);
+
+		BigFixed zx(fractionBits);
+		BigFixed zy(fractionBits);
+		BigFixed squareX(fractionBits);
+		BigFixed squareY(fractionBits);
+		BigFixed product(fractionBits);
+		std::unique_ptr<Utilities::ParallelSquares> parallelSquares;
+		if (zx.GetLimbCount() >= ParallelLimbThreshold && std::thread::hardware_concurrency() >= 3)
+			parallelSquares = std::make_unique<Utilities::ParallelSquares>(zx, zy, squareX, squareY);
+
+		for (uint32_t i = 0; i < view.MaxIterations; ++i)
+		{
+			if (parallelSquares)
+				parallelSquares->Start();
+			else
+			{
+				BigFixed::Square(zx, squareX);
+				BigFixed::Square(zy, squareY);
+			}
+
+			BigFixed::Multiply(zx, zy, product);
+			if (parallelSquares)
+				parallelSquares->Wait();
+
+			zx = squareX - squareY + cx;
+			zy = product + product + cy;
+
+			const double x = zx.ToDouble();
+			const double y = zy.ToDouble();
+			reference.Points.push_back(x);
+			reference.Points.push_back(y);
+			if (x * x + y * y > ReferenceEscapeRadiusSquared)
+				break;
+		}
+
+		return reference;
+	}
+
+	ReferenceOrbit ComputeMainReference(const PerturbationView& view)
+	{
+		ReferenceOrbit best = ComputeReferenceOrbit(view, 0.0, 0.0);
+		const double aspectRatio = static_cast<double>(view.Height) / static_cast<double>(view.Width);
+		const double gridSize = static_cast<double>(MainReferenceGridSize);
+		for (uint32_t candidate = 0; candidate < MainReferenceGridSize * MainReferenceGridSize && best.GetLength() < view.MaxIterations; ++candidate)
+		{
+			/* Cell centers, none of them coincides with the view center */
+			const double offsetX = ((static_cast<double>(candidate % MainReferenceGridSize) + 0.5) / gridSize - 0.5) * view.Scale;
+			const double offsetY = ((static_cast<double>(candidate / MainReferenceGridSize) + 0.5) / gridSize - 0.5) * (view.Scale * aspectRatio);
+			ReferenceOrbit reference = ComputeReferenceOrbit(view, offsetX, offsetY);
+			if (reference.GetLength() > best.GetLength())
+				best = std::move(reference);
+		}
+
+		return best;
+	}
+
+	SeriesApproximation ComputeSeriesApproximation(const PerturbationView& view, const ReferenceOrbit& reference)
+	{
+		/* The corner farthest from the reference */
+		double radius = 0.0;
+		for (uint32_t corner = 0; corner < 4; ++corner)
+		{
+			double offsetX;
+			double offsetY;
+			GetPixelOffset(view, corner % 2 == 0 ? 0 : view.Width - 1, corner / 2 == 0 ? 0 : view.Height - 1, offsetX, offsetY);
+			radius = std::max(radius, hypot(offsetX - reference.OffsetX, offsetY - reference.OffsetY));
+		}
+
+		SeriesApproximation series;
+		series.Radius = radius;
+		series.Coefficients.assign(SeriesTermCount * 2, 0.0);
+		const uint32_t limit = std::min(reference.GetLength(), view.MaxIterations);
+		if (limit == 0 || !(radius > 0.0))
+			return series;
+
+		/* Largest shift of c the truncation error e may cause: e / min |d'(u)|, times the radius for c */
+		const double maxShift = SeriesTolerance * view.Scale / static_cast<double>(view.Width);
+		const double* points = reference.Points.data();
+		std::vector<double> coefficients = series.Coefficients;
+		std::vector<double> next(SeriesTermCount * 2);
+		double error = 0.0;
+		for (uint32_t n = 0; n + 1 < limit; ++n)
+		{
+			const double referenceX = points[n * 2];
+			const double referenceY = points[n * 2 + 1];
+
+			/* Magnitude bound of the series over the disk, |u| <= 1 */
+			double seriesBound = 0.0;
+			for (uint32_t k = 0; k < SeriesTermCount; ++k)
+				seriesBound += hypot(coefficients[k * 2], coefficients[k * 2 + 1]);
+
+			/* The products of the square that fall past K are dropped, the error grows with the whole delta recurrence */
+			double truncated = 0.0;
+			for (uint32_t k = 0; k < SeriesTermCount; ++k)
+			{
+				const double twoZaX = 2.0 * (referenceX * coefficients[k * 2] - referenceY * coefficients[k * 2 + 1]);
+				const double twoZaY = 2.0 * (referenceX * coefficients[k * 2 + 1] + referenceY * coefficients[k * 2]);
+				double sumX = 0.0;
+				double sumY = 0.0;
+				for (uint32_t j = 0; j < k; ++j)
+				{
+					const uint32_t other = k - 1 - j;
+					sumX += coefficients[j * 2] * coefficients[other * 2] - coefficients[j * 2 + 1] * coefficients[other * 2 + 1];
+					sumY += coefficients[j * 2] * coefficients[other * 2 + 1] + coefficients[j * 2 + 1] * coefficients[other * 2];
+				}
+
+				next[k * 2] = twoZaX + sumX + (k == 0 ? radius : 0.0);
+				next[k * 2 + 1] = twoZaY + sumY;
+
+				const double magnitude = hypot(coefficients[k * 2], coefficients[k * 2 + 1]);
+				for (uint32_t j = SeriesTermCount - 1 - k; j < SeriesTermCount; ++j)
+					truncated += magnitude * hypot(coefficients[j * 2], coefficients[j * 2 + 1]);
+			}
+
+			const double referenceMagnitude = hypot(referenceX, referenceY);
+			const double nextError = (2.0 * referenceMagnitude + 2.0 * seriesBound) * error + error * error + truncated;
+
+			/* |d'(u)| >= |A_1| - sum k |A_k| on the disk, the series has to stay invertible to turn the error into a shift of c */
+			double derivativeBound = hypot(next[0], next[1]);
+			double nextSeriesBound = 0.0;
+			for (uint32_t k = 0; k < SeriesTermCount; ++k)
+			{
+				const double magnitude = hypot(next[k * 2], next[k * 2 + 1]);
+				nextSeriesBound += magnitude;
+				if (k != 0)
+					derivativeBound -= static_cast<double>(k + 1) * magnitude;
+			}
+
+			const double nextReferenceMagnitude = hypot(points[n * 2 + 2], points[n * 2 + 3]);
+			const double pixelBound = nextReferenceMagnitude + nextSeriesBound + nextError;
+			if (!(derivativeBound > 0.0) || !(nextError * radius <= maxShift * derivativeBound) || !(pixelBound * pixelBound <= SeriesEscapeRadiusSquared))
+				break;
+
+			coefficients.swap(next);
+			error = nextError;
+			series.SkipIterations = n + 1;
+		}
+
+		if (series.SkipIterations != 0)
+			series.Coefficients = std::move(coefficients);
+
+		return series;
+	}
+
+	void EvaluateSeries(const SeriesApproximation& series, const double dcX, const double dcY, double& dx, double& dy)
+	{
+		const double* coefficients = series.Coefficients.data();
+		const double inverseRadius = 1.0 / series.Radius;
+		const double ux = dcX * inverseRadius;
+		const double uy = dcY * inverseRadius;
+		double x = 0.0;
+		double y = 0.0;
+		for (uint32_t k = SeriesTermCount; k-- > 0;)
+		{
+			const double sumX = coefficients[k * 2] + x;
+			const double sumY = coefficients[k * 2 + 1] + y;
+			x = sumX * ux - sumY * uy;
+			y = sumX * uy + sumY * ux;
+		}
+
+		dx = x;
+		dy = y;
+	}
+
+	void GetPixelOffset(const PerturbationView& view, const uint32_t x, const uint32_t y, double& offsetX, double& offsetY)
+	{
+		const double u = static_cast<double>(x) / static_cast<double>(view.Width);
+		const double v = static_cast<double>(y) / static_cast<double>(view.Height);
+		const double aspectRatio = static_cast<double>(view.Height) / static_cast<double>(view.Width);
+		offsetX = (u - 0.5) * view.Scale;
+		offsetY = (v - 0.5) * (view.Scale * aspectRatio);
+	}
+
+	bool IteratePixel(
+		const ReferenceOrbit& reference, const SeriesApproximation* series, const double dcX, const double dcY,
+		const uint32_t maxIterations, const double escapeRadiusSquared, uint32_t& iterations, float& magnitude, uint64_t& iterationCount)
+	{
+		const double* points = reference.Points.data();
+		const uint32_t length = reference.GetLength();
+		double dx = 0.0;
+		double dy = 0.0;
+		uint32_t start = 0;
+		if (series != nullptr && series->SkipIterations != 0)
+		{
+			EvaluateSeries(*series, dcX, dcY, dx, dy);
+			start = series->SkipIterations;
+		}
+
+		uint32_t n = start;
+		bool valid = true;
+		double zMagnitude = 0.0;
+		uint32_t i = start;
+		for (; i < maxIterations; ++i)
+		{
+			if (i >= length)
+			{
+				valid = false;
+				break;
+			}
+
+			/* d = (2 Z + d) d + dc */
+			const double ax = 2.0 * points[i * 2] + dx;
+			const double ay = 2.0 * points[i * 2 + 1] + dy;
+			const double nextDx = ax * dx - ay * dy + dcX;
+			dy = ax * dy + ay * dx + dcY;
+			dx = nextDx;
+
+			const double referenceX = points[i * 2 + 2];
+			const double referenceY = points[i * 2 + 3];
+			const double zx = referenceX + dx;
+			const double zy = referenceY + dy;
+			zMagnitude = zx * zx + zy * zy;
+			if (zMagnitude > escapeRadiusSquared)
+			{
+				++i;
+				break;
+			}
+
+			++n;
+			if (zMagnitude < GlitchToleranceSquared * (referenceX * referenceX + referenceY * referenceY))
+			{
+				valid = false;
+				++i;
+				break;
+			}
+		}
+
+		iterations = n;
+		magnitude = static_cast<float>(zMagnitude);
+		iterationCount += i - start;
+		return valid;
+	}
+}
@@ -1,5 +1,6 @@
 #include "include/Platform.h"
 
+#ifdef _WIN32
 INTERNALSCOPE double s_SystemClockFrequency;
 INTERNALSCOPE LARGE_INTEGER s_SystemClockStartTime;
 
@@ -20,3 +21,13 @@ double Platform::GetAbsoluteTime()
 	QueryPerformanceCounter(&currentTime);
 	return currentTime.QuadPart * s_SystemClockFrequency;
 }
+#else
+#include <chrono>
+
+double Platform::GetAbsoluteTime()
+{
+	/* Headless builds (mandelbrot-render) only need a monotonic clock */
+	const auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return std::chrono::duration<double>(now).count();
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,779 @@
+#include "include/PngEncoder.h"
+#include "include/ThreadPool.h"
+#include <algorithm>
+#include <stdlib.h>
+
+namespace Utilities {
+	/* Deflate parameters, roughly what zlib does at its default level */
+	constexpr std::size_t DeflateWindowSize = 32768;
+	constexpr uint32_t DeflateHashBits = 15;
+	constexpr uint32_t DeflateMaxChainLength = 64;
+	constexpr uint32_t DeflateLazyMatchLength = 32;
+	constexpr uint32_t DeflateNiceMatchLength = 128;
+	constexpr uint32_t DeflateMinMatchLength = 3;
+	constexpr uint32_t DeflateMaxMatchLength = 258;
+	constexpr std::size_t DeflateMaxBlockSymbolCount = 1 << 15;
+	/* Uncompressed bytes per stripe of the parallel encoder, large enough that the per stripe overhead does not matter */
+	constexpr std::size_t PngStripeSize = 1 << 20;
+	/* Rows EncodeRGBA hands to the stream encoder at once */
+	constexpr std::size_t PngBatchSize = 32 << 20;
+
+	constexpr std::array<uint16_t, 29> LengthBase = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	constexpr std::array<uint8_t, 29> LengthExtraBits = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	constexpr std::array<uint16_t, 30> DistanceBase = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	constexpr std::array<uint8_t, 30> DistanceExtraBits = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	constexpr std::array<uint8_t, 19> CodeLengthOrder = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	INTERNALSCOPE const std::array<uint32_t, 256> CrcTable = []() {
+		std::array<uint32_t, 256> table{};
+		for (uint32_t n = 0; n < 256; ++n)
+		{
+			uint32_t c = n;
+			for (uint32_t k = 0; k < 8; ++k)
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+
+			table[n] = c;
+		}
+
+		return table;
+	}();
+
+	/* Deflate length symbol (minus 257) for every match length */
+	INTERNALSCOPE const std::array<uint8_t, DeflateMaxMatchLength + 1> LengthCodes = []() {
+		std::array<uint8_t, DeflateMaxMatchLength + 1> codes{};
+		for (uint32_t code = 0; code < LengthBase.size(); ++code)
+			for (uint32_t length = LengthBase[code]; length < LengthBase[code] + (1u << LengthExtraBits[code]) && length <= DeflateMaxMatchLength; ++length)
+				codes[length] = static_cast<uint8_t>(code);
+
+		/* 258 has a code of its own instead of 227 + 31 */
+		codes[DeflateMaxMatchLength] = 28;
+		return codes;
+	}();
+
+	INTERNALSCOPE uint32_t GetDistanceCode(const uint32_t distance)
+	{
+		return static_cast<uint32_t>(std::upper_bound(DistanceBase.begin(), DistanceBase.end(), distance) - DistanceBase.begin()) - 1;
+	}
+
+	/* LSB first bit packer as deflate requires it */
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(std::vector<uint8_t>& output)
+			:
+			m_Output(output),
+			m_Bits(0),
+			m_BitCount(0)
+		{}
+
+		void Write(const uint32_t bits, const uint32_t count)
+		{
+			m_Bits |= static_cast<uint64_t>(bits) << m_BitCount;
+			m_BitCount += count;
+			while (m_BitCount >= 8)
+			{
+				m_Output.push_back(static_cast<uint8_t>(m_Bits));
+				m_Bits >>= 8;
+				m_BitCount -= 8;
+			}
+		}
+
+		void AlignToByte()
+		{
+			if (m_BitCount)
+				m_Output.push_back(static_cast<uint8_t>(m_Bits));
+
+			m_Bits = 0;
+			m_BitCount = 0;
+		}
+	private:
+		std::vector<uint8_t>& m_Output;
+		uint64_t m_Bits;
+		uint32_t m_BitCount;
+	};
+
+	/* Distance 0 marks a literal */
+	struct DeflateSymbol
+	{
+		uint16_t LiteralOrLength;
+		uint16_t Distance;
+	};
+
+	/* Optimal Huffman code lengths, then limited to maxLength by rebalancing the Kraft sum (same approach as miniz) */
+	INTERNALSCOPE void BuildCodeLengths(const uint32_t* frequencies, const uint32_t symbolCount, const uint32_t maxLength, uint8_t* lengths)
+	{
+		std::fill(lengths, lengths + symbolCount, static_cast<uint8_t>(0));
+
+		std::vector<uint32_t> usedSymbols;
+		for (uint32_t i = 0; i < symbolCount; ++i)
+			if (frequencies[i])
+				usedSymbols.push_back(i);
+
+		if (usedSymbols.empty())
+			return;
+
+		if (usedSymbols.size() == 1)
+		{
+			lengths[usedSymbols[0]] = 1;
+			return;
+		}
+
+		std::stable_sort(usedSymbols.begin(), usedSymbols.end(), [frequencies](const uint32_t a, const uint32_t b) { return frequencies[a] < frequencies[b]; });
+
+		/* Two-queue construction over the sorted leaves: leaves are [0, n), internal nodes [n, 2n - 1) in creation order */
+		const uint32_t leafCount = static_cast<uint32_t>(usedSymbols.size());
+		std::vector<uint64_t> weights(leafCount * 2 - 1);
+		std::vector<uint32_t> parents(leafCount * 2 - 1, 0);
+		for (uint32_t i = 0; i < leafCount; ++i)
+			weights[i] = frequencies[usedSymbols[i]];
+
+		uint32_t nextLeaf = 0;
+		uint32_t nextNode = leafCount;
+		for (uint32_t node = leafCount; node < leafCount * 2 - 1; ++node)
+		{
+			uint32_t children[2];
+			for (uint32_t& child : children)
+				child = (nextLeaf < leafCount && (nextNode >= node || weights[nextLeaf] <= weights[nextNode])) ? nextLeaf++ : nextNode++;
+
+			weights[node] = weights[children[0]] + weights[children[1]];
+			parents[children[0]] = node;
+			parents[children[1]] = node;
+		}
+
+		/* Parents always have a higher index, so depths resolve walking down from the root */
+		std::vector<uint32_t> depths(leafCount * 2 - 1, 0);
+		for (int32_t node = static_cast<int32_t>(leafCount) * 2 - 3; node >= 0; --node)
+			depths[node] = depths[parents[node]] + 1;
+
+		std::array<uint32_t, 32> lengthCounts{};
+		for (uint32_t i = 0; i < leafCount; ++i)
+			++lengthCounts[std::min(depths[i], maxLength)];
+
+		uint32_t kraftSum = 0;
+		for (uint32_t length = 1; length <= maxLength; ++length)
+			kraftSum += lengthCounts[length] << (maxLength - length);
+
+		while (kraftSum > (1u << maxLength))
+		{
+			--lengthCounts[maxLength];
+			for (uint32_t length = maxLength - 1; length > 0; --length)
+				if (lengthCounts[length])
+				{
+					--lengthCounts[length];
+					lengthCounts[length + 1] += 2;
+					break;
+				}
+
+			--kraftSum;
+		}
+
+		/* Rarest symbols get the longest codes */
+		uint32_t leaf = 0;
+		for (uint32_t length = maxLength; length > 0; --length)
+			for (uint32_t i = 0; i < lengthCounts[length]; ++i)
+				lengths[usedSymbols[leaf++]] = static_cast<uint8_t>(length);
+	}
+
+	/* Canonical codes, bit reversed for the LSB first writer */
+	INTERNALSCOPE void BuildCodes(const uint8_t* lengths, const uint32_t symbolCount, uint16_t* codes)
+	{
+		std::array<uint32_t, 16> lengthCounts{};
+		for (uint32_t i = 0; i < symbolCount; ++i)
+			++lengthCounts[lengths[i]];
+
+		lengthCounts[0] = 0;
+		std::array<uint32_t, 16> nextCode{};
+		uint32_t code = 0;
+		for (uint32_t length = 1; length < 16; ++length)
+		{
+			code = (code + lengthCounts[length - 1]) << 1;
+			nextCode[length] = code;
+		}
+
+		for (uint32_t i = 0; i < symbolCount; ++i)
+		{
+			const uint32_t length = lengths[i];
+			if (!length)
+				continue;
+
+			uint32_t value = nextCode[length]++;
+			uint32_t reversed = 0;
+			for (uint32_t bit = 0; bit < length; ++bit)
+			{
+				reversed = (reversed << 1) | (value & 1);
+				value >>= 1;
+			}
+
+			codes[i] = static_cast<uint16_t>(reversed);
+		}
+	}
+
+	/* Deflate only needs a complete code for decoding, keep at least two symbols so no decoder chokes on a single one */
+	INTERNALSCOPE void EnsureTwoSymbols(uint32_t* frequencies, const uint32_t symbolCount)
+	{
+		uint32_t usedCount = 0;
+		for (uint32_t i = 0; i < symbolCount; ++i)
+			usedCount += frequencies[i] ? 1 : 0;
+
+		for (uint32_t i = 0; i < symbolCount && usedCount < 2; ++i)
+			if (!frequencies[i])
+			{
+				frequencies[i] = 1;
+				++usedCount;
+			}
+	}
+
+	INTERNALSCOPE void WriteDynamicBlock(BitWriter& writer, const DeflateSymbol* symbols, const std::size_t symbolCount, const bool final)
+	{
+		std::array<uint32_t, 286> literalFrequencies{};
+		std::array<uint32_t, 30> distanceFrequencies{};
+		for (std::size_t i = 0; i < symbolCount; ++i)
+		{
+			const DeflateSymbol& symbol = symbols[i];
+			if (symbol.Distance == 0)
+				++literalFrequencies[symbol.LiteralOrLength];
+			else
+			{
+				++literalFrequencies[257 + LengthCodes[symbol.LiteralOrLength]];
+				++distanceFrequencies[GetDistanceCode(symbol.Distance)];
+			}
+		}
+
+		literalFrequencies[256] = 1;
+		EnsureTwoSymbols(literalFrequencies.data(), static_cast<uint32_t>(literalFrequencies.size()));
+		EnsureTwoSymbols(distanceFrequencies.data(), static_cast<uint32_t>(distanceFrequencies.size()));
+
+		std::array<uint8_t, 286> literalLengths;
+		std::array<uint8_t, 30> distanceLengths;
+		BuildCodeLengths(literalFrequencies.data(), static_cast<uint32_t>(literalFrequencies.size()), 15, literalLengths.data());
+		BuildCodeLengths(distanceFrequencies.data(), static_cast<uint32_t>(distanceFrequencies.size()), 15, distanceLengths.data());
+
+		std::array<uint16_t, 286> literalCodes{};
+		std::array<uint16_t, 30> distanceCodes{};
+		BuildCodes(literalLengths.data(), static_cast<uint32_t>(literalLengths.size()), literalCodes.data());
+		BuildCodes(distanceLengths.data(), static_cast<uint32_t>(distanceLengths.size()), distanceCodes.data());
+
+		uint32_t literalCodeCount = 286;
+		while (literalCodeCount > 257 && literalLengths[literalCodeCount - 1] == 0)
+			--literalCodeCount;
+
+		uint32_t distanceCodeCount = 30;
+		while (distanceCodeCount > 1 && distanceLengths[distanceCodeCount - 1] == 0)
+			--distanceCodeCount;
+
+		/* Both length tables are sent as one run-length encoded sequence (symbols 16, 17 and 18) */
+		std::vector<uint8_t> allLengths(literalLengths.begin(), literalLengths.begin() + literalCodeCount);
+		allLengths.insert(allLengths.end(), distanceLengths.begin(), distanceLengths.begin() + distanceCodeCount);
+
+		struct CodeLengthSymbol
+		{
+			uint8_t Symbol;
+			uint8_t ExtraValue;
+			uint8_t ExtraBitCount;
+		};
+
+		std::vector<CodeLengthSymbol> codeLengthSymbols;
+		std::array<uint32_t, 19> codeLengthFrequencies{};
+		const auto emit = [&](const uint8_t symbol, const uint8_t extraValue, const uint8_t extraBitCount) {
+			codeLengthSymbols.push_back({ symbol, extraValue, extraBitCount });
+			++codeLengthFrequencies[symbol];
+		};
+
+		for (std::size_t i = 0; i < allLengths.size();)
+		{
+			const uint8_t length = allLengths[i];
+			std::size_t run = 1;
+			while (i + run < allLengths.size() && allLengths[i + run] == length)
+				++run;
+
+			i += run;
+			if (length == 0)
+			{
+				while (run >= 11)
+				{
+					const std::size_t count = std::min<std::size_t>(run, 138);
+					emit(18, static_cast<uint8_t>(count - 11), 7);
+					run -= count;
+				}
+
+				if (run >= 3)
+				{
+					emit(17, static_cast<uint8_t>(run - 3), 3);
+					run = 0;
+				}
+			}
+			else
+			{
+				emit(length, 0, 0);
+				--run;
+				while (run >= 3)
+				{
+					const std::size_t count = std::min<std::size_t>(run, 6);
+					emit(16, static_cast<uint8_t>(count - 3), 2);
+					run -= count;
+				}
+			}
+
+			for (; run > 0; --run)
+				emit(length, 0, 0);
+		}
+
+		std::array<uint8_t, 19> codeLengthLengths;
+		std::array<uint16_t, 19> codeLengthCodes{};
+		BuildCodeLengths(codeLengthFrequencies.data(), 19, 7, codeLengthLengths.data());
+		BuildCodes(codeLengthLengths.data(), 19, codeLengthCodes.data());
+
+		uint32_t codeLengthCodeCount = 19;
+		while (codeLengthCodeCount > 4 && codeLengthLengths[CodeLengthOrder[codeLengthCodeCount - 1]] == 0)
+			--codeLengthCodeCount;
+
+		writer.Write(final ? 1 : 0, 1);
+		writer.Write(2, 2);
+		writer.Write(literalCodeCount - 257, 5);
+		writer.Write(distanceCodeCount - 1, 5);
+		writer.Write(codeLengthCodeCount - 4, 4);
+		for (uint32_t i = 0; i < codeLengthCodeCount; ++i)
+			writer.Write(codeLengthLengths[CodeLengthOrder[i]], 3);
+
+		for (const CodeLengthSymbol& symbol : codeLengthSymbols)
+		{
+			writer.Write(codeLengthCodes[symbol.Symbol], codeLengthLengths[symbol.Symbol]);
+			if (symbol.ExtraBitCount)
+				writer.Write(symbol.ExtraValue, symbol.ExtraBitCount);
+		}
+
+		for (std::size_t i = 0; i < symbolCount; ++i)
+		{
+			const DeflateSymbol& symbol = symbols[i];
+			if (symbol.Distance == 0)
+			{
+				writer.Write(literalCodes[symbol.LiteralOrLength], literalLengths[symbol.LiteralOrLength]);
+				continue;
+			}
+
+			const uint32_t lengthCode = LengthCodes[symbol.LiteralOrLength];
+			writer.Write(literalCodes[257 + lengthCode], literalLengths[257 + lengthCode]);
+			if (LengthExtraBits[lengthCode])
+				writer.Write(symbol.LiteralOrLength - LengthBase[lengthCode], LengthExtraBits[lengthCode]);
+
+			const uint32_t distanceCode = GetDistanceCode(symbol.Distance);
+			writer.Write(distanceCodes[distanceCode], distanceLengths[distanceCode]);
+			if (DistanceExtraBits[distanceCode])
+				writer.Write(symbol.Distance - DistanceBase[distanceCode], DistanceExtraBits[distanceCode]);
+		}
+
+		writer.Write(literalCodes[256], literalLengths[256]);
+	}
+
+	INTERNALSCOPE void WriteBigEndian(std::vector<uint8_t>& output, const uint32_t value)
+	{
+		output.push_back(static_cast<uint8_t>(value >> 24));
+		output.push_back(static_cast<uint8_t>(value >> 16));
+		output.push_back(static_cast<uint8_t>(value >> 8));
+		output.push_back(static_cast<uint8_t>(value));
+	}
+
+	INTERNALSCOPE int32_t PaethPredictor(const int32_t a, const int32_t b, const int32_t c)
+	{
+		const int32_t p = a + b - c;
+		const int32_t pa = abs(p - a);
+		const int32_t pb = abs(p - b);
+		const int32_t pc = abs(p - c);
+		if (pa <= pb && pa <= pc)
+			return a;
+
+		return pb <= pc ? b : c;
+	}
+}
+
+uint32_t Png::Crc32(uint32_t crc, const uint8_t* data, const std::size_t size)
+{
+	crc = ~crc;
+	for (std::size_t i = 0; i < size; ++i)
+		crc = Utilities::CrcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+uint32_t Png::Adler32(uint32_t adler, const uint8_t* data, const std::size_t size)
+{
+	constexpr uint32_t modulus = 65521;
+	/* Largest block whose sums cannot overflow 32 bits before the modulo */
+	constexpr std::size_t blockSize = 5552;
+
+	uint32_t a = adler & 0xFFFF;
+	uint32_t b = adler >> 16;
+	for (std::size_t offset = 0; offset < size; offset += blockSize)
+	{
+		const std::size_t end = std::min(size, offset + blockSize);
+		for (std::size_t i = offset; i < end; ++i)
+		{
+			a += data[i];
+			b += a;
+		}
+
+		a %= modulus;
+		b %= modulus;
+	}
+
+	return (b << 16) | a;
+}
+
+uint32_t Png::Adler32Combine(const uint32_t adlerA, const uint32_t adlerB, const std::size_t sizeB)
+{
+	/* Same arithmetic as zlib's adler32_combine */
+	constexpr uint64_t modulus = 65521;
+	const uint64_t remainder = sizeB % modulus;
+	uint64_t sum1 = adlerA & 0xFFFF;
+	uint64_t sum2 = (remainder * sum1) % modulus;
+	sum1 += (adlerB & 0xFFFF) + modulus - 1;
+	sum2 += ((adlerA >> 16) & 0xFFFF) + ((adlerB >> 16) & 0xFFFF) + modulus - remainder;
+
+	if (sum1 >= modulus)
+		sum1 -= modulus;
+
+	if (sum1 >= modulus)
+		sum1 -= modulus;
+
+	if (sum2 >= (modulus << 1))
+		sum2 -= (modulus << 1);
+
+	if (sum2 >= modulus)
+		sum2 -= modulus;
+
+	return static_cast<uint32_t>(sum1 | (sum2 << 16));
+}
+
+void Png::FilterRow(const uint8_t* row, const uint8_t* previousRow, const std::size_t rowSize, const uint32_t bytesPerPixel, uint8_t* output)
+{
+	/* Same heuristic as lodepng and libpng: pick the filter with the smallest sum of absolute (signed) residuals */
+	std::array<uint64_t, 5> sums{};
+	for (std::size_t i = 0; i < rowSize; ++i)
+	{
+		const int32_t x = row[i];
+		const int32_t a = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+		const int32_t b = previousRow ? previousRow[i] : 0;
+		const int32_t c = (previousRow && i >= bytesPerPixel) ? previousRow[i - bytesPerPixel] : 0;
+
+		sums[0] += abs(static_cast<int8_t>(x));
+		sums[1] += abs(static_cast<int8_t>(x - a));
+		sums[2] += abs(static_cast<int8_t>(x - b));
+		sums[3] += abs(static_cast<int8_t>(x - ((a + b) >> 1)));
+		sums[4] += abs(static_cast<int8_t>(x - Utilities::PaethPredictor(a, b, c)));
+	}
+
+	const uint8_t filter = static_cast<uint8_t>(std::min_element(sums.begin(), sums.end()) - sums.begin());
+	output[0] = filter;
+	for (std::size_t i = 0; i < rowSize; ++i)
+	{
+		const int32_t x = row[i];
+		const int32_t a = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+		const int32_t b = previousRow ? previousRow[i] : 0;
+		const int32_t c = (previousRow && i >= bytesPerPixel) ? previousRow[i - bytesPerPixel] : 0;
+
+		int32_t predictor = 0;
+		switch (filter)
+		{
+			case 1: predictor = a; break;
+			case 2: predictor = b; break;
+			case 3: predictor = (a + b) >> 1; break;
+			case 4: predictor = Utilities::PaethPredictor(a, b, c); break;
+			default: break;
+		}
+
+		output[i + 1] = static_cast<uint8_t>(x - predictor);
+	}
+}
+
+void Png::Deflate(const uint8_t* data, const std::size_t dictionarySize, const std::size_t size, const bool final, std::vector<uint8_t>& output)
+{
+	using namespace Utilities;
+	constexpr std::size_t windowMask = DeflateWindowSize - 1;
+
+	/* Hash chains over absolute positions, prev is indexed by position modulo the window */
+	std::vector<int64_t> head(std::size_t(1) << DeflateHashBits, -1);
+	std::vector<int64_t> prev(DeflateWindowSize, -1);
+
+	const auto hash = [data](const std::size_t position) -> uint32_t {
+		const uint32_t value = (static_cast<uint32_t>(data[position]) << 16) | (static_cast<uint32_t>(data[position + 1]) << 8) | data[position + 2];
+		return (value * 2654435761u) >> (32 - DeflateHashBits);
+	};
+
+	const auto insert = [&](const std::size_t position) {
+		if (position + DeflateMinMatchLength > size)
+			return;
+
+		const uint32_t h = hash(position);
+		prev[position & windowMask] = head[h];
+		head[h] = static_cast<int64_t>(position);
+	};
+
+	const auto findMatch = [&](const std::size_t position, uint32_t& distance) -> uint32_t {
+		const uint32_t limit = static_cast<uint32_t>(std::min<std::size_t>(DeflateMaxMatchLength, size - position));
+		if (limit < DeflateMinMatchLength)
+			return 0;
+
+		uint32_t bestLength = DeflateMinMatchLength - 1;
+		int64_t candidate = head[hash(position)];
+		for (uint32_t chain = 0; chain < DeflateMaxChainLength && candidate >= 0; ++chain)
+		{
+			const std::size_t candidateDistance = position - static_cast<std::size_t>(candidate);
+			if (candidateDistance > DeflateWindowSize)
+				break;
+
+			const uint8_t* a = data + candidate;
+			const uint8_t* b = data + position;
+			if (a[bestLength] == b[bestLength] && a[0] == b[0])
+			{
+				uint32_t length = 0;
+				while (length < limit && a[length] == b[length])
+					++length;
+
+				if (length > bestLength)
+				{
+					bestLength = length;
+					distance = static_cast<uint32_t>(candidateDistance);
+					if (length >= DeflateNiceMatchLength || length == limit)
+						break;
+				}
+			}
+
+			/* Chains only ever point backwards, anything else is a slot reused by a newer position */
+			const int64_t next = prev[static_cast<std::size_t>(candidate) & windowMask];
+			if (next >= candidate)
+				break;
+
+			candidate = next;
+		}
+
+		return bestLength >= DeflateMinMatchLength ? bestLength : 0;
+	};
+
+	for (std::size_t position = dictionarySize > DeflateWindowSize ? dictionarySize - DeflateWindowSize : 0; position < dictionarySize; ++position)
+		insert(position);
+
+	BitWriter writer(output);
+	std::vector<DeflateSymbol> symbols;
+	symbols.reserve(DeflateMaxBlockSymbolCount);
+
+	const auto emitMatch = [&](const std::size_t position, const uint32_t length, const uint32_t distance, const std::size_t firstUninserted) {
+		symbols.push_back({ static_cast<uint16_t>(length), static_cast<uint16_t>(distance) });
+		for (std::size_t i = firstUninserted; i < position + length; ++i)
+			insert(i);
+	};
+
+	std::size_t position = dictionarySize;
+	while (position < size)
+	{
+		if (symbols.size() >= DeflateMaxBlockSymbolCount)
+		{
+			WriteDynamicBlock(writer, symbols.data(), symbols.size(), false);
+			symbols.clear();
+		}
+
+		uint32_t distance = 0;
+		const uint32_t length = findMatch(position, distance);
+		if (length == 0)
+		{
+			insert(position);
+			symbols.push_back({ data[position], 0 });
+			++position;
+			continue;
+		}
+
+		/* Lazy evaluation: a longer match one byte later wins over the current one */
+		if (length < DeflateLazyMatchLength && position + 1 < size)
+		{
+			insert(position);
+			uint32_t nextDistance = 0;
+			const uint32_t nextLength = findMatch(position + 1, nextDistance);
+			if (nextLength > length)
+			{
+				symbols.push_back({ data[position], 0 });
+				emitMatch(position + 1, nextLength, nextDistance, position + 1);
+				position += 1 + nextLength;
+			}
+			else
+			{
+				emitMatch(position, length, distance, position + 1);
+				position += length;
+			}
+
+			continue;
+		}
+
+		emitMatch(position, length, distance, position);
+		position += length;
+	}
+
+	if (final || !symbols.empty())
+		WriteDynamicBlock(writer, symbols.data(), symbols.size(), final);
+
+	if (!final)
+	{
+		/* Empty stored block, leaves the stream byte aligned */
+		writer.Write(0, 3);
+		writer.AlignToByte();
+		output.push_back(0x00);
+		output.push_back(0x00);
+		output.push_back(0xFF);
+		output.push_back(0xFF);
+	}
+	else
+		writer.AlignToByte();
+}
+
+void Png::AppendChunk(const char type[4], const uint8_t* data, const std::size_t size, std::vector<uint8_t>& output)
+{
+	Utilities::WriteBigEndian(output, static_cast<uint32_t>(size));
+	const std::size_t typeOffset = output.size();
+	output.insert(output.end(), type, type + 4);
+	if (size)
+		output.insert(output.end(), data, data + size);
+
+	Utilities::WriteBigEndian(output, Crc32(0, output.data() + typeOffset, size + 4));
+}
+
+void Png::AppendHeader(const uint32_t width, const uint32_t height, std::vector<uint8_t>& output)
+{
+	constexpr std::array<uint8_t, 8> signature = { 137, 80, 78, 71, 13, 10, 26, 10 };
+	output.insert(output.end(), signature.begin(), signature.end());
+
+	std::vector<uint8_t> header;
+	Utilities::WriteBigEndian(header, width);
+	Utilities::WriteBigEndian(header, height);
+	header.push_back(8); /* Bit depth */
+	header.push_back(6); /* RGBA */
+	header.push_back(0); /* Deflate */
+	header.push_back(0); /* Adaptive filtering */
+	header.push_back(0); /* No interlacing */
+	AppendChunk("IHDR", header.data(), header.size(), output);
+}
+
+Png::StreamEncoder::StreamEncoder(ThreadPool& threadPool)
+	:
+	m_ThreadPool(threadPool),
+	m_Width(0),
+	m_Height(0),
+	m_RowCount(0),
+	m_PreviousRow(),
+	m_Filtered(),
+	m_DictionarySize(0),
+	m_Adler(1)
+{}
+
+bool Png::StreamEncoder::Begin(const uint32_t width, const uint32_t height, std::vector<uint8_t>& output)
+{
+	if (width == 0 || height == 0)
+		return false;
+
+	m_Width = width;
+	m_Height = height;
+	m_RowCount = 0;
+	m_PreviousRow.assign(static_cast<std::size_t>(width) * 4, 0);
+	m_Filtered.clear();
+	m_DictionarySize = 0;
+	m_Adler = 1;
+
+	AppendHeader(width, height, output);
+	return true;
+}
+
+bool Png::StreamEncoder::AppendRows(const uint8_t* rows, const uint32_t rowCount, std::vector<uint8_t>& output)
+{
+	if (m_Width == 0 || rowCount > m_Height - m_RowCount)
+		return false;
+
+	if (rowCount == 0)
+		return true;
+
+	const std::size_t rowSize = static_cast<std::size_t>(m_Width) * 4;
+	const std::size_t filteredRowSize = rowSize + 1;
+	const uint32_t rowsPerStripe = static_cast<uint32_t>(std::max<std::size_t>(1, Utilities::PngStripeSize / rowSize));
+	const uint32_t stripeCount = (rowCount + rowsPerStripe - 1) / rowsPerStripe;
+	const bool firstRows = m_RowCount == 0;
+	const bool lastRows = m_RowCount + rowCount == m_Height;
+
+	/* The tail of the previous batch stays in front of the new rows as deflate dictionary */
+	m_Filtered.resize(m_DictionarySize + rowCount * filteredRowSize);
+	m_ThreadPool.ParallelFor(stripeCount, [&](const uint32_t stripe) {
+		const uint32_t firstRow = stripe * rowsPerStripe;
+		const uint32_t endRow = std::min(rowCount, firstRow + rowsPerStripe);
+		for (uint32_t row = firstRow; row < endRow; ++row)
+			FilterRow(
+				rows + row * rowSize,
+				row ? rows + (row - 1) * rowSize : (firstRows ? nullptr : m_PreviousRow.data()),
+				rowSize,
+				4,
+				m_Filtered.data() + m_DictionarySize + row * filteredRowSize);
+	});
+
+	/* Filtering has to finish first, every stripe reads the end of the one before it as dictionary */
+	std::vector<std::vector<uint8_t>> chunks(stripeCount);
+	std::vector<uint32_t> adlers(stripeCount);
+	std::vector<std::size_t> stripeSizes(stripeCount);
+	m_ThreadPool.ParallelFor(stripeCount, [&](const uint32_t stripe) {
+		const uint32_t firstRow = stripe * rowsPerStripe;
+		const uint32_t endRow = std::min(rowCount, firstRow + rowsPerStripe);
+		const std::size_t begin = m_DictionarySize + firstRow * filteredRowSize;
+		const std::size_t end = m_DictionarySize + endRow * filteredRowSize;
+		const std::size_t dictionaryBegin = begin > Utilities::DeflateWindowSize ? begin - Utilities::DeflateWindowSize : 0;
+
+		stripeSizes[stripe] = end - begin;
+		adlers[stripe] = Adler32(1, m_Filtered.data() + begin, end - begin);
+
+		std::vector<uint8_t> compressed;
+		compressed.reserve(stripeSizes[stripe] / 4);
+		if (firstRows && stripe == 0)
+		{
+			/* zlib header: deflate with a 32K window, default compression level */
+			compressed.push_back(0x78);
+			compressed.push_back(0x9C);
+		}
+
+		Deflate(m_Filtered.data() + dictionaryBegin, begin - dictionaryBegin, end - dictionaryBegin, lastRows && stripe == stripeCount - 1, compressed);
+		AppendChunk("IDAT", compressed.data(), compressed.size(), chunks[stripe]);
+	});
+
+	for (uint32_t stripe = 0; stripe < stripeCount; ++stripe)
+	{
+		output.insert(output.end(), chunks[stripe].begin(), chunks[stripe].end());
+		m_Adler = Adler32Combine(m_Adler, adlers[stripe], stripeSizes[stripe]);
+	}
+
+	memcpy(m_PreviousRow.data(), rows + (rowCount - 1) * rowSize, rowSize);
+	const std::size_t dictionarySize = std::min(m_Filtered.size(), Utilities::DeflateWindowSize);
+	memmove(m_Filtered.data(), m_Filtered.data() + m_Filtered.size() - dictionarySize, dictionarySize);
+	m_Filtered.resize(dictionarySize);
+	m_DictionarySize = dictionarySize;
+	m_RowCount += rowCount;
+
+	if (lastRows)
+	{
+		/* The zlib trailer only exists once all stripes are done, it gets an IDAT chunk of its own */
+		std::vector<uint8_t> trailer;
+		Utilities::WriteBigEndian(trailer, m_Adler);
+		AppendChunk("IDAT", trailer.data(), trailer.size(), output);
+		AppendChunk("IEND", nullptr, 0, output);
+		m_Filtered = std::vector<uint8_t>();
+	}
+
+	return true;
+}
+
+bool Png::EncodeRGBA(const uint8_t* pixels, const uint32_t width, const uint32_t height, ThreadPool& threadPool, std::vector<uint8_t>& png)
+{
+	png.clear();
+	StreamEncoder encoder(threadPool);
+	if (!encoder.Begin(width, height, png))
+		return false;
+
+	/* Batches keep the filtered copy bounded while leaving enough stripes for every thread */
+	const std::size_t rowSize = static_cast<std::size_t>(width) * 4;
+	const uint32_t rowsPerBatch = static_cast<uint32_t>(std::max<std::size_t>(1, Utilities::PngBatchSize / rowSize));
+	for (uint32_t row = 0; row < height; row += rowsPerBatch)
+		if (!encoder.AppendRows(pixels + row * rowSize, std::min(rowsPerBatch, height - row), png))
+			return false;
+
+	return true;
+}
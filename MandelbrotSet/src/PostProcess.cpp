@@ -0,0 +1,305 @@
+#include "include/PostProcess.h"
+#include "include/Coloring.h"
+#include "include/ThreadPool.h"
+#include "glm/gtc/packing.hpp"
+#include <algorithm>
+#include <math.h>
+
+namespace Utilities {
+	constexpr std::array<std::array<uint8_t, 8>, 8> BayerMatrix = { {
+		{ 0, 32, 8, 40, 2, 34, 10, 42 },
+		{ 48, 16, 56, 24, 50, 18, 58, 26 },
+		{ 12, 44, 4, 36, 14, 46, 6, 38 },
+		{ 60, 28, 52, 20, 62, 30, 54, 22 },
+		{ 3, 35, 11, 43, 1, 33, 9, 41 },
+		{ 51, 19, 59, 27, 49, 17, 57, 25 },
+		{ 15, 47, 7, 39, 13, 45, 5, 37 },
+		{ 63, 31, 55, 23, 61, 29, 53, 21 },
+	} };
+
+	/*
+	* Value added before truncating value * 255, per channel of 16 consecutive pixels starting at a
+	* multiple of 8, so two or four neighbouring pixels can be loaded from any column & 7.
+	* Plain rounding adds 0.5, dithering a Bayer threshold in [0, 1). Alpha is always rounded.
+	*/
+	struct alignas(64) QuantizationOffsets
+	{
+		float Values[16 * 4];
+	};
+
+	INTERNALSCOPE void BuildQuantizationOffsets(const uint32_t y, const bool dither, QuantizationOffsets& offsets)
+	{
+		for (uint32_t pixel = 0; pixel < 16; ++pixel)
+		{
+			const float offset = dither ? (BayerMatrix[y & 7][pixel & 7] + 0.5f) / 64.0f : 0.5f;
+			offsets.Values[pixel * 4 + 0] = offset;
+			offsets.Values[pixel * 4 + 1] = offset;
+			offsets.Values[pixel * 4 + 2] = offset;
+			offsets.Values[pixel * 4 + 3] = 0.5f;
+		}
+	}
+
+	/* Same steps for every kernel: clamp (NaN to 0), gamma on the color channels, scale, offset, truncate */
+	INTERNALSCOPE uint8_t QuantizeReference(const float value, const float inverseGamma, const bool colorChannel, const float offset)
+	{
+		float clamped = value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+		if (colorChannel && inverseGamma != 1.0f)
+			clamped = powf(clamped, inverseGamma);
+
+		const float scaled = clamped * 255.0f + offset;
+		return static_cast<uint8_t>(scaled < 255.0f ? scaled : 255.0f);
+	}
+
+#if APP_SIMD_X64
+	/*
+	* pow(x, e) for x in [0, 1] as exp2(e * log2(x)). log2 of the mantissa uses the atanh series
+	* 2 / ln 2 * (t + t^3 / 3 + ...) with t = (m - 1) / (m + 1), exp2 of the fraction a degree 6
+	* Taylor polynomial. Both stay within a few 1e-6 relative error, far below one RGBA8 step.
+	*/
+	INTERNALSCOPE __m128 PowUnitSSE2(const __m128 x, const __m128 exponent)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128i bits = _mm_castps_si128(x);
+		const __m128 biasedExponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+		const __m128 mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_castps_si128(one)));
+
+		const __m128 t = _mm_div_ps(_mm_sub_ps(mantissa, one), _mm_add_ps(mantissa, one));
+		const __m128 t2 = _mm_mul_ps(t, t);
+		__m128 series = _mm_set1_ps(1.0f / 9.0f);
+		series = _mm_add_ps(_mm_mul_ps(series, t2), _mm_set1_ps(1.0f / 7.0f));
+		series = _mm_add_ps(_mm_mul_ps(series, t2), _mm_set1_ps(1.0f / 5.0f));
+		series = _mm_add_ps(_mm_mul_ps(series, t2), _mm_set1_ps(1.0f / 3.0f));
+		series = _mm_add_ps(_mm_mul_ps(series, t2), one);
+		const __m128 log2 = _mm_add_ps(biasedExponent, _mm_mul_ps(_mm_mul_ps(series, t), _mm_set1_ps(2.88539008f)));
+
+		/* The product is <= 0 here, keep it away from the denormal range */
+		const __m128 y = _mm_max_ps(_mm_mul_ps(log2, exponent), _mm_set1_ps(-126.0f));
+		/* floor() without SSE4.1: truncation rounds negative values up, step back where it did */
+		__m128 integer = _mm_cvtepi32_ps(_mm_cvttps_epi32(y));
+		integer = _mm_sub_ps(integer, _mm_and_ps(_mm_cmpgt_ps(integer, y), one));
+		const __m128 fraction = _mm_sub_ps(y, integer);
+
+		__m128 power = _mm_set1_ps(1.5403530e-4f);
+		power = _mm_add_ps(_mm_mul_ps(power, fraction), _mm_set1_ps(1.3333558e-3f));
+		power = _mm_add_ps(_mm_mul_ps(power, fraction), _mm_set1_ps(9.6181291e-3f));
+		power = _mm_add_ps(_mm_mul_ps(power, fraction), _mm_set1_ps(5.5504109e-2f));
+		power = _mm_add_ps(_mm_mul_ps(power, fraction), _mm_set1_ps(2.4022651e-1f));
+		power = _mm_add_ps(_mm_mul_ps(power, fraction), _mm_set1_ps(6.9314718e-1f));
+		power = _mm_add_ps(_mm_mul_ps(power, fraction), one);
+
+		const __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(integer), _mm_set1_epi32(127)), 23));
+		/* log2 is meaningless for 0 (and denormals), their result is 0 */
+		return _mm_and_ps(_mm_mul_ps(power, scale), _mm_cmpge_ps(x, _mm_set1_ps(1.17549435e-38f)));
+	}
+
+	/* One pixel to four int32 in [0, 255] */
+	INTERNALSCOPE __m128i QuantizePixelSSE2(const __m128 pixel, const __m128 offset, const __m128 exponent, const __m128 colorMask, const bool applyGamma)
+	{
+		/* maxps returns its second operand when one is NaN, so NaN becomes 0 */
+		__m128 value = _mm_min_ps(_mm_max_ps(pixel, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		if (applyGamma)
+			value = _mm_or_ps(_mm_and_ps(colorMask, PowUnitSSE2(value, exponent)), _mm_andnot_ps(colorMask, value));
+
+		const __m128 scaled = _mm_min_ps(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), offset), _mm_set1_ps(255.0f));
+		return _mm_cvttps_epi32(scaled);
+	}
+
+	INTERNALSCOPE void ConvertFloatRowSSE2(const float* source, uint8_t* destination, const uint32_t count, const uint32_t x, const QuantizationOffsets& offsets, const float inverseGamma)
+	{
+		const __m128 exponent = _mm_set1_ps(inverseGamma);
+		const __m128 colorMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+		const bool applyGamma = inverseGamma != 1.0f;
+
+		uint32_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const float* offset = offsets.Values + ((x + i) & 7) * 4;
+			const __m128i p0 = QuantizePixelSSE2(_mm_loadu_ps(source + i * 4 + 0), _mm_load_ps(offset + 0), exponent, colorMask, applyGamma);
+			const __m128i p1 = QuantizePixelSSE2(_mm_loadu_ps(source + i * 4 + 4), _mm_load_ps(offset + 4), exponent, colorMask, applyGamma);
+			const __m128i p2 = QuantizePixelSSE2(_mm_loadu_ps(source + i * 4 + 8), _mm_load_ps(offset + 8), exponent, colorMask, applyGamma);
+			const __m128i p3 = QuantizePixelSSE2(_mm_loadu_ps(source + i * 4 + 12), _mm_load_ps(offset + 12), exponent, colorMask, applyGamma);
+			const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 4), packed);
+		}
+
+		for (; i < count; ++i)
+		{
+			const __m128i pixel = QuantizePixelSSE2(_mm_loadu_ps(source + i * 4), _mm_load_ps(offsets.Values + ((x + i) & 7) * 4), exponent, colorMask, applyGamma);
+			const __m128i word = _mm_packs_epi32(pixel, pixel);
+			const int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(word, word));
+			memcpy(destination + i * 4, &packed, sizeof(packed));
+		}
+	}
+
+	/* Same approximation as PowUnitSSE2, two pixels per register */
+	APP_TARGET_AVX2 INTERNALSCOPE __m256 PowUnitAVX2(const __m256 x, const __m256 exponent)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256i bits = _mm256_castps_si256(x);
+		const __m256 biasedExponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+		const __m256 mantissa = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_castps_si256(one)));
+
+		const __m256 t = _mm256_div_ps(_mm256_sub_ps(mantissa, one), _mm256_add_ps(mantissa, one));
+		const __m256 t2 = _mm256_mul_ps(t, t);
+		__m256 series = _mm256_set1_ps(1.0f / 9.0f);
+		series = _mm256_fmadd_ps(series, t2, _mm256_set1_ps(1.0f / 7.0f));
+		series = _mm256_fmadd_ps(series, t2, _mm256_set1_ps(1.0f / 5.0f));
+		series = _mm256_fmadd_ps(series, t2, _mm256_set1_ps(1.0f / 3.0f));
+		series = _mm256_fmadd_ps(series, t2, one);
+		const __m256 log2 = _mm256_fmadd_ps(_mm256_mul_ps(series, t), _mm256_set1_ps(2.88539008f), biasedExponent);
+
+		const __m256 y = _mm256_max_ps(_mm256_mul_ps(log2, exponent), _mm256_set1_ps(-126.0f));
+		const __m256 integer = _mm256_floor_ps(y);
+		const __m256 fraction = _mm256_sub_ps(y, integer);
+
+		__m256 power = _mm256_set1_ps(1.5403530e-4f);
+		power = _mm256_fmadd_ps(power, fraction, _mm256_set1_ps(1.3333558e-3f));
+		power = _mm256_fmadd_ps(power, fraction, _mm256_set1_ps(9.6181291e-3f));
+		power = _mm256_fmadd_ps(power, fraction, _mm256_set1_ps(5.5504109e-2f));
+		power = _mm256_fmadd_ps(power, fraction, _mm256_set1_ps(2.4022651e-1f));
+		power = _mm256_fmadd_ps(power, fraction, _mm256_set1_ps(6.9314718e-1f));
+		power = _mm256_fmadd_ps(power, fraction, one);
+
+		const __m256 scale = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(integer), _mm256_set1_epi32(127)), 23));
+		return _mm256_and_ps(_mm256_mul_ps(power, scale), _mm256_cmp_ps(x, _mm256_set1_ps(1.17549435e-38f), _CMP_GE_OQ));
+	}
+
+	APP_TARGET_AVX2 INTERNALSCOPE __m256i QuantizePixelPairAVX2(const __m256 pixels, const __m256 offset, const __m256 exponent, const __m256 colorMask, const bool applyGamma)
+	{
+		__m256 value = _mm256_min_ps(_mm256_max_ps(pixels, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+		if (applyGamma)
+			value = _mm256_blendv_ps(value, PowUnitAVX2(value, exponent), colorMask);
+
+		const __m256 scaled = _mm256_min_ps(_mm256_fmadd_ps(value, _mm256_set1_ps(255.0f), offset), _mm256_set1_ps(255.0f));
+		return _mm256_cvttps_epi32(scaled);
+	}
+
+	APP_TARGET_AVX2 INTERNALSCOPE void ConvertFloatRowAVX2(const float* source, uint8_t* destination, const uint32_t count, const uint32_t x, const QuantizationOffsets& offsets, const float inverseGamma)
+	{
+		const __m256 exponent = _mm256_set1_ps(inverseGamma);
+		const __m256 colorMask = _mm256_castsi256_ps(_mm256_set_epi32(0, -1, -1, -1, 0, -1, -1, -1));
+		/* The in-lane packs leave pixels in the order 0 2 4 6 1 3 5 7 */
+		const __m256i pixelOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+		const bool applyGamma = inverseGamma != 1.0f;
+
+		uint32_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const float* offset = offsets.Values + ((x + i) & 7) * 4;
+			const __m256i p01 = QuantizePixelPairAVX2(_mm256_loadu_ps(source + i * 4 + 0), _mm256_loadu_ps(offset + 0), exponent, colorMask, applyGamma);
+			const __m256i p23 = QuantizePixelPairAVX2(_mm256_loadu_ps(source + i * 4 + 8), _mm256_loadu_ps(offset + 8), exponent, colorMask, applyGamma);
+			const __m256i p45 = QuantizePixelPairAVX2(_mm256_loadu_ps(source + i * 4 + 16), _mm256_loadu_ps(offset + 16), exponent, colorMask, applyGamma);
+			const __m256i p67 = QuantizePixelPairAVX2(_mm256_loadu_ps(source + i * 4 + 24), _mm256_loadu_ps(offset + 24), exponent, colorMask, applyGamma);
+			const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(p01, p23), _mm256_packs_epi32(p45, p67));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i * 4), _mm256_permutevar8x32_epi32(packed, pixelOrder));
+		}
+
+		if (i < count)
+			ConvertFloatRowSSE2(source + i * 4, destination + i * 4, count - i, x + i, offsets, inverseGamma);
+	}
+#endif
+
+	/* Splits rows into a few chunks per thread, enough to balance without paying per row */
+	INTERNALSCOPE void ParallelForRows(ThreadPool& threadPool, const uint32_t height, const std::function<void(const uint32_t firstRow, const uint32_t endRow)>& function)
+	{
+		const uint32_t chunkCount = std::min(height, threadPool.GetThreadCount() * 4);
+		if (chunkCount == 0)
+			return;
+
+		threadPool.ParallelFor(chunkCount, [&](const uint32_t chunk) {
+			const uint32_t firstRow = static_cast<uint32_t>(static_cast<uint64_t>(height) * chunk / chunkCount);
+			const uint32_t endRow = static_cast<uint32_t>(static_cast<uint64_t>(height) * (chunk + 1) / chunkCount);
+			function(firstRow, endRow);
+		});
+	}
+}
+
+void PostProcess::ConvertFloatRowReference(const float* source, uint8_t* destination, const uint32_t count, const uint32_t x, const uint32_t y, const ConversionSettings& settings)
+{
+	Utilities::QuantizationOffsets offsets;
+	Utilities::BuildQuantizationOffsets(y, settings.Dither, offsets);
+	const float inverseGamma = 1.0f / settings.Gamma;
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const float* offset = offsets.Values + ((x + i) & 7) * 4;
+		for (uint32_t channel = 0; channel < 4; ++channel)
+			destination[i * 4 + channel] = Utilities::QuantizeReference(source[i * 4 + channel], inverseGamma, channel < 3, offset[channel]);
+	}
+}
+
+void PostProcess::ConvertFloatRow(const float* source, uint8_t* destination, const uint32_t count, const uint32_t x, const uint32_t y, const ConversionSettings& settings, const ESimdLevel level)
+{
+#if APP_SIMD_X64
+	if (level != ESimdLevel::Scalar)
+	{
+		Utilities::QuantizationOffsets offsets;
+		Utilities::BuildQuantizationOffsets(y, settings.Dither, offsets);
+		if (level >= ESimdLevel::AVX2)
+			Utilities::ConvertFloatRowAVX2(source, destination, count, x, offsets, 1.0f / settings.Gamma);
+		else
+			Utilities::ConvertFloatRowSSE2(source, destination, count, x, offsets, 1.0f / settings.Gamma);
+
+		return;
+	}
+#endif
+
+	ConvertFloatRowReference(source, destination, count, x, y, settings);
+}
+
+void PostProcess::ConvertFloatToRGBA8(
+	const float* source, const std::size_t sourcePitch,
+	uint8_t* destination, const std::size_t destinationPitch,
+	const uint32_t width, const uint32_t height, const uint32_t x, const uint32_t y,
+	const ConversionSettings& settings, ThreadPool& threadPool, const ESimdLevel level)
+{
+	Utilities::ParallelForRows(threadPool, height, [&](const uint32_t firstRow, const uint32_t endRow) {
+		for (uint32_t row = firstRow; row < endRow; ++row)
+			ConvertFloatRow(
+				reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(source) + row * sourcePitch),
+				destination + row * destinationPitch,
+				width,
+				x,
+				y + row,
+				settings,
+				level);
+	});
+}
+
+void PostProcess::ColorIterations(
+	const uint32_t* source, const std::size_t sourcePitch,
+	uint8_t* destination, const std::size_t destinationPitch,
+	const uint32_t width, const uint32_t height, const uint32_t maxIterations,
+	const ColoringSettings& coloring, ThreadPool& threadPool)
+{
+	const CosinePaletteCoefficients& coefficients = Coloring::GetCoefficients(coloring.Palette);
+	const float limit = static_cast<float>(maxIterations);
+	Utilities::ParallelForRows(threadPool, height, [&](const uint32_t firstRow, const uint32_t endRow) {
+		for (uint32_t row = firstRow; row < endRow; ++row)
+		{
+			const uint32_t* iterations = reinterpret_cast<const uint32_t*>(reinterpret_cast<const uint8_t*>(source) + row * sourcePitch);
+			uint8_t* rgba = destination + row * destinationPitch;
+			for (uint32_t x = 0; x < width; ++x)
+				Coloring::Palette(coefficients, Coloring::MapEscapeTime(static_cast<float>(iterations[x]), limit, coloring), rgba + x * 4);
+		}
+	});
+}
+
+void PostProcess::ColorSmoothIterations(
+	const uint16_t* source, const std::size_t sourcePitch,
+	uint8_t* destination, const std::size_t destinationPitch,
+	const uint32_t width, const uint32_t height, const uint32_t maxIterations,
+	const ColoringSettings& coloring, ThreadPool& threadPool)
+{
+	const CosinePaletteCoefficients& coefficients = Coloring::GetCoefficients(coloring.Palette);
+	const float limit = static_cast<float>(maxIterations);
+	Utilities::ParallelForRows(threadPool, height, [&](const uint32_t firstRow, const uint32_t endRow) {
+		for (uint32_t row = firstRow; row < endRow; ++row)
+		{
+			const uint16_t* smoothIterations = reinterpret_cast<const uint16_t*>(reinterpret_cast<const uint8_t*>(source) + row * sourcePitch);
+			uint8_t* rgba = destination + row * destinationPitch;
+			for (uint32_t x = 0; x < width; ++x)
+				Coloring::Palette(coefficients, Coloring::MapEscapeTime(glm::unpackHalf1x16(smoothIterations[x]), limit, coloring), rgba + x * 4);
+		}
+	});
+}
@@ -0,0 +1,365 @@
+/* Entry point of the headless offline renderer (mandelbrot-render) */
+#include "include/Core.h"
+#include "include/OfflineRenderer.h"
+#include "include/ImageWriter.h"
+#include "include/Platform.h"
+#include "include/ZoomSequence.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <sstream>
+
+INTERNALSCOPE void PrintUsage(const char* executableName)
+{
+	printf(
+		"Usage: %s [options]\n"
+		"  --width <pixels>        Output width (default 6400)\n"
+		"  --height <pixels>       Output height (default 4800)\n"
+		"  --iterations <count>    Iteration limit (default 10000)\n"
+		"  --center <x> <y>        Viewport center in the complex plane (default -0.445 0.0)\n"
+		"  --scale <extent>        Horizontal extent of the viewport (default 2.34)\n"
+		"  --output <path>         Output file, .png or .pam (default mandelbrot.png).\n"
+		"                          Both are streamed while rendering, host memory does not grow with the image\n"
+		"  --format <format>       Compute output: rgba8 (default, colored on the GPU),\n"
+		"                          iterations (uint32) or smooth (float16), both colored on the CPU,\n"
+		"                          or float (linear float32 RGBA, quantized on the CPU)\n"
+		"  --gamma <gamma>         Gamma applied when quantizing --format float (default 1, linear)\n"
+		"  --dither                Ordered dithering instead of rounding for --format float\n"
+		"  --palette <name>        Palette of the CPU colored formats: twilight (default), rainbow,\n"
+		"                          fire, ocean or grayscale\n"
+		"  --color-scale <scale>   Palette periods per iteration limit (default 1)\n"
+		"  --color-offset <offset> Palette shift (default 0)\n"
+		"  --save-escape-time <path> Also store the escape time buffer (requires --format smooth)\n"
+		"  --recolor <path>        Color a saved escape time buffer into --output without rendering,\n"
+		"                          only the palette options apply\n"
+		"  --zoom-frames <count>   Render a zoom video of <count> frames from --scale to --zoom-to,\n"
+		"                          --output is then a frame pattern such as frame%%05d.png\n"
+		"  --zoom-to <scale>       Extent of the last zoom frame\n"
+		"  --cpu                   Render with the CPU kernels instead of the vulkan device\n"
+		"                          (also the fallback when no suitable device exists)\n"
+		"  --simd <level>          Highest instruction set of the CPU kernels: scalar, sse2, avx2 or avx512\n"
+		"                          (default: the best the CPU supports)\n"
+		"  --verify-cpu            Render every tile on the CPU as well and report the pixels that differ\n"
+		"  --subdivide             Mariani-Silver subdivision of CPU renders: rectangles with a uniform\n"
+		"                          border are filled without iterating (smooth fills only the inside).\n"
+		"                          Device renders reject it, pass --cpu as well\n"
+		"  --subdivide-min <pixels> Rectangles this small are iterated pixel by pixel (default 8)\n"
+		"  --subdivide-depth <count> Deepest subdivision below a tile (default 16)\n"
+		"  --subdivide-margin <rings> Rings inside a uniform border that have to match it too (default 0)\n"
+		"  --no-cardioid           Iterate points in the main cardioid instead of settling them analytically\n"
+		"  --no-bulb               Iterate points in the period-2 bulb instead of settling them analytically\n"
+		"  --no-periodicity        Disable orbit periodicity detection\n"
+		"  --periodicity-tolerance <distance> Distance that counts as a repeated orbit (default 1e-6)\n"
+		"  --precision <precision> Compute shader arithmetic: auto (default, float64 once float32 cannot\n"
+		"                          resolve the pixels and the device has shaderFloat64), fp32 or fp64\n"
+		"  --perturbation <mode>   Deep zoom by perturbation: auto (default, once float64 cannot resolve the\n"
+		"                          pixels), off or on. The center is then parsed in full precision\n"
+		"  --no-series             Iterate perturbation renders from the start instead of skipping what the\n"
+		"                          series approximation covers\n"
+		"  --compare-precision     Benchmark: render the view in fp32 and fp64 without writing it and\n"
+		"                          compare throughput and pixels\n"
+		"  --tile-size <pixels>    Edge length of the render tiles (default: derived from device memory)\n"
+		"  --shaders <directory>   Directory containing the compiled SPIR-V (default assets/shaders/)\n"
+		"  --pipeline-cache <path> Load/store compiled pipelines, later runs skip shader compilation\n"
+		"  --orbit-cache <directory> Load/store perturbation reference orbits, later renders of the same\n"
+		"                          center, precision and iteration limit skip computing them\n"
+		"  --batch <file>          Render one job per line of <file>, each line holds the options above.\n"
+		"                          All jobs share one device and reuse compiled pipeline variants\n"
+		"  --help                  Print this message\n",
+		executableName);
+}
+
+INTERNALSCOPE bool ParseArguments(const int argc, char** argv, OfflineRenderSettings& settings, std::string& batchPath, bool& comparePrecision)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view argument = argv[i];
+		const int remaining = argc - i - 1;
+
+		if (argument == "--help" || argument == "-h")
+			return false;
+		else if (argument == "--width" && remaining >= 1)
+			settings.Width = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--height" && remaining >= 1)
+			settings.Height = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--iterations" && remaining >= 1)
+			settings.MaxIterations = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--center" && remaining >= 2)
+		{
+			/* The text too, perturbation renders parse it past double precision */
+			settings.PreciseCenterX = argv[++i];
+			settings.CenterX = strtod(argv[i], nullptr);
+			settings.PreciseCenterY = argv[++i];
+			settings.CenterY = strtod(argv[i], nullptr);
+		}
+		else if (argument == "--scale" && remaining >= 1)
+			settings.Scale = strtod(argv[++i], nullptr);
+		else if (argument == "--output" && remaining >= 1)
+			settings.OutputPath = argv[++i];
+		else if (argument == "--format" && remaining >= 1)
+		{
+			const std::string_view format = argv[++i];
+			if (format == "rgba8")
+				settings.OutputFormat = EOutputFormat::RGBA8;
+			else if (format == "iterations")
+				settings.OutputFormat = EOutputFormat::Iterations;
+			else if (format == "smooth")
+				settings.OutputFormat = EOutputFormat::SmoothIterations;
+			else if (format == "float")
+				settings.OutputFormat = EOutputFormat::LinearFloat;
+			else
+			{
+				printf("Unknown output format: %s\n", argv[i]);
+				return false;
+			}
+		}
+		else if (argument == "--gamma" && remaining >= 1)
+		{
+			settings.Conversion.Gamma = strtof(argv[++i], nullptr);
+			if (!(settings.Conversion.Gamma > 0.0f))
+			{
+				printf("Gamma must be positive: %s\n", argv[i]);
+				return false;
+			}
+		}
+		else if (argument == "--dither")
+			settings.Conversion.Dither = true;
+		else if (argument == "--palette" && remaining >= 1)
+		{
+			if (!Coloring::ParsePalette(argv[++i], settings.Coloring.Palette))
+			{
+				printf("Unknown palette: %s\n", argv[i]);
+				return false;
+			}
+		}
+		else if (argument == "--color-scale" && remaining >= 1)
+			settings.Coloring.Scale = strtof(argv[++i], nullptr);
+		else if (argument == "--color-offset" && remaining >= 1)
+			settings.Coloring.Offset = strtof(argv[++i], nullptr);
+		else if (argument == "--save-escape-time" && remaining >= 1)
+			settings.EscapeTimePath = argv[++i];
+		else if (argument == "--recolor" && remaining >= 1)
+			settings.RecolorPath = argv[++i];
+		else if (argument == "--zoom-frames" && remaining >= 1)
+			settings.ZoomFrameCount = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--zoom-to" && remaining >= 1)
+			settings.ZoomFinalScale = strtod(argv[++i], nullptr);
+		else if (argument == "--cpu")
+			settings.RenderOnCpu = true;
+		else if (argument == "--simd" && remaining >= 1)
+		{
+			if (!Simd::ParseLevel(argv[++i], settings.SimdLevel))
+			{
+				printf("Unknown SIMD level: %s\n", argv[i]);
+				return false;
+			}
+		}
+		else if (argument == "--verify-cpu")
+			settings.VerifyWithCpu = true;
+		else if (argument == "--subdivide")
+			settings.Subdivision.Enabled = true;
+		else if (argument == "--subdivide-min" && remaining >= 1)
+			settings.Subdivision.MinEdge = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--subdivide-depth" && remaining >= 1)
+			settings.Subdivision.MaxDepth = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--subdivide-margin" && remaining >= 1)
+			settings.Subdivision.Margin = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--no-cardioid")
+			settings.Interior.Cardioid = false;
+		else if (argument == "--no-bulb")
+			settings.Interior.Bulb = false;
+		else if (argument == "--no-periodicity")
+			settings.Interior.Periodicity = false;
+		else if (argument == "--periodicity-tolerance" && remaining >= 1)
+			settings.Interior.PeriodicityTolerance = strtof(argv[++i], nullptr);
+		else if (argument == "--precision" && remaining >= 1)
+		{
+			const std::string_view precision = argv[++i];
+			if (precision == "auto")
+				settings.Precision = EShaderPrecision::Auto;
+			else if (precision == "fp32")
+				settings.Precision = EShaderPrecision::Single;
+			else if (precision == "fp64")
+				settings.Precision = EShaderPrecision::Double;
+			else
+			{
+				printf("Unknown precision: %s\n", argv[i]);
+				return false;
+			}
+		}
+		else if (argument == "--perturbation" && remaining >= 1)
+		{
+			const std::string_view perturbation = argv[++i];
+			if (perturbation == "auto")
+				settings.Perturbation = EPerturbation::Auto;
+			else if (perturbation == "off")
+				settings.Perturbation = EPerturbation::Off;
+			else if (perturbation == "on")
+				settings.Perturbation = EPerturbation::On;
+			else
+			{
+				printf("Unknown perturbation mode: %s\n", argv[i]);
+				return false;
+			}
+		}
+		else if (argument == "--no-series")
+			settings.Series = false;
+		else if (argument == "--compare-precision")
+			comparePrecision = true;
+		else if (argument == "--tile-size" && remaining >= 1)
+			settings.TileSize = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		else if (argument == "--pipeline-cache" && remaining >= 1)
+			settings.PipelineCachePath = argv[++i];
+		else if (argument == "--orbit-cache" && remaining >= 1)
+			settings.OrbitCacheDirectory = argv[++i];
+		else if (argument == "--batch" && remaining >= 1)
+			batchPath = argv[++i];
+		else if (argument == "--shaders" && remaining >= 1)
+		{
+			settings.ShaderDirectory = argv[++i];
+			if (!settings.ShaderDirectory.empty() && settings.ShaderDirectory.back() != '/' && settings.ShaderDirectory.back() != '\\')
+				settings.ShaderDirectory += '/';
+		}
+		else
+		{
+			printf("Unknown or incomplete argument: %s\n", argv[i]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Every batch line is parsed on top of the command line settings */
+INTERNALSCOPE bool ParseBatchFile(const std::string& batchPath, const OfflineRenderSettings& baseSettings, std::vector<OfflineRenderSettings>& jobs)
+{
+	std::ifstream file(batchPath);
+	if (!file.is_open())
+	{
+		printf("Failed to open batch file: %s\n", batchPath.c_str());
+		return false;
+	}
+
+	std::string line;
+	uint32_t lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		++lineNumber;
+		std::istringstream stream(line);
+		std::vector<std::string> tokens{ "batch" };
+		for (std::string token; stream >> token;)
+			tokens.push_back(token);
+
+		if (tokens.size() == 1 || tokens[1][0] == '#')
+			continue;
+
+		std::vector<char*> arguments;
+		for (std::string& token : tokens)
+			arguments.push_back(token.data());
+
+		OfflineRenderSettings jobSettings = baseSettings;
+		std::string nestedBatchPath;
+		bool comparePrecision = false;
+		if (!ParseArguments(static_cast<int>(arguments.size()), arguments.data(), jobSettings, nestedBatchPath, comparePrecision) || !nestedBatchPath.empty() || comparePrecision)
+		{
+			printf("Invalid job on line %u of %s\n", lineNumber, batchPath.c_str());
+			return false;
+		}
+
+		jobs.push_back(jobSettings);
+	}
+
+	return true;
+}
+
+/* Same view in float32 and float64 into memory, the second render of each is timed (the first compiles its pipeline variant) */
+INTERNALSCOPE bool ComparePrecision(OfflineRenderer& renderer, const OfflineRenderSettings& settings)
+{
+	if (!renderer.SupportsDoublePrecision())
+	{
+		printf("Comparing precisions needs a device with shaderFloat64 and computeShaderDoublePrecision.spv\n");
+		return false;
+	}
+
+	constexpr std::array<EShaderPrecision, 2> precisions{ EShaderPrecision::Single, EShaderPrecision::Double };
+	std::array<MemoryImageWriter, 2> images;
+	std::array<double, 2> renderTimes{};
+	for (std::size_t i = 0; i < precisions.size(); ++i)
+	{
+		OfflineRenderSettings job = settings;
+		job.Precision = precisions[i];
+		job.OutputPath = precisions[i] == EShaderPrecision::Single ? "fp32" : "fp64";
+		job.EscapeTimePath.clear();
+		job.VerifyWithCpu = false;
+
+		for (uint32_t run = 0; run < 2; ++run)
+		{
+			const double startTime = Platform::GetAbsoluteTime();
+			if (!renderer.Render(job, images[i]))
+				return false;
+
+			renderTimes[i] = Platform::GetAbsoluteTime() - startTime;
+		}
+	}
+
+	const std::vector<uint8_t>& singlePixels = images[0].GetPixels();
+	const std::vector<uint8_t>& doublePixels = images[1].GetPixels();
+	uint64_t differentPixelCount = 0;
+	for (std::size_t i = 0; i < singlePixels.size(); i += 4)
+		if (memcmp(&singlePixels[i], &doublePixels[i], 4) != 0)
+			++differentPixelCount;
+
+	const double pixelCount = static_cast<double>(settings.Width) * static_cast<double>(settings.Height);
+	printf("fp32: %.3f s, %.2f MPixel/s\n", renderTimes[0], pixelCount / renderTimes[0] / 1.0e6);
+	printf("fp64: %.3f s, %.2f MPixel/s, %.2fx the fp32 time\n", renderTimes[1], pixelCount / renderTimes[1] / 1.0e6, renderTimes[1] / renderTimes[0]);
+	printf("%llu of %.0f pixels differ (%.4f%%)\n", static_cast<unsigned long long>(differentPixelCount), pixelCount, 100.0 * static_cast<double>(differentPixelCount) / pixelCount);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	OfflineRenderSettings settings;
+	std::string batchPath;
+	bool comparePrecision = false;
+	if (!ParseArguments(argc, argv, settings, batchPath, comparePrecision))
+	{
+		PrintUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (comparePrecision)
+	{
+		OfflineRenderer renderer(settings);
+		const bool compared = renderer.Initialize() && ComparePrecision(renderer, settings);
+		renderer.Shutdown();
+		return compared ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	std::vector<OfflineRenderSettings> jobs;
+	if (batchPath.empty())
+		jobs.push_back(settings);
+	else if (!ParseBatchFile(batchPath, settings, jobs))
+		return EXIT_FAILURE;
+
+	/* Recoloring and CPU renders need no device, a batch of only those never creates one */
+	const bool needsDevice = std::any_of(jobs.begin(), jobs.end(), [](const OfflineRenderSettings& job) { return job.RecolorPath.empty() && !job.RenderOnCpu; });
+
+	OfflineRenderer renderer(settings);
+	if (needsDevice && !renderer.Initialize())
+	{
+		printf("Failed to initialize offline renderer\n");
+		renderer.Shutdown();
+		return EXIT_FAILURE;
+	}
+
+	ZoomSequence zoomSequence(renderer);
+	uint32_t failedJobCount = 0;
+	for (const OfflineRenderSettings& job : jobs)
+		if (job.ZoomFrameCount > 0 ? !zoomSequence.Render(job) : !renderer.Render(job))
+		{
+			printf("Failed to render image: %s\n", job.OutputPath.c_str());
+			++failedJobCount;
+		}
+
+	renderer.Shutdown();
+	return failedJobCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
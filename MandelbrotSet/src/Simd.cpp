@@ -0,0 +1,108 @@
+#include "include/Simd.h"
+#include <ctype.h>
+
+namespace Utilities {
+#if APP_SIMD_X64
+	INTERNALSCOPE void QueryCpuid(const uint32_t leaf, const uint32_t subleaf, uint32_t registers[4])
+	{
+	#ifdef _MSC_VER
+		int values[4];
+		__cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+		for (uint32_t i = 0; i < 4; ++i)
+			registers[i] = static_cast<uint32_t>(values[i]);
+	#else
+		__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+	#endif
+	}
+
+	/* XCR0, which register files the OS saves on a context switch */
+	INTERNALSCOPE uint64_t QueryEnabledStateMask()
+	{
+	#ifdef _MSC_VER
+		return _xgetbv(0);
+	#else
+		uint32_t low;
+		uint32_t high;
+		__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+		return (static_cast<uint64_t>(high) << 32) | low;
+	#endif
+	}
+
+	INTERNALSCOPE ESimdLevel DetectSimdLevel()
+	{
+		uint32_t registers[4];
+		QueryCpuid(0, 0, registers);
+		const uint32_t maxLeaf = registers[0];
+
+		/* SSE2 is part of x64 */
+		QueryCpuid(1, 0, registers);
+		const bool osxsave = (registers[2] & (1u << 27)) != 0;
+		const bool avx = (registers[2] & (1u << 28)) != 0;
+		const bool fma = (registers[2] & (1u << 12)) != 0;
+		if (!osxsave || !avx || maxLeaf < 7)
+			return ESimdLevel::SSE2;
+
+		const uint64_t stateMask = QueryEnabledStateMask();
+		/* XMM and YMM state */
+		if ((stateMask & 0x6) != 0x6)
+			return ESimdLevel::SSE2;
+
+		QueryCpuid(7, 0, registers);
+		const bool avx2 = (registers[1] & (1u << 5)) != 0;
+		const bool avx512f = (registers[1] & (1u << 16)) != 0;
+		if (!avx2 || !fma)
+			return ESimdLevel::SSE2;
+
+		/* Opmask, upper ZMM0-15 and ZMM16-31 state */
+		if (avx512f && (stateMask & 0xE0) == 0xE0)
+			return ESimdLevel::AVX512;
+
+		return ESimdLevel::AVX2;
+	}
+#endif
+}
+
+ESimdLevel Simd::GetSupportedLevel()
+{
+#if APP_SIMD_X64
+	static const ESimdLevel level = Utilities::DetectSimdLevel();
+	return level;
+#else
+	return ESimdLevel::Scalar;
+#endif
+}
+
+const char* Simd::GetLevelName(const ESimdLevel level)
+{
+	switch (level)
+	{
+		case ESimdLevel::Scalar: return "scalar";
+		case ESimdLevel::SSE2: return "sse2";
+		case ESimdLevel::AVX2: return "avx2";
+		case ESimdLevel::AVX512: return "avx512";
+	}
+
+	return "unknown";
+}
+
+bool Simd::ParseLevel(const std::string_view name, ESimdLevel& level)
+{
+	for (const ESimdLevel candidate : { ESimdLevel::Scalar, ESimdLevel::SSE2, ESimdLevel::AVX2, ESimdLevel::AVX512 })
+	{
+		const std::string_view candidateName = GetLevelName(candidate);
+		if (candidateName.size() != name.size())
+			continue;
+
+		bool equal = true;
+		for (std::size_t i = 0; i < name.size() && equal; ++i)
+			equal = tolower(static_cast<unsigned char>(name[i])) == candidateName[i];
+
+		if (equal)
+		{
+			level = candidate;
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,190 @@
+#include "include/ThreadPool.h"
+
+ThreadPool::ThreadPool(const uint32_t threadCount)
+	:
+	m_Workers(),
+	m_Queues(),
+	m_Function(nullptr),
+	m_ActiveWorkerCount(0),
+	m_Generation(0),
+	m_Stop(false),
+	m_PendingCount(0),
+	m_StealCount(0)
+{
+	uint32_t totalThreadCount = threadCount != 0 ? threadCount : std::thread::hardware_concurrency();
+	if (totalThreadCount == 0)
+		totalThreadCount = 1;
+
+	for (uint32_t i = 0; i < totalThreadCount; ++i)
+	{
+		m_Queues.push_back(std::make_unique<WorkQueue>());
+		m_Queues.back()->VictimSeed = 0x9E3779B9u * (i + 1);
+	}
+
+	for (uint32_t i = 1; i < totalThreadCount; ++i)
+		m_Workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+	}
+
+	m_WorkAvailable.notify_all();
+	for (std::thread& worker : m_Workers)
+		worker.join();
+}
+
+void ThreadPool::ParallelFor(const uint32_t count, const std::function<void(const uint32_t index)>& function)
+{
+	if (count == 0)
+		return;
+
+	if (m_Workers.empty() || count == 1)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+			function(i);
+
+		return;
+	}
+
+	/* One loop at a time, concurrent callers queue up here */
+	std::lock_guard<std::mutex> submitLock(m_SubmitMutex);
+
+	/* Contiguous equal shares, neighbouring indices (rows, tiles) stay on one thread unless stolen */
+	const uint32_t queueCount = static_cast<uint32_t>(m_Queues.size());
+	for (uint32_t queueIndex = 0; queueIndex < queueCount; ++queueIndex)
+	{
+		const uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(count) * queueIndex / queueCount);
+		const uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(count) * (queueIndex + 1) / queueCount);
+
+		WorkQueue& queue = *m_Queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Ranges.clear();
+		if (begin < end)
+			queue.Ranges.push_back({ begin, end });
+	}
+
+	m_PendingCount = count;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Function = &function;
+		++m_Generation;
+	}
+
+	m_WorkAvailable.notify_all();
+	RunIndices(0);
+
+	/* Every index was taken, wait for the workers still running theirs */
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_WorkDone.wait(lock, [this]() { return m_ActiveWorkerCount == 0; });
+	m_Function = nullptr;
+}
+
+void ThreadPool::WorkerLoop(const uint32_t queueIndex)
+{
+	uint64_t seenGeneration = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			/* A worker that slept through a whole loop finds it closed (no function) and keeps waiting */
+			m_WorkAvailable.wait(lock, [this, seenGeneration]() { return m_Stop || (m_Function && m_Generation != seenGeneration); });
+			if (m_Stop)
+				return;
+
+			seenGeneration = m_Generation;
+			++m_ActiveWorkerCount;
+		}
+
+		RunIndices(queueIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			--m_ActiveWorkerCount;
+		}
+
+		m_WorkDone.notify_all();
+	}
+}
+
+void ThreadPool::RunIndices(const uint32_t queueIndex)
+{
+	const std::function<void(const uint32_t)>& function = *m_Function;
+	for (;;)
+	{
+		uint32_t index;
+		if (PopIndex(queueIndex, index) || (Steal(queueIndex) && PopIndex(queueIndex, index)))
+		{
+			function(index);
+			continue;
+		}
+
+		/* Indices only move between deques while some are pending, a failed steal just lost a race */
+		if (m_PendingCount.load() == 0)
+			return;
+
+		std::this_thread::yield();
+	}
+}
+
+bool ThreadPool::PopIndex(const uint32_t queueIndex, uint32_t& index)
+{
+	WorkQueue& queue = *m_Queues[queueIndex];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	if (queue.Ranges.empty())
+		return false;
+
+	/* Ascending within the newest range, thieves take the upper half of the oldest one */
+	IndexRange& range = queue.Ranges.back();
+	index = range.Begin++;
+	if (range.Begin == range.End)
+		queue.Ranges.pop_back();
+
+	m_PendingCount.fetch_sub(1);
+	return true;
+}
+
+bool ThreadPool::Steal(const uint32_t queueIndex)
+{
+	WorkQueue& queue = *m_Queues[queueIndex];
+	const uint32_t queueCount = static_cast<uint32_t>(m_Queues.size());
+
+	/* Random first victim (xorshift), so idle threads do not all line up behind the same lock */
+	queue.VictimSeed ^= queue.VictimSeed << 13;
+	queue.VictimSeed ^= queue.VictimSeed >> 17;
+	queue.VictimSeed ^= queue.VictimSeed << 5;
+	const uint32_t firstVictim = queue.VictimSeed % queueCount;
+
+	for (uint32_t i = 0; i < queueCount; ++i)
+	{
+		const uint32_t victimIndex = (firstVictim + i) % queueCount;
+		if (victimIndex == queueIndex)
+			continue;
+
+		IndexRange stolen;
+		{
+			WorkQueue& victim = *m_Queues[victimIndex];
+			std::lock_guard<std::mutex> lock(victim.Mutex);
+			if (victim.Ranges.empty())
+				continue;
+
+			/* The oldest range is the largest, half of it is worth the trip */
+			IndexRange& range = victim.Ranges.front();
+			const uint32_t middle = range.Begin + (range.End - range.Begin) / 2;
+			stolen = { middle, range.End };
+			range.End = middle;
+			if (range.Begin == range.End)
+				victim.Ranges.pop_front();
+		}
+
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Ranges.push_back(stolen);
+		m_StealCount.fetch_add(1);
+		return true;
+	}
+
+	return false;
+}
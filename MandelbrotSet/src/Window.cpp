@@ -85,6 +85,12 @@ void Window::PollEvents()
 	}
 }
 
+void Window::WaitEvents()
+{
+	WaitMessage();
+	PollEvents();
+}
+
 bool Window::KeyPressed(const KeyCode keyCode)
 {
 	return static_cast<bool>(m_KeyStates[static_cast<std::size_t>(keyCode)]);
@@ -0,0 +1,265 @@
+#include "include/ZoomSequence.h"
+#include "include/ImageWriter.h"
+#include "include/Platform.h"
+#include <algorithm>
+#include <future>
+#include <math.h>
+
+namespace Utilities {
+	/* Band along the inner keyframe's border where both keyframes are blended, in inner keyframe extents */
+	constexpr float KeyframeBlendWidth = 0.05f;
+	/* Frame rows resampled per thread pool index */
+	constexpr uint32_t ResampleRowBlock = 16;
+	/* 2x2 taps per frame pixel, the keyframes are 1 to 4 times denser than the frame */
+	constexpr std::array<float, 2> TapOffsets = { -0.25f, 0.25f };
+
+	/* Pixel i holds the value at coordinate i, the same convention as PixelToComplex in computeShader.comp */
+	INTERNALSCOPE void AccumulateBilinear(const uint8_t* pixels, const uint32_t width, const uint32_t height, float x, float y, const float weight, float rgba[4])
+	{
+		x = std::min(std::max(x, 0.0f), static_cast<float>(width - 1));
+		y = std::min(std::max(y, 0.0f), static_cast<float>(height - 1));
+		const uint32_t x0 = static_cast<uint32_t>(x);
+		const uint32_t y0 = static_cast<uint32_t>(y);
+		const uint32_t x1 = std::min(x0 + 1, width - 1);
+		const uint32_t y1 = std::min(y0 + 1, height - 1);
+		const float fx = x - static_cast<float>(x0);
+		const float fy = y - static_cast<float>(y0);
+
+		const uint8_t* p00 = pixels + (static_cast<std::size_t>(y0) * width + x0) * 4;
+		const uint8_t* p10 = pixels + (static_cast<std::size_t>(y0) * width + x1) * 4;
+		const uint8_t* p01 = pixels + (static_cast<std::size_t>(y1) * width + x0) * 4;
+		const uint8_t* p11 = pixels + (static_cast<std::size_t>(y1) * width + x1) * 4;
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			const float top = p00[channel] + (p10[channel] - p00[channel]) * fx;
+			const float bottom = p01[channel] + (p11[channel] - p01[channel]) * fx;
+			rgba[channel] += (top + (bottom - top) * fy) * weight;
+		}
+	}
+
+	/* Accepts exactly one integer conversion such as %d or %05d, nothing else is passed to snprintf */
+	INTERNALSCOPE bool IsFramePattern(const std::string& pattern)
+	{
+		uint32_t conversionCount = 0;
+		for (std::size_t i = 0; i < pattern.size(); ++i)
+		{
+			if (pattern[i] != '%')
+				continue;
+
+			std::size_t j = i + 1;
+			while (j < pattern.size() && pattern[j] >= '0' && pattern[j] <= '9')
+				++j;
+
+			if (j >= pattern.size() || pattern[j] != 'd')
+				return false;
+
+			++conversionCount;
+			i = j;
+		}
+
+		return conversionCount == 1;
+	}
+}
+
+ZoomSequence::ZoomSequence(OfflineRenderer& renderer)
+	:
+	m_Renderer(renderer),
+	m_Settings(),
+	m_KeyframeWidth(0),
+	m_KeyframeHeight(0),
+	m_ThreadPool(),
+	m_Frame()
+{}
+
+bool ZoomSequence::Render(const OfflineRenderSettings& settings)
+{
+	m_Settings = settings;
+	if (m_Settings.ZoomFrameCount == 0 || m_Settings.Width == 0 || m_Settings.Height == 0 ||
+		!(m_Settings.ZoomFinalScale > 0.0) || m_Settings.ZoomFinalScale > m_Settings.Scale)
+	{
+		printf("Invalid zoom sequence: %u frames from scale %g to %g, the final scale must be positive and at most the start scale\n",
+			m_Settings.ZoomFrameCount, m_Settings.Scale, m_Settings.ZoomFinalScale);
+		return false;
+	}
+
+	if (!Utilities::IsFramePattern(m_Settings.OutputPath))
+	{
+		printf("Zoom sequence output must contain one frame number conversion such as %%05d: %s\n", m_Settings.OutputPath.c_str());
+		return false;
+	}
+
+	if (!m_Settings.EscapeTimePath.empty() || !m_Settings.RecolorPath.empty())
+	{
+		printf("Zoom sequences cannot save or recolor escape time buffers\n");
+		return false;
+	}
+
+	m_KeyframeWidth = m_Settings.Width * KeyframeScale;
+	m_KeyframeHeight = m_Settings.Height * KeyframeScale;
+	m_Frame.resize(static_cast<std::size_t>(m_Settings.Width) * m_Settings.Height * 4);
+
+	/* Keyframe k has scale Scale / 2^k, the last one is at most as large as the final frame */
+	const double octaveCount = log2(m_Settings.Scale / m_Settings.ZoomFinalScale);
+	const uint32_t keyframeCount = static_cast<uint32_t>(ceil(octaveCount - 1.0e-9)) + 1;
+
+	/* Frames shrink monotonically, so each keyframe interval owns a contiguous range ending at frameEnds[k] */
+	std::vector<uint32_t> frameEnds(keyframeCount, 0);
+	for (uint32_t frame = 0; frame < m_Settings.ZoomFrameCount; ++frame)
+	{
+		const double octave = log2(m_Settings.Scale / GetFrameScale(frame));
+		const uint32_t interval = std::min(static_cast<uint32_t>(std::max(0.0, floor(octave + 1.0e-9))), keyframeCount - 1);
+		frameEnds[interval] = frame + 1;
+	}
+
+	for (uint32_t k = 1; k < keyframeCount; ++k)
+		frameEnds[k] = std::max(frameEnds[k], frameEnds[k - 1]);
+
+	printf("Zoom sequence: %u frames of %ux%u from %u keyframes of %ux%u\n",
+		m_Settings.ZoomFrameCount, m_Settings.Width, m_Settings.Height, keyframeCount, m_KeyframeWidth, m_KeyframeHeight);
+
+	const double startTime = Platform::GetAbsoluteTime();
+	std::array<Keyframe, KeyframeSlotCount> keyframes;
+	if (!RenderKeyframe(0, keyframes[0]))
+		return false;
+
+	bool succeeded = true;
+	uint32_t firstFrame = 0;
+	std::future<bool> pendingFrames;
+	for (uint32_t k = 0; k < keyframeCount; ++k)
+	{
+		/* Overlaps with the frames of the previous interval, which only read the other two slots */
+		if (k + 1 < keyframeCount)
+			succeeded = RenderKeyframe(k + 1, keyframes[(k + 1) % KeyframeSlotCount]);
+
+		if (pendingFrames.valid())
+			succeeded = pendingFrames.get() && succeeded;
+
+		if (!succeeded)
+			break;
+
+		const Keyframe* inner = k + 1 < keyframeCount ? &keyframes[(k + 1) % KeyframeSlotCount] : nullptr;
+		pendingFrames = std::async(std::launch::async, &ZoomSequence::WriteFrames, this, firstFrame, frameEnds[k], std::cref(keyframes[k % KeyframeSlotCount]), inner);
+		firstFrame = frameEnds[k];
+	}
+
+	if (pendingFrames.valid())
+		succeeded = pendingFrames.get() && succeeded;
+
+	if (!succeeded)
+		return false;
+
+	/* Pixels iterated against rendering every frame on its own */
+	const double keyframePixels = static_cast<double>(keyframeCount) * m_KeyframeWidth * m_KeyframeHeight;
+	const double framePixels = static_cast<double>(m_Settings.ZoomFrameCount) * m_Settings.Width * m_Settings.Height;
+	printf("Zoom sequence done in %.3f s: %.1f MPixel iterated for %.1f MPixel of frames (%.1fx less than per-frame renders)\n",
+		Platform::GetAbsoluteTime() - startTime, keyframePixels / 1.0e6, framePixels / 1.0e6, framePixels / keyframePixels);
+	return true;
+}
+
+bool ZoomSequence::RenderKeyframe(const uint32_t index, Keyframe& keyframe)
+{
+	OfflineRenderSettings keyframeSettings = m_Settings;
+	keyframeSettings.Width = m_KeyframeWidth;
+	keyframeSettings.Height = m_KeyframeHeight;
+	keyframeSettings.Scale = ldexp(m_Settings.Scale, -static_cast<int>(index));
+	keyframeSettings.OutputPath = "keyframe " + std::to_string(index);
+	keyframeSettings.ZoomFrameCount = 0;
+
+	/* Reuses the allocation of the keyframe this slot held before */
+	MemoryImageWriter writer;
+	writer.GetPixels().swap(keyframe.Pixels);
+	const bool rendered = m_Renderer.Render(keyframeSettings, writer);
+	keyframe.Pixels.swap(writer.GetPixels());
+	keyframe.Scale = keyframeSettings.Scale;
+	return rendered;
+}
+
+bool ZoomSequence::WriteFrames(const uint32_t firstFrame, const uint32_t endFrame, const Keyframe& outer, const Keyframe* inner)
+{
+	for (uint32_t frame = firstFrame; frame < endFrame; ++frame)
+	{
+		ResampleFrame(GetFrameScale(frame), outer, inner);
+
+		const std::string framePath = GetFramePath(frame);
+		std::unique_ptr<ImageWriter> writer = ImageWriter::Create(framePath, m_ThreadPool);
+		if (!writer->Open(framePath, m_Settings.Width, m_Settings.Height) ||
+			!writer->WriteTile(0, 0, m_Settings.Width, m_Settings.Height, m_Frame.data(), static_cast<std::size_t>(m_Settings.Width) * 4) ||
+			!writer->Close())
+		{
+			printf("Failed to write frame %u: %s\n", frame, framePath.c_str());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void ZoomSequence::ResampleFrame(const double scale, const Keyframe& outer, const Keyframe* inner)
+{
+	/* Frame extent relative to each keyframe, (0.5, 1] for the outer and (1, 2] for the inner one */
+	const float outerRatio = static_cast<float>(scale / outer.Scale);
+	const float innerRatio = inner ? static_cast<float>(scale / inner->Scale) : 0.0f;
+	const float inverseWidth = 1.0f / static_cast<float>(m_Settings.Width);
+	const float inverseHeight = 1.0f / static_cast<float>(m_Settings.Height);
+	const float keyframeWidth = static_cast<float>(m_KeyframeWidth);
+	const float keyframeHeight = static_cast<float>(m_KeyframeHeight);
+	constexpr float tapWeight = 1.0f / (Utilities::TapOffsets.size() * Utilities::TapOffsets.size());
+
+	const uint32_t blockCount = (m_Settings.Height + Utilities::ResampleRowBlock - 1) / Utilities::ResampleRowBlock;
+	m_ThreadPool.ParallelFor(blockCount, [&](const uint32_t block) {
+		const uint32_t endRow = std::min(m_Settings.Height, (block + 1) * Utilities::ResampleRowBlock);
+		for (uint32_t y = block * Utilities::ResampleRowBlock; y < endRow; ++y)
+		{
+			uint8_t* row = m_Frame.data() + static_cast<std::size_t>(y) * m_Settings.Width * 4;
+			for (uint32_t x = 0; x < m_Settings.Width; ++x)
+			{
+				float rgba[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				for (const float offsetY : Utilities::TapOffsets)
+					for (const float offsetX : Utilities::TapOffsets)
+					{
+						/* Position relative to the shared center, in frame extents */
+						const float u = (static_cast<float>(x) + offsetX) * inverseWidth - 0.5f;
+						const float v = (static_cast<float>(y) + offsetY) * inverseHeight - 0.5f;
+
+						float innerWeight = 0.0f;
+						if (inner)
+						{
+							const float innerU = u * innerRatio + 0.5f;
+							const float innerV = v * innerRatio + 0.5f;
+							const float edgeDistance = std::min(std::min(innerU, 1.0f - innerU), std::min(innerV, 1.0f - innerV));
+							innerWeight = std::min(std::max(edgeDistance / Utilities::KeyframeBlendWidth, 0.0f), 1.0f);
+							if (innerWeight > 0.0f)
+								Utilities::AccumulateBilinear(inner->Pixels.data(), m_KeyframeWidth, m_KeyframeHeight,
+									innerU * keyframeWidth, innerV * keyframeHeight, innerWeight * tapWeight, rgba);
+						}
+
+						if (innerWeight < 1.0f)
+							Utilities::AccumulateBilinear(outer.Pixels.data(), m_KeyframeWidth, m_KeyframeHeight,
+								(u * outerRatio + 0.5f) * keyframeWidth, (v * outerRatio + 0.5f) * keyframeHeight, (1.0f - innerWeight) * tapWeight, rgba);
+					}
+
+				for (uint32_t channel = 0; channel < 4; ++channel)
+					row[x * 4 + channel] = static_cast<uint8_t>(std::min(rgba[channel] + 0.5f, 255.0f));
+			}
+		}
+	});
+}
+
+double ZoomSequence::GetFrameScale(const uint32_t frame) const
+{
+	if (m_Settings.ZoomFrameCount < 2)
+		return m_Settings.Scale;
+
+	/* Exponential, so the zoom speed is constant */
+	const double t = static_cast<double>(frame) / static_cast<double>(m_Settings.ZoomFrameCount - 1);
+	return m_Settings.Scale * pow(m_Settings.ZoomFinalScale / m_Settings.Scale, t);
+}
+
+std::string ZoomSequence::GetFramePath(const uint32_t frame) const
+{
+	const int length = snprintf(nullptr, 0, m_Settings.OutputPath.c_str(), frame);
+	std::string path(static_cast<std::size_t>(std::max(length, 0)) + 1, '\0');
+	snprintf(path.data(), path.size(), m_Settings.OutputPath.c_str(), frame);
+	path.resize(static_cast<std::size_t>(std::max(length, 0)));
+	return path;
+}
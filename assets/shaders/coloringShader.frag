@@ -0,0 +1,76 @@
+#version 450 core
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) out vec4 Color;
+
+/* Must match VulkanApp::UBO */
+layout(std140, set = 0, binding = 0) uniform UniformBufferObject {
+	int IterationCount;
+	int PaletteIndex;
+	float ColorScale;
+	float ColorOffset;
+	/* D, E, F, G of the cosine palette, see Coloring.h */
+	vec4 PaletteCoefficients[4];
+	uint InteriorChecks;
+	float PeriodicityTolerance;
+	/* Lattice of the last escape time pass, see fragmentShader.frag */
+	uint ReprojectionMode;
+	uint RefineStep;
+	uint RefineGridX;
+	uint RefineGridY;
+	float ReprojectionScaleX;
+	float ReprojectionScaleY;
+	float ReprojectionOffsetX;
+	float ReprojectionOffsetY;
+} ubo;
+
+/* Must match VulkanApp::CameraPushConstants up to the accumulated sample, see Accumulation.h */
+layout(push_constant) uniform PushConstants {
+	float AspectRatio;
+	float CenterX;
+	float CenterY;
+	float ZoomScale;
+	float SampleOffsetX;
+	float SampleOffsetY;
+	uint SampleIndex;
+} camera;
+
+layout(set = 1, binding = 0) uniform sampler2D u_ColorPalette;
+layout(set = 2, binding = 0) uniform sampler2D u_EscapeTime;
+
+/* Deferred coloring: one lookup per pixel, palette changes never rerun the escape time pass */
+void main()
+{
+	const ivec2 pixel = ivec2(gl_FragCoord.xy);
+	const vec2 texel = texelFetch(u_EscapeTime, pixel, 0).xy;
+	float escapeTime = texel.x;
+	/* Pixels the escape time pass has not iterated yet (code 0) take the lattice sample at or before them */
+	if (texel.y == 0.0)
+	{
+		const int step = int(ubo.RefineStep);
+		ivec2 latticePixel = pixel - ((pixel + ivec2(ubo.RefineGridX, ubo.RefineGridY)) & (step - 1));
+		latticePixel += ivec2(lessThan(latticePixel, ivec2(0))) * step;
+		escapeTime = texelFetch(u_EscapeTime, latticePixel, 0).x;
+	}
+
+	const bool inside = escapeTime >= float(ubo.IterationCount);
+	const float t = escapeTime / float(ubo.IterationCount) * ubo.ColorScale + ubo.ColorOffset;
+
+	/* Palette 0 is the palette texture, its sampler mirrors so cycling has no seam */
+	if (ubo.PaletteIndex == 0)
+	{
+		const float value = inside ? 0.0 : t;
+		Color = texture(u_ColorPalette, vec2(value, value));
+	}
+	else
+	{
+		const float value = inside ? 1.0 : t;
+		const vec3 color = ubo.PaletteCoefficients[0].rgb + ubo.PaletteCoefficients[1].rgb * cos(6.28318 * (ubo.PaletteCoefficients[2].rgb * value + ubo.PaletteCoefficients[3].rgb));
+		Color = vec4(color, 1.0);
+	}
+
+#ifdef ACCUMULATE
+	/* coloringShaderAccumulate.spv blends with this weight over the mean of the samples before, which keeps the running mean */
+	Color.a = 1.0 / float(camera.SampleIndex + 1u);
+#endif
+}
@@ -1,4 +1,18 @@
+cd /d "%~dp0"
 C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe vertexShader.vert -o vertexShader.spv
 C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe fragmentShader.frag -o fragmentShader.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe --target-env=vulkan1.1 -DSUBGROUP_HISTOGRAM fragmentShader.frag -o fragmentShaderSubgroup.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe -DDOUBLE_PRECISION fragmentShader.frag -o fragmentShaderDoublePrecision.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe --target-env=vulkan1.1 -DSUBGROUP_HISTOGRAM -DDOUBLE_PRECISION fragmentShader.frag -o fragmentShaderDoublePrecisionSubgroup.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe -fshader-stage=compute -DCOMPUTE_ESCAPE_TIME fragmentShader.frag -o escapeTimeShader.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe -fshader-stage=compute --target-env=vulkan1.1 -DCOMPUTE_ESCAPE_TIME -DSUBGROUP_HISTOGRAM fragmentShader.frag -o escapeTimeShaderSubgroup.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe -fshader-stage=compute -DCOMPUTE_ESCAPE_TIME -DDOUBLE_PRECISION fragmentShader.frag -o escapeTimeShaderDoublePrecision.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe -fshader-stage=compute --target-env=vulkan1.1 -DCOMPUTE_ESCAPE_TIME -DSUBGROUP_HISTOGRAM -DDOUBLE_PRECISION fragmentShader.frag -o escapeTimeShaderDoublePrecisionSubgroup.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe coloringShader.frag -o coloringShader.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe -DACCUMULATE coloringShader.frag -o coloringShaderAccumulate.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe resolveShader.frag -o resolveShader.spv
 C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe computeShader.comp -o computeShader.spv
-pause
\ No newline at end of file
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe -DDOUBLE_PRECISION computeShader.comp -o computeShaderDoublePrecision.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe perturbationShader.comp -o perturbationShader.spv
+C:\VulkanSDK\1.2.170.0\Bin32\glslc.exe -DDOUBLE_PRECISION perturbationShader.comp -o perturbationShaderDoublePrecision.spv
+if not "%1"=="nopause" pause
\ No newline at end of file
@@ -0,0 +1,20 @@
+#!/bin/sh
+# Linux counterpart of compile.bat, requires glslc (Vulkan SDK or shaderc) on PATH.
+set -e
+cd "$(dirname "$0")"
+glslc vertexShader.vert -o vertexShader.spv
+glslc fragmentShader.frag -o fragmentShader.spv
+glslc --target-env=vulkan1.1 -DSUBGROUP_HISTOGRAM fragmentShader.frag -o fragmentShaderSubgroup.spv
+glslc -DDOUBLE_PRECISION fragmentShader.frag -o fragmentShaderDoublePrecision.spv
+glslc --target-env=vulkan1.1 -DSUBGROUP_HISTOGRAM -DDOUBLE_PRECISION fragmentShader.frag -o fragmentShaderDoublePrecisionSubgroup.spv
+glslc -fshader-stage=compute -DCOMPUTE_ESCAPE_TIME fragmentShader.frag -o escapeTimeShader.spv
+glslc -fshader-stage=compute --target-env=vulkan1.1 -DCOMPUTE_ESCAPE_TIME -DSUBGROUP_HISTOGRAM fragmentShader.frag -o escapeTimeShaderSubgroup.spv
+glslc -fshader-stage=compute -DCOMPUTE_ESCAPE_TIME -DDOUBLE_PRECISION fragmentShader.frag -o escapeTimeShaderDoublePrecision.spv
+glslc -fshader-stage=compute --target-env=vulkan1.1 -DCOMPUTE_ESCAPE_TIME -DSUBGROUP_HISTOGRAM -DDOUBLE_PRECISION fragmentShader.frag -o escapeTimeShaderDoublePrecisionSubgroup.spv
+glslc coloringShader.frag -o coloringShader.spv
+glslc -DACCUMULATE coloringShader.frag -o coloringShaderAccumulate.spv
+glslc resolveShader.frag -o resolveShader.spv
+glslc computeShader.comp -o computeShader.spv
+glslc -DDOUBLE_PRECISION computeShader.comp -o computeShaderDoublePrecision.spv
+glslc perturbationShader.comp -o perturbationShader.spv
+glslc -DDOUBLE_PRECISION perturbationShader.comp -o perturbationShaderDoublePrecision.spv
@@ -1,36 +1,361 @@
 #version 450 core
 #extension GL_ARB_separate_shader_objects : enable
+/* compile.sh builds a *Subgroup.spv variant for devices with subgroup ballots in fragment (compute for escapeTimeShader*) shaders */
+#ifdef SUBGROUP_HISTOGRAM
+#extension GL_KHR_shader_subgroup_ballot : enable
+#endif
 
+/*
+* Built in float32 and, with -DDOUBLE_PRECISION, as fragmentShaderDoublePrecision.spv (and the
+* matching subgroup and escapeTimeShader variants) for devices with shaderFloat64: zooms stay sharp
+* down to a pixel spacing of about 1e-14
+*/
+#ifdef DOUBLE_PRECISION
+	#define real double
+	#define real2 dvec2
+#else
+	#define real float
+	#define real2 vec2
+#endif
+
+/* Must match AutoIteration::HistogramBinCount */
+#define HISTOGRAM_BIN_COUNT 256u
+
+/* Pixel codes past the limit for points settled inside, see Store */
+#define SETTLED_LIMIT 1
+#define SETTLED_CARDIOID 2
+#define SETTLED_BULB 3
+#define SETTLED_PERIODICITY 4
+
+#ifdef COMPUTE_ESCAPE_TIME
+/*
+* escapeTimeShader*.spv: the same pass built as a compute shader for the async compute backend,
+* one workgroup per tile (see main)
+*/
+/* Must match Utilities::EscapeTimeTileWidth and Utilities::EscapeTimeTileHeight */
+#define TILE_WIDTH 16
+#define TILE_HEIGHT 8
+layout(local_size_x = TILE_WIDTH, local_size_y = TILE_HEIGHT, local_size_z = 1) in;
+/* Stored instead of a color attachment, coloringShader.frag samples it on the graphics queue */
+layout(set = 1, binding = 0, rg32f) uniform writeonly image2D u_EscapeTimeOutput;
+/* Pixel center and texture coordinates the quad would give the pixel */
+#define FRAG_COORD (vec2(gl_GlobalInvocationID.xy) + 0.5)
+vec2 v_TextureCoordinates;
+vec2 EscapeTime;
+#else
 layout(location = 0) in vec2 v_TextureCoordinates;
-layout(location = 1) in float v_AspectRatio;
-layout(location = 2) in float v_CenterX;
-layout(location = 3) in float v_CenterY;
-layout(location = 4) in float v_ZoomScale;
-layout(location = 5) in flat int v_IterationCount;
-layout(location = 0) out vec4 Color;
+/* Escape time pass: continuous iteration count, IterationCount inside the set, and the pixel code (see Store). Colored by coloringShader.frag */
+layout(location = 0) out vec2 EscapeTime;
+#define FRAG_COORD gl_FragCoord.xy
+#endif
 
-layout(set = 1, binding = 0) uniform sampler2D u_ColorPalette;
+/* Must match VulkanApp::UBO */
+layout(std140, set = 0, binding = 0) uniform UniformBufferObject {
+	int IterationCount;
+	int PaletteIndex;
+	float ColorScale;
+	float ColorOffset;
+	vec4 PaletteCoefficients[4];
+	/* Bit 0 cardioid, bit 1 bulb, bit 2 periodicity, see InteriorChecks.h */
+	uint InteriorChecks;
+	float PeriodicityTolerance;
+	/* Reprojection of the previous pass, see Reprojection.h */
+	uint ReprojectionMode;
+	uint RefineStep;
+	uint RefineGridX;
+	uint RefineGridY;
+	float ReprojectionScaleX;
+	float ReprojectionScaleY;
+	float ReprojectionOffsetX;
+	float ReprojectionOffsetY;
+} ubo;
 
-void main()
+/* Must match VulkanApp::CameraPushConstants, the float64 variants add the precise camera */
+layout(push_constant) uniform PushConstants {
+	float AspectRatio;
+	float CenterX;
+	float CenterY;
+	float ZoomScale;
+	/* Subpixel offset of an accumulated sample in texture coordinates, see Accumulation.h */
+	float SampleOffsetX;
+	float SampleOffsetY;
+	uint SampleIndex;
+#ifdef DOUBLE_PRECISION
+	double PreciseCenterX;
+	double PreciseCenterY;
+	double PreciseZoomScale;
+#endif
+} camera;
+
+/* Cleared before every escape time pass: points settled by each interior check and escaped points by escape iteration */
+layout(std430, set = 0, binding = 1) buffer Counters {
+	uint hitCounts[3];
+	/* Pixels iterated rather than reused, VulkanApp weighs the pass's GPU time with it */
+	uint iteratedCount;
+	/* Bin i * HISTOGRAM_BIN_COUNT / ubo.IterationCount, read back by VulkanApp to pick the next iteration limit */
+	uint escapeHistogram[HISTOGRAM_BIN_COUNT];
+};
+
+/* Copy of the previous pass's target, bound in place of the coloring pass's escape time */
+layout(set = 2, binding = 0) uniform sampler2D u_PreviousEscapeTime;
+
+/* Same float order as the CPU kernels (CpuKernels.cpp) */
+bool IsInCardioid(real2 c)
+{
+	const real x = c.x - 0.25;
+	const real imaginarySquared = c.y * c.y;
+	const real q = x * x + imaginarySquared;
+	return q * (q + x) <= 0.25 * imaginarySquared;
+}
+
+bool IsInBulb(real2 c)
+{
+	const real x = c.x + 1.0;
+	return x * x + c.y * c.y <= 0.0625;
+}
+
+void CountEscape(uint bin)
+{
+#ifdef SUBGROUP_HISTOGRAM
+#ifndef COMPUTE_ESCAPE_TIME
+	/* Helper invocations take part in ballots, their atomics would be dropped but the sums would not */
+	if (gl_HelperInvocation)
+		return;
+#endif
+
+	/* The lanes sharing the first active lane's bin add once together and leave, until every lane has added */
+	for (;;)
+	{
+		if (subgroupBroadcastFirst(bin) == bin)
+		{
+			const uint count = subgroupBallotBitCount(subgroupBallot(true));
+			if (subgroupElect())
+				atomicAdd(escapeHistogram[bin], count);
+
+			return;
+		}
+	}
+#else
+	atomicAdd(escapeHistogram[bin], 1u);
+#endif
+}
+
+/*
+* The pixel code is i + 1 for a pixel that escaped at iteration i and ubo.IterationCount + 1 + SETTLED_*
+* for one settled inside, negated for placeholders resampled from a zoomed previous pass. Reused
+* pixels count again, so the counters always describe the whole image.
+*/
+void Store(float escapeTime, int code)
+{
+	EscapeTime = vec2(escapeTime, float(code));
+	const int absoluteCode = abs(code);
+	if (absoluteCode <= ubo.IterationCount)
+		CountEscape(uint(absoluteCode - 1) * HISTOGRAM_BIN_COUNT / uint(ubo.IterationCount));
+	else if (absoluteCode > ubo.IterationCount + 1 + SETTLED_LIMIT)
+		atomicAdd(hitCounts[absoluteCode - ubo.IterationCount - 1 - SETTLED_CARDIOID], 1u);
+}
+
+/* Coarsest refinement step (8, 4, 2 or 1) whose lattice on the snapped grid holds the pixel */
+uint GetPixelStep()
+{
+	const uvec2 grid = (uvec2(FRAG_COORD) + uvec2(ubo.RefineGridX, ubo.RefineGridY)) & 7u;
+	return 1u << uint(min(findLSB(grid.x | 8u), findLSB(grid.y | 8u)));
+}
+
+/*
+* Mode 1 shifts the previous pass by whole pixels, mode 2 resamples it. Pixels that are not exact
+* are iterated if their step is at least RefineStep, the others keep a placeholder or, without one,
+* stay missing (code 0) and are colored from the lattice sample. False if the pixel has to be iterated.
+*/
+bool Reproject()
 {
-	vec2 c; 
-	c.x = (v_TextureCoordinates.x - 0.5) * v_ZoomScale - v_CenterX;
-	c.y = v_AspectRatio * (v_TextureCoordinates.y - 0.5) * v_ZoomScale - v_CenterY;
-	
-    vec2 z = c;
-    int i;
-    for(i = 0; i < v_IterationCount; ++i)
-	{
-		float x = (z.x * z.x - z.y * z.y) + c.x;
-		float y = (z.y * z.x + z.x * z.y) + c.y;
-	
-		if((x * x + y * y) > 4.0)
+	vec2 previous = vec2(0.0);
+	if (ubo.ReprojectionMode != 0u)
+	{
+		const vec2 scale = vec2(ubo.ReprojectionScaleX, ubo.ReprojectionScaleY);
+		const vec2 offset = vec2(ubo.ReprojectionOffsetX, ubo.ReprojectionOffsetY);
+		const ivec2 previousPixel = ivec2(floor(FRAG_COORD * scale + offset));
+		if (all(greaterThanEqual(previousPixel, ivec2(0))) && all(lessThan(previousPixel, textureSize(u_PreviousEscapeTime, 0))))
+			previous = texelFetch(u_PreviousEscapeTime, previousPixel, 0).xy;
+	}
+
+	if (ubo.ReprojectionMode == 1u && previous.y > 0.0)
+	{
+		Store(previous.x, int(previous.y));
+		return true;
+	}
+
+	if (GetPixelStep() >= ubo.RefineStep)
+		return false;
+
+	if (previous.y == 0.0)
+	{
+		EscapeTime = vec2(0.0);
+		return true;
+	}
+
+	Store(previous.x, -abs(int(previous.y)));
+	return true;
+}
+
+void CountIterated()
+{
+#ifdef SUBGROUP_HISTOGRAM
+#ifndef COMPUTE_ESCAPE_TIME
+	/* The elected lane must not be a helper invocation, whose atomics are dropped */
+	if (gl_HelperInvocation)
+		return;
+#endif
+
+	const uvec4 ballot = subgroupBallot(true);
+	if (subgroupElect())
+		atomicAdd(iteratedCount, subgroupBallotBitCount(ballot));
+#else
+	atomicAdd(iteratedCount, 1u);
+#endif
+}
+
+/* Escape time of the pixel at FRAG_COORD into EscapeTime */
+void Shade()
+{
+	if (Reproject())
+		return;
+
+	CountIterated();
+#ifdef DOUBLE_PRECISION
+	/* The texture coordinate only needs to resolve a pixel, everything scaled by the zoom is double */
+	dvec2 c;
+	const dvec2 textureCoordinates = dvec2(v_TextureCoordinates) + dvec2(camera.SampleOffsetX, camera.SampleOffsetY);
+	c.x = (textureCoordinates.x - 0.5) * camera.PreciseZoomScale - camera.PreciseCenterX;
+	c.y = double(camera.AspectRatio) * (textureCoordinates.y - 0.5) * camera.PreciseZoomScale - camera.PreciseCenterY;
+#else
+	vec2 c;
+	const vec2 textureCoordinates = v_TextureCoordinates + vec2(camera.SampleOffsetX, camera.SampleOffsetY);
+	c.x = (textureCoordinates.x - 0.5) * camera.ZoomScale - camera.CenterX;
+	c.y = camera.AspectRatio * (textureCoordinates.y - 0.5) * camera.ZoomScale - camera.CenterY;
+#endif
+
+	if ((ubo.InteriorChecks & 1u) != 0u && IsInCardioid(c))
+	{
+		Store(float(ubo.IterationCount), ubo.IterationCount + 1 + SETTLED_CARDIOID);
+		return;
+	}
+
+	if ((ubo.InteriorChecks & 2u) != 0u && IsInBulb(c))
+	{
+		Store(float(ubo.IterationCount), ubo.IterationCount + 1 + SETTLED_BULB);
+		return;
+	}
+
+	/* Brent's cycle detection, z is saved at iterations 1, 2, 4, 8, ... */
+	const bool periodicity = (ubo.InteriorChecks & 4u) != 0u;
+	const real toleranceSquared = real(ubo.PeriodicityTolerance) * real(ubo.PeriodicityTolerance);
+	real2 saved = real2(0.0);
+	int nextSave = 1;
+	bool periodic = false;
+
+	real2 z = c;
+	int i;
+	for(i = 0; i < ubo.IterationCount; ++i)
+	{
+		z = real2(z.x * z.x - z.y * z.y, 2.0 * z.x * z.y) + c;
+
+		/* A large escape radius keeps the continuous count smooth, same as computeShader.comp */
+		if(dot(z, z) > 65536.0)
 			break;
-		
-		z.x = x;
-		z.y = y;
-    }
-
-	const float value = i == v_IterationCount ? 0.0 : float(	i) / v_IterationCount;
-	Color = texture(u_ColorPalette, vec2(value, value)); 
-}
\ No newline at end of file
+
+		if (periodicity)
+		{
+			const real2 d = z - saved;
+			if (dot(d, d) <= toleranceSquared)
+			{
+				periodic = true;
+				i = ubo.IterationCount;
+				break;
+			}
+
+			if (i + 1 == nextSave)
+			{
+				saved = z;
+				nextSave <<= 1;
+			}
+		}
+	}
+
+	if (i == ubo.IterationCount)
+	{
+		Store(float(ubo.IterationCount), ubo.IterationCount + 1 + (periodic ? SETTLED_PERIODICITY : SETTLED_LIMIT));
+		return;
+	}
+
+	/* log2 has no double overload, |z|^2 just left the escape radius and fits a float */
+	Store(float(i) + 1.0 - log2(log2(float(dot(z, z))) * 0.5), i + 1);
+}
+
+#ifdef COMPUTE_ESCAPE_TIME
+/* Cleared by the first invocation of a tile, any border pixel that escapes or lies outside the image sets it */
+shared uint s_BorderEscaped;
+
+/*
+* Passes that iterate every pixel shade the tile's border first. The set is connected, so a tile
+* whose whole border settled inside holds no escaping pixel, and its interior is stored as reaching
+* the limit without iterating. A fragment shader never learns about its neighbours, this is what
+* the compute pass gains. The filled pixels count neither as iterated nor as interior check hits.
+*/
+void main()
+{
+	const ivec2 size = imageSize(u_EscapeTimeOutput);
+	const ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+	const bool inImage = all(lessThan(pixel, size));
+	/* Texture u runs against window y and v against window x, see vertexShader.vert */
+	v_TextureCoordinates = vec2(1.0) - FRAG_COORD.yx / vec2(size.yx);
+
+	if (ubo.ReprojectionMode == 0u && ubo.RefineStep == 1u)
+	{
+		const uvec2 local = gl_LocalInvocationID.xy;
+		const bool border = any(equal(local, uvec2(0u))) || any(equal(local, gl_WorkGroupSize.xy - 1u));
+		if (gl_LocalInvocationIndex == 0u)
+			s_BorderEscaped = 0u;
+
+		barrier();
+		if (border)
+		{
+			/* Tiles cut by the image edge have no closed border */
+			if (!inImage)
+			{
+				s_BorderEscaped = 1u;
+			}
+			else
+			{
+				Shade();
+				imageStore(u_EscapeTimeOutput, pixel, vec4(EscapeTime, 0.0, 0.0));
+				if (EscapeTime.y <= float(ubo.IterationCount))
+					s_BorderEscaped = 1u;
+			}
+		}
+
+		barrier();
+		if (border || !inImage)
+			return;
+
+		if (s_BorderEscaped == 0u)
+		{
+			Store(float(ubo.IterationCount), ubo.IterationCount + 1 + SETTLED_LIMIT);
+			imageStore(u_EscapeTimeOutput, pixel, vec4(EscapeTime, 0.0, 0.0));
+			return;
+		}
+	}
+	else if (!inImage)
+	{
+		return;
+	}
+
+	Shade();
+	imageStore(u_EscapeTimeOutput, pixel, vec4(EscapeTime, 0.0, 0.0));
+}
+#else
+void main()
+{
+	Shade();
+}
+#endif
@@ -0,0 +1,13 @@
+#version 450 core
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) out vec4 Color;
+
+/* Running mean of the accumulated samples, see Accumulation.h */
+layout(set = 2, binding = 0) uniform sampler2D u_Accumulation;
+
+/* Shows the accumulation image in the swapchain image */
+void main()
+{
+	Color = vec4(texelFetch(u_Accumulation, ivec2(gl_FragCoord.xy), 0).rgb, 1.0);
+}
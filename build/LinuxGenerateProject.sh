@@ -0,0 +1,4 @@
+#!/bin/sh
+# Generates makefiles for the headless renderer (mandelbrot-render). Requires premake5 on PATH.
+cd "$(dirname "$0")"
+premake5 gmake2
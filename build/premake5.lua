@@ -3,6 +3,7 @@ local RootDirectory = "../"
 workspace "MandelbrotSet"
 	location(RootDirectory)
 	entrypoint "wWinMainCRTStartup"  
+	startproject "MandelbrotSet"
 
 	configurations 
 	{
@@ -18,6 +19,32 @@ workspace "MandelbrotSet"
 	filter "configurations:Debug"
 		defines "APP_DEBUG"
 
+-- SPIR-V is not checked in: every build compiles the GLSL in assets/shaders with glslc first
+project "Shaders"
+	kind "Utility"
+
+	local ShaderDirectory = path.getabsolute(RootDirectory .. "assets/shaders")
+	files
+	{
+		ShaderDirectory .. "/*.vert",
+		ShaderDirectory .. "/*.frag",
+		ShaderDirectory .. "/*.comp",
+	}
+
+	filter "system:windows"
+		prebuildcommands
+		{
+			"call \"" .. path.translate(ShaderDirectory .. "/compile.bat", "\\") .. "\" nopause",
+		}
+
+	filter "system:linux"
+		prebuildcommands
+		{
+			"sh \"" .. ShaderDirectory .. "/compile.sh\"",
+		}
+
+	filter {}
+
 project "MandelbrotSet"
 	kind "ConsoleApp"
 	language "C++"
@@ -26,6 +53,7 @@ project "MandelbrotSet"
 
 	targetdir (RootDirectory .. "bin_%{cfg.buildcfg}_%{cfg.platform}") -- where the output binary goes.
     targetname "MandelbrotSet" -- the name of the executable saved to targetdir
+	dependson "Shaders"
 
 	local ProjectSourceDirectory = RootDirectory .. "MandelbrotSet/"
 	files
@@ -36,6 +64,14 @@ project "MandelbrotSet"
 		ProjectSourceDirectory .. "**.cpp",
 	}
 
+	removefiles
+	{
+		-- entry point of the headless renderer
+		ProjectSourceDirectory .. "src/RenderMain.cpp",
+		-- mandelbrot-bench
+		ProjectSourceDirectory .. "benchmark/**",
+	}
+
 	includedirs
 	{
 		ProjectSourceDirectory,
@@ -43,6 +79,9 @@ project "MandelbrotSet"
 		ProjectSourceDirectory .. "vendor/glm/glm",
 	}
 
+	-- Only mandelbrot-bench runs the whole kernel family, the window needs the float32 power 2 kernels
+	defines { "APP_ESCAPE_TIME_DOUBLE=0", "APP_ESCAPE_TIME_MAX_POWER=2", "APP_ESCAPE_TIME_CHECK_VARIANTS=0" }
+
 	libdirs
     {
       -- add dependency directories here
@@ -51,4 +90,133 @@ project "MandelbrotSet"
     links
     {
 		RootDirectory .. "MandelbrotSet/vendor/vulkan/lib/vulkan-1.lib"
-    }
\ No newline at end of file
+    }
+
+-- Headless offline renderer, needs no window or surface and builds on linux (premake5 gmake2)
+project "MandelbrotRender"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+	entrypoint "mainCRTStartup"
+
+	targetdir (RootDirectory .. "bin_%{cfg.buildcfg}_%{cfg.platform}")
+	targetname "mandelbrot-render"
+	dependson "Shaders"
+
+	local ProjectSourceDirectory = RootDirectory .. "MandelbrotSet/"
+	files
+	{
+		ProjectSourceDirectory .. "include/Core.h",
+		ProjectSourceDirectory .. "include/Platform.h",
+		ProjectSourceDirectory .. "include/VulkanTypes.h",
+		ProjectSourceDirectory .. "include/OfflineRenderer.h",
+		ProjectSourceDirectory .. "include/ImageWriter.h",
+		ProjectSourceDirectory .. "include/PngEncoder.h",
+		ProjectSourceDirectory .. "include/ThreadPool.h",
+		ProjectSourceDirectory .. "include/Coloring.h",
+		ProjectSourceDirectory .. "include/PostProcess.h",
+		ProjectSourceDirectory .. "include/Simd.h",
+		ProjectSourceDirectory .. "include/EscapeTimeFile.h",
+		ProjectSourceDirectory .. "include/ZoomSequence.h",
+		ProjectSourceDirectory .. "include/CpuKernels.h",
+		ProjectSourceDirectory .. "include/CpuRenderer.h",
+		ProjectSourceDirectory .. "include/InteriorChecks.h",
+		ProjectSourceDirectory .. "include/BigFixed.h",
+		ProjectSourceDirectory .. "include/Perturbation.h",
+		ProjectSourceDirectory .. "include/MappedFile.h",
+		ProjectSourceDirectory .. "include/OrbitCache.h",
+		ProjectSourceDirectory .. "src/Platform.cpp",
+		ProjectSourceDirectory .. "src/OfflineRenderer.cpp",
+		ProjectSourceDirectory .. "src/ImageWriter.cpp",
+		ProjectSourceDirectory .. "src/PngEncoder.cpp",
+		ProjectSourceDirectory .. "src/ThreadPool.cpp",
+		ProjectSourceDirectory .. "src/PostProcess.cpp",
+		ProjectSourceDirectory .. "src/Simd.cpp",
+		ProjectSourceDirectory .. "src/EscapeTimeFile.cpp",
+		ProjectSourceDirectory .. "src/ZoomSequence.cpp",
+		ProjectSourceDirectory .. "src/CpuKernels.cpp",
+		ProjectSourceDirectory .. "src/CpuRenderer.cpp",
+		ProjectSourceDirectory .. "src/BigFixed.cpp",
+		ProjectSourceDirectory .. "src/Perturbation.cpp",
+		ProjectSourceDirectory .. "src/MappedFile.cpp",
+		ProjectSourceDirectory .. "src/OrbitCache.cpp",
+		ProjectSourceDirectory .. "src/RenderMain.cpp",
+	}
+
+	includedirs
+	{
+		ProjectSourceDirectory,
+		ProjectSourceDirectory .. "vendor/glm",
+	}
+
+	-- Only mandelbrot-bench runs the whole kernel family, the renderer needs the float32 power 2 kernels
+	defines { "APP_ESCAPE_TIME_DOUBLE=0", "APP_ESCAPE_TIME_MAX_POWER=2", "APP_ESCAPE_TIME_CHECK_VARIANTS=0" }
+
+	filter "system:windows"
+		links
+		{
+			RootDirectory .. "MandelbrotSet/vendor/vulkan/lib/vulkan-1.lib"
+		}
+
+	filter "system:linux"
+		links
+		{
+			"vulkan",
+			"pthread",
+		}
+
+	filter {}
+-- CPU benchmarks (encoders, conversion and reference kernels), no Vulkan needed
+project "MandelbrotBench"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+	entrypoint "mainCRTStartup"
+
+	targetdir (RootDirectory .. "bin_%{cfg.buildcfg}_%{cfg.platform}")
+	targetname "mandelbrot-bench"
+
+	local ProjectSourceDirectory = RootDirectory .. "MandelbrotSet/"
+	files
+	{
+		ProjectSourceDirectory .. "benchmark/**.h",
+		ProjectSourceDirectory .. "benchmark/**.cpp",
+		ProjectSourceDirectory .. "include/BigFixed.h",
+		ProjectSourceDirectory .. "include/Core.h",
+		ProjectSourceDirectory .. "include/Coloring.h",
+		ProjectSourceDirectory .. "include/CpuKernels.h",
+		ProjectSourceDirectory .. "include/InteriorChecks.h",
+		ProjectSourceDirectory .. "include/Perturbation.h",
+		ProjectSourceDirectory .. "include/PngEncoder.h",
+		ProjectSourceDirectory .. "include/PostProcess.h",
+		ProjectSourceDirectory .. "include/Simd.h",
+		ProjectSourceDirectory .. "include/ThreadPool.h",
+		ProjectSourceDirectory .. "src/BigFixed.cpp",
+		ProjectSourceDirectory .. "src/CpuKernels.cpp",
+		ProjectSourceDirectory .. "src/Perturbation.cpp",
+		ProjectSourceDirectory .. "src/PngEncoder.cpp",
+		ProjectSourceDirectory .. "src/PostProcess.cpp",
+		ProjectSourceDirectory .. "src/Simd.cpp",
+		ProjectSourceDirectory .. "src/ThreadPool.cpp",
+		ProjectSourceDirectory .. "vendor/lodepng/lodepng.h",
+		ProjectSourceDirectory .. "vendor/lodepng/lodepng.cpp",
+	}
+
+	includedirs
+	{
+		ProjectSourceDirectory,
+		ProjectSourceDirectory .. "vendor/glm",
+	}
+
+	-- Escape time kernel family: fewer variants build faster, for example
+	-- defines { "APP_ESCAPE_TIME_DOUBLE=0", "APP_ESCAPE_TIME_MAX_POWER=2", "APP_ESCAPE_TIME_CHECK_VARIANTS=0" }
+
+	filter "system:linux"
+		links
+		{
+			"pthread",
+		}
+
+	filter {}